@@ -3,15 +3,36 @@
 ---------------------------*/
 
 #include <windows.h>
-#include <math.h> 
 #include <stdio.h>
+#include <stdlib.h>
 #include <mmsystem.h> 
 #include <shellapi.h>
 #include <tchar.h>
 #include <shlwapi.h>
+#include <wtsapi32.h>
+#include "rotate.h"
+#include "damage.h"
+#include "wavfile.h"
+#include "mixer.h"
+#include "assetpak.h"
+#include "clockdraw.h"
+#include "ticksched.h"
+#include "clockgrid.h"
+#include "glyphatlas.h"
+#include "phasetime.h"
+#include "renderpolicy.h"
+#include "startprof.h"
+#include "frameshm.h"
+#include "timesource.h"
+#include "sweep.h"
+#include "controls.h"
+#include "facecache.h"
+#include "alarms.h"
+#include "stopwatch.h"
 #pragma comment(lib, "winmm.lib")
 #pragma comment(lib, "shell32.lib")
 #pragma comment(lib, "shlwapi.lib")
+#pragma comment(lib, "wtsapi32.lib")
 
 #define ID_TIMER 1
 #define ID_DARKMODE_BTN 2
@@ -20,93 +41,792 @@
 #define ID_SOUND_BTN 5
 #define ID_DOTS_BTN 6
 #define ID_MYSTERY_BTN 7
-#define TWOPI (2*3.14159)
+#define ID_OCCLUSION_TIMER 8
+
+#define TICK_GUARD_US 1000
+
+#define AUDIO_BUFFERS 4
+#define AUDIO_BUFFER_MS 50
+
+#define GRID_MAX_CLOCKS 1024
+
+#define STARTUP_BUDGET_MS 50
+
+#define BTN_HEAVY_TEXT_HEIGHT 24
+#define BTN_LIGHT_TEXT_HEIGHT 16
+
+// Glyph atlas font ids
+#define ATLAS_FONT_FACE 0
+#define ATLAS_FONT_BUTTON 2
 
 // Global variables
 BOOL g_bDarkMode = FALSE;
-HWND hBtnDarkMode = NULL;
-
 BOOL g_bRomanMode = FALSE;
-HWND hBtnRomanMode = NULL;
-
 BOOL g_bUseLightFont = FALSE;
-HWND hBtnFontSwitch = NULL;
 
 BOOL g_bSoundOn = TRUE;
-HWND hBtnSound = NULL;
 HICON hSoundOnIcon = NULL;
 HICON hSoundOffIcon = NULL;
 
 BOOL g_bShowDots = TRUE;
-HWND hBtnDots = NULL;
 
-HWND hBtnMystery = NULL;
+// The buttons, drawn on the clock surface rather than as child windows
+CONTROLLAYER g_controls;
+BOOL g_bTrackingLeave = FALSE;
 
-HFONT hHeavyFont = NULL;
-HFONT hHeavyBtnFont = NULL;
-HFONT hLightFont = NULL;
-HFONT hLightBtnFont = NULL;
+// clock.pak next to the executable, mapped read-only on first use
+PAKFILE g_pak = { 0 };
+HANDLE g_hPakFile = NULL;
+HANDLE g_hPakMap = NULL;
+LPVOID g_pPakView = NULL;
+BOOL g_bPakTried = FALSE;
 
-const TCHAR* romanNumerals[] = {
-    TEXT(""), TEXT("I"), TEXT("II"), TEXT("III"), TEXT("IV"), TEXT("V"),
-    TEXT("VI"), TEXT("VII"), TEXT("VIII"), TEXT("IX"), TEXT("X"), TEXT("XI"), TEXT("XII")
+HINSTANCE g_hInstance = NULL;
+
+// Clock and button fonts, made the first time they are drawn with. A
+// family registers its TTF on first use and remembers which face name
+// worked, so its other size goes straight to that face.
+enum { FONT_HEAVY, FONT_HEAVY_BTN, FONT_LIGHT, FONT_LIGHT_BTN, FONT_COUNT };
+enum { FAMILY_MINECRAFT, FAMILY_DOGICA, FAMILY_COUNT };
+
+typedef struct
+{
+    const char* pszPackedTtf;           // name in clock.pak
+    const TCHAR* pszTtfFile;            // or next to the executable
+    const TCHAR* pszFaces[6];           // tried in order, NULL-terminated
+    BOOL bRegistered;
+    HANDLE hMemFont;                    // registered from clock.pak
+    BOOL bFileFont;                     // registered from the file; removed at exit
+    int iFace;                          // the face that worked, -1 until known
+} FONTFAMILY;
+
+typedef struct
+{
+    int iFamily;
+    int iHeight;
+    const char* pszPhase;               // name on the startup timeline
+    HFONT hFont;
+} CLOCKFONT;
+
+FONTFAMILY g_fontFamilies[FAMILY_COUNT] = {
+    { "Minecraft.ttf", TEXT("Minecraft.ttf"),
+        { TEXT("Minecraft"), TEXT("Minecraft Regular"), TEXT("Lucida Console"), TEXT("Courier New"), NULL },
+        FALSE, NULL, FALSE, -1 },
+    { "Dogica.ttf", TEXT("Dogica.ttf"),
+        { TEXT("Dogica"), TEXT("Dogica Pixel"), TEXT("Dogica Bold"), TEXT("Dogica Regular"), TEXT("Courier New"), NULL },
+        FALSE, NULL, FALSE, -1 }
 };
 
+CLOCKFONT g_fonts[FONT_COUNT] = {
+    { FAMILY_MINECRAFT, 40, "font:heavy", NULL },
+    { FAMILY_MINECRAFT, BTN_HEAVY_TEXT_HEIGHT, "font:heavy_button", NULL },
+    { FAMILY_DOGICA, 24, "font:light", NULL },
+    { FAMILY_DOGICA, BTN_LIGHT_TEXT_HEIGHT, "font:light_button", NULL }
+};
+
+// Offscreen copies of the clock face (background, dots and numerals) at
+// the sizes shown lately, keyed on everything that changes how it looks.
+// Each is an HBITMAP, selected into g_hdcFace to be copied.
+FACECACHE g_faceCache;
+HDC g_hdcFace = NULL;
+HBITMAP g_hbmFaceOld = NULL;
+HBITMAP g_hbmFaceSelected = NULL;
+
+// Set between WM_ENTERSIZEMOVE and WM_EXITSIZEMOVE, and once the drag has
+// changed the size: until it ends, paints scale the nearest cached face
+// instead of drawing one for every size the frame passes through
+BOOL g_bLiveResize = FALSE;
+BOOL g_bLiveResized = FALSE;
+
+// Tick.wav decoded once at startup and streamed from memory through the
+// mixer, so each tick can be placed on the exact second boundary
+typedef struct
+{
+    const BYTE* pFile;          // raw Tick.wav, for PlaySound if waveOut is unavailable
+    DWORD cbFile;
+    BOOL bFileOwned;            // FALSE when pFile points into clock.pak
+    WAVSOUND tick;
+    MIXER mixer;
+    CRITICAL_SECTION cs;        // guards mixer between the UI and audio threads
+    HWAVEOUT hWaveOut;
+    HANDLE hEvent;
+    HANDLE hThread;
+    volatile BOOL bQuit;
+    BOOL bStreaming;
+    WAVEHDR hdr[AUDIO_BUFFERS];
+    int iNextHdr;
+    int16_t* pBuffer;
+    DWORD dwBufferFrames;
+    DWORD dwLastPos;            // widens the 32-bit waveOut position to 64 bits
+    ULONGLONG qwPosBase;
+    ULONGLONG qwLastDue;
+    DWORD dwStartsSeen;
+
+    // Offset of audio start from the tick event, in microseconds
+    DWORD dwOffsets;
+    LONGLONG llOffsetSumUs;
+    LONGLONG llOffsetMinUs;
+    LONGLONG llOffsetMaxUs;
+} TICKAUDIO;
+
+TICKAUDIO g_tickAudio = { 0 };
+
+// World-time grid (CLOCK /grid sites.txt): every site is drawn by the
+// software rasterizer into one DIB section and shown with a single blit
+typedef struct
+{
+    CLOCKINSTANCE* pClocks;
+    int nClocks;
+    CLOCKGRID grid;
+    HDC hdcMem;
+    HBITMAP hBitmap;
+    HBITMAP hOldBitmap;
+    FRAMEBUFFER fb;             // pixels are the DIB section's bits
+    DWORD dwFrames;
+    LONGLONG llRenderTicks;
+} GRIDVIEW;
+
+GRIDVIEW g_gridView = { 0 };
+
+// Labels rendered once per font, pixel size and color into a memory
+// bitmap; the face numerals and the "???" button are copied out with BitBlt
+typedef struct
+{
+    GLYPHATLAS atlas;
+    HDC hdcMem;
+    HBITMAP hBitmap;
+    HBITMAP hOldBitmap;
+    HFONT hFont, hOldFont;
+    BOOL bOwnFont;
+
+    // Numeral positions for one client size
+    BOOL bPlaced;
+    int cxClient, cyClient;
+    BOOL bRomanMode;
+    ATLASPLACE place[12];
+} LABELATLAS;
+
+LABELATLAS g_faceAtlas = { 0 };
+LABELATLAS g_btnAtlas = { 0 };
+
+// Paint and tick time by phase; F9 writes clockphases.csv and .json
+PHASESTATS g_phaseStats;
+
+// One-shot timer re-armed on every tick for the next wall-clock second
+TICKSCHED g_tickSched;
+LARGE_INTEGER g_liPerfFreq = { 0 };
+BOOL g_bTimerArmed = FALSE;
+
+// Local time for each tick from the performance counter and a cached zone
+// offset; the wall clock is re-read every second and WM_TIMECHANGE drops both
+#define TIME_RESYNC_MS 1000
+#define TIME_JUMP_US 2000
+TIMESOURCE g_timeSource;
+
+// CLOCK /sweep moves the hands every display refresh from millisecond time,
+// and /mechanical ticks the second hand with a spring instead. The frames
+// are paced in the message loop; the one-second timer still does the tick
+// sound and everything else once a second.
+BOOL g_bSweep = FALSE;
+BOOL g_bMechanical = FALSE;
+int g_iSweepMode = SWEEP_OFF;
+FRAMEPACER g_framePacer;
+SWEEPHANDS g_sweepHands;
+
+// WinMain up to the end of the first paint; written to the debugger then
+// and to clockstartup.csv with F9
+STARTPROF g_startProf;
+
+// Nothing is drawn while the window is minimized, covered or the session
+// is locked; CLOCK /tickhidden keeps the tick sound going meanwhile
+RENDERPOLICY g_renderPolicy;
+BOOL g_bTickHidden = FALSE;
+
+// Under desktop composition being uncovered sends no WM_PAINT, so while
+// covered WinEvent hooks watch other windows move, hide, close or take
+// the foreground, and ID_OCCLUSION_TIMER checks again once they settle
+#define OCCLUSION_SETTLE_MS 100
+#define OCCLUSION_HOOKS 4
+HWINEVENTHOOK g_hOcclusionHooks[OCCLUSION_HOOKS] = { 0 };
+HWND g_hwndOcclusion = NULL;
+
+// CLOCK /publish also draws every tick into a shared-memory ring for other
+// processes, at a fixed size and whether or not the window is visible;
+// clockshm.c has a reader. The first frame and any restyle go out whole.
+#define PUBLISH_SIZE 512
+#define PUBLISH_SLOTS 4
+FRAMESHM g_frameShm = { 0 };
+BOOL g_bPublish = FALSE;
+BOOL g_bPublishFull = TRUE;
+SYSTEMTIME g_stPublished;
+
+// CLOCK /alarms alarms.txt rings the alarms in the list (alarms.h has the
+// format) with three quick ticks through the tick mixer and a face that
+// flashes for ALARM_FLASH_SECONDS. The wheel moves on every timer tick,
+// hidden or not, and keeps the timer running while anything is pending.
+#define ALARM_MAX_LABELS 4096
+#define ALARM_FLASH_SECONDS 10
+#define ALARM_CHIMES 3
+#define ALARM_CHIME_MS 120
+ALARMWHEEL g_alarms = { 0 };
+char (*g_pAlarmLabels)[ALARM_LABEL_CHARS] = NULL;
+char g_szAlarmPath[MAX_PATH] = "";
+int g_iAlarmFlash = 0;
+
+// CLOCK /stopwatch turns the hands into a stopwatch on the phase counter,
+// with a millisecond sub-dial and the elapsed time and last lap above the
+// centre. Space starts and stops it, Enter or L takes a lap, Backspace or
+// R resets it, and F8 writes the laps to clocklaps.csv on a thread of its
+// own. The hands sweep at the display rate while it runs.
+#define STOPWATCH_CSV_NAME "clocklaps.csv"
+BOOL g_bStopwatch = FALSE;
+STOPWATCH g_stopwatch;
+uint32_t g_dwLastLap = 0;
+
 // Function prototypes
 LRESULT CALLBACK WndProc(HWND, UINT, WPARAM, LPARAM);
-void UpdateButtonFonts(HWND hwnd);
+HFONT GetClockFont(int iFont);
 BOOL LoadFonts();
+HICON GetSoundIcon(BOOL bOn);
 void FreeResources();
+const void* GetAsset(const char* pszName, DWORD* pcbSize);
+void CloseAssetPack(void);
+BOOL LoadTickSound(void);
+void FreeTickSound(void);
+void ScheduleTick(SYSTEMTIME * pst);
+void CancelTicks(void);
+void ReportTickAudioStats(void);
 void PlayMysteryVideo();
 void SetIsotropic(HDC hdc, int cxClient, int cyClient);
 void RotatePoint(POINT pt[], int iNum, int iAngle);
-void DrawClock(HDC hdc);
+void DrawClock(HDC hdc, int cxClient, int cyClient);
+void FreeLabelAtlases(void);
+void ComputeHands(SYSTEMTIME * pst, POINT ptHands[3][5]);
 void DrawHands(HDC hdc, SYSTEMTIME * pst, BOOL fChange);
-
-// Helper function to get executable directory
+void AddHandDamage(DAMAGERECT * pDamage, SYSTEMTIME * pst, BOOL fChange, int cxClient, int cyClient);
+void DrawCachedFace(HDC hdc, int cxClient, int cyClient, const RECT * prcDirty);
+void DrawScaledFace(HDC hdc, int cxClient, int cyClient);
+void MarkPublishFull(void);
+void PublishTick(SYSTEMTIME * pst);
+void FreeFaceCache(void);
+void FreeFaceBitmap(void* pCtx, void* pFace);
+void ReportFaceCacheStats(void);
+void ReportTickSchedStats(void);
+void GetClockTime(SYSTEMTIME * pst);
+void ReportTimeSourceStats(void);
+void SweepFrame(HWND hwnd);
+void ReportFramePacerStats(void);
+void WaitForWork(HWND hwnd);
+BOOL LoadGrid(PSTR szCmdLine);
+void FreeGrid(void);
+void FreeGridSurface(void);
+void PaintGrid(HDC hdc, int cxClient, int cyClient);
+void ReportGridStats(void);
+void DumpPhaseStats(void);
+void ApplyRenderPolicy(HWND hwnd, SYSTEMTIME* pstShown);
+void SetOccluded(HWND hwnd, BOOL bOccluded, SYSTEMTIME* pstShown);
+void WatchOcclusion(HWND hwnd, BOOL bWatch);
+void ReportRenderPolicyStats(void);
+void ReportStartup(void);
+void ReportControlStats(void);
+void ScheduleChime(SYSTEMTIME * pst);
+BOOL LoadAlarms(void);
+void FreeAlarms(void);
+void CheckAlarms(HWND hwnd, SYSTEMTIME * pst);
+void ReportAlarmStats(void);
+void InitStopwatch(void);
+void StopwatchKey(HWND hwnd, WPARAM wParam);
+void ExportLaps(void);
+void ReportStopwatchStats(void);
+
+// Helper function to get executable directory; looked up once, since
+// every asset fallback asks for it
 BOOL GetExeDirectory(TCHAR* buffer, DWORD size)
 {
-    if (!GetModuleFileName(NULL, buffer, size))
+    static TCHAR exeDir[MAX_PATH];
+    static BOOL bKnown = FALSE;
+
+    if (!bKnown)
+    {
+        if (!GetModuleFileName(NULL, exeDir, MAX_PATH))
+            return FALSE;
+        PathRemoveFileSpec(exeDir);
+        bKnown = TRUE;
+    }
+    lstrcpyn(buffer, exeDir, size);
+    return TRUE;
+}
+
+static BOOL OpenAssetPack(void)
+{
+    TCHAR pakPath[MAX_PATH];
+    LARGE_INTEGER liSize;
+
+    if (!GetExeDirectory(pakPath, MAX_PATH))
+        return FALSE;
+    PathCombine(pakPath, pakPath, TEXT(PAK_DEFAULT_NAME));
+
+    g_hPakFile = CreateFile(pakPath, GENERIC_READ, FILE_SHARE_READ, NULL,
+        OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (g_hPakFile == INVALID_HANDLE_VALUE)
+    {
+        g_hPakFile = NULL;
+        return FALSE;
+    }
+
+    if (GetFileSizeEx(g_hPakFile, &liSize) && liSize.QuadPart > 0)
+    {
+        g_hPakMap = CreateFileMapping(g_hPakFile, NULL, PAGE_READONLY, 0, 0, NULL);
+        if (g_hPakMap)
+            g_pPakView = MapViewOfFile(g_hPakMap, FILE_MAP_READ, 0, 0, 0);
+    }
+
+    if (!g_pPakView || !PakOpenMemory(&g_pak, g_pPakView, (size_t)liSize.QuadPart))
+    {
+        CloseAssetPack();
         return FALSE;
-    
-    PathRemoveFileSpec(buffer);
+    }
     return TRUE;
 }
 
-// Function to load icons from embedded resources or files
-BOOL LoadSoundIcons(HINSTANCE hInstance)
+// Returns a read-only view of an asset in clock.pak, or NULL if there is no
+// pack or it lacks the asset. The pack is opened and mapped on the first
+// call; pages are only read in when an asset is actually used.
+const void* GetAsset(const char* pszName, DWORD* pcbSize)
+{
+    const void* pData;
+    size_t cb;
+
+    if (!g_bPakTried)
+    {
+        g_bPakTried = TRUE;
+        OpenAssetPack();
+    }
+    if (!g_pPakView)
+        return NULL;
+
+    pData = PakFind(&g_pak, pszName, &cb);
+    if (pData && pcbSize)
+        *pcbSize = (DWORD)cb;
+    return pData;
+}
+
+void CloseAssetPack(void)
+{
+    if (g_pPakView)
+    {
+        UnmapViewOfFile(g_pPakView);
+        g_pPakView = NULL;
+    }
+    if (g_hPakMap)
+    {
+        CloseHandle(g_hPakMap);
+        g_hPakMap = NULL;
+    }
+    if (g_hPakFile)
+    {
+        CloseHandle(g_hPakFile);
+        g_hPakFile = NULL;
+    }
+    memset(&g_pak, 0, sizeof(g_pak));
+}
+
+// Builds an icon from the first image of a packed .ico file
+static HICON IconFromAsset(const char* pszName)
+{
+    const BYTE* pIco;
+    DWORD cb, cbImage, dwOffset;
+
+    pIco = (const BYTE*)GetAsset(pszName, &cb);
+    if (!pIco || cb < 22 || pIco[2] != 1 || (pIco[4] | (pIco[5] << 8)) == 0)
+        return NULL;
+
+    // ICONDIR is 6 bytes; the first ICONDIRENTRY holds size and offset
+    cbImage = pIco[14] | (pIco[15] << 8) | (pIco[16] << 16) | ((DWORD)pIco[17] << 24);
+    dwOffset = pIco[18] | (pIco[19] << 8) | (pIco[20] << 16) | ((DWORD)pIco[21] << 24);
+    if (dwOffset > cb || cbImage > cb - dwOffset)
+        return NULL;
+
+    return CreateIconFromResourceEx((PBYTE)(pIco + dwOffset), cbImage, TRUE, 0x00030000,
+        0, 0, LR_DEFAULTCOLOR);
+}
+
+// Registers a packed TTF as a private font; NULL if it is not in the pack
+static HANDLE AddPackedFont(const char* pszName)
+{
+    const void* pData;
+    DWORD cb, nFonts = 0;
+
+    pData = GetAsset(pszName, &cb);
+    if (!pData)
+        return NULL;
+    return AddFontMemResourceEx((PVOID)pData, cb, NULL, &nFonts);
+}
+
+// Loads a sound button icon the first time it is shown: from the
+// resources, then clock.pak, then a file next to the executable, and last
+// a system icon
+HICON GetSoundIcon(BOOL bOn)
 {
-    // Try loading from resources first
-    hSoundOnIcon = LoadIcon(hInstance, MAKEINTRESOURCE(101));
-    hSoundOffIcon = LoadIcon(hInstance, MAKEINTRESOURCE(102));
-    
-    // If not found in resources, try loading from files in executable directory
-    if (!hSoundOnIcon || !hSoundOffIcon)
+    HICON* phIcon = bOn ? &hSoundOnIcon : &hSoundOffIcon;
+    TCHAR iconPath[MAX_PATH];
+
+    if (*phIcon)
+        return *phIcon;
+
+    StartProfBegin(&g_startProf, bOn ? "icon:sound_on" : "icon:sound_off");
+    *phIcon = LoadIcon(g_hInstance, MAKEINTRESOURCE(bOn ? 101 : 102));
+    if (!*phIcon)
+        *phIcon = IconFromAsset(bOn ? "sound_on.ico" : "sound_off.ico");
+
+    if (!*phIcon && GetExeDirectory(iconPath, MAX_PATH))
+    {
+        PathCombine(iconPath, iconPath, bOn ? TEXT("sound_on.ico") : TEXT("sound_off.ico"));
+        if (PathFileExists(iconPath))
+            *phIcon = (HICON)LoadImage(NULL, iconPath, IMAGE_ICON, 0, 0, LR_LOADFROMFILE | LR_DEFAULTSIZE);
+    }
+
+    if (!*phIcon)
+        *phIcon = LoadIcon(NULL, bOn ? IDI_INFORMATION : IDI_WARNING);
+    StartProfEnd(&g_startProf);
+    return *phIcon;
+}
+
+// Reads a whole file into a malloc'd buffer
+static BYTE* ReadWholeFile(const TCHAR* pszPath, DWORD* pcb)
+{
+    FILE* fp = _tfopen(pszPath, TEXT("rb"));
+    BYTE* pData = NULL;
+    long cb;
+
+    if (!fp)
+        return NULL;
+
+    if (fseek(fp, 0, SEEK_END) == 0 && (cb = ftell(fp)) > 0 && fseek(fp, 0, SEEK_SET) == 0)
     {
-        TCHAR exePath[MAX_PATH];
-        if (GetExeDirectory(exePath, MAX_PATH))
+        pData = (BYTE*)malloc(cb);
+        if (pData && fread(pData, 1, cb, fp) != (size_t)cb)
         {
-            TCHAR iconPath[MAX_PATH];
-            
-            // Try loading sound_on.ico
-            PathCombine(iconPath, exePath, TEXT("sound_on.ico"));
-            if (PathFileExists(iconPath))
-                hSoundOnIcon = (HICON)LoadImage(NULL, iconPath, IMAGE_ICON, 0, 0, LR_LOADFROMFILE | LR_DEFAULTSIZE);
-            
-            // Try loading sound_off.ico
-            PathCombine(iconPath, exePath, TEXT("sound_off.ico"));
-            if (PathFileExists(iconPath))
-                hSoundOffIcon = (HICON)LoadImage(NULL, iconPath, IMAGE_ICON, 0, 0, LR_LOADFROMFILE | LR_DEFAULTSIZE);
+            free(pData);
+            pData = NULL;
+        }
+        *pcb = (DWORD)cb;
+    }
+    fclose(fp);
+    return pData;
+}
+
+// Mixes the next block into a waveOut buffer and queues it
+static void QueueAudioBuffer(WAVEHDR* pHdr)
+{
+    EnterCriticalSection(&g_tickAudio.cs);
+    MixerRender(&g_tickAudio.mixer, (int16_t*)pHdr->lpData, g_tickAudio.dwBufferFrames);
+    LeaveCriticalSection(&g_tickAudio.cs);
+    waveOutWrite(g_tickAudio.hWaveOut, pHdr, sizeof(WAVEHDR));
+}
+
+static DWORD WINAPI AudioThreadProc(LPVOID pParam)
+{
+    (void)pParam;
+    while (!g_tickAudio.bQuit)
+    {
+        WaitForSingleObject(g_tickAudio.hEvent, INFINITE);
+
+        // Buffers complete in order, so refill them in the same order
+        while (!g_tickAudio.bQuit && (g_tickAudio.hdr[g_tickAudio.iNextHdr].dwFlags & WHDR_DONE))
+        {
+            QueueAudioBuffer(&g_tickAudio.hdr[g_tickAudio.iNextHdr]);
+            g_tickAudio.iNextHdr = (g_tickAudio.iNextHdr + 1) % AUDIO_BUFFERS;
         }
     }
-    
-    // If still not loaded, use system icons as fallback
-    if (!hSoundOnIcon)
-        hSoundOnIcon = LoadIcon(NULL, IDI_INFORMATION);
-    if (!hSoundOffIcon)
-        hSoundOffIcon = LoadIcon(NULL, IDI_WARNING);
-    
-    return (hSoundOnIcon && hSoundOffIcon);
+    return 0;
+}
+
+static BOOL StartTickStream(void)
+{
+    WAVEFORMATEX wfx;
+    int i;
+
+    wfx.wFormatTag = WAVE_FORMAT_PCM;
+    wfx.nChannels = g_tickAudio.tick.wChannels;
+    wfx.nSamplesPerSec = g_tickAudio.tick.dwSampleRate;
+    wfx.wBitsPerSample = 16;
+    wfx.nBlockAlign = wfx.nChannels * 2;
+    wfx.nAvgBytesPerSec = wfx.nSamplesPerSec * wfx.nBlockAlign;
+    wfx.cbSize = 0;
+
+    MixerInit(&g_tickAudio.mixer, wfx.nChannels, wfx.nSamplesPerSec);
+    g_tickAudio.dwBufferFrames = wfx.nSamplesPerSec * AUDIO_BUFFER_MS / 1000;
+    g_tickAudio.pBuffer = (int16_t*)malloc(g_tickAudio.dwBufferFrames * wfx.nBlockAlign * AUDIO_BUFFERS);
+    g_tickAudio.hEvent = CreateEvent(NULL, FALSE, FALSE, NULL);
+
+    if (!g_tickAudio.pBuffer || !g_tickAudio.hEvent ||
+        waveOutOpen(&g_tickAudio.hWaveOut, WAVE_MAPPER, &wfx, (DWORD_PTR)g_tickAudio.hEvent, 0,
+            CALLBACK_EVENT) != MMSYSERR_NOERROR)
+    {
+        g_tickAudio.hWaveOut = NULL;
+        return FALSE;
+    }
+
+    // Keep the device running on silence; device sample 0 is mixer frame 0
+    for (i = 0; i < AUDIO_BUFFERS; i++)
+    {
+        WAVEHDR* pHdr = &g_tickAudio.hdr[i];
+        pHdr->lpData = (char*)(g_tickAudio.pBuffer + i * g_tickAudio.dwBufferFrames * wfx.nChannels);
+        pHdr->dwBufferLength = g_tickAudio.dwBufferFrames * wfx.nBlockAlign;
+        waveOutPrepareHeader(g_tickAudio.hWaveOut, pHdr, sizeof(WAVEHDR));
+        QueueAudioBuffer(pHdr);
+    }
+
+    g_tickAudio.hThread = CreateThread(NULL, 0, AudioThreadProc, NULL, 0, NULL);
+    return g_tickAudio.hThread != NULL;
+}
+
+static void ReleaseTickFile(void)
+{
+    if (g_tickAudio.bFileOwned)
+        free((void*)g_tickAudio.pFile);
+    g_tickAudio.pFile = NULL;
+    g_tickAudio.bFileOwned = FALSE;
+}
+
+static void StopTickStream(void)
+{
+    int i;
+
+    if (g_tickAudio.hThread)
+    {
+        g_tickAudio.bQuit = TRUE;
+        SetEvent(g_tickAudio.hEvent);
+        WaitForSingleObject(g_tickAudio.hThread, INFINITE);
+        CloseHandle(g_tickAudio.hThread);
+        g_tickAudio.hThread = NULL;
+    }
+    if (g_tickAudio.hWaveOut)
+    {
+        waveOutReset(g_tickAudio.hWaveOut);
+        for (i = 0; i < AUDIO_BUFFERS; i++)
+            waveOutUnprepareHeader(g_tickAudio.hWaveOut, &g_tickAudio.hdr[i], sizeof(WAVEHDR));
+        waveOutClose(g_tickAudio.hWaveOut);
+        g_tickAudio.hWaveOut = NULL;
+    }
+    if (g_tickAudio.hEvent)
+    {
+        CloseHandle(g_tickAudio.hEvent);
+        g_tickAudio.hEvent = NULL;
+    }
+    free(g_tickAudio.pBuffer);
+    g_tickAudio.pBuffer = NULL;
+    g_tickAudio.bStreaming = FALSE;
+}
+
+// Loads and decodes Tick.wav once, then starts the streaming mixer. If no
+// waveOut device opens, the raw file stays resident for PlaySound instead.
+BOOL LoadTickSound(void)
+{
+    TCHAR soundPath[MAX_PATH];
+
+    InitializeCriticalSection(&g_tickAudio.cs);
+    g_tickAudio.llOffsetMinUs = 0x7FFFFFFF;
+    g_tickAudio.llOffsetMaxUs = -0x7FFFFFFF;
+
+    g_tickAudio.pFile = (const BYTE*)GetAsset("Tick.wav", &g_tickAudio.cbFile);
+    if (!g_tickAudio.pFile)
+    {
+        if (!GetExeDirectory(soundPath, MAX_PATH))
+            return FALSE;
+        PathCombine(soundPath, soundPath, TEXT("Tick.wav"));
+
+        g_tickAudio.pFile = ReadWholeFile(soundPath, &g_tickAudio.cbFile);
+        if (!g_tickAudio.pFile)
+            return FALSE;
+        g_tickAudio.bFileOwned = TRUE;
+    }
+
+    if (WavParse(g_tickAudio.pFile, g_tickAudio.cbFile, &g_tickAudio.tick))
+        g_tickAudio.bStreaming = StartTickStream();
+
+    if (g_tickAudio.bStreaming)
+        ReleaseTickFile();
+    else
+    {
+        StopTickStream();
+        WavFree(&g_tickAudio.tick);
+    }
+    return TRUE;
+}
+
+void FreeTickSound(void)
+{
+    if (!g_tickAudio.bStreaming && g_tickAudio.pFile)
+        PlaySound(NULL, NULL, 0);
+
+    StopTickStream();
+    WavFree(&g_tickAudio.tick);
+    ReleaseTickFile();
+}
+
+// Frames the device has played since the stream started
+static ULONGLONG AudioPlayedFrames(void)
+{
+    MMTIME mmt;
+
+    mmt.wType = TIME_SAMPLES;
+    if (waveOutGetPosition(g_tickAudio.hWaveOut, &mmt, sizeof(mmt)) != MMSYSERR_NOERROR)
+        return g_tickAudio.qwPosBase + g_tickAudio.dwLastPos;
+    if (mmt.wType == TIME_BYTES)
+        mmt.u.sample = mmt.u.cb / (g_tickAudio.mixer.wChannels * 2);
+
+    if (mmt.u.sample < g_tickAudio.dwLastPos)
+        g_tickAudio.qwPosBase += 0x100000000ULL;
+    g_tickAudio.dwLastPos = mmt.u.sample;
+    return g_tickAudio.qwPosBase + mmt.u.sample;
+}
+
+// Called on each timer tick. Measures how far the tick queued for this
+// second landed from the event, then queues the next one on the next
+// second boundary.
+void ScheduleTick(SYSTEMTIME * pst)
+{
+    ULONGLONG qwNow, qwDue;
+    LONGLONG llOffsetUs;
+
+    if (!g_tickAudio.bStreaming)
+    {
+        if (g_tickAudio.pFile)
+            PlaySound((LPCTSTR)g_tickAudio.pFile, NULL, SND_MEMORY | SND_ASYNC);
+        return;
+    }
+
+    qwNow = AudioPlayedFrames();
+    qwDue = qwNow + MixerMsToFrames(&g_tickAudio.mixer, 1000 - pst->wMilliseconds);
+
+    EnterCriticalSection(&g_tickAudio.cs);
+    if (g_tickAudio.mixer.dwStarts != g_tickAudio.dwStartsSeen)
+    {
+        g_tickAudio.dwStartsSeen = g_tickAudio.mixer.dwStarts;
+        llOffsetUs = ((LONGLONG)g_tickAudio.mixer.qwLastStart - (LONGLONG)qwNow) * 1000000 /
+            g_tickAudio.mixer.dwSampleRate;
+        g_tickAudio.llOffsetSumUs += llOffsetUs;
+        if (llOffsetUs < g_tickAudio.llOffsetMinUs) g_tickAudio.llOffsetMinUs = llOffsetUs;
+        if (llOffsetUs > g_tickAudio.llOffsetMaxUs) g_tickAudio.llOffsetMaxUs = llOffsetUs;
+        g_tickAudio.dwOffsets++;
+    }
+
+    // A timer that fires twice in one second must not queue a double tick
+    if (g_tickAudio.qwLastDue == 0 || qwDue >= g_tickAudio.qwLastDue + g_tickAudio.mixer.dwSampleRate / 2)
+    {
+        if (MixerSchedule(&g_tickAudio.mixer, &g_tickAudio.tick, qwDue))
+            g_tickAudio.qwLastDue = qwDue;
+    }
+    LeaveCriticalSection(&g_tickAudio.cs);
+
+    if (g_tickAudio.dwOffsets && g_tickAudio.dwOffsets % 60 == 0)
+        ReportTickAudioStats();
+}
+
+// Drops queued ticks when sound is switched off
+void CancelTicks(void)
+{
+    if (!g_tickAudio.bStreaming)
+        return;
+
+    EnterCriticalSection(&g_tickAudio.cs);
+    MixerClear(&g_tickAudio.mixer);
+    g_tickAudio.dwStartsSeen = g_tickAudio.mixer.dwStarts;
+    g_tickAudio.qwLastDue = 0;
+    LeaveCriticalSection(&g_tickAudio.cs);
+}
+
+// Queues ALARM_CHIMES ticks just after the one for the next second, so
+// an alarm is heard apart from the ticking
+void ScheduleChime(SYSTEMTIME * pst)
+{
+    ULONGLONG qwDue;
+    int i;
+
+    if (!g_tickAudio.bStreaming)
+    {
+        if (g_tickAudio.pFile)
+            PlaySound((LPCTSTR)g_tickAudio.pFile, NULL, SND_MEMORY | SND_ASYNC);
+        return;
+    }
+
+    qwDue = AudioPlayedFrames() + MixerMsToFrames(&g_tickAudio.mixer, 1000 - pst->wMilliseconds);
+    EnterCriticalSection(&g_tickAudio.cs);
+    for (i = 1; i <= ALARM_CHIMES; i++)
+        MixerSchedule(&g_tickAudio.mixer, &g_tickAudio.tick,
+            qwDue + MixerMsToFrames(&g_tickAudio.mixer, i * ALARM_CHIME_MS));
+    LeaveCriticalSection(&g_tickAudio.cs);
+}
+
+// Writes the tick-event to audio-start offset to the debugger; negative
+// values mean the sound started before the timer message arrived
+void ReportTickAudioStats(void)
+{
+    TCHAR buf[160];
+
+    if (!g_tickAudio.dwOffsets)
+        return;
+
+    wsprintf(buf, TEXT("Tick audio: %lu ticks, start offset avg %ld us, min %ld us, max %ld us\n"),
+        g_tickAudio.dwOffsets, (LONG)(g_tickAudio.llOffsetSumUs / g_tickAudio.dwOffsets),
+        (LONG)g_tickAudio.llOffsetMinUs, (LONG)g_tickAudio.llOffsetMaxUs);
+    OutputDebugString(buf);
+}
+
+// Skips a leading switch such as /tickhidden, setting *pbOn if present
+static PSTR TakeSwitch(PSTR szCmdLine, const char* pszSwitch, BOOL* pbOn)
+{
+    size_t cch = strlen(pszSwitch);
+
+    while (*szCmdLine == ' ')
+        szCmdLine++;
+    if ((*szCmdLine == '/' || *szCmdLine == '-') &&
+        _strnicmp(szCmdLine + 1, pszSwitch + 1, cch - 1) == 0 &&
+        (szCmdLine[cch] == ' ' || szCmdLine[cch] == '\0'))
+    {
+        *pbOn = TRUE;
+        szCmdLine += cch;
+    }
+    return szCmdLine;
+}
+
+// Skips a leading switch that takes a word, such as /alarms alarms.txt,
+// copying the word to pszValue if present
+static PSTR TakeSwitchValue(PSTR szCmdLine, const char* pszSwitch, char* pszValue, size_t cchValue)
+{
+    BOOL bFound = FALSE;
+    size_t cch = 0, cchCopy;
+
+    szCmdLine = TakeSwitch(szCmdLine, pszSwitch, &bFound);
+    if (!bFound)
+        return szCmdLine;
+    while (*szCmdLine == ' ')
+        szCmdLine++;
+    while (szCmdLine[cch] && szCmdLine[cch] != ' ')
+        cch++;
+    cchCopy = cch < cchValue ? cch : cchValue - 1;
+    memcpy(pszValue, szCmdLine, cchCopy);
+    pszValue[cchCopy] = '\0';
+    return szCmdLine + cch;
+}
+
+// PhaseNowNs() when the process was created, so the startup timeline
+// also covers loading the executable and its DLLs
+static uint64_t ProcessStartNs(void)
+{
+    FILETIME ftCreation, ftExit, ftKernel, ftUser, ftNow;
+    uint64_t qwNowNs = PhaseNowNs(), qwAgeNs;
+
+    if (!GetProcessTimes(GetCurrentProcess(), &ftCreation, &ftExit, &ftKernel, &ftUser))
+        return qwNowNs;
+    GetSystemTimeAsFileTime(&ftNow);
+
+    // FILETIMEs count 100 ns units
+    qwAgeNs = ((((uint64_t)ftNow.dwHighDateTime << 32) | ftNow.dwLowDateTime) -
+        (((uint64_t)ftCreation.dwHighDateTime << 32) | ftCreation.dwLowDateTime)) * 100;
+    return qwAgeNs < qwNowNs ? qwNowNs - qwAgeNs : qwNowNs;
 }
 
 int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, PSTR szCmdLine, int iCmdShow)
@@ -115,20 +835,76 @@ int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, PSTR szCmdLine,
     HWND hwnd;
     MSG msg;
     WNDCLASS wndclass;
+    PSTR pszSwitches;
+    BOOL bQuit = FALSE;
+
+    StartProfInit(&g_startProf, ProcessStartNs());
+    g_hInstance = hInstance;
+
+    StartProfBegin(&g_startProf, "rotate_table");
+    InitRotateTable();
+    QueryPerformanceFrequency(&g_liPerfFreq);
+    {
+        TIMECLOCK clock;
+        TimeSourceSystemClock(&clock);
+        TimeSourceInit(&g_timeSource, &clock, (uint64_t)TIME_RESYNC_MS * 1000000, TIME_JUMP_US);
+    }
+    InitSweepTable();
+    StartProfEnd(&g_startProf);
 
-    // Load sound icons
-    if (!LoadSoundIcons(hInstance))
+    StartProfBegin(&g_startProf, "tick_sound");
+    LoadTickSound();
+    StartProfEnd(&g_startProf);
+
+    StartProfBegin(&g_startProf, "grid");
+    do
+    {
+        pszSwitches = szCmdLine;
+        szCmdLine = TakeSwitch(szCmdLine, "/tickhidden", &g_bTickHidden);
+        szCmdLine = TakeSwitch(szCmdLine, "/publish", &g_bPublish);
+        szCmdLine = TakeSwitch(szCmdLine, "/sweep", &g_bSweep);
+        szCmdLine = TakeSwitch(szCmdLine, "/mechanical", &g_bMechanical);
+        szCmdLine = TakeSwitchValue(szCmdLine, "/alarms", g_szAlarmPath, MAX_PATH);
+        szCmdLine = TakeSwitch(szCmdLine, "/stopwatch", &g_bStopwatch);
+    } while (szCmdLine != pszSwitches);
+    if (!LoadGrid(szCmdLine))
+    {
+        MessageBox(NULL, TEXT("Could not read the site list for /grid!"), szAppName, MB_ICONERROR);
+        FreeResources();
+        return 0;
+    }
+    if (!LoadAlarms())
+    {
+        MessageBox(NULL, TEXT("Could not read the alarm list for /alarms!"), szAppName, MB_ICONERROR);
+        FreeResources();
+        return 0;
+    }
+    if (!g_gridView.nClocks)
+        g_iSweepMode = g_bMechanical ? SWEEP_MECHANICAL : g_bSweep ? SWEEP_SMOOTH : SWEEP_OFF;
+    g_bStopwatch = g_bStopwatch && !g_gridView.nClocks;
+    if (g_bStopwatch)
     {
-        MessageBox(NULL, TEXT("Failed to load sound icons!"), szAppName, MB_ICONWARNING);
+        InitStopwatch();
+        g_iSweepMode = SWEEP_SMOOTH;
     }
-    
-    if (!LoadFonts())
+    if (g_bPublish && !g_gridView.nClocks &&
+        !FrameShmCreate(&g_frameShm, FRAMESHM_DEFAULT_NAME, PUBLISH_SIZE, PUBLISH_SIZE, PUBLISH_SLOTS))
+        OutputDebugStringA("Could not create the frame ring for /publish\n");
+    StartProfEnd(&g_startProf);
+
+    // The grid draws its own text
+    StartProfBegin(&g_startProf, "fonts");
+    if (!g_gridView.nClocks && !LoadFonts())
     {
         MessageBox(NULL, TEXT("Failed to load required fonts!"), szAppName, MB_ICONERROR);
+        FreeResources();
         return 0;
     }
+    StartProfEnd(&g_startProf);
 
-    wndclass.style = CS_HREDRAW | CS_VREDRAW;
+    // No CS_HREDRAW | CS_VREDRAW: WM_SIZE invalidates without erasing, so
+    // a drag never flashes the class brush before the face goes down
+    wndclass.style = 0;
     wndclass.lpfnWndProc = WndProc;
     wndclass.cbClsExtra = 0;
     wndclass.cbWndExtra = 0;
@@ -139,13 +915,16 @@ int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, PSTR szCmdLine,
     wndclass.lpszMenuName = NULL;
     wndclass.lpszClassName = szAppName;
 
+    StartProfBegin(&g_startProf, "register_class");
     if (!RegisterClass(&wndclass))
     {
         MessageBox(NULL, TEXT("Program requires Windows NT!"), szAppName, MB_ICONERROR);
         FreeResources();
         return 0;
     }
+    StartProfEnd(&g_startProf);
 
+    StartProfBegin(&g_startProf, "create_window");
     hwnd = CreateWindow(szAppName, TEXT("Analog Clock"),
         WS_OVERLAPPEDWINDOW,
         CW_USEDEFAULT, CW_USEDEFAULT,
@@ -157,174 +936,156 @@ int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, PSTR szCmdLine,
         FreeResources();
         return 0;
     }
+    StartProfEnd(&g_startProf);
 
+    // UpdateWindow sends the first WM_PAINT straight to WndProc
+    StartProfBegin(&g_startProf, "first_paint");
     ShowWindow(hwnd, iCmdShow);
     UpdateWindow(hwnd);
+    StartProfFirstFrame(&g_startProf);
+    ReportStartup();
 
-    while (GetMessage(&msg, NULL, 0, 0))
+    while (!bQuit)
     {
-        TranslateMessage(&msg);
-        DispatchMessage(&msg);
+        WaitForWork(hwnd);
+        while (!bQuit && PeekMessage(&msg, NULL, 0, 0, PM_REMOVE))
+        {
+            bQuit = msg.message == WM_QUIT;
+            TranslateMessage(&msg);
+            DispatchMessage(&msg);
+        }
     }
 
     FreeResources();
     return msg.wParam;
 }
 
-// Font loading function (unchanged from your original)
-BOOL LoadFonts()
+// Registers the family's TTF privately, from clock.pak if it is there
+static void RegisterFontFamily(FONTFAMILY* pFamily)
 {
     TCHAR fontPath[MAX_PATH];
-    BOOL bMinecraftLoaded = FALSE;
-    BOOL bDogicaLoaded = FALSE;
-
-    if (GetExeDirectory(fontPath, MAX_PATH))
-    {
-        TCHAR mcPath[MAX_PATH];
-        PathCombine(mcPath, fontPath, TEXT("Minecraft.ttf"));
-        if (PathFileExists(mcPath))
-        {
-            bMinecraftLoaded = AddFontResourceEx(mcPath, FR_PRIVATE, NULL) > 0;
-        }
 
-        TCHAR dogicaPath[MAX_PATH];
-        PathCombine(dogicaPath, fontPath, TEXT("Dogica.ttf"));
-        if (PathFileExists(dogicaPath))
-        {
-            bDogicaLoaded = AddFontResourceEx(dogicaPath, FR_PRIVATE, NULL) > 0;
-        }
-    }
-
-    hHeavyFont = CreateFont(-40, 0, 0, 0, FW_BOLD, FALSE, FALSE, FALSE,
-        DEFAULT_CHARSET, OUT_OUTLINE_PRECIS, CLIP_DEFAULT_PRECIS, CLEARTYPE_QUALITY,
-        FF_DONTCARE, TEXT("Minecraft"));
+    if (pFamily->bRegistered)
+        return;
+    pFamily->bRegistered = TRUE;
 
-    if (!hHeavyFont)
+    pFamily->hMemFont = AddPackedFont(pFamily->pszPackedTtf);
+    if (!pFamily->hMemFont && GetExeDirectory(fontPath, MAX_PATH))
     {
-        const TCHAR* heavyFallbacks[] = {
-            TEXT("Minecraft Regular"), TEXT("Lucida Console"), TEXT("Courier New"), NULL
-        };
-        
-        for (int i = 0; heavyFallbacks[i] && !hHeavyFont; i++)
-        {
-            hHeavyFont = CreateFont(-40, 0, 0, 0, FW_BOLD, FALSE, FALSE, FALSE,
-                DEFAULT_CHARSET, OUT_OUTLINE_PRECIS, CLIP_DEFAULT_PRECIS, CLEARTYPE_QUALITY,
-                FF_DONTCARE, heavyFallbacks[i]);
-        }
+        PathCombine(fontPath, fontPath, pFamily->pszTtfFile);
+        if (PathFileExists(fontPath))
+            pFamily->bFileFont = AddFontResourceEx(fontPath, FR_PRIVATE, NULL) > 0;
     }
+}
 
-    hHeavyBtnFont = CreateFont(-24, 0, 0, 0, FW_BOLD, FALSE, FALSE, FALSE,
-        DEFAULT_CHARSET, OUT_OUTLINE_PRECIS, CLIP_DEFAULT_PRECIS, CLEARTYPE_QUALITY,
-        FF_DONTCARE, TEXT("Minecraft"));
+static void UnregisterFontFamily(FONTFAMILY* pFamily)
+{
+    TCHAR fontPath[MAX_PATH];
 
-    if (!hHeavyBtnFont)
+    if (pFamily->hMemFont)
+        RemoveFontMemResourceEx(pFamily->hMemFont);
+    if (pFamily->bFileFont && GetExeDirectory(fontPath, MAX_PATH))
     {
-        const TCHAR* heavyBtnFallbacks[] = {
-            TEXT("Minecraft Regular"), TEXT("Lucida Console"), TEXT("Courier New"), NULL
-        };
-        
-        for (int i = 0; heavyBtnFallbacks[i] && !hHeavyBtnFont; i++)
-        {
-            hHeavyBtnFont = CreateFont(-24, 0, 0, 0, FW_BOLD, FALSE, FALSE, FALSE,
-                DEFAULT_CHARSET, OUT_OUTLINE_PRECIS, CLIP_DEFAULT_PRECIS, CLEARTYPE_QUALITY,
-                FF_DONTCARE, heavyBtnFallbacks[i]);
-        }
+        PathCombine(fontPath, fontPath, pFamily->pszTtfFile);
+        RemoveFontResourceEx(fontPath, FR_PRIVATE, NULL);
     }
+    pFamily->hMemFont = NULL;
+    pFamily->bFileFont = FALSE;
+    pFamily->bRegistered = FALSE;
+}
 
-    const TCHAR* lightFontNames[] = {
-        TEXT("Dogica"), TEXT("Dogica Pixel"), TEXT("Dogica Bold"), 
-        TEXT("Dogica Regular"), TEXT("Courier New"), NULL
-    };
+// Creates the font the first time it is asked for. Face names are tried
+// from the one that last worked for the family; the stock GUI font stands
+// in if none do.
+HFONT GetClockFont(int iFont)
+{
+    CLOCKFONT* pFont = &g_fonts[iFont];
+    FONTFAMILY* pFamily = &g_fontFamilies[pFont->iFamily];
+    int i;
 
-    for (int i = 0; lightFontNames[i] && !hLightFont; i++)
-    {
-        hLightFont = CreateFont(-24, 0, 0, 0, FW_BOLD, FALSE, FALSE, FALSE,
-            DEFAULT_CHARSET, OUT_OUTLINE_PRECIS, CLIP_DEFAULT_PRECIS, CLEARTYPE_QUALITY,
-            FF_DONTCARE, lightFontNames[i]);
-    }
+    if (pFont->hFont)
+        return pFont->hFont;
 
-    for (int i = 0; lightFontNames[i] && !hLightBtnFont; i++)
+    StartProfBegin(&g_startProf, pFont->pszPhase);
+    RegisterFontFamily(pFamily);
+    for (i = pFamily->iFace < 0 ? 0 : pFamily->iFace; pFamily->pszFaces[i] && !pFont->hFont; i++)
     {
-        hLightBtnFont = CreateFont(-16, 0, 0, 0, FW_BOLD, FALSE, FALSE, FALSE,
+        pFont->hFont = CreateFont(-pFont->iHeight, 0, 0, 0, FW_BOLD, FALSE, FALSE, FALSE,
             DEFAULT_CHARSET, OUT_OUTLINE_PRECIS, CLIP_DEFAULT_PRECIS, CLEARTYPE_QUALITY,
-            FF_DONTCARE, lightFontNames[i]);
+            FF_DONTCARE, pFamily->pszFaces[i]);
+        if (pFont->hFont)
+            pFamily->iFace = i;
     }
+    if (!pFont->hFont)
+        pFont->hFont = (HFONT)GetStockObject(DEFAULT_GUI_FONT);
+    StartProfEnd(&g_startProf);
+    return pFont->hFont;
+}
 
-    if (!hLightFont)
-    {
-        hLightFont = CreateFont(-24, 0, 0, 0, FW_BOLD, FALSE, FALSE, FALSE,
-            DEFAULT_CHARSET, OUT_OUTLINE_PRECIS, CLIP_DEFAULT_PRECIS, CLEARTYPE_QUALITY,
-            FF_DONTCARE, TEXT("Courier New"));
-    }
-    
-    if (!hLightBtnFont)
-    {
-        hLightBtnFont = CreateFont(-16, 0, 0, 0, FW_BOLD, FALSE, FALSE, FALSE,
-            DEFAULT_CHARSET, OUT_OUTLINE_PRECIS, CLIP_DEFAULT_PRECIS, CLEARTYPE_QUALITY,
-            FF_DONTCARE, TEXT("Courier New"));
-    }
+// Only the face and button fonts the clock starts with are made here; the
+// other pair waits until the font button is pressed
+BOOL LoadFonts()
+{
+    HFONT hStock = (HFONT)GetStockObject(DEFAULT_GUI_FONT);
 
-    return (hHeavyFont && hHeavyBtnFont && hLightFont && hLightBtnFont);
+    return GetClockFont(g_bUseLightFont ? FONT_LIGHT : FONT_HEAVY) != hStock &&
+        GetClockFont(g_bUseLightFont ? FONT_LIGHT_BTN : FONT_HEAVY_BTN) != hStock;
 }
 
 void FreeResources()
 {
-    // Remove temporary font resources
-    TCHAR fontPath[MAX_PATH];
-    if (GetExeDirectory(fontPath, MAX_PATH))
+    int i;
+
+    FreeFaceCache();
+    FreeLabelAtlases();
+    FreeGrid();
+    FreeAlarms();
+    FreeTickSound();
+    FrameShmClose(&g_frameShm);
+
+    // Delete font objects, then the private fonts they were made from
+    for (i = 0; i < FONT_COUNT; i++)
     {
-        TCHAR mcPath[MAX_PATH];
-        PathCombine(mcPath, fontPath, TEXT("Minecraft.ttf"));
-        if (PathFileExists(mcPath))
-        {
-            RemoveFontResourceEx(mcPath, FR_PRIVATE, NULL);
-        }
-        
-        TCHAR dogicaPath[MAX_PATH];
-        PathCombine(dogicaPath, fontPath, TEXT("Dogica.ttf"));
-        if (PathFileExists(dogicaPath))
-        {
-            RemoveFontResourceEx(dogicaPath, FR_PRIVATE, NULL);
-        }
+        if (g_fonts[i].hFont && g_fonts[i].hFont != (HFONT)GetStockObject(DEFAULT_GUI_FONT))
+            DeleteObject(g_fonts[i].hFont);
+        g_fonts[i].hFont = NULL;
     }
-
-    // Delete font objects
-    if (hHeavyFont && hHeavyFont != (HFONT)GetStockObject(DEFAULT_GUI_FONT))
-        DeleteObject(hHeavyFont);
-    if (hHeavyBtnFont && hHeavyBtnFont != (HFONT)GetStockObject(DEFAULT_GUI_FONT))
-        DeleteObject(hHeavyBtnFont);
-    if (hLightFont && hLightFont != (HFONT)GetStockObject(DEFAULT_GUI_FONT))
-        DeleteObject(hLightFont);
-    if (hLightBtnFont && hLightBtnFont != (HFONT)GetStockObject(DEFAULT_GUI_FONT))
-        DeleteObject(hLightBtnFont);
+    for (i = 0; i < FAMILY_COUNT; i++)
+        UnregisterFontFamily(&g_fontFamilies[i]);
 
     // Clean up icons
     if (hSoundOnIcon && hSoundOnIcon != LoadIcon(NULL, IDI_INFORMATION))
         DestroyIcon(hSoundOnIcon);
     if (hSoundOffIcon && hSoundOffIcon != LoadIcon(NULL, IDI_WARNING))
         DestroyIcon(hSoundOffIcon);
+    hSoundOnIcon = NULL;
+    hSoundOffIcon = NULL;
+
+    CloseAssetPack();
 }
 
-void UpdateButtonFonts(HWND hwnd)
-{
-    HFONT hCurrentBtnFont = g_bUseLightFont ? hLightBtnFont : hHeavyBtnFont;
-    
-    if (hBtnRomanMode)
-        SendMessage(hBtnRomanMode, WM_SETFONT, (WPARAM)hCurrentBtnFont, TRUE);
-    if (hBtnDarkMode)
-        SendMessage(hBtnDarkMode, WM_SETFONT, (WPARAM)hCurrentBtnFont, TRUE);
-    if (hBtnFontSwitch)
-        SendMessage(hBtnFontSwitch, WM_SETFONT, (WPARAM)hCurrentBtnFont, TRUE);
-    if (hBtnDots)
-        SendMessage(hBtnDots, WM_SETFONT, (WPARAM)hCurrentBtnFont, TRUE);
-    if (hBtnMystery)
-        SendMessage(hBtnMystery, WM_SETFONT, (WPARAM)hCurrentBtnFont, TRUE);
-    
-    InvalidateRect(hBtnRomanMode, NULL, TRUE);
-    InvalidateRect(hBtnDarkMode, NULL, TRUE);
-    InvalidateRect(hBtnFontSwitch, NULL, TRUE);
-    InvalidateRect(hBtnDots, NULL, TRUE);
-    InvalidateRect(hBtnMystery, NULL, TRUE);
+// ShellExecute needs a real file, so a packed asset is copied out to the
+// temp directory when it is opened
+static BOOL ExtractAssetToTemp(const char* pszName, const TCHAR* pszFile, TCHAR* pszOut)
+{
+    const void* pData;
+    DWORD cb, cbWritten = 0;
+    HANDLE hFile;
+    TCHAR tempDir[MAX_PATH];
+    BOOL bOk;
+
+    pData = GetAsset(pszName, &cb);
+    if (!pData || !GetTempPath(MAX_PATH, tempDir))
+        return FALSE;
+    PathCombine(pszOut, tempDir, pszFile);
+
+    hFile = CreateFile(pszOut, GENERIC_WRITE, 0, NULL, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (hFile == INVALID_HANDLE_VALUE)
+        return PathFileExists(pszOut);     // still open in the player from last time
+
+    bOk = WriteFile(hFile, pData, cb, &cbWritten, NULL) && cbWritten == cb;
+    CloseHandle(hFile);
+    return bOk;
 }
 
 void PlayMysteryVideo()
@@ -335,7 +1096,8 @@ void PlayMysteryVideo()
         TCHAR videoPath[MAX_PATH];
         PathCombine(videoPath, exePath, TEXT("ASTELLION.mp4"));
         
-        if (PathFileExists(videoPath))
+        if (PathFileExists(videoPath) ||
+            ExtractAssetToTemp("ASTELLION.mp4", TEXT("ASTELLION.mp4"), videoPath))
         {
             ShellExecute(NULL, TEXT("open"), videoPath, NULL, NULL, SW_SHOWNORMAL);
         }
@@ -357,122 +1119,1558 @@ void PlayMysteryVideo()
 
 void SetIsotropic(HDC hdc, int cxClient, int cyClient)
 {
-    int iScale = (cxClient < cyClient ? cxClient : cyClient) / 2;
-    if (iScale == 0) iScale = 1;
+    int iScale = IsoScale(cxClient, cyClient);
 
     SetMapMode(hdc, MM_ISOTROPIC);
-    SetWindowExtEx(hdc, 600, 600, NULL);
+    SetWindowExtEx(hdc, ISO_WINDOW_EXT, ISO_WINDOW_EXT, NULL);
     SetViewportExtEx(hdc, iScale, -iScale, NULL);
     SetViewportOrgEx(hdc, cxClient / 2, cyClient / 2, NULL);
 }
 
+// Rotates clockwise by whole degrees using the Q16 sine table in rotate.c.
+// POINT is two 32-bit LONGs on Win32, the same layout as ROTPOINT.
 void RotatePoint(POINT pt[], int iNum, int iAngle)
 {
-    int i;
-    POINT ptTemp;
-
-    for (i = 0; i < iNum; i++)
-    {
-        ptTemp.x = (int)(pt[i].x * cos(TWOPI * iAngle / 360) +
-            pt[i].y * sin(TWOPI * iAngle / 360));
-        ptTemp.y = (int)(pt[i].y * cos(TWOPI * iAngle / 360) -
-            pt[i].x * sin(TWOPI * iAngle / 360));
-        pt[i] = ptTemp;
-    }
+    RotatePoints((ROTPOINT*)pt, iNum, iAngle * ROT_STEPS_PER_DEGREE);
 }
 
-void DrawClock(HDC hdc)
+// GDI implementation of CLOCKBACKEND. The brush and pen are recreated only
+// when the color changes and are released by EndGdiBackend.
+typedef struct
 {
-    int iAngle;
-    POINT pt[3];
+    HDC hdc;
+    HFONT hFont;
     HBRUSH hBrush, hOldBrush;
-    HFONT hOldFont = NULL;
-    HFONT hCurrentFont = g_bUseLightFont ? hLightFont : hHeavyFont;
-
-    hBrush = CreateSolidBrush(g_bDarkMode ? RGB(255, 255, 255) : RGB(0, 0, 0));
-    hOldBrush = SelectObject(hdc, hBrush);
+    HPEN hPen, hOldPen;
+    uint32_t crBrush, crPen;
+} GDIBACKEND;
 
-    if (g_bShowDots)
-    {
-        for (iAngle = 0; iAngle < 360; iAngle += 6)
-        {
-            pt[0].x = 0;
-            pt[0].y = 500;
+static COLORREF ToColorRef(uint32_t color)
+{
+    return RGB((color >> 16) & 0xFF, (color >> 8) & 0xFF, color & 0xFF);
+}
 
-            RotatePoint(pt, 1, iAngle);
+static void GdiDisc(void* pCtx, int left, int top, int right, int bottom, uint32_t color)
+{
+    GDIBACKEND* pGdi = (GDIBACKEND*)pCtx;
 
-            pt[2].x = pt[2].y = iAngle % 5 ? 18 : 55;
+    if (!pGdi->hBrush || pGdi->crBrush != color)
+    {
+        HBRUSH hBrush = CreateSolidBrush(ToColorRef(color));
+        HBRUSH hPrev = SelectObject(pGdi->hdc, hBrush);
+        if (pGdi->hBrush)
+            DeleteObject(pGdi->hBrush);
+        else
+            pGdi->hOldBrush = hPrev;
+        pGdi->hBrush = hBrush;
+        pGdi->crBrush = color;
+    }
+    Ellipse(pGdi->hdc, left, top, right, bottom);
+}
+
+static void GdiPolyline(void* pCtx, const ROTPOINT pt[], int iNum, int iWidth, uint32_t color)
+{
+    GDIBACKEND* pGdi = (GDIBACKEND*)pCtx;
+
+    if (!pGdi->hPen || pGdi->crPen != color)
+    {
+        HPEN hPen = CreatePen(PS_SOLID, iWidth, ToColorRef(color));
+        HPEN hPrev = SelectObject(pGdi->hdc, hPen);
+        if (pGdi->hPen)
+            DeleteObject(pGdi->hPen);
+        else
+            pGdi->hOldPen = hPrev;
+        pGdi->hPen = hPen;
+        pGdi->crPen = color;
+    }
+    // ROTPOINT has the same layout as POINT
+    Polyline(pGdi->hdc, (const POINT*)pt, iNum);
+}
+
+static void GdiText(void* pCtx, int x, int y, const char* psz, int iHeight, uint32_t color)
+{
+    GDIBACKEND* pGdi = (GDIBACKEND*)pCtx;
+    HFONT hOldFont;
+    TCHAR buf[STOPWATCH_TEXT_CHARS];
+    SIZE sz;
+    int i;
+
+    // The font already has the right height; iHeight is for other backends
+    (void)iHeight;
+    if (!pGdi->hFont)
+        return;
+
+    // The stopwatch readouts are the longest text drawn
+    for (i = 0; psz[i] && i < STOPWATCH_TEXT_CHARS - 1; i++)
+        buf[i] = (TCHAR)psz[i];
+    buf[i] = 0;
+
+    hOldFont = (HFONT)SelectObject(pGdi->hdc, pGdi->hFont);
+    SetBkMode(pGdi->hdc, TRANSPARENT);
+    SetTextColor(pGdi->hdc, ToColorRef(color));
+    GetTextExtentPoint32(pGdi->hdc, buf, i, &sz);
+    TextOut(pGdi->hdc, x - sz.cx / 2, y - sz.cy / 2, buf, i);
+    SelectObject(pGdi->hdc, hOldFont);
+}
+
+static void BeginGdiBackend(CLOCKBACKEND* pBackend, GDIBACKEND* pGdi, HDC hdc)
+{
+    memset(pGdi, 0, sizeof(*pGdi));
+    pGdi->hdc = hdc;
+    pGdi->hFont = GetClockFont(g_bUseLightFont ? FONT_LIGHT : FONT_HEAVY);
+
+    pBackend->pCtx = pGdi;
+    pBackend->pfnDisc = GdiDisc;
+    pBackend->pfnPolyline = GdiPolyline;
+    pBackend->pfnText = GdiText;
+}
+
+static void EndGdiBackend(GDIBACKEND* pGdi)
+{
+    if (pGdi->hBrush)
+    {
+        SelectObject(pGdi->hdc, pGdi->hOldBrush);
+        DeleteObject(pGdi->hBrush);
+    }
+    if (pGdi->hPen)
+    {
+        SelectObject(pGdi->hdc, pGdi->hOldPen);
+        DeleteObject(pGdi->hPen);
+    }
+}
+
+static void FreeLabelAtlas(LABELATLAS* pLabels)
+{
+    if (pLabels->hdcMem)
+    {
+        if (pLabels->hOldBitmap)
+            SelectObject(pLabels->hdcMem, pLabels->hOldBitmap);
+        if (pLabels->hOldFont)
+            SelectObject(pLabels->hdcMem, pLabels->hOldFont);
+        DeleteDC(pLabels->hdcMem);
+    }
+    if (pLabels->hBitmap)
+        DeleteObject(pLabels->hBitmap);
+    if (pLabels->hFont && pLabels->bOwnFont)
+        DeleteObject(pLabels->hFont);
+    memset(pLabels, 0, sizeof(*pLabels));
+}
+
+void FreeLabelAtlases(void)
+{
+    FreeLabelAtlas(&g_faceAtlas);
+    FreeLabelAtlas(&g_btnAtlas);
+}
+
+static void AtlasMeasure(void* pCtx, const char* psz, int* pcx, int* pcy)
+{
+    LABELATLAS* pLabels = (LABELATLAS*)pCtx;
+    SIZE sz;
+
+    GetTextExtentPoint32A(pLabels->hdcMem, psz, (int)strlen(psz), &sz);
+    *pcx = sz.cx;
+    *pcy = sz.cy;
+}
+
+static void AtlasDraw(void* pCtx, const char* psz, uint32_t color, int x, int y)
+{
+    LABELATLAS* pLabels = (LABELATLAS*)pCtx;
+
+    SetTextColor(pLabels->hdcMem, ToColorRef(color));
+    TextOutA(pLabels->hdcMem, x, y, psz, (int)strlen(psz));
+}
+
+// Packs and draws the entries already added to pLabels->atlas with hFont.
+// Takes ownership of hFont when bOwnFont is set, even on failure.
+static BOOL RenderLabelAtlas(LABELATLAS* pLabels, HDC hdc, HFONT hFont, BOOL bOwnFont)
+{
+    GLYPHSOURCE source = { pLabels, AtlasMeasure, AtlasDraw };
+    HBRUSH hBrush;
+    RECT rect;
+
+    pLabels->hFont = hFont;
+    pLabels->bOwnFont = bOwnFont;
+    pLabels->hdcMem = hFont ? CreateCompatibleDC(hdc) : NULL;
+    if (!pLabels->hdcMem)
+        return FALSE;
+    pLabels->hOldFont = (HFONT)SelectObject(pLabels->hdcMem, hFont);
+
+    GlyphAtlasPack(&pLabels->atlas, &source, 512);
+
+    pLabels->hBitmap = CreateCompatibleBitmap(hdc, pLabels->atlas.cx, pLabels->atlas.cy);
+    if (!pLabels->hBitmap)
+        return FALSE;
+    pLabels->hOldBitmap = (HBITMAP)SelectObject(pLabels->hdcMem, pLabels->hBitmap);
+
+    SetRect(&rect, 0, 0, pLabels->atlas.cx, pLabels->atlas.cy);
+    hBrush = CreateSolidBrush(ToColorRef(pLabels->atlas.bgColor));
+    FillRect(pLabels->hdcMem, &rect, hBrush);
+    DeleteObject(hBrush);
+
+    SetBkMode(pLabels->hdcMem, TRANSPARENT);
+    GlyphAtlasRender(&pLabels->atlas, &source);
+    return TRUE;
+}
+
+// Glyphs drawn over white are darker than it and over black lighter, so
+// AND or OR puts them on the face without touching the dots around them
+static DWORD AtlasRop(uint32_t bgColor)
+{
+    if (bgColor == CLOCK_WHITE)
+        return SRCAND;
+    if (bgColor == CLOCK_BLACK)
+        return SRCPAINT;
+    return SRCCOPY;
+}
+
+// Face numerals as twelve blits from the atlas. Returns FALSE if the atlas
+// cannot be built; the caller then draws them as text.
+static BOOL DrawAtlasNumerals(HDC hdc, const CLOCKSTYLE* pStyle, int cxClient, int cyClient)
+{
+    HFONT hBase = GetClockFont(pStyle->bUseLightFont ? FONT_LIGHT : FONT_HEAVY);
+    int iFont = ATLAS_FONT_FACE + (pStyle->bUseLightFont ? 1 : 0);
+    int iHeight = (pStyle->bUseLightFont ? CLOCK_LIGHT_TEXT_HEIGHT : CLOCK_HEAVY_TEXT_HEIGHT) *
+        IsoScale(cxClient, cyClient) / ISO_WINDOW_EXT;
+    uint32_t bgColor = ClockBackground(pStyle);
+    const ATLASENTRY* pEntry;
+    DWORD dwRop;
+    LOGFONT lf;
+    BOOL bBuilt;
+    int i;
+
+    if (!hBase || iHeight <= 0)
+        return FALSE;
+
+    if (!GlyphAtlasMatches(&g_faceAtlas.atlas, iFont, iHeight, bgColor))
+    {
+        // The face font is sized in logical units; the atlas needs pixels
+        FreeLabelAtlas(&g_faceAtlas);
+        if (!GetObject(hBase, sizeof(lf), &lf))
+            return FALSE;
+        lf.lfHeight = -iHeight;
+
+        GlyphAtlasInit(&g_faceAtlas.atlas, iFont, iHeight, bgColor);
+        GlyphAtlasAddNumerals(&g_faceAtlas.atlas, ClockForeground(pStyle));
+        StartProfBegin(&g_startProf, "label_atlas");
+        bBuilt = RenderLabelAtlas(&g_faceAtlas, hdc, CreateFontIndirect(&lf), TRUE);
+        StartProfEnd(&g_startProf);
+        if (!bBuilt)
+        {
+            FreeLabelAtlas(&g_faceAtlas);
+            return FALSE;
+        }
+    }
+
+    if (!g_faceAtlas.bPlaced || g_faceAtlas.cxClient != cxClient || g_faceAtlas.cyClient != cyClient ||
+        g_faceAtlas.bRomanMode != pStyle->bRomanMode)
+    {
+        g_faceAtlas.bPlaced = GlyphAtlasPlaceNumerals(&g_faceAtlas.atlas, pStyle->bRomanMode,
+            ClockForeground(pStyle), cxClient, cyClient, g_faceAtlas.place);
+        g_faceAtlas.cxClient = cxClient;
+        g_faceAtlas.cyClient = cyClient;
+        g_faceAtlas.bRomanMode = pStyle->bRomanMode;
+        if (!g_faceAtlas.bPlaced)
+            return FALSE;
+    }
+
+    // The places are in device pixels
+    SaveDC(hdc);
+    SetMapMode(hdc, MM_TEXT);
+    SetViewportOrgEx(hdc, 0, 0, NULL);
+    dwRop = AtlasRop(bgColor);
+    for (i = 0; i < 12; i++)
+    {
+        pEntry = &g_faceAtlas.atlas.entries[g_faceAtlas.place[i].iEntry];
+        BitBlt(hdc, g_faceAtlas.place[i].x, g_faceAtlas.place[i].y, pEntry->cx, pEntry->cy,
+            g_faceAtlas.hdcMem, pEntry->x, pEntry->y, dwRop);
+    }
+    RestoreDC(hdc, -1);
+    return TRUE;
+}
+
+// The mystery button's "???", one color per character
+static const uint32_t mysteryColors[3] = {
+    CLOCK_RGB(255, 0, 0), CLOCK_RGB(0, 255, 0), CLOCK_RGB(0, 0, 255)
+};
+
+static BOOL DrawAtlasMystery(HDC hdc, const RECT* prcItem)
+{
+    HFONT hFont = GetClockFont(g_bUseLightFont ? FONT_LIGHT_BTN : FONT_HEAVY_BTN);
+    int iFont = ATLAS_FONT_BUTTON + (g_bUseLightFont ? 1 : 0);
+    int iHeight = g_bUseLightFont ? BTN_LIGHT_TEXT_HEIGHT : BTN_HEAVY_TEXT_HEIGHT;
+    COLORREF crFace = GetSysColor(COLOR_BTNFACE);
+    uint32_t bgColor = CLOCK_RGB(GetRValue(crFace), GetGValue(crFace), GetBValue(crFace));
+    const ATLASENTRY* pEntry;
+    int i, x, y;
+
+    if (!GlyphAtlasMatches(&g_btnAtlas.atlas, iFont, iHeight, bgColor))
+    {
+        FreeLabelAtlas(&g_btnAtlas);
+        GlyphAtlasInit(&g_btnAtlas.atlas, iFont, iHeight, bgColor);
+        for (i = 0; i < 3; i++)
+            GlyphAtlasAdd(&g_btnAtlas.atlas, "?", mysteryColors[i]);
+        if (!RenderLabelAtlas(&g_btnAtlas, hdc, hFont, FALSE))
+        {
+            FreeLabelAtlas(&g_btnAtlas);
+            return FALSE;
+        }
+    }
+
+    // Each character a third of the way along "???", centered in the button
+    pEntry = &g_btnAtlas.atlas.entries[0];
+    x = prcItem->left + (prcItem->right - prcItem->left - pEntry->cx * 3) / 2;
+    y = prcItem->top + (prcItem->bottom - prcItem->top - pEntry->cy) / 2;
+    for (i = 0; i < 3; i++)
+    {
+        pEntry = &g_btnAtlas.atlas.entries[i];
+        BitBlt(hdc, x + i * pEntry->cx, y, pEntry->cx, pEntry->cy,
+            g_btnAtlas.hdcMem, pEntry->x, pEntry->y, AtlasRop(bgColor));
+    }
+    return TRUE;
+}
+
+// The face toggles as a CLOCKSTYLE for the portable drawing code
+static void GetClockStyle(CLOCKSTYLE* pStyle)
+{
+    pStyle->bDarkMode = g_bDarkMode;
+    pStyle->bRomanMode = g_bRomanMode;
+    pStyle->bUseLightFont = g_bUseLightFont;
+    pStyle->bShowDots = g_bShowDots;
+}
+
+void DrawClock(HDC hdc, int cxClient, int cyClient)
+{
+    CLOCKBACKEND backend;
+    GDIBACKEND gdi;
+    CLOCKSTYLE style;
+
+    uint64_t qwStart = PhaseNowNs();
+
+    GetClockStyle(&style);
+    BeginGdiBackend(&backend, &gdi, hdc);
+    ClockDrawDots(&backend, &style);
+    PhaseLap(&g_phaseStats, PHASE_DOTS, &qwStart);
+    if (!DrawAtlasNumerals(hdc, &style, cxClient, cyClient))
+        ClockDrawLabels(&backend, &style);
+    EndGdiBackend(&gdi);
+    PhaseLap(&g_phaseStats, PHASE_LABELS, &qwStart);
+}
+
+// Rotated outlines of the hour, minute and second hands for *pst
+void ComputeHands(SYSTEMTIME * pst, POINT ptHands[3][5])
+{
+    ClockComputeHands(pst->wHour, pst->wMinute, pst->wSecond, (ROTPOINT(*)[CLOCK_HAND_POINTS])ptHands);
+}
+
+void DrawHands(HDC hdc, SYSTEMTIME * pst, BOOL fChange)
+{
+    CLOCKBACKEND backend;
+    GDIBACKEND gdi;
+    CLOCKSTYLE style;
+
+    GetClockStyle(&style);
+    BeginGdiBackend(&backend, &gdi, hdc);
+    ClockDrawHands(&backend, &style, pst->wHour, pst->wMinute, pst->wSecond, fChange);
+    EndGdiBackend(&gdi);
+}
+
+// Grows *pDamage by the device-space boxes of the hands at *pst. Only the
+// second hand counts unless fChange says the hour or minute moved as well.
+void AddHandDamage(DAMAGERECT * pDamage, SYSTEMTIME * pst, BOOL fChange, int cxClient, int cyClient)
+{
+    int i;
+    POINT ptHands[3][5];
+    DAMAGERECT rcHand;
+
+    ComputeHands(pst, ptHands);
+
+    for (i = fChange ? 0 : 2; i < 3; i++)
+    {
+        DamageFromPolygon(&rcHand, (ROTPOINT*)ptHands[i], 5, cxClient, cyClient, 2);
+        DamageUnion(pDamage, &rcHand);
+    }
+}
+
+// System time in microseconds since 1970, for the tick scheduler
+static uint64_t WallClockUs(void* pCtx)
+{
+    (void)pCtx;
+    return (uint64_t)TimeSourceUtcUs();
+}
+
+// Whole UTC seconds since 1970
+static int64_t UtcSeconds(void)
+{
+    return TimeSourceUtcUs() / 1000000;
+}
+
+void ReportTickSchedStats(void)
+{
+    char buf[512];
+
+    if (!g_tickSched.dwTicks)
+        return;
+
+    TickSchedFormat(&g_tickSched, buf, sizeof(buf) - 1);
+    strcat(buf, "\n");
+    OutputDebugStringA(buf);
+}
+
+// GetLocalTime without converting from UTC on every call
+void GetClockTime(SYSTEMTIME * pst)
+{
+    WALLTIME wt;
+
+    TimeSourceNow(&g_timeSource, &wt);
+    pst->wYear = (WORD)wt.iYear;
+    pst->wMonth = (WORD)wt.iMonth;
+    pst->wDayOfWeek = (WORD)wt.iDayOfWeek;
+    pst->wDay = (WORD)wt.iDay;
+    pst->wHour = (WORD)wt.iHour;
+    pst->wMinute = (WORD)wt.iMinute;
+    pst->wSecond = (WORD)wt.iSecond;
+    pst->wMilliseconds = (WORD)wt.iMilliseconds;
+}
+
+void ReportFramePacerStats(void)
+{
+    char buf[256];
+
+    if (g_iSweepMode == SWEEP_OFF)
+        return;
+
+    FramePacerFormat(&g_framePacer, buf, sizeof(buf) - 1);
+    strcat(buf, "\n");
+    OutputDebugStringA(buf);
+}
+
+void ReportTimeSourceStats(void)
+{
+    char buf[256];
+
+    TimeSourceFormat(&g_timeSource, buf, sizeof(buf) - 1);
+    strcat(buf, "\n");
+    OutputDebugStringA(buf);
+}
+
+static LONGLONG PerfNow(void)
+{
+    LARGE_INTEGER li;
+    QueryPerformanceCounter(&li);
+    return li.QuadPart;
+}
+
+// Called when a face toggle changes: the next published frame goes out
+// whole. The face cache needs nothing, since faces are keyed on the
+// toggles; those for the old look stay until the budget pushes them out,
+// and flipping back is a copy.
+void MarkPublishFull(void)
+{
+    g_bPublishFull = TRUE;
+}
+
+// Draws *pst with the software rasterizer straight into the next slot of
+// the ring, with the damage since the last published tick
+void PublishTick(SYSTEMTIME * pst)
+{
+    CLOCKSTYLE style;
+    FRAMEBUFFER fb;
+    FRAMETIME time;
+    DAMAGERECT damage;
+    BOOL fChange = pst->wHour != g_stPublished.wHour || pst->wMinute != g_stPublished.wMinute;
+
+    if (!g_frameShm.pHeader)
+        return;
+
+    DamageEmpty(&damage);
+    AddHandDamage(&damage, &g_stPublished, fChange, PUBLISH_SIZE, PUBLISH_SIZE);
+    AddHandDamage(&damage, pst, fChange, PUBLISH_SIZE, PUBLISH_SIZE);
+    DamageClip(&damage, PUBLISH_SIZE, PUBLISH_SIZE);
+
+    GetClockStyle(&style);
+    FrameShmBeginWrite(&g_frameShm, &fb);
+    RasterDrawClock(&fb, &style, pst->wHour, pst->wMinute, pst->wSecond);
+
+    // FRAMETIME has the layout of SYSTEMTIME
+    memcpy(&time, pst, sizeof(time));
+    FrameShmPublish(&g_frameShm, &time, g_bPublishFull ? NULL : &damage);
+    g_bPublishFull = FALSE;
+    g_stPublished = *pst;
+}
+
+void FreeFaceBitmap(void* pCtx, void* pFace)
+{
+    (void)pCtx;
+    if ((HBITMAP)pFace == g_hbmFaceSelected)
+    {
+        SelectObject(g_hdcFace, g_hbmFaceOld);
+        g_hbmFaceSelected = NULL;
+    }
+    DeleteObject((HBITMAP)pFace);
+}
+
+void FreeFaceCache(void)
+{
+    FaceCacheFree(&g_faceCache);
+    if (g_hdcFace)
+    {
+        DeleteDC(g_hdcFace);
+        g_hdcFace = NULL;
+    }
+}
+
+static uint32_t FaceStyle(void)
+{
+    return (g_bDarkMode ? FACE_DARK : 0) | (g_bRomanMode ? FACE_ROMAN : 0) |
+        (g_bUseLightFont ? FACE_LIGHT : 0) | (g_bShowDots ? FACE_DOTS : 0);
+}
+
+// The memory DC the faces are copied from, created on first use
+static HDC FaceDC(HDC hdc)
+{
+    if (!g_hdcFace && (g_hdcFace = CreateCompatibleDC(hdc)) != NULL)
+        g_hbmFaceOld = (HBITMAP)GetCurrentObject(g_hdcFace, OBJ_BITMAP);
+    return g_hdcFace;
+}
+
+// The memory DC with the face's bitmap selected
+static HDC SelectFace(HDC hdc, const FACEENTRY * pEntry)
+{
+    if (!FaceDC(hdc))
+        return NULL;
+    if (g_hbmFaceSelected != (HBITMAP)pEntry->pFace)
+    {
+        SelectObject(g_hdcFace, (HBITMAP)pEntry->pFace);
+        g_hbmFaceSelected = (HBITMAP)pEntry->pFace;
+    }
+    return g_hdcFace;
+}
+
+// Draws the face for a cxClient by cyClient client into a new bitmap and
+// adds it to the cache
+static FACEENTRY* RenderFace(HDC hdc, int cxClient, int cyClient)
+{
+    FACEENTRY* pEntry;
+    HBITMAP hBitmap;
+    HDC hdcMem;
+    RECT rect;
+    uint64_t qwStart, qwRender = PhaseNowNs();
+
+    if (!FaceDC(hdc) || !(hBitmap = CreateCompatibleBitmap(hdc, cxClient, cyClient)))
+        return NULL;
+    pEntry = FaceCacheInsert(&g_faceCache, cxClient, cyClient, FaceStyle(), hBitmap);
+    hdcMem = SelectFace(hdc, pEntry);
+
+    StartProfBegin(&g_startProf, "face_cache");
+    qwStart = PhaseNowNs();
+    SetRect(&rect, 0, 0, cxClient, cyClient);
+    FillRect(hdcMem, &rect, (HBRUSH)GetStockObject(g_bDarkMode ? BLACK_BRUSH : WHITE_BRUSH));
+    PhaseLap(&g_phaseStats, PHASE_CLEAR, &qwStart);
+
+    SetIsotropic(hdcMem, cxClient, cyClient);
+    PhaseLap(&g_phaseStats, PHASE_ISOTROPIC, &qwStart);
+    DrawClock(hdcMem, cxClient, cyClient);
+
+    // Back to device units so BitBlt can copy pixel for pixel
+    SetMapMode(hdcMem, MM_TEXT);
+    SetViewportOrgEx(hdcMem, 0, 0, NULL);
+    StartProfEnd(&g_startProf);
+
+    g_faceCache.qwRenderNs += PhaseNowNs() - qwRender;
+    return pEntry;
+}
+
+// Copies the face to hdc (which must be in MM_TEXT), rendering it first
+// if no face was cached for this size and these face toggles. Only the
+// part inside prcDirty is copied, or all of it if prcDirty is NULL.
+void DrawCachedFace(HDC hdc, int cxClient, int cyClient, const RECT * prcDirty)
+{
+    FACEENTRY* pEntry;
+    HDC hdcMem;
+    RECT rcCopy;
+    uint64_t qwStart;
+
+    if (cxClient <= 0 || cyClient <= 0)
+        return;
+
+    SetRect(&rcCopy, 0, 0, cxClient, cyClient);
+    if (prcDirty && !IntersectRect(&rcCopy, &rcCopy, prcDirty))
+        return;
+
+    qwStart = PhaseNowNs();
+    if ((pEntry = FaceCacheFind(&g_faceCache, cxClient, cyClient, FaceStyle())) != NULL)
+    {
+        hdcMem = SelectFace(hdc, pEntry);
+        BitBlt(hdc, rcCopy.left, rcCopy.top, rcCopy.right - rcCopy.left, rcCopy.bottom - rcCopy.top,
+            hdcMem, rcCopy.left, rcCopy.top, SRCCOPY);
+        qwStart = PhaseNowNs() - qwStart;
+        g_faceCache.qwBlitNs += qwStart;
+        PhaseRecord(&g_phaseStats, PHASE_FACE_BLIT, qwStart);
+    }
+    else if ((pEntry = RenderFace(hdc, cxClient, cyClient)) != NULL)
+    {
+        BitBlt(hdc, rcCopy.left, rcCopy.top, rcCopy.right - rcCopy.left, rcCopy.bottom - rcCopy.top,
+            g_hdcFace, rcCopy.left, rcCopy.top, SRCCOPY);
+    }
+    else
+    {
+        // No memory for the offscreen bitmap; draw straight to the window
+        RECT rect;
+        SetRect(&rect, 0, 0, cxClient, cyClient);
+        FillRect(hdc, &rect, (HBRUSH)GetStockObject(g_bDarkMode ? BLACK_BRUSH : WHITE_BRUSH));
+        SetIsotropic(hdc, cxClient, cyClient);
+        DrawClock(hdc, cxClient, cyClient);
+        SetMapMode(hdc, MM_TEXT);
+        SetViewportOrgEx(hdc, 0, 0, NULL);
+    }
+
+    if ((g_faceCache.dwHits + g_faceCache.dwScaled + g_faceCache.dwMisses) % 60 == 0)
+        ReportFaceCacheStats();
+}
+
+// A paint during a live resize: the face square stretched from the cached
+// face nearest its size, and only the bands beside it cleared. A face is
+// drawn, at the bucket's square size, only when none is near enough.
+void DrawScaledFace(HDC hdc, int cxClient, int cyClient)
+{
+    HBRUSH hBrush = (HBRUSH)GetStockObject(g_bDarkMode ? BLACK_BRUSH : WHITE_BRUSH);
+    FACEENTRY* pEntry;
+    DAMAGERECT rcDst, rcSrc;
+    RECT rect;
+    HDC hdcMem;
+    int iBucket, iSide;
+    uint64_t qwStart;
+
+    if (cxClient <= 0 || cyClient <= 0)
+        return;
+
+    FaceSquare(cxClient, cyClient, &rcDst);
+    iBucket = FaceBucketIndex(rcDst.right - rcDst.left);
+    pEntry = FaceCacheNearest(&g_faceCache, iBucket, FaceStyle(), FACE_SCALE_STEPS);
+    if (!pEntry)
+    {
+        iSide = FaceBucketSide(iBucket);
+        pEntry = RenderFace(hdc, iSide, iSide);
+    }
+    if (!pEntry || !(hdcMem = SelectFace(hdc, pEntry)))
+    {
+        DrawCachedFace(hdc, cxClient, cyClient, NULL);
+        return;
+    }
+
+    qwStart = PhaseNowNs();
+    SetRect(&rect, 0, 0, cxClient, rcDst.top);
+    FillRect(hdc, &rect, hBrush);
+    SetRect(&rect, 0, rcDst.bottom, cxClient, cyClient);
+    FillRect(hdc, &rect, hBrush);
+    SetRect(&rect, 0, rcDst.top, rcDst.left, rcDst.bottom);
+    FillRect(hdc, &rect, hBrush);
+    SetRect(&rect, rcDst.right, rcDst.top, cxClient, rcDst.bottom);
+    FillRect(hdc, &rect, hBrush);
+
+    // COLORONCOLOR rather than HALFTONE: the frame is thrown away as soon
+    // as the drag moves on, and the full-quality face follows on release
+    FaceSquare(pEntry->cx, pEntry->cy, &rcSrc);
+    SetStretchBltMode(hdc, COLORONCOLOR);
+    StretchBlt(hdc, rcDst.left, rcDst.top, rcDst.right - rcDst.left, rcDst.bottom - rcDst.top,
+        hdcMem, rcSrc.left, rcSrc.top, rcSrc.right - rcSrc.left, rcSrc.bottom - rcSrc.top, SRCCOPY);
+    qwStart = PhaseNowNs() - qwStart;
+    g_faceCache.qwScaleNs += qwStart;
+    PhaseRecord(&g_phaseStats, PHASE_FACE_BLIT, qwStart);
+}
+
+// Writes how often a face was copied, scaled or drawn to the debugger
+void ReportFaceCacheStats(void)
+{
+    char buf[320];
+
+    FaceCacheFormat(&g_faceCache, buf, sizeof(buf) - 1);
+    strcat(buf, "\n");
+    OutputDebugStringA(buf);
+}
+
+// "/grid sites.txt" on the command line switches to the world-time grid.
+// Returns FALSE only when the site list was asked for and cannot be read.
+BOOL LoadGrid(PSTR szCmdLine)
+{
+    const char* pszPath;
+    int n;
+
+    while (*szCmdLine == ' ')
+        szCmdLine++;
+    if (_strnicmp(szCmdLine, "/grid", 5) != 0 && _strnicmp(szCmdLine, "-grid", 5) != 0)
+        return TRUE;
+
+    for (pszPath = szCmdLine + 5; *pszPath == ' '; pszPath++)
+        ;
+
+    g_gridView.pClocks = (CLOCKINSTANCE*)malloc(sizeof(CLOCKINSTANCE) * GRID_MAX_CLOCKS);
+    if (!g_gridView.pClocks)
+        return FALSE;
+
+    n = ClockGridLoad(pszPath, g_gridView.pClocks, GRID_MAX_CLOCKS);
+    if (n <= 0)
+    {
+        FreeGrid();
+        return FALSE;
+    }
+
+    g_gridView.nClocks = n;
+    ClockGridInit(&g_gridView.grid);
+    return TRUE;
+}
+
+void FreeGridSurface(void)
+{
+    if (g_gridView.hdcMem)
+    {
+        SelectObject(g_gridView.hdcMem, g_gridView.hOldBitmap);
+        DeleteDC(g_gridView.hdcMem);
+    }
+    if (g_gridView.hBitmap)
+        DeleteObject(g_gridView.hBitmap);
+
+    g_gridView.hdcMem = NULL;
+    g_gridView.hBitmap = NULL;
+    g_gridView.hOldBitmap = NULL;
+    g_gridView.fb.pPixels = NULL;
+    g_gridView.fb.cx = g_gridView.fb.cy = 0;
+}
+
+void FreeGrid(void)
+{
+    FreeGridSurface();
+    ClockGridFree(&g_gridView.grid);
+    free(g_gridView.pClocks);
+    g_gridView.pClocks = NULL;
+    g_gridView.nClocks = 0;
+}
+
+// Top-down 32-bit DIB section the rasterizer draws into directly
+static BOOL CreateGridSurface(HDC hdc, int cxClient, int cyClient)
+{
+    BITMAPINFO bmi;
+    void* pBits = NULL;
+
+    FreeGridSurface();
+
+    ZeroMemory(&bmi, sizeof(bmi));
+    bmi.bmiHeader.biSize = sizeof(BITMAPINFOHEADER);
+    bmi.bmiHeader.biWidth = cxClient;
+    bmi.bmiHeader.biHeight = -cyClient;
+    bmi.bmiHeader.biPlanes = 1;
+    bmi.bmiHeader.biBitCount = 32;
+    bmi.bmiHeader.biCompression = BI_RGB;
+
+    g_gridView.hBitmap = CreateDIBSection(hdc, &bmi, DIB_RGB_COLORS, &pBits, NULL, 0);
+    g_gridView.hdcMem = CreateCompatibleDC(hdc);
+    if (!g_gridView.hBitmap || !g_gridView.hdcMem || !pBits)
+    {
+        FreeGridSurface();
+        return FALSE;
+    }
+
+    g_gridView.hOldBitmap = (HBITMAP)SelectObject(g_gridView.hdcMem, g_gridView.hBitmap);
+    g_gridView.fb.cx = cxClient;
+    g_gridView.fb.cy = cyClient;
+    g_gridView.fb.pPixels = (uint8_t*)pBits;
+    return TRUE;
+}
+
+// The rasterizer writes RGBA; a DIB wants BGRA
+static void SwapRedBlue(FRAMEBUFFER* pFb)
+{
+    uint8_t* p = pFb->pPixels;
+    uint8_t* pEnd = p + (size_t)pFb->cx * pFb->cy * 4;
+    uint8_t t;
+
+    for (; p < pEnd; p += 4)
+    {
+        t = p[0];
+        p[0] = p[2];
+        p[2] = t;
+    }
+}
+
+void PaintGrid(HDC hdc, int cxClient, int cyClient)
+{
+    int64_t llUtc = UtcSeconds();
+    const CLOCKINSTANCE* pClock;
+    HFONT hOldFont;
+    LONGLONG llStart;
+    int i, x, y;
+
+    if (cxClient <= 0 || cyClient <= 0)
+        return;
+    if (g_gridView.fb.cx != cxClient || g_gridView.fb.cy != cyClient)
+    {
+        if (!CreateGridSurface(hdc, cxClient, cyClient))
+            return;
+    }
+
+    llStart = PerfNow();
+    ClockGridRender(&g_gridView.grid, &g_gridView.fb, g_gridView.pClocks, g_gridView.nClocks,
+        llUtc, CLOCK_RGB(32, 32, 32));
+    SwapRedBlue(&g_gridView.fb);
+    g_gridView.llRenderTicks += PerfNow() - llStart;
+
+    // Site names go on with GDI, which has real fonts
+    hOldFont = (HFONT)SelectObject(g_gridView.hdcMem, GetStockObject(DEFAULT_GUI_FONT));
+    SetBkMode(g_gridView.hdcMem, TRANSPARENT);
+    SetTextAlign(g_gridView.hdcMem, TA_CENTER | TA_BOTTOM);
+    for (i = 0; i < g_gridView.nClocks; i++)
+    {
+        pClock = &g_gridView.pClocks[i];
+        if (!pClock->szLabel[0])
+            continue;
+        ClockGridCell(&g_gridView.grid.layout, i, &x, &y);
+        SetTextColor(g_gridView.hdcMem, ToColorRef(ClockForeground(&pClock->style)));
+        TextOutA(g_gridView.hdcMem, x + g_gridView.grid.layout.iCell / 2,
+            y + g_gridView.grid.layout.iCell, pClock->szLabel, (int)strlen(pClock->szLabel));
+    }
+    SelectObject(g_gridView.hdcMem, hOldFont);
+
+    BitBlt(hdc, 0, 0, cxClient, cyClient, g_gridView.hdcMem, 0, 0, SRCCOPY);
+
+    if (++g_gridView.dwFrames % 60 == 0)
+        ReportGridStats();
+}
+
+void ReportGridStats(void)
+{
+    TCHAR buf[160];
+
+    if (!g_gridView.dwFrames || g_liPerfFreq.QuadPart == 0)
+        return;
+
+    wsprintf(buf, TEXT("World grid: %d clocks, %lu frames, render %lu us per frame, %lu face renders last frame\n"),
+        g_gridView.nClocks, g_gridView.dwFrames,
+        (DWORD)(g_gridView.llRenderTicks * 1000000 / g_liPerfFreq.QuadPart / g_gridView.dwFrames),
+        g_gridView.grid.dwFaceRenders);
+    OutputDebugString(buf);
+}
+
+// Writes the phase histograms next to the executable, as CSV and JSON,
+// and the startup timeline as CSV
+void DumpPhaseStats(void)
+{
+    TCHAR dir[MAX_PATH];
+    char szDir[MAX_PATH], szPath[MAX_PATH + 32];
+
+    if (!GetExeDirectory(dir, MAX_PATH))
+        return;
+#ifdef UNICODE
+    if (!WideCharToMultiByte(CP_ACP, 0, dir, -1, szDir, MAX_PATH, NULL, NULL))
+        return;
+#else
+    lstrcpyn(szDir, dir, MAX_PATH);
+#endif
+
+    sprintf(szPath, "%s\\clockphases.csv", szDir);
+    if (!PhaseDumpFile(&g_phaseStats, szPath))
+        OutputDebugStringA("Could not write clockphases.csv\n");
+    sprintf(szPath, "%s\\clockphases.json", szDir);
+    if (!PhaseDumpFile(&g_phaseStats, szPath))
+        OutputDebugStringA("Could not write clockphases.json\n");
+
+    sprintf(szPath, "%s\\clockstartup.csv", szDir);
+    if (!StartProfDumpFile(&g_startProf, szPath))
+        OutputDebugStringA("Could not write clockstartup.csv\n");
+}
+
+static uint64_t PolicyWallNs(void* pCtx)
+{
+    (void)pCtx;
+    return PhaseNowNs();
+}
+
+// User plus kernel time of the whole process, audio thread included
+static uint64_t PolicyCpuNs(void* pCtx)
+{
+    FILETIME ftCreation, ftExit, ftKernel, ftUser;
+
+    (void)pCtx;
+    if (!GetProcessTimes(GetCurrentProcess(), &ftCreation, &ftExit, &ftKernel, &ftUser))
+        return 0;
+    return ((((uint64_t)ftKernel.dwHighDateTime << 32) | ftKernel.dwLowDateTime) +
+        (((uint64_t)ftUser.dwHighDateTime << 32) | ftUser.dwLowDateTime)) * 100;
+}
+
+// dwmapi.dll attributes; the DLL is there from Vista and is looked up so
+// the clock still loads without it
+#define DWM_ATTR_EXTENDED_FRAME_BOUNDS 9
+#define DWM_ATTR_CLOAKED 14
+
+typedef HRESULT (WINAPI* PFNDWMGETWINDOWATTRIBUTE)(HWND, DWORD, PVOID, DWORD);
+
+static PFNDWMGETWINDOWATTRIBUTE DwmAttributeProc(void)
+{
+    static PFNDWMGETWINDOWATTRIBUTE pfnGetAttribute;
+    static BOOL bTried;
+    HMODULE hDwm;
+
+    if (!bTried)
+    {
+        bTried = TRUE;
+        hDwm = LoadLibrary(TEXT("dwmapi.dll"));
+        if (hDwm)
+            pfnGetAttribute = (PFNDWMGETWINDOWATTRIBUTE)GetProcAddress(hDwm, "DwmGetWindowAttribute");
+    }
+    return pfnGetAttribute;
+}
+
+// Composed but not shown: on another virtual desktop, a suspended app.
+// Windows 8 and later; earlier systems fail the call.
+static BOOL IsCloaked(HWND hwnd)
+{
+    PFNDWMGETWINDOWATTRIBUTE pfnGetAttribute = DwmAttributeProc();
+    DWORD dwCloaked = 0;
+
+    return pfnGetAttribute && SUCCEEDED(pfnGetAttribute(hwnd, DWM_ATTR_CLOAKED, &dwCloaked, sizeof(dwCloaked))) &&
+        dwCloaked;
+}
+
+// Screen bounds of a top-level window that hides whatever is under it;
+// FALSE for one that is hidden, minimized, cloaked or may be see-through.
+// The composed bounds leave out the invisible resize borders.
+static BOOL OpaqueBounds(HWND hwnd, RECT* prc)
+{
+    PFNDWMGETWINDOWATTRIBUTE pfnGetAttribute = DwmAttributeProc();
+
+    if (!IsWindowVisible(hwnd) || IsIconic(hwnd) ||
+        (GetWindowLong(hwnd, GWL_EXSTYLE) & (WS_EX_LAYERED | WS_EX_TRANSPARENT)) || IsCloaked(hwnd))
+        return FALSE;
+    if (pfnGetAttribute && SUCCEEDED(pfnGetAttribute(hwnd, DWM_ATTR_EXTENDED_FRAME_BOUNDS, prc, sizeof(*prc))))
+        return TRUE;
+    return GetWindowRect(hwnd, prc);
+}
+
+// Covered when cloaked, or when none of the client area is both on a
+// screen and clear of the opaque windows above it. GetClipBox answers
+// that by itself without desktop composition, but under it never finds a
+// window covered, so the windows above are subtracted one by one. The
+// foreground window is taken as seen.
+static BOOL IsOccluded(HWND hwnd)
+{
+    HDC hdc;
+    HWND hwndAbove;
+    HRGN hrgnVisible, hrgnAbove;
+    RECT rc, rcScreen, rcAbove;
+    int iRegion;
+
+    if (IsCloaked(hwnd))
+        return TRUE;
+    if (GetForegroundWindow() == hwnd)
+        return FALSE;
+
+    hdc = GetDC(hwnd);
+    iRegion = GetClipBox(hdc, &rc);
+    ReleaseDC(hwnd, hdc);
+    if (iRegion == NULLREGION)
+        return TRUE;
+
+    GetClientRect(hwnd, &rc);
+    MapWindowPoints(hwnd, NULL, (POINT*)&rc, 2);
+    SetRect(&rcScreen, GetSystemMetrics(SM_XVIRTUALSCREEN), GetSystemMetrics(SM_YVIRTUALSCREEN),
+        GetSystemMetrics(SM_XVIRTUALSCREEN) + GetSystemMetrics(SM_CXVIRTUALSCREEN),
+        GetSystemMetrics(SM_YVIRTUALSCREEN) + GetSystemMetrics(SM_CYVIRTUALSCREEN));
+    if (!IntersectRect(&rc, &rc, &rcScreen))
+        return TRUE;
+
+    hrgnVisible = CreateRectRgnIndirect(&rc);
+    hrgnAbove = CreateRectRgn(0, 0, 0, 0);
+    iRegion = hrgnVisible && hrgnAbove ? SIMPLEREGION : ERROR;
+    for (hwndAbove = GetWindow(hwnd, GW_HWNDPREV); hwndAbove && iRegion != NULLREGION && iRegion != ERROR;
+        hwndAbove = GetWindow(hwndAbove, GW_HWNDPREV))
+    {
+        if (!OpaqueBounds(hwndAbove, &rcAbove))
+            continue;
+        SetRectRgn(hrgnAbove, rcAbove.left, rcAbove.top, rcAbove.right, rcAbove.bottom);
+        iRegion = CombineRgn(hrgnVisible, hrgnVisible, hrgnAbove, RGN_DIFF);
+    }
+    if (hrgnAbove)
+        DeleteObject(hrgnAbove);
+    if (hrgnVisible)
+        DeleteObject(hrgnVisible);
+    return iRegion == NULLREGION;
+}
+
+// Any top-level window changing; the check waits for them to settle
+static void CALLBACK OcclusionEvent(HWINEVENTHOOK hHook, DWORD dwEvent, HWND hwnd, LONG idObject, LONG idChild,
+    DWORD dwThread, DWORD dwTime)
+{
+    (void)hHook;
+    (void)dwEvent;
+    (void)hwnd;
+    (void)dwThread;
+    (void)dwTime;
+    if (idObject == OBJID_WINDOW && idChild == CHILDID_SELF && g_hwndOcclusion)
+        SetTimer(g_hwndOcclusion, ID_OCCLUSION_TIMER, OCCLUSION_SETTLE_MS, NULL);
+}
+
+// Hooks the events that can uncover the window, only while it is covered
+void WatchOcclusion(HWND hwnd, BOOL bWatch)
+{
+    static const DWORD dwEvents[OCCLUSION_HOOKS][2] =
+    {
+        { EVENT_SYSTEM_FOREGROUND, EVENT_SYSTEM_FOREGROUND },
+        { EVENT_SYSTEM_MINIMIZESTART, EVENT_SYSTEM_MINIMIZEEND },
+        { EVENT_OBJECT_DESTROY, EVENT_OBJECT_HIDE },
+        { EVENT_OBJECT_LOCATIONCHANGE, EVENT_OBJECT_LOCATIONCHANGE }
+    };
+    int i;
+
+    if (bWatch && !g_hwndOcclusion)
+    {
+        g_hwndOcclusion = hwnd;
+        for (i = 0; i < OCCLUSION_HOOKS; i++)
+            g_hOcclusionHooks[i] = SetWinEventHook(dwEvents[i][0], dwEvents[i][1], NULL, OcclusionEvent, 0, 0,
+                WINEVENT_OUTOFCONTEXT);
+    }
+    else if (!bWatch && g_hwndOcclusion)
+    {
+        for (i = 0; i < OCCLUSION_HOOKS; i++)
+        {
+            if (g_hOcclusionHooks[i])
+                UnhookWinEvent(g_hOcclusionHooks[i]);
+            g_hOcclusionHooks[i] = NULL;
+        }
+        KillTimer(g_hwndOcclusion, ID_OCCLUSION_TIMER);
+        g_hwndOcclusion = NULL;
+    }
+}
 
-            pt[0].x -= pt[2].x / 2;
-            pt[0].y -= pt[2].y / 2;
+// Sets or clears POLICY_OCCLUDED, and watches for the window being
+// uncovered for as long as it is set
+void SetOccluded(HWND hwnd, BOOL bOccluded, SYSTEMTIME* pstShown)
+{
+    if (RenderPolicySet(&g_renderPolicy, POLICY_OCCLUDED, bOccluded))
+        ApplyRenderPolicy(hwnd, pstShown);
+    WatchOcclusion(hwnd, (g_renderPolicy.dwHidden & POLICY_OCCLUDED) != 0);
+}
 
-            pt[1].x = pt[0].x + pt[2].x;
-            pt[1].y = pt[0].y + pt[2].y;
+// The monitor's refresh rate; FramePacerInit takes 0 or 1 as 60 Hz
+static int DisplayRefreshHz(HWND hwnd)
+{
+    HDC hdc = GetDC(hwnd);
+    int iHz = GetDeviceCaps(hdc, VREFRESH);
 
-            Ellipse(hdc, pt[0].x, pt[0].y, pt[1].x, pt[1].y);
-        }
+    ReleaseDC(hwnd, hdc);
+    return iHz;
+}
+
+// The buttons of the normal view; the grid has none
+static void AddControls(void)
+{
+    CtrlLayerInit(&g_controls);
+    CtrlAdd(&g_controls, ID_SOUND_BTN, CTRL_LEFT | CTRL_TOP, 10, 10, 40, 40);
+    CtrlAdd(&g_controls, ID_ROMAN_BTN, CTRL_HCENTER | CTRL_TOP, 0, 10, 260, 50);
+    CtrlAdd(&g_controls, ID_DARKMODE_BTN, CTRL_HCENTER | CTRL_BOTTOM, 0, 10, 180, 50);
+    CtrlAdd(&g_controls, ID_FONT_BTN, CTRL_RIGHT | CTRL_TOP, 10, 10, 180, 50);
+    CtrlAdd(&g_controls, ID_DOTS_BTN, CTRL_LEFT | CTRL_BOTTOM, 10, 10, 220, 50);
+    CtrlAdd(&g_controls, ID_MYSTERY_BTN, CTRL_RIGHT | CTRL_BOTTOM, 10, 10, 50, 50);
+}
+
+static const TCHAR* ControlLabel(int iId)
+{
+    switch (iId)
+    {
+        case ID_ROMAN_BTN:
+            return g_bRomanMode ? TEXT("Switch to nums") : TEXT("Switch to Roman");
+        case ID_DARKMODE_BTN:
+            return g_bDarkMode ? TEXT("Light Mode") : TEXT("Dark Mode");
+        case ID_FONT_BTN:
+            return g_bUseLightFont ? TEXT("Heavy Font") : TEXT("Light Font");
+        case ID_DOTS_BTN:
+            return g_bShowDots ? TEXT("Disable Dots") : TEXT("Enable Dots");
+    }
+    return TEXT("");
+}
+
+// "???" one color per character, from the atlas or else as text
+static void DrawMysteryControl(HDC hdc, const RECT* prc)
+{
+    static const COLORREF colors[3] = { RGB(255, 0, 0), RGB(0, 255, 0), RGB(0, 0, 255) };
+    const TCHAR* text = TEXT("???");
+    HFONT hOldFont;
+    SIZE sz;
+    int i, x, y;
+
+    if (DrawAtlasMystery(hdc, prc))
+        return;
+
+    hOldFont = (HFONT)SelectObject(hdc, GetClockFont(g_bUseLightFont ? FONT_LIGHT_BTN : FONT_HEAVY_BTN));
+    GetTextExtentPoint32(hdc, text, 3, &sz);
+    x = prc->left + (prc->right - prc->left - sz.cx) / 2;
+    y = prc->top + (prc->bottom - prc->top - sz.cy) / 2;
+    SetBkMode(hdc, TRANSPARENT);
+    for (i = 0; i < 3; i++)
+    {
+        SetTextColor(hdc, colors[i]);
+        TextOut(hdc, x + i * (sz.cx / 3), y, text + i, 1);
     }
+    SelectObject(hdc, hOldFont);
+}
 
-    for (iAngle = 0; iAngle < 360; iAngle += 30)
+// A push button in the classic look: raised, sunken while pressed, with a
+// highlight frame under the pointer
+static void DrawControl(HDC hdc, int iIndex)
+{
+    const CONTROL* pCtrl = &g_controls.ctrls[iIndex];
+    int iState = CtrlState(&g_controls, iIndex);
+    HFONT hOldFont;
+    RECT rc, rcFrame;
+
+    SetRect(&rc, pCtrl->rc.left, pCtrl->rc.top, pCtrl->rc.right, pCtrl->rc.bottom);
+    FillRect(hdc, &rc, GetSysColorBrush(COLOR_BTNFACE));
+    DrawEdge(hdc, &rc, (iState & CTRL_PRESSED) ? EDGE_SUNKEN : EDGE_RAISED, BF_RECT);
+    if (iState == CTRL_HOT)
     {
-        if (hCurrentFont) {
-            int hour = iAngle / 30;
-            if (hour == 0) hour = 12;
-            double rad = iAngle * 3.14159265358979323846 / 180.0;
-            int numRadius = 450;
-            int tx = (int)(0 + numRadius * sin(rad));
-            int ty = (int)(0 + numRadius * cos(rad)) + 35;
-            const TCHAR* label = g_bRomanMode ? romanNumerals[hour] : NULL;
-            TCHAR buf[8];
-            if (g_bRomanMode) {
-                lstrcpy(buf, label);
-            }
-            else {
-                wsprintf(buf, TEXT("%d"), hour);
-            }
-            hOldFont = (HFONT)SelectObject(hdc, hCurrentFont);
+        rcFrame = rc;
+        InflateRect(&rcFrame, -3, -3);
+        FrameRect(hdc, &rcFrame, GetSysColorBrush(COLOR_HIGHLIGHT));
+    }
+    if (iState & CTRL_PRESSED)
+        OffsetRect(&rc, 1, 1);
+
+    switch (pCtrl->iId)
+    {
+        case ID_SOUND_BTN:
+            DrawIcon(hdc, (rc.left + rc.right - GetSystemMetrics(SM_CXICON)) / 2,
+                (rc.top + rc.bottom - GetSystemMetrics(SM_CYICON)) / 2, GetSoundIcon(g_bSoundOn));
+            break;
+
+        case ID_MYSTERY_BTN:
+            DrawMysteryControl(hdc, &rc);
+            break;
+
+        default:
+            hOldFont = (HFONT)SelectObject(hdc, GetClockFont(g_bUseLightFont ? FONT_LIGHT_BTN : FONT_HEAVY_BTN));
             SetBkMode(hdc, TRANSPARENT);
-            SetTextColor(hdc, g_bDarkMode ? RGB(255, 255, 255) : RGB(0, 0, 0));
-            SIZE sz;
-            GetTextExtentPoint32(hdc, buf, lstrlen(buf), &sz);
-            TextOut(hdc, tx - sz.cx / 2, ty - sz.cy / 2, buf, lstrlen(buf));
+            SetTextColor(hdc, GetSysColor(COLOR_BTNTEXT));
+            DrawText(hdc, ControlLabel(pCtrl->iId), -1, &rc, DT_CENTER | DT_VCENTER | DT_SINGLELINE);
             SelectObject(hdc, hOldFont);
+            break;
+    }
+}
+
+// Keeps the face and hands off the buttons, which are drawn last
+static void ExcludeControls(HDC hdc)
+{
+    int i;
+
+    for (i = 0; i < g_controls.nCtrls; i++)
+        ExcludeClipRect(hdc, g_controls.ctrls[i].rc.left, g_controls.ctrls[i].rc.top,
+            g_controls.ctrls[i].rc.right, g_controls.ctrls[i].rc.bottom);
+}
+
+// The buttons in the update region, in client pixels
+static void DrawControls(HDC hdc)
+{
+    RECT rc;
+    int i;
+
+    SaveDC(hdc);
+    SetMapMode(hdc, MM_TEXT);
+    SetViewportOrgEx(hdc, 0, 0, NULL);
+    SelectClipRgn(hdc, NULL);
+    for (i = 0; i < g_controls.nCtrls; i++)
+    {
+        SetRect(&rc, g_controls.ctrls[i].rc.left, g_controls.ctrls[i].rc.top,
+            g_controls.ctrls[i].rc.right, g_controls.ctrls[i].rc.bottom);
+        if (!RectVisible(hdc, &rc))
+            continue;
+        DrawControl(hdc, i);
+        g_controls.dwDrawn++;
+    }
+    RestoreDC(hdc, -1);
+}
+
+// Invalidates the hands' damage except where the buttons are, so moving
+// hands never make a button paint again
+static void InvalidateHandDamage(HWND hwnd, const DAMAGERECT* pDamage)
+{
+    DAMAGERECT pieces[CTRL_MAX_PIECES];
+    int i, n = CtrlDamageOutside(&g_controls, pDamage, pieces, CTRL_MAX_PIECES);
+
+    for (i = 0; i < n; i++)
+        InvalidateRect(hwnd, (RECT*)&pieces[i], FALSE);
+}
+
+// Invalidates each button inside *pDamage on its own, leaving the face
+// between them alone
+static void InvalidateControls(HWND hwnd, const DAMAGERECT* pDamage)
+{
+    const DAMAGERECT* pr;
+    int i;
+
+    if (DamageIsEmpty(pDamage))
+        return;
+    for (i = 0; i < g_controls.nCtrls; i++)
+    {
+        pr = &g_controls.ctrls[i].rc;
+        if (pr->left >= pDamage->left && pr->top >= pDamage->top &&
+            pr->right <= pDamage->right && pr->bottom <= pDamage->bottom)
+            InvalidateRect(hwnd, (const RECT*)pr, FALSE);
+    }
+}
+
+// For a button whose picture or label changed
+static void InvalidateControl(HWND hwnd, int iId)
+{
+    DAMAGERECT damage;
+
+    DamageEmpty(&damage);
+    CtrlDamage(&g_controls, iId, &damage);
+    InvalidateControls(hwnd, &damage);
+}
+
+// The pointer left the client area, or the press it held was lost
+static void ReleaseControls(HWND hwnd, BOOL bLeave)
+{
+    DAMAGERECT damage;
+
+    DamageEmpty(&damage);
+    if (bLeave)
+        CtrlMouseLeave(&g_controls, &damage);
+    else
+        CtrlCancel(&g_controls, &damage);
+    InvalidateControls(hwnd, &damage);
+}
+
+void ReportControlStats(void)
+{
+    char buf[256];
+
+    CtrlLayerFormat(&g_controls, buf, sizeof(buf) - 1);
+    strcat(buf, "\n");
+    OutputDebugStringA(buf);
+}
+
+// The sub-dial and both readouts. A lap line runs to about 20 characters
+// of the face font for any time under 100 hours, none wider than 0.8 em.
+static void AddStopwatchDamage(DAMAGERECT* pDamage, int cxClient, int cyClient)
+{
+    int iHeight = g_bUseLightFont ? CLOCK_LIGHT_TEXT_HEIGHT : CLOCK_HEAVY_TEXT_HEIGHT;
+    int cyText = iHeight * IsoScale(cxClient, cyClient) / ISO_WINDOW_EXT + 1;
+
+    StopwatchDamage(cxClient, cyClient, cyText * 16, cyText, pDamage);
+}
+
+// One sweep frame: repaints the old and new boxes of the hands that moved,
+// and on a stopwatch the sub-dial and readouts as well
+void SweepFrame(HWND hwnd)
+{
+    SYSTEMTIME st;
+    DAMAGERECT damage;
+    RECT rc;
+    int iTenths[3];
+
+    if (g_bStopwatch)
+        StopwatchHandAngles(StopwatchElapsedNs(&g_stopwatch, PhaseNowNs()), iTenths);
+    else
+    {
+        GetClockTime(&st);
+        SweepHandAngles(g_iSweepMode, st.wHour, st.wMinute, st.wSecond, st.wMilliseconds, iTenths);
+    }
+
+    GetClientRect(hwnd, &rc);
+    DamageEmpty(&damage);
+    if (!SweepHandsMove(&g_sweepHands, iTenths, rc.right, rc.bottom, &damage) && !g_bStopwatch)
+        return;
+    if (g_bStopwatch)
+        AddStopwatchDamage(&damage, rc.right, rc.bottom);
+    DamageClip(&damage, rc.right, rc.bottom);
+    if (!DamageIsEmpty(&damage))
+    {
+        InvalidateHandDamage(hwnd, &damage);
+        UpdateWindow(hwnd);
+    }
+}
+
+// Blocks until there is a message, or in sweep mode until the next frame
+// is due; SetTimer cannot go below 10 ms, a timed wait can. A stopped
+// stopwatch has nothing to move.
+void WaitForWork(HWND hwnd)
+{
+    uint64_t qwWaitNs;
+
+    if (g_iSweepMode == SWEEP_OFF || !RenderPolicyVisible(&g_renderPolicy) ||
+        (g_bStopwatch && !g_stopwatch.bRunning))
+    {
+        WaitMessage();
+        return;
+    }
+    if (FramePacerWake(&g_framePacer, PhaseNowNs(), &qwWaitNs))
+        SweepFrame(hwnd);
+    else
+        MsgWaitForMultipleObjects(0, NULL, FALSE, (DWORD)((qwWaitNs + 999999) / 1000000), QS_ALLINPUT);
+}
+
+static void DrawSweepHands(HDC hdc)
+{
+    CLOCKBACKEND backend;
+    GDIBACKEND gdi;
+    CLOCKSTYLE style;
+
+    GetClockStyle(&style);
+    BeginGdiBackend(&backend, &gdi, hdc);
+    ClockDrawHandOutlines(&backend, &style, (const ROTPOINT(*)[CLOCK_HAND_POINTS])g_sweepHands.pt);
+    EndGdiBackend(&gdi);
+}
+
+// Stops or restarts the tick timer to match the render policy, and shows
+// the current time at once when the window has just become visible
+void ApplyRenderPolicy(HWND hwnd, SYSTEMTIME* pstShown)
+{
+    if (RenderPolicyMode(&g_renderPolicy) == POLICY_SUSPENDED)
+    {
+        if (g_bTimerArmed)
+        {
+            KillTimer(hwnd, ID_TIMER);
+            g_bTimerArmed = FALSE;
         }
     }
+    else if (!g_bTimerArmed)
+    {
+        TickSchedResync(&g_tickSched);
+        SetTimer(hwnd, ID_TIMER, TickSchedNextDelayMs(&g_tickSched), NULL);
+        g_bTimerArmed = TRUE;
+    }
 
-    SelectObject(hdc, hOldBrush);
-    DeleteObject(hBrush);
+    if (RenderPolicyTakeRepaint(&g_renderPolicy))
+    {
+        FramePacerResync(&g_framePacer, PhaseNowNs());
+        GetClockTime(pstShown);
+        InvalidateRect(hwnd, NULL, FALSE);
+        ReportRenderPolicyStats();
+    }
 }
 
-void DrawHands(HDC hdc, SYSTEMTIME * pst, BOOL fChange)
+void ReportRenderPolicyStats(void)
 {
-    static POINT pt[3][5] = {
-        {0, -110, 70, 0, 0, 300, -70, 0, 0, -110},
-        {0, -150, 40, 0, 0, 420, -40, 0, 0, -150},
-        {0, 0, 0, 0, 0, 0, 0, 0, 0, 420}
-    };
-    int i, iAngle[3];
-    POINT ptTemp[3][5];
-    HPEN hPen, hOldPen;
-    COLORREF handColor = g_bDarkMode ? RGB(255, 255, 255) : RGB(0, 0, 0);
+    char buf[256];
+
+    RenderPolicyFormat(&g_renderPolicy, buf, sizeof(buf) - 1);
+    strcat(buf, "\n");
+    OutputDebugStringA(buf);
+}
+
+// The timer keeps running while hidden for the tick sound, the ring or
+// alarms still to ring
+static BOOL KeepTicking(void)
+{
+    return (g_bTickHidden && g_bSoundOn) || g_frameShm.pHeader != NULL || g_alarms.nPending;
+}
+
+// "/alarms alarms.txt" on the command line loads the alarm list. Returns
+// FALSE only when the list was asked for and cannot be read.
+BOOL LoadAlarms(void)
+{
+    if (!g_szAlarmPath[0])
+        return TRUE;
+
+    g_pAlarmLabels = (char(*)[ALARM_LABEL_CHARS])malloc(ALARM_MAX_LABELS * sizeof(*g_pAlarmLabels));
+    if (!g_pAlarmLabels || !AlarmWheelInit(&g_alarms, ALARM_MAX_LABELS, UtcSeconds(), &g_timeSource.clock) ||
+        AlarmLoad(&g_alarms, g_szAlarmPath, g_pAlarmLabels, ALARM_MAX_LABELS) < 0)
+    {
+        FreeAlarms();
+        return FALSE;
+    }
+    ReportAlarmStats();
+    return TRUE;
+}
 
-    iAngle[0] = (pst->wHour * 30) % 360 + pst->wMinute / 2;
-    iAngle[1] = pst->wMinute * 6;
-    iAngle[2] = pst->wSecond * 6;
+void FreeAlarms(void)
+{
+    AlarmWheelFree(&g_alarms);
+    free(g_pAlarmLabels);
+    g_pAlarmLabels = NULL;
+}
 
-    memcpy(ptTemp, pt, sizeof(pt));
+static void OnAlarm(void* pCtx, uint32_t dwId, uint32_t dwTag, int64_t llDue)
+{
+    char buf[ALARM_LABEL_CHARS + 64];
 
-    hPen = CreatePen(PS_SOLID, 0, handColor);
-    hOldPen = SelectObject(hdc, hPen);
+    (void)pCtx;
+    sprintf(buf, "Alarm %08lx: %s, %ld s late\n", (unsigned long)dwId, g_pAlarmLabels[dwTag],
+        (long)(g_alarms.llNow - llDue));
+    OutputDebugStringA(buf);
+    g_iAlarmFlash = ALARM_FLASH_SECONDS;
+}
 
-    for (i = fChange ? 0 : 2; i < 3; i++)
+// Called on each timer tick: rings whatever has come due, then flashes
+// the face every other second and chimes with it while the flash lasts
+void CheckAlarms(HWND hwnd, SYSTEMTIME * pst)
+{
+    if (!g_alarms.pAlarms)
+        return;
+
+    if (AlarmWheelAdvance(&g_alarms, UtcSeconds(), OnAlarm, NULL) && !g_alarms.nPending)
+        RenderPolicyKeepAudio(&g_renderPolicy, KeepTicking());
+    if (!g_iAlarmFlash)
+        return;
+
+    g_iAlarmFlash--;
+    InvalidateRect(hwnd, NULL, FALSE);
+    if (g_iAlarmFlash & 1)
+        ScheduleChime(pst);
+}
+
+// Inverts the painted part of the face on a flash second; the buttons are
+// already cut out of the clip region
+static void DrawAlarmFlash(HDC hdc, const RECT* prcPaint)
+{
+    if (!(g_iAlarmFlash & 1))
+        return;
+
+    SaveDC(hdc);
+    SetMapMode(hdc, MM_TEXT);
+    SetViewportOrgEx(hdc, 0, 0, NULL);
+    PatBlt(hdc, prcPaint->left, prcPaint->top, prcPaint->right - prcPaint->left,
+        prcPaint->bottom - prcPaint->top, DSTINVERT);
+    RestoreDC(hdc, -1);
+}
+
+void ReportAlarmStats(void)
+{
+    char buf[256];
+
+    if (!g_alarms.pAlarms)
+        return;
+
+    AlarmWheelFormat(&g_alarms, buf, sizeof(buf) - 1);
+    strcat(buf, "\n");
+    OutputDebugStringA(buf);
+}
+
+static uint64_t StopwatchNowNs(void* pCtx)
+{
+    (void)pCtx;
+    return PhaseNowNs();
+}
+
+void InitStopwatch(void)
+{
+    WATCHCLOCK clock = { StopwatchNowNs, NULL };
+
+    StopwatchInit(&g_stopwatch, &clock);
+}
+
+// The paint reads the last lap back from the ring like any other reader
+static void DrawStopwatchDial(HDC hdc)
+{
+    CLOCKBACKEND backend;
+    GDIBACKEND gdi;
+    CLOCKSTYLE style;
+    LAP lap;
+    BOOL bLap;
+
+    bLap = g_dwLastLap && LapRingRead(&g_stopwatch.ring, g_dwLastLap, &lap, 1) == 1;
+    GetClockStyle(&style);
+    BeginGdiBackend(&backend, &gdi, hdc);
+    StopwatchDrawDial(&backend, &style, StopwatchElapsedNs(&g_stopwatch, PhaseNowNs()), bLap ? &lap : NULL,
+        style.bUseLightFont ? CLOCK_LIGHT_TEXT_HEIGHT : CLOCK_HEAVY_TEXT_HEIGHT);
+    EndGdiBackend(&gdi);
+}
+
+static DWORD WINAPI ExportLapsProc(LPVOID pParam)
+{
+    char* pszPath = (char*)pParam;
+
+    if (!StopwatchDumpFile(&g_stopwatch.ring, pszPath))
+        OutputDebugStringA("Could not write " STOPWATCH_CSV_NAME "\n");
+    free(pszPath);
+    return 0;
+}
+
+// Writes the laps next to the executable on a thread of its own; the
+// ring needs no lock, so laps go on being taken while it writes
+void ExportLaps(void)
+{
+    TCHAR dir[MAX_PATH];
+    char szDir[MAX_PATH];
+    char* pszPath;
+    HANDLE hThread;
+
+    if (!GetExeDirectory(dir, MAX_PATH))
+        return;
+#ifdef UNICODE
+    if (!WideCharToMultiByte(CP_ACP, 0, dir, -1, szDir, MAX_PATH, NULL, NULL))
+        return;
+#else
+    lstrcpyn(szDir, dir, MAX_PATH);
+#endif
+
+    pszPath = (char*)malloc(MAX_PATH + 32);
+    if (!pszPath)
+        return;
+    sprintf(pszPath, "%s\\%s", szDir, STOPWATCH_CSV_NAME);
+    hThread = CreateThread(NULL, 0, ExportLapsProc, pszPath, 0, NULL);
+    if (hThread)
+        CloseHandle(hThread);
+    else
+        free(pszPath);
+}
+
+// A key counts from when it is handled: GetMessageTime is only as fine
+// as the tick count, 10 to 16 ms, far coarser than the wait in the queue
+void StopwatchKey(HWND hwnd, WPARAM wParam)
+{
+    uint32_t dwLap;
+
+    switch (wParam)
     {
-        RotatePoint(ptTemp[i], 5, iAngle[i]);
-        Polyline(hdc, ptTemp[i], 5);
+        case VK_SPACE:
+            if (g_stopwatch.bRunning)
+                StopwatchStop(&g_stopwatch, 0);
+            else
+                StopwatchStart(&g_stopwatch, 0);
+            break;
+
+        case VK_RETURN:
+        case 'L':
+            dwLap = StopwatchLap(&g_stopwatch, 0);
+            if (dwLap)
+                g_dwLastLap = dwLap;
+            break;
+
+        case VK_BACK:
+        case 'R':
+            StopwatchReset(&g_stopwatch);
+            g_dwLastLap = 0;
+            break;
+
+        case VK_F8:
+            ExportLaps();
+            return;
+
+        default:
+            return;
     }
+    SweepFrame(hwnd);
+}
+
+void ReportStopwatchStats(void)
+{
+    char buf[256];
+
+    if (!g_bStopwatch)
+        return;
 
-    SelectObject(hdc, hOldPen);
-    DeleteObject(hPen);
+    StopwatchFormat(&g_stopwatch, buf, sizeof(buf) - 1);
+    strcat(buf, "\n");
+    OutputDebugStringA(buf);
+}
+
+// Writes the startup timeline to the debugger
+void ReportStartup(void)
+{
+    char buf[4096];
+
+    StartProfFormat(&g_startProf, (uint64_t)STARTUP_BUDGET_MS * 1000000, buf, sizeof(buf) - 1);
+    strcat(buf, "\n");
+    OutputDebugStringA(buf);
 }
 
 LRESULT CALLBACK WndProc(HWND hwnd, UINT message, WPARAM wParam, LPARAM lParam)
@@ -483,119 +2681,126 @@ LRESULT CALLBACK WndProc(HWND hwnd, UINT message, WPARAM wParam, LPARAM lParam)
     HDC hdc;
     PAINTSTRUCT ps;
     SYSTEMTIME st;
-    RECT rect;
+    uint64_t qwStart;
 
     switch (message)
     {
         case WM_CREATE:
         {
-            SetTimer(hwnd, ID_TIMER, 1000, NULL);
-            GetLocalTime(&st);
+            // 1 ms timer resolution keeps the re-armed timer within a
+            // millisecond or two of each second boundary
+            {
+                TICKCLOCK clock = { WallClockUs, NULL };
+                POLICYCLOCK policyClock = { PolicyWallNs, PolicyCpuNs, NULL };
+                timeBeginPeriod(1);
+                TickSchedInit(&g_tickSched, &clock, TICK_GUARD_US);
+                SetTimer(hwnd, ID_TIMER, TickSchedNextDelayMs(&g_tickSched), NULL);
+                g_bTimerArmed = TRUE;
+                RenderPolicyInit(&g_renderPolicy, &policyClock, KeepTicking());
+                WTSRegisterSessionNotification(hwnd, NOTIFY_FOR_THIS_SESSION);
+            }
+            GetClockTime(&st);
             stPrevious = st;
+            PublishTick(&st);
+            FramePacerInit(&g_framePacer, DisplayRefreshHz(hwnd), PhaseNowNs());
+            SweepHandsInit(&g_sweepHands);
+            if (g_bStopwatch)
+            {
+                DAMAGERECT damage;
+                int iTenths[3] = { 0, 0, 0 };
 
-            // Create buttons
-            hBtnSound = CreateWindow(
-                TEXT("BUTTON"), NULL,
-                WS_CHILD | WS_VISIBLE | BS_ICON,
-                10, 10, 40, 40,
-                hwnd, (HMENU)ID_SOUND_BTN,
-                ((LPCREATESTRUCT)lParam)->hInstance, NULL);
-
-            hBtnRomanMode = CreateWindow(
-                TEXT("BUTTON"), TEXT("Switch to Roman"),
-                WS_CHILD | WS_VISIBLE | BS_PUSHBUTTON,
-                0, 0, 260, 50, hwnd, (HMENU)ID_ROMAN_BTN,
-                ((LPCREATESTRUCT)lParam)->hInstance, NULL);
-
-            hBtnDarkMode = CreateWindow(
-                TEXT("BUTTON"), TEXT("Dark Mode"),
-                WS_CHILD | WS_VISIBLE | BS_PUSHBUTTON,
-                0, 0, 180, 50, hwnd, (HMENU)ID_DARKMODE_BTN,
-                ((LPCREATESTRUCT)lParam)->hInstance, NULL);
-
-            hBtnFontSwitch = CreateWindow(
-                TEXT("BUTTON"), TEXT("Light Font"),
-                WS_CHILD | WS_VISIBLE | BS_PUSHBUTTON,
-                0, 0, 180, 50, hwnd, (HMENU)ID_FONT_BTN,
-                ((LPCREATESTRUCT)lParam)->hInstance, NULL);
-
-            hBtnDots = CreateWindow(
-                TEXT("BUTTON"), TEXT("Disable Dots"),
-                WS_CHILD | WS_VISIBLE | BS_PUSHBUTTON,
-                0, 0, 220, 50, hwnd, (HMENU)ID_DOTS_BTN,
-                ((LPCREATESTRUCT)lParam)->hInstance, NULL);
-
-            hBtnMystery = CreateWindow(
-                TEXT("BUTTON"), TEXT("???"),
-                WS_CHILD | WS_VISIBLE | BS_OWNERDRAW,
-                0, 0, 50, 50,
-                hwnd, (HMENU)ID_MYSTERY_BTN,
-                ((LPCREATESTRUCT)lParam)->hInstance, NULL);
-
-            // Set initial icon
-            SendMessage(hBtnSound, BM_SETIMAGE, IMAGE_ICON,
-                (LPARAM)(g_bSoundOn ? hSoundOnIcon : hSoundOffIcon));
-
-            UpdateButtonFonts(hwnd);
+                SweepHandsMove(&g_sweepHands, iTenths, 0, 0, &damage);
+            }
+            FaceCacheInit(&g_faceCache, FACE_CACHE_BUDGET, FreeFaceBitmap, NULL);
+
+            // The grid is a display wall; it has no controls
+            if (g_gridView.nClocks)
+                return 0;
 
+            AddControls();
             return 0;
         }
 
-        case WM_DRAWITEM:
-        {
-            LPDRAWITEMSTRUCT lpDrawItem = (LPDRAWITEMSTRUCT)lParam;
-            if (lpDrawItem->CtlID == ID_MYSTERY_BTN)
+        case WM_SIZE:
+            // Keep the face cache for the size the window comes back at
+            if (wParam == SIZE_MINIMIZED)
             {
-                FillRect(lpDrawItem->hDC, &lpDrawItem->rcItem, 
-                        (HBRUSH)(COLOR_BTNFACE + 1));
-                
-                if (lpDrawItem->itemState & ODS_SELECTED)
-                    DrawEdge(lpDrawItem->hDC, &lpDrawItem->rcItem, EDGE_SUNKEN, BF_RECT);
-                else
-                    DrawEdge(lpDrawItem->hDC, &lpDrawItem->rcItem, EDGE_RAISED, BF_RECT);
-                
-                HFONT hOldFont = (HFONT)SelectObject(lpDrawItem->hDC, 
-                    g_bUseLightFont ? hLightBtnFont : hHeavyBtnFont);
-                
-                const TCHAR* text = TEXT("???");
-                SIZE sz;
-                GetTextExtentPoint32(lpDrawItem->hDC, text, 3, &sz);
-                int x = (lpDrawItem->rcItem.right - sz.cx) / 2;
-                int y = (lpDrawItem->rcItem.bottom - sz.cy) / 2;
-                
-                SetBkMode(lpDrawItem->hDC, TRANSPARENT);
-                
-                for (int i = 0; i < 3; i++)
-                {
-                    COLORREF colors[] = {RGB(255, 0, 0), RGB(0, 255, 0), RGB(0, 0, 255)};
-                    SetTextColor(lpDrawItem->hDC, colors[i]);
-                    TCHAR ch[2] = {text[i], 0};
-                    TextOut(lpDrawItem->hDC, x + i * (sz.cx / 3), y, ch, 1);
-                }
-                
-                SelectObject(lpDrawItem->hDC, hOldFont);
-                return TRUE;
+                RenderPolicySet(&g_renderPolicy, POLICY_MINIMIZED, TRUE);
+                ApplyRenderPolicy(hwnd, &stPrevious);
+                return 0;
             }
-            break;
-        }
+            if (RenderPolicySet(&g_renderPolicy, POLICY_MINIMIZED, FALSE))
+                ApplyRenderPolicy(hwnd, &stPrevious);
 
-        case WM_SIZE:
             cxClient = LOWORD(lParam);
             cyClient = HIWORD(lParam);
+            g_bLiveResized = g_bLiveResize;
+            InvalidateRect(hwnd, NULL, FALSE);
+            FreeGridSurface();
+
+            CtrlLayout(&g_controls, cxClient, cyClient);
+            return 0;
+
+        // A drag of the frame: scaled faces until it ends, then one drawn
+        // for the size it ended at
+        case WM_ENTERSIZEMOVE:
+            g_bLiveResize = TRUE;
+            g_bLiveResized = FALSE;
+            return 0;
+
+        case WM_EXITSIZEMOVE:
+            g_bLiveResize = FALSE;
+            if (g_bLiveResized)
+                InvalidateRect(hwnd, NULL, FALSE);
+            g_bLiveResized = FALSE;
+            return 0;
+
+        case WM_MOUSEMOVE:
+        {
+            DAMAGERECT damage;
+            TRACKMOUSEEVENT tme = { sizeof(TRACKMOUSEEVENT), TME_LEAVE, hwnd, 0 };
+
+            if (!g_bTrackingLeave && TrackMouseEvent(&tme))
+                g_bTrackingLeave = TRUE;
+            DamageEmpty(&damage);
+            CtrlMouseMove(&g_controls, (short)LOWORD(lParam), (short)HIWORD(lParam), &damage);
+            InvalidateControls(hwnd, &damage);
+            return 0;
+        }
+
+        case WM_MOUSELEAVE:
+            g_bTrackingLeave = FALSE;
+            ReleaseControls(hwnd, TRUE);
+            return 0;
+
+        case WM_LBUTTONDOWN:
+        {
+            DAMAGERECT damage;
+
+            DamageEmpty(&damage);
+            if (CtrlMouseDown(&g_controls, (short)LOWORD(lParam), (short)HIWORD(lParam), &damage))
+                SetCapture(hwnd);
+            InvalidateControls(hwnd, &damage);
+            return 0;
+        }
+
+        case WM_LBUTTONUP:
+        {
+            DAMAGERECT damage;
+            int iId;
+
+            DamageEmpty(&damage);
+            iId = CtrlMouseUp(&g_controls, (short)LOWORD(lParam), (short)HIWORD(lParam), &damage);
+            if (GetCapture() == hwnd)
+                ReleaseCapture();
+            InvalidateControls(hwnd, &damage);
+            if (iId >= 0)
+                SendMessage(hwnd, WM_COMMAND, MAKEWPARAM(iId, BN_CLICKED), 0);
+            return 0;
+        }
 
-            // Position buttons
-            if (hBtnRomanMode)
-                MoveWindow(hBtnRomanMode, (cxClient - 260)/2, 10, 260, 50, TRUE);
-            if (hBtnDarkMode)
-                MoveWindow(hBtnDarkMode, (cxClient - 180)/2, cyClient-60, 180, 50, TRUE);
-            if (hBtnFontSwitch)
-                MoveWindow(hBtnFontSwitch, cxClient-190, 10, 180, 50, TRUE);
-            if (hBtnSound)
-                MoveWindow(hBtnSound, 10, 10, 40, 40, TRUE);
-            if (hBtnDots)
-                MoveWindow(hBtnDots, 10, cyClient-60, 220, 50, TRUE);
-            if (hBtnMystery)
-                MoveWindow(hBtnMystery, cxClient-60, cyClient-60, 50, 50, TRUE);
+        case WM_CAPTURECHANGED:
+            ReleaseControls(hwnd, FALSE);
             return 0;
 
         case WM_COMMAND:
@@ -603,32 +2808,33 @@ LRESULT CALLBACK WndProc(HWND hwnd, UINT message, WPARAM wParam, LPARAM lParam)
             {
                 case ID_DARKMODE_BTN:
                     g_bDarkMode = !g_bDarkMode;
-                    SetWindowText(hBtnDarkMode, g_bDarkMode ? TEXT("Light Mode") : TEXT("Dark Mode"));
+                    MarkPublishFull();
                     InvalidateRect(hwnd, NULL, FALSE);
                     return 0;
                     
                 case ID_ROMAN_BTN:
                     g_bRomanMode = !g_bRomanMode;
-                    SetWindowText(hBtnRomanMode, g_bRomanMode ? TEXT("Switch to nums") : TEXT("Switch to Roman"));
+                    MarkPublishFull();
                     InvalidateRect(hwnd, NULL, FALSE);
                     return 0;
                     
                 case ID_FONT_BTN:
                     g_bUseLightFont = !g_bUseLightFont;
-                    SetWindowText(hBtnFontSwitch, g_bUseLightFont ? TEXT("Heavy Font") : TEXT("Light Font"));
-                    UpdateButtonFonts(hwnd);
+                    MarkPublishFull();
                     InvalidateRect(hwnd, NULL, FALSE);
                     return 0;
                     
                 case ID_SOUND_BTN:
                     g_bSoundOn = !g_bSoundOn;
-                    SendMessage(hBtnSound, BM_SETIMAGE, IMAGE_ICON,
-                        (LPARAM)(g_bSoundOn ? hSoundOnIcon : hSoundOffIcon));
+                    RenderPolicyKeepAudio(&g_renderPolicy, KeepTicking());
+                    if (!g_bSoundOn)
+                        CancelTicks();
+                    InvalidateControl(hwnd, ID_SOUND_BTN);
                     return 0;
                     
                 case ID_DOTS_BTN:
                     g_bShowDots = !g_bShowDots;
-                    SetWindowText(hBtnDots, g_bShowDots ? TEXT("Disable Dots") : TEXT("Enable Dots"));
+                    MarkPublishFull();
                     InvalidateRect(hwnd, NULL, FALSE);
                     return 0;
                     
@@ -639,62 +2845,178 @@ LRESULT CALLBACK WndProc(HWND hwnd, UINT message, WPARAM wParam, LPARAM lParam)
             break;
 
         case WM_TIMER:
-            GetLocalTime(&st);
-            fChange = st.wHour != stPrevious.wHour || st.wMinute != stPrevious.wMinute;
+        {
+            DAMAGERECT damage;
+            UINT uNextMs;
 
-            hdc = GetDC(hwnd);
-            
-            GetClientRect(hwnd, &rect);
-            FillRect(hdc, &rect, (HBRUSH)GetStockObject(g_bDarkMode ? BLACK_BRUSH : WHITE_BRUSH));
-            
-            SetIsotropic(hdc, cxClient, cyClient);
-            DrawClock(hdc);
-            DrawHands(hdc, &st, TRUE);
-
-            if (g_bSoundOn) {
-                TCHAR soundPath[MAX_PATH];
-                if (GetExeDirectory(soundPath, MAX_PATH))
-                {
-                    PathCombine(soundPath, soundPath, TEXT("Tick.wav"));
-                    if (PathFileExists(soundPath))
-                        PlaySound(soundPath, NULL, SND_FILENAME | SND_ASYNC);
-                }
+            RenderPolicyWake(&g_renderPolicy);
+
+            // Other windows settled while this one was covered
+            if (wParam == ID_OCCLUSION_TIMER)
+            {
+                KillTimer(hwnd, ID_OCCLUSION_TIMER);
+                if (g_renderPolicy.dwHidden & POLICY_OCCLUDED)
+                    SetOccluded(hwnd, IsOccluded(hwnd), &stPrevious);
+                return 0;
             }
 
-            InvalidateRect(hBtnSound, NULL, TRUE);
-            InvalidateRect(hBtnRomanMode, NULL, TRUE);
-            InvalidateRect(hBtnDarkMode, NULL, TRUE);
-            InvalidateRect(hBtnFontSwitch, NULL, TRUE);
-            InvalidateRect(hBtnDots, NULL, TRUE);
-            InvalidateRect(hBtnMystery, NULL, TRUE);
-            UpdateWindow(hwnd);
+            // Re-arm for the next boundary; an early wake-up shows nothing
+            if (!TickSchedOnTimer(&g_tickSched, &uNextMs))
+            {
+                SetTimer(hwnd, ID_TIMER, uNextMs, NULL);
+                return 0;
+            }
+            SetTimer(hwnd, ID_TIMER, uNextMs, NULL);
+            if (g_tickSched.dwTicks && g_tickSched.dwTicks % 60 == 0)
+                ReportTickSchedStats();
+
+            GetClockTime(&st);
+            PublishTick(&st);
+            CheckAlarms(hwnd, &st);
+
+            // Being covered is only noticed here; being uncovered arrives
+            // through the hooks SetOccluded installs, or as WM_PAINT
+            // without desktop composition
+            if (!(g_renderPolicy.dwHidden & ~POLICY_OCCLUDED))
+                SetOccluded(hwnd, IsOccluded(hwnd), &stPrevious);
+
+            if (!RenderPolicyVisible(&g_renderPolicy))
+            {
+                if (g_bSoundOn && g_bTickHidden && RenderPolicyMode(&g_renderPolicy) == POLICY_AUDIO_ONLY)
+                    ScheduleTick(&st);
+                return 0;
+            }
+
+            if (g_gridView.nClocks)
+            {
+                stPrevious = st;
+                if (g_bSoundOn)
+                    ScheduleTick(&st);
+                InvalidateRect(hwnd, NULL, FALSE);
+                UpdateWindow(hwnd);
+                return 0;
+            }
+
+            // The sweep frames move the hands; a stopwatch does not tick
+            if (g_iSweepMode != SWEEP_OFF)
+            {
+                stPrevious = st;
+                if (g_bSoundOn && !g_bStopwatch)
+                    ScheduleTick(&st);
+                return 0;
+            }
+
+            fChange = st.wHour != stPrevious.wHour || st.wMinute != stPrevious.wMinute;
 
-            ReleaseDC(hwnd, hdc);
+            // Repaint only where the old and new hands are; WM_PAINT redraws
+            // every hand, clipped to that box, over the cached face
+            DamageEmpty(&damage);
+            AddHandDamage(&damage, &stPrevious, fChange, cxClient, cyClient);
+            AddHandDamage(&damage, &st, fChange, cxClient, cyClient);
+            DamageClip(&damage, cxClient, cyClient);
             stPrevious = st;
+
+            InvalidateHandDamage(hwnd, &damage);
+
+            qwStart = PhaseNowNs();
+            if (g_bSoundOn)
+                ScheduleTick(&st);
+            PhaseLap(&g_phaseStats, PHASE_AUDIO, &qwStart);
+            UpdateWindow(hwnd);
             return 0;
+        }
 
         case WM_PAINT:
+            if (g_renderPolicy.dwHidden & POLICY_OCCLUDED)
+                SetOccluded(hwnd, FALSE, &stPrevious);
+
             hdc = BeginPaint(hwnd, &ps);
+
+            if (g_gridView.nClocks)
+            {
+                PaintGrid(hdc, cxClient, cyClient);
+                EndPaint(hwnd, &ps);
+                return 0;
+            }
             
-            GetClientRect(hwnd, &rect);
-            FillRect(hdc, &rect, (HBRUSH)GetStockObject(g_bDarkMode ? BLACK_BRUSH : WHITE_BRUSH));
-            
-            SetIsotropic(hdc, cxClient, cyClient);
-            DrawClock(hdc);
-            DrawHands(hdc, &stPrevious, TRUE);
-            
+            // A paint inside one button (a hover or a press) leaves the
+            // face and hands alone
+            if (!CtrlContains(&g_controls, (DAMAGERECT*)&ps.rcPaint))
+            {
+                ExcludeControls(hdc);
+                if (g_bLiveResized)
+                    DrawScaledFace(hdc, cxClient, cyClient);
+                else
+                    DrawCachedFace(hdc, cxClient, cyClient, &ps.rcPaint);
+
+                qwStart = PhaseNowNs();
+                SetIsotropic(hdc, cxClient, cyClient);
+                PhaseLap(&g_phaseStats, PHASE_ISOTROPIC, &qwStart);
+                if (g_bStopwatch)
+                    DrawStopwatchDial(hdc);
+                if (g_iSweepMode != SWEEP_OFF && g_sweepHands.iTenths[0] >= 0)
+                    DrawSweepHands(hdc);
+                else
+                    DrawHands(hdc, &stPrevious, TRUE);
+                PhaseLap(&g_phaseStats, PHASE_HANDS, &qwStart);
+                DrawAlarmFlash(hdc, &ps.rcPaint);
+            }
+
+            // Buttons are drawn in this same pass, and only those the update
+            // region reaches: a tick's damage is cut around them
+            qwStart = PhaseNowNs();
+            DrawControls(hdc);
+            PhaseLap(&g_phaseStats, PHASE_BUTTONS, &qwStart);
+
             EndPaint(hwnd, &ps);
-            
-            RedrawWindow(hBtnSound, NULL, NULL, RDW_INVALIDATE | RDW_UPDATENOW);
-            RedrawWindow(hBtnRomanMode, NULL, NULL, RDW_INVALIDATE | RDW_UPDATENOW);
-            RedrawWindow(hBtnDarkMode, NULL, NULL, RDW_INVALIDATE | RDW_UPDATENOW);
-            RedrawWindow(hBtnFontSwitch, NULL, NULL, RDW_INVALIDATE | RDW_UPDATENOW);
-            RedrawWindow(hBtnDots, NULL, NULL, RDW_INVALIDATE | RDW_UPDATENOW);
-            RedrawWindow(hBtnMystery, NULL, NULL, RDW_INVALIDATE | RDW_UPDATENOW);
             return 0;
 
+        case WM_WTSSESSION_CHANGE:
+            if (wParam == WTS_SESSION_LOCK || wParam == WTS_SESSION_UNLOCK)
+            {
+                RenderPolicySet(&g_renderPolicy, POLICY_LOCKED, wParam == WTS_SESSION_LOCK);
+                ApplyRenderPolicy(hwnd, &stPrevious);
+            }
+            return 0;
+
+        case WM_TIMECHANGE:
+            // The time or the time zone was set; show it at once
+            TimeSourceInvalidate(&g_timeSource);
+            AlarmWheelRezone(&g_alarms);
+            InvalidateRect(hwnd, NULL, FALSE);
+            return 0;
+
+        case WM_KEYDOWN:
+            if (wParam == VK_F9)
+            {
+                DumpPhaseStats();
+                return 0;
+            }
+            // Auto-repeat would start and stop it over and over
+            if (g_bStopwatch)
+            {
+                if (!(lParam & 0x40000000))
+                    StopwatchKey(hwnd, wParam);
+                return 0;
+            }
+            break;
+
         case WM_DESTROY:
             KillTimer(hwnd, ID_TIMER);
+            WatchOcclusion(hwnd, FALSE);
+            WTSUnRegisterSessionNotification(hwnd);
+            timeEndPeriod(1);
+            ReportTickSchedStats();
+            ReportTimeSourceStats();
+            ReportFramePacerStats();
+            g_iSweepMode = SWEEP_OFF;
+            ReportRenderPolicyStats();
+            ReportFaceCacheStats();
+            ReportGridStats();
+            ReportTickAudioStats();
+            ReportControlStats();
+            ReportAlarmStats();
+            ReportStopwatchStats();
             FreeResources();
             PostQuitMessage(0);
             return 0;
@@ -0,0 +1,786 @@
+/*--------------------------
+    AARASTER.C -- Anti-aliased discs and thick lines
+                  (portable C with SSE2/AVX2 paths)
+---------------------------*/
+
+#include <math.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include "aaraster.h"
+
+#if defined(__AVX2__)
+#define AA_USE_AVX2
+#define AA_USE_SSE2
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define AA_USE_SSE2
+#include <emmintrin.h>
+#endif
+
+// Largest component of a unit normal is never below sqrt(1/2); clamping to
+// it also keeps the division finite at the very center of a disc
+#define AA_MIN_MAJOR 0.70710678f
+#define AA_MIN_LEN 1e-20f
+#define AA_MIN_MINOR 1e-6f
+
+// Sample rows per pixel for the reference coverage
+#define AA_REFERENCE_ROWS 1024
+
+// A pixel reaches at most sqrt(1/2) from its center along any normal
+#define AA_THIN 0.70710679
+
+// Farther than this along the band from both ends, no chord reaches a cap
+// and the slivers are exactly zero
+#define AA_CAP_REACH 1.5f
+
+// A disc is a capsule whose segment has no length. The float copy feeds
+// the per-pixel kernels, the double copy the row bounds.
+typedef struct
+{
+    float x0, y0, dx, dy, invLen2, len, r, inv6r;
+    float bandA, bandB;         // the band's normal, largest component first
+    int bBandSwap;              // the band's normal is closer to y than to x
+    int bDisc;
+    int bThin;                  // both sides of the shape can cross one pixel
+    double dx0, dy0, dx1, dy1, dr;
+    uint8_t rgb[3];
+} AASHAPE;
+
+typedef void (*AARUNFN)(const AASHAPE* pShape, uint8_t* p, int x, int xEnd, float py);
+
+static void InitShape(AASHAPE* pShape, double x0, double y0, double x1, double y1, double r, uint32_t color)
+{
+    float len2, ax, ay;
+
+    pShape->x0 = (float)x0;
+    pShape->y0 = (float)y0;
+    pShape->dx = (float)x1 - (float)x0;
+    pShape->dy = (float)y1 - (float)y0;
+    len2 = pShape->dx * pShape->dx + pShape->dy * pShape->dy;
+    pShape->bDisc = !(len2 > 0);
+    pShape->invLen2 = pShape->bDisc ? 0.0f : 1.0f / len2;
+    pShape->len = sqrtf(len2);
+    pShape->bandA = pShape->bandB = 0.0f;
+    pShape->bBandSwap = 0;
+    if (!pShape->bDisc)
+    {
+        ax = fabsf(pShape->dy) / pShape->len;
+        ay = fabsf(pShape->dx) / pShape->len;
+        pShape->bandA = ax > ay ? ax : ay;
+        pShape->bandB = ax < ay ? ax : ay;
+        pShape->bBandSwap = ay > ax;
+    }
+    pShape->r = (float)r;
+    pShape->inv6r = pShape->r > 0 ? 1.0f / (6.0f * pShape->r) : 0.0f;
+    pShape->bThin = r < AA_THIN;
+    pShape->dx0 = x0;
+    pShape->dy0 = y0;
+    pShape->dx1 = x1;
+    pShape->dy1 = y1;
+    pShape->dr = r;
+    pShape->rgb[0] = (uint8_t)(color >> 16);
+    pShape->rgb[1] = (uint8_t)(color >> 8);
+    pShape->rgb[2] = (uint8_t)color;
+}
+
+// Area of a pixel on the inside of an edge at distance s from its center
+// (positive inside), with (a, b) the edge normal's components, largest
+// first: linear in s across the middle, quadratic where a corner crosses
+static float EdgeCover(float s, float a, float b)
+{
+    float h = (a + b) * 0.5f;
+    float m = (a - b) * 0.5f;
+    float e;
+
+    if (s >= h)
+        return 1.0f;
+    if (s <= -h)
+        return 0.0f;
+    if (s > m)
+    {
+        e = h - s;
+        return 1.0f - e * e / (2.0f * a * b);
+    }
+    if (s < -m)
+    {
+        e = h + s;
+        return e * e / (2.0f * a * b);
+    }
+    return 0.5f + s / a;
+}
+
+// The part [*pu0, *pu1] of that edge's line inside the pixel, measured
+// along the line from the point nearest the center, in the frame where
+// the normal is (a, b)
+static void EdgeChord(float s, float a, float b, float* pu0, float* pu1)
+{
+    float bSafe = b > AA_MIN_MINOR ? b : AA_MIN_MINOR;
+    float u0 = (-0.5f - s * b) / a, u1 = (0.5f - s * b) / a;
+    float v0 = (s * a - 0.5f) / bSafe, v1 = (s * a + 0.5f) / bSafe;
+
+    *pu0 = u0 > v0 ? u0 : v0;
+    *pu1 = u1 < v1 ? u1 : v1;
+}
+
+// A circular edge of radius r falls u * u / (2 * r) behind its tangent
+// line at u along it, and a straight edge leaving a circle at u = j falls
+// (u - j) * (u - j) / (2 * r) short of the circle beyond it. These are
+// those slivers' areas within the chord [u0, u1], times 6 * r: the whole
+// arc, and the part past j in direction dir (+1 or -1).
+static float ArcSliver(float u0, float u1)
+{
+    return u1 * u1 * u1 - u0 * u0 * u0;
+}
+
+static float PastSliver(float u0, float u1, float j, float dir)
+{
+    float lo = dir > 0.0f ? u0 : -u1, hi = dir > 0.0f ? u1 : -u0;
+
+    j = dir * j;
+    lo = lo - j > 0.0f ? lo - j : 0.0f;
+    hi = hi - j > 0.0f ? hi - j : 0.0f;
+    return hi * hi * hi - lo * lo * lo;
+}
+
+// Coverage of the pixel centered at (px, py) as an alpha of 0 to 255. The
+// nearest edge counts as its tangent line, less the sliver the curve of
+// the cap takes off it: on a disc, everywhere; on a cap, up to where the
+// band's straight side leaves it; beside the band, past where a cap
+// starts. A thin shape also has its far side inside the pixel, at r + len,
+// whose outside area is taken back off. The SIMD paths below repeat these
+// float operations in the same order, so every path rounds identically
+// (given no FP contraction, as with -std=c11).
+static int CoverPixel(const AASHAPE* pShape, float px, float py)
+{
+    float wx = px - pShape->x0, wy = py - pShape->y0;
+    float t = (wx * pShape->dx + wy * pShape->dy) * pShape->invLen2;
+    float tRaw = t;
+    float qx, qy, len, lenSafe, ax, ay, a, b, s, u0, u1, sign, e, sliver, cov;
+    int bBand = t > 0.0f && t < 1.0f, bSwap;
+
+    t = t > 0.0f ? t : 0.0f;
+    t = t < 1.0f ? t : 1.0f;
+    qx = wx - t * pShape->dx;
+    qy = wy - t * pShape->dy;
+    len = sqrtf(qx * qx + qy * qy);
+    s = pShape->r - len;
+
+    // Beside the segment the normal is the band's, which stays defined
+    // for a pixel centered on the segment itself
+    lenSafe = len > AA_MIN_LEN ? len : AA_MIN_LEN;
+    ax = fabsf(qx) / lenSafe;
+    ay = fabsf(qy) / lenSafe;
+    a = ax > ay ? ax : ay;
+    b = ax < ay ? ax : ay;
+    bSwap = ay > ax;
+    a = bBand ? pShape->bandA : a;
+    b = bBand ? pShape->bandB : b;
+    bSwap = bBand ? pShape->bBandSwap : bSwap;
+    a = a > AA_MIN_MAJOR ? a : AA_MIN_MAJOR;
+
+    cov = EdgeCover(s, a, b);
+
+    // Each reflection into the (a, b) frame reverses the line's direction;
+    // sign is then +1 where the band runs toward increasing u
+    EdgeChord(s, a, b, &u0, &u1);
+    if (u1 > u0 && !(bBand && tRaw * pShape->len >= AA_CAP_REACH && (1.0f - tRaw) * pShape->len >= AA_CAP_REACH))
+    {
+        sign = (qx < 0.0f) ^ (qy < 0.0f) ^ bSwap ? -1.0f : 1.0f;
+        sign = qx * pShape->dy - qy * pShape->dx >= 0.0f ? sign : -sign;
+        if (pShape->bDisc)
+            sliver = ArcSliver(u0, u1);
+        else if (bBand)
+            sliver = PastSliver(u0, u1, sign * (1.0f - tRaw) * pShape->len, sign) +
+                PastSliver(u0, u1, -sign * tRaw * pShape->len, -sign);
+        else
+        {
+            sign = tRaw > 0.0f ? -sign : sign;
+            e = tRaw > 0.0f ? (tRaw - 1.0f) * pShape->len : -tRaw * pShape->len;
+            sliver = ArcSliver(u0, u1) - PastSliver(u0, u1, sign * pShape->r * e / lenSafe, sign);
+        }
+        cov -= sliver * pShape->inv6r;
+    }
+
+    if (pShape->bThin)
+        cov = cov + EdgeCover(pShape->r + len, a, b) - 1.0f;
+    cov = cov > 0.0f ? cov : 0.0f;
+    return (int)(cov * 255.0f + 0.5f);
+}
+
+// dst + (src - dst) * alpha / 255, rounded; (t + (t >> 8)) >> 8 is
+// round(t / 255) for every t this can produce
+static void BlendPixel(uint8_t* p, int iAlpha, const uint8_t rgb[3])
+{
+    int i, t;
+
+    for (i = 0; i < 3; i++)
+    {
+        t = rgb[i] * iAlpha + p[i] * (255 - iAlpha) + 128;
+        p[i] = (uint8_t)((t + (t >> 8)) >> 8);
+    }
+    t = 255 * iAlpha + p[3] * (255 - iAlpha) + 128;
+    p[3] = (uint8_t)((t + (t >> 8)) >> 8);
+}
+
+static void RunScalar(const AASHAPE* pShape, uint8_t* p, int x, int xEnd, float py)
+{
+    for (; x < xEnd; x++, p += 4)
+        BlendPixel(p, CoverPixel(pShape, (float)x + 0.5f, py), pShape->rgb);
+}
+
+#if defined(AA_USE_SSE2)
+
+// BlendPixel on four pixels, in 16-bit lanes: the largest t is 65153
+static void Blend4(uint8_t* p, __m128i alpha, __m128i src)
+{
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i k255 = _mm_set1_epi16(255), k128 = _mm_set1_epi16(128);
+    __m128i dst = _mm_loadu_si128((const __m128i*)p);
+    __m128i a16 = _mm_packs_epi32(alpha, alpha);
+    __m128i aPairs = _mm_unpacklo_epi16(a16, a16);
+    __m128i aLo = _mm_unpacklo_epi32(aPairs, aPairs);
+    __m128i aHi = _mm_unpackhi_epi32(aPairs, aPairs);
+    __m128i lo = _mm_unpacklo_epi8(dst, zero), hi = _mm_unpackhi_epi8(dst, zero);
+
+    lo = _mm_add_epi16(_mm_add_epi16(_mm_mullo_epi16(src, aLo),
+        _mm_mullo_epi16(lo, _mm_sub_epi16(k255, aLo))), k128);
+    hi = _mm_add_epi16(_mm_add_epi16(_mm_mullo_epi16(src, aHi),
+        _mm_mullo_epi16(hi, _mm_sub_epi16(k255, aHi))), k128);
+    lo = _mm_srli_epi16(_mm_add_epi16(lo, _mm_srli_epi16(lo, 8)), 8);
+    hi = _mm_srli_epi16(_mm_add_epi16(hi, _mm_srli_epi16(hi, 8)), 8);
+    _mm_storeu_si128((__m128i*)p, _mm_packus_epi16(lo, hi));
+}
+
+static __m128i BlendSource(const AASHAPE* pShape)
+{
+    return _mm_setr_epi16(pShape->rgb[0], pShape->rgb[1], pShape->rgb[2], 255,
+        pShape->rgb[0], pShape->rgb[1], pShape->rgb[2], 255);
+}
+
+static __m128 Select4(__m128 mask, __m128 a, __m128 b)
+{
+    return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
+}
+
+// EdgeCover on four lanes. The cheapest case goes first, then lanes are
+// overwritten from the bottom of the if-chain up, which also replaces any
+// lane where a division by zero made a NaN.
+static __m128 Edge4(__m128 s, __m128 a, __m128 b)
+{
+    const __m128 zero = _mm_setzero_ps(), one = _mm_set1_ps(1.0f), half = _mm_set1_ps(0.5f);
+    __m128 h = _mm_mul_ps(_mm_add_ps(a, b), half);
+    __m128 m = _mm_mul_ps(_mm_sub_ps(a, b), half);
+    __m128 ab2 = _mm_mul_ps(_mm_mul_ps(_mm_set1_ps(2.0f), a), b);
+    __m128 e, cov;
+
+    cov = _mm_add_ps(half, _mm_div_ps(s, a));
+    e = _mm_add_ps(h, s);
+    cov = Select4(_mm_cmplt_ps(s, _mm_sub_ps(zero, m)), _mm_div_ps(_mm_mul_ps(e, e), ab2), cov);
+    e = _mm_sub_ps(h, s);
+    cov = Select4(_mm_cmpgt_ps(s, m), _mm_sub_ps(one, _mm_div_ps(_mm_mul_ps(e, e), ab2)), cov);
+    cov = Select4(_mm_cmple_ps(s, _mm_sub_ps(zero, h)), zero, cov);
+    return Select4(_mm_cmpge_ps(s, h), one, cov);
+}
+
+static void Chord4(__m128 s, __m128 a, __m128 b, __m128* pu0, __m128* pu1)
+{
+    const __m128 half = _mm_set1_ps(0.5f);
+    __m128 bSafe = _mm_max_ps(b, _mm_set1_ps(AA_MIN_MINOR));
+    __m128 u0 = _mm_div_ps(_mm_sub_ps(_mm_set1_ps(-0.5f), _mm_mul_ps(s, b)), a);
+    __m128 u1 = _mm_div_ps(_mm_sub_ps(half, _mm_mul_ps(s, b)), a);
+    __m128 v0 = _mm_div_ps(_mm_sub_ps(_mm_mul_ps(s, a), half), bSafe);
+    __m128 v1 = _mm_div_ps(_mm_add_ps(_mm_mul_ps(s, a), half), bSafe);
+
+    *pu0 = _mm_max_ps(u0, v0);
+    *pu1 = _mm_min_ps(u1, v1);
+}
+
+static __m128 Cube4(__m128 x)
+{
+    return _mm_mul_ps(_mm_mul_ps(x, x), x);
+}
+
+static __m128 Past4(__m128 u0, __m128 u1, __m128 j, __m128 dir)
+{
+    const __m128 zero = _mm_setzero_ps(), neg = _mm_set1_ps(-0.0f);
+    __m128 fwd = _mm_cmpgt_ps(dir, zero);
+    __m128 lo = Select4(fwd, u0, _mm_xor_ps(u1, neg)), hi = Select4(fwd, u1, _mm_xor_ps(u0, neg));
+
+    j = _mm_mul_ps(dir, j);
+    lo = _mm_max_ps(_mm_sub_ps(lo, j), zero);
+    hi = _mm_max_ps(_mm_sub_ps(hi, j), zero);
+    return _mm_sub_ps(Cube4(hi), Cube4(lo));
+}
+
+// CoverPixel for four pixel centers px on one row
+static __m128i Cover4(const AASHAPE* pShape, __m128 px, __m128 py)
+{
+    const __m128 zero = _mm_setzero_ps(), one = _mm_set1_ps(1.0f), neg = _mm_set1_ps(-0.0f);
+    const __m128 absMask = _mm_castsi128_ps(_mm_set1_epi32(0x7FFFFFFF));
+    __m128 dx = _mm_set1_ps(pShape->dx), dy = _mm_set1_ps(pShape->dy);
+    __m128 r = _mm_set1_ps(pShape->r), segLen = _mm_set1_ps(pShape->len);
+    __m128 wx = _mm_sub_ps(px, _mm_set1_ps(pShape->x0));
+    __m128 wy = _mm_sub_ps(py, _mm_set1_ps(pShape->y0));
+    __m128 t = _mm_mul_ps(_mm_add_ps(_mm_mul_ps(wx, dx), _mm_mul_ps(wy, dy)), _mm_set1_ps(pShape->invLen2));
+    __m128 tRaw = t;
+    __m128 band = _mm_and_ps(_mm_cmpgt_ps(t, zero), _mm_cmplt_ps(t, one));
+    __m128 qx, qy, len, lenSafe, ax, ay, a, b, swap, s, cov, reach, far;
+    __m128 u0, u1, cross, sign, capSign, e, bandSliver, capSliver, sliver;
+
+    t = _mm_min_ps(_mm_max_ps(t, zero), one);
+    qx = _mm_sub_ps(wx, _mm_mul_ps(t, dx));
+    qy = _mm_sub_ps(wy, _mm_mul_ps(t, dy));
+    len = _mm_sqrt_ps(_mm_add_ps(_mm_mul_ps(qx, qx), _mm_mul_ps(qy, qy)));
+    s = _mm_sub_ps(r, len);
+
+    lenSafe = _mm_max_ps(len, _mm_set1_ps(AA_MIN_LEN));
+    ax = _mm_div_ps(_mm_and_ps(qx, absMask), lenSafe);
+    ay = _mm_div_ps(_mm_and_ps(qy, absMask), lenSafe);
+    a = _mm_max_ps(ax, ay);
+    b = _mm_min_ps(ax, ay);
+    swap = _mm_cmpgt_ps(ay, ax);
+    a = Select4(band, _mm_set1_ps(pShape->bandA), a);
+    b = Select4(band, _mm_set1_ps(pShape->bandB), b);
+    swap = Select4(band, pShape->bBandSwap ? _mm_castsi128_ps(_mm_set1_epi32(-1)) : zero, swap);
+    a = _mm_max_ps(a, _mm_set1_ps(AA_MIN_MAJOR));
+
+    cov = Edge4(s, a, b);
+
+    // Only lanes near a cap or on it can lose a sliver
+    reach = _mm_set1_ps(AA_CAP_REACH);
+    far = _mm_and_ps(band, _mm_and_ps(_mm_cmpge_ps(_mm_mul_ps(tRaw, segLen), reach),
+        _mm_cmpge_ps(_mm_mul_ps(_mm_sub_ps(one, tRaw), segLen), reach)));
+    if (_mm_movemask_ps(far) != 0xF || pShape->bDisc)
+    {
+        Chord4(s, a, b, &u0, &u1);
+        sign = _mm_xor_ps(_mm_cmplt_ps(qx, zero), _mm_cmplt_ps(qy, zero));
+        sign = _mm_xor_ps(sign, swap);
+        sign = Select4(sign, _mm_set1_ps(-1.0f), one);
+        cross = _mm_sub_ps(_mm_mul_ps(qx, dy), _mm_mul_ps(qy, dx));
+        sign = Select4(_mm_cmpge_ps(cross, zero), sign, _mm_xor_ps(sign, neg));
+        if (pShape->bDisc)
+            sliver = _mm_sub_ps(Cube4(u1), Cube4(u0));
+        else
+        {
+            __m128 past = _mm_cmpgt_ps(tRaw, zero);
+            __m128 flip = _mm_xor_ps(sign, neg);
+
+            capSign = Select4(past, flip, sign);
+            e = Select4(past, _mm_mul_ps(_mm_sub_ps(tRaw, one), segLen), _mm_mul_ps(_mm_xor_ps(tRaw, neg), segLen));
+            e = _mm_div_ps(_mm_mul_ps(_mm_mul_ps(capSign, r), e), lenSafe);
+            bandSliver = _mm_add_ps(
+                Past4(u0, u1, _mm_mul_ps(_mm_mul_ps(sign, _mm_sub_ps(one, tRaw)), segLen), sign),
+                Past4(u0, u1, _mm_mul_ps(_mm_mul_ps(flip, tRaw), segLen), flip));
+            capSliver = _mm_sub_ps(_mm_sub_ps(Cube4(u1), Cube4(u0)), Past4(u0, u1, e, capSign));
+            sliver = Select4(band, bandSliver, capSliver);
+        }
+        sliver = _mm_and_ps(_mm_cmpgt_ps(u1, u0), sliver);
+        cov = _mm_sub_ps(cov, _mm_mul_ps(sliver, _mm_set1_ps(pShape->inv6r)));
+    }
+
+    if (pShape->bThin)
+        cov = _mm_sub_ps(_mm_add_ps(cov, Edge4(_mm_add_ps(r, len), a, b)), one);
+    cov = _mm_max_ps(cov, zero);
+    return _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(cov, _mm_set1_ps(255.0f)), _mm_set1_ps(0.5f)));
+}
+
+#endif
+
+#if defined(AA_USE_AVX2)
+
+static __m256 Select8(__m256 mask, __m256 a, __m256 b)
+{
+    return _mm256_blendv_ps(b, a, mask);
+}
+
+static __m256 Edge8(__m256 s, __m256 a, __m256 b)
+{
+    const __m256 zero = _mm256_setzero_ps(), one = _mm256_set1_ps(1.0f), half = _mm256_set1_ps(0.5f);
+    __m256 h = _mm256_mul_ps(_mm256_add_ps(a, b), half);
+    __m256 m = _mm256_mul_ps(_mm256_sub_ps(a, b), half);
+    __m256 ab2 = _mm256_mul_ps(_mm256_mul_ps(_mm256_set1_ps(2.0f), a), b);
+    __m256 e, cov;
+
+    cov = _mm256_add_ps(half, _mm256_div_ps(s, a));
+    e = _mm256_add_ps(h, s);
+    cov = Select8(_mm256_cmp_ps(s, _mm256_sub_ps(zero, m), _CMP_LT_OQ), _mm256_div_ps(_mm256_mul_ps(e, e), ab2), cov);
+    e = _mm256_sub_ps(h, s);
+    cov = Select8(_mm256_cmp_ps(s, m, _CMP_GT_OQ), _mm256_sub_ps(one, _mm256_div_ps(_mm256_mul_ps(e, e), ab2)), cov);
+    cov = Select8(_mm256_cmp_ps(s, _mm256_sub_ps(zero, h), _CMP_LE_OQ), zero, cov);
+    return Select8(_mm256_cmp_ps(s, h, _CMP_GE_OQ), one, cov);
+}
+
+static void Chord8(__m256 s, __m256 a, __m256 b, __m256* pu0, __m256* pu1)
+{
+    const __m256 half = _mm256_set1_ps(0.5f);
+    __m256 bSafe = _mm256_max_ps(b, _mm256_set1_ps(AA_MIN_MINOR));
+    __m256 u0 = _mm256_div_ps(_mm256_sub_ps(_mm256_set1_ps(-0.5f), _mm256_mul_ps(s, b)), a);
+    __m256 u1 = _mm256_div_ps(_mm256_sub_ps(half, _mm256_mul_ps(s, b)), a);
+    __m256 v0 = _mm256_div_ps(_mm256_sub_ps(_mm256_mul_ps(s, a), half), bSafe);
+    __m256 v1 = _mm256_div_ps(_mm256_add_ps(_mm256_mul_ps(s, a), half), bSafe);
+
+    *pu0 = _mm256_max_ps(u0, v0);
+    *pu1 = _mm256_min_ps(u1, v1);
+}
+
+static __m256 Cube8(__m256 x)
+{
+    return _mm256_mul_ps(_mm256_mul_ps(x, x), x);
+}
+
+static __m256 Past8(__m256 u0, __m256 u1, __m256 j, __m256 dir)
+{
+    const __m256 zero = _mm256_setzero_ps(), neg = _mm256_set1_ps(-0.0f);
+    __m256 fwd = _mm256_cmp_ps(dir, zero, _CMP_GT_OQ);
+    __m256 lo = Select8(fwd, u0, _mm256_xor_ps(u1, neg)), hi = Select8(fwd, u1, _mm256_xor_ps(u0, neg));
+
+    j = _mm256_mul_ps(dir, j);
+    lo = _mm256_max_ps(_mm256_sub_ps(lo, j), zero);
+    hi = _mm256_max_ps(_mm256_sub_ps(hi, j), zero);
+    return _mm256_sub_ps(Cube8(hi), Cube8(lo));
+}
+
+// Cover4 eight lanes wide
+static __m256i Cover8(const AASHAPE* pShape, __m256 px, __m256 py)
+{
+    const __m256 zero = _mm256_setzero_ps(), one = _mm256_set1_ps(1.0f), neg = _mm256_set1_ps(-0.0f);
+    const __m256 absMask = _mm256_castsi256_ps(_mm256_set1_epi32(0x7FFFFFFF));
+    __m256 dx = _mm256_set1_ps(pShape->dx), dy = _mm256_set1_ps(pShape->dy);
+    __m256 r = _mm256_set1_ps(pShape->r), segLen = _mm256_set1_ps(pShape->len);
+    __m256 wx = _mm256_sub_ps(px, _mm256_set1_ps(pShape->x0));
+    __m256 wy = _mm256_sub_ps(py, _mm256_set1_ps(pShape->y0));
+    __m256 t = _mm256_mul_ps(_mm256_add_ps(_mm256_mul_ps(wx, dx), _mm256_mul_ps(wy, dy)),
+        _mm256_set1_ps(pShape->invLen2));
+    __m256 tRaw = t;
+    __m256 band = _mm256_and_ps(_mm256_cmp_ps(t, zero, _CMP_GT_OQ), _mm256_cmp_ps(t, one, _CMP_LT_OQ));
+    __m256 qx, qy, len, lenSafe, ax, ay, a, b, swap, s, cov, reach, far;
+    __m256 u0, u1, cross, sign, capSign, e, bandSliver, capSliver, sliver;
+
+    t = _mm256_min_ps(_mm256_max_ps(t, zero), one);
+    qx = _mm256_sub_ps(wx, _mm256_mul_ps(t, dx));
+    qy = _mm256_sub_ps(wy, _mm256_mul_ps(t, dy));
+    len = _mm256_sqrt_ps(_mm256_add_ps(_mm256_mul_ps(qx, qx), _mm256_mul_ps(qy, qy)));
+    s = _mm256_sub_ps(r, len);
+
+    lenSafe = _mm256_max_ps(len, _mm256_set1_ps(AA_MIN_LEN));
+    ax = _mm256_div_ps(_mm256_and_ps(qx, absMask), lenSafe);
+    ay = _mm256_div_ps(_mm256_and_ps(qy, absMask), lenSafe);
+    a = _mm256_max_ps(ax, ay);
+    b = _mm256_min_ps(ax, ay);
+    swap = _mm256_cmp_ps(ay, ax, _CMP_GT_OQ);
+    a = Select8(band, _mm256_set1_ps(pShape->bandA), a);
+    b = Select8(band, _mm256_set1_ps(pShape->bandB), b);
+    swap = Select8(band, pShape->bBandSwap ? _mm256_castsi256_ps(_mm256_set1_epi32(-1)) : zero, swap);
+    a = _mm256_max_ps(a, _mm256_set1_ps(AA_MIN_MAJOR));
+
+    cov = Edge8(s, a, b);
+
+    // Only lanes near a cap or on it can lose a sliver
+    reach = _mm256_set1_ps(AA_CAP_REACH);
+    far = _mm256_and_ps(band, _mm256_and_ps(_mm256_cmp_ps(_mm256_mul_ps(tRaw, segLen), reach, _CMP_GE_OQ),
+        _mm256_cmp_ps(_mm256_mul_ps(_mm256_sub_ps(one, tRaw), segLen), reach, _CMP_GE_OQ)));
+    if (_mm256_movemask_ps(far) != 0xFF || pShape->bDisc)
+    {
+        Chord8(s, a, b, &u0, &u1);
+        sign = _mm256_xor_ps(_mm256_cmp_ps(qx, zero, _CMP_LT_OQ), _mm256_cmp_ps(qy, zero, _CMP_LT_OQ));
+        sign = _mm256_xor_ps(sign, swap);
+        sign = Select8(sign, _mm256_set1_ps(-1.0f), one);
+        cross = _mm256_sub_ps(_mm256_mul_ps(qx, dy), _mm256_mul_ps(qy, dx));
+        sign = Select8(_mm256_cmp_ps(cross, zero, _CMP_GE_OQ), sign, _mm256_xor_ps(sign, neg));
+        if (pShape->bDisc)
+            sliver = _mm256_sub_ps(Cube8(u1), Cube8(u0));
+        else
+        {
+            __m256 past = _mm256_cmp_ps(tRaw, zero, _CMP_GT_OQ);
+            __m256 flip = _mm256_xor_ps(sign, neg);
+
+            capSign = Select8(past, flip, sign);
+            e = Select8(past, _mm256_mul_ps(_mm256_sub_ps(tRaw, one), segLen),
+                _mm256_mul_ps(_mm256_xor_ps(tRaw, neg), segLen));
+            e = _mm256_div_ps(_mm256_mul_ps(_mm256_mul_ps(capSign, r), e), lenSafe);
+            bandSliver = _mm256_add_ps(
+                Past8(u0, u1, _mm256_mul_ps(_mm256_mul_ps(sign, _mm256_sub_ps(one, tRaw)), segLen), sign),
+                Past8(u0, u1, _mm256_mul_ps(_mm256_mul_ps(flip, tRaw), segLen), flip));
+            capSliver = _mm256_sub_ps(_mm256_sub_ps(Cube8(u1), Cube8(u0)), Past8(u0, u1, e, capSign));
+            sliver = Select8(band, bandSliver, capSliver);
+        }
+        sliver = _mm256_and_ps(_mm256_cmp_ps(u1, u0, _CMP_GT_OQ), sliver);
+        cov = _mm256_sub_ps(cov, _mm256_mul_ps(sliver, _mm256_set1_ps(pShape->inv6r)));
+    }
+
+    if (pShape->bThin)
+        cov = _mm256_sub_ps(_mm256_add_ps(cov, Edge8(_mm256_add_ps(r, len), a, b)), one);
+    cov = _mm256_max_ps(cov, zero);
+    return _mm256_cvttps_epi32(_mm256_add_ps(_mm256_mul_ps(cov, _mm256_set1_ps(255.0f)), _mm256_set1_ps(0.5f)));
+}
+
+// Coverage eight pixels at a time; blending stays four wide, since the
+// 256-bit byte unpacks work within 128-bit halves anyway. Edge runs are
+// often only a few pixels, so four more go through the SSE2 kernel.
+static void RunSimd(const AASHAPE* pShape, uint8_t* p, int x, int xEnd, float py)
+{
+    const __m256 lanes = _mm256_setr_ps(0.5f, 1.5f, 2.5f, 3.5f, 4.5f, 5.5f, 6.5f, 7.5f);
+    __m256 vy = _mm256_set1_ps(py);
+    __m128i src = BlendSource(pShape);
+    __m256i alpha;
+
+    for (; x + 8 <= xEnd; x += 8, p += 32)
+    {
+        alpha = Cover8(pShape, _mm256_add_ps(_mm256_set1_ps((float)x), lanes), vy);
+        Blend4(p, _mm256_castsi256_si128(alpha), src);
+        Blend4(p + 16, _mm256_extracti128_si256(alpha, 1), src);
+    }
+    if (x + 4 <= xEnd)
+    {
+        Blend4(p, Cover4(pShape, _mm_add_ps(_mm_set1_ps((float)x), _mm256_castps256_ps128(lanes)),
+            _mm_set1_ps(py)), src);
+        x += 4;
+        p += 16;
+    }
+    RunScalar(pShape, p, x, xEnd, py);
+}
+
+const char* AAKernelName(void)
+{
+    return "avx2";
+}
+
+#elif defined(AA_USE_SSE2)
+
+static void RunSimd(const AASHAPE* pShape, uint8_t* p, int x, int xEnd, float py)
+{
+    const __m128 lanes = _mm_setr_ps(0.5f, 1.5f, 2.5f, 3.5f);
+    __m128 vy = _mm_set1_ps(py);
+    __m128i src = BlendSource(pShape);
+
+    for (; x + 4 <= xEnd; x += 4, p += 16)
+        Blend4(p, Cover4(pShape, _mm_add_ps(_mm_set1_ps((float)x), lanes), vy), src);
+    RunScalar(pShape, p, x, xEnd, py);
+}
+
+const char* AAKernelName(void)
+{
+    return "sse2";
+}
+
+#else
+
+#define RunSimd RunScalar
+
+const char* AAKernelName(void)
+{
+    return "scalar";
+}
+
+#endif
+
+// Visits the rows the shape can touch. Pixels whose centers are within
+// r - 1 of the segment are fully covered and filled directly; those
+// within r + 1 (a pixel reaches sqrt(1/2) from its center) go through
+// pfnRun. Everything else has no coverage.
+static void DrawShape(FRAMEBUFFER* pFb, const RASTERCLIP* pClip, const AASHAPE* pShape, AARUNFN pfnRun)
+{
+    double rOuter = pShape->dr + 1, rInner = pShape->dr - 1;
+    double xl, xr;
+    int left = 0, right = pFb->cx, top = 0, bottom = pFb->cy;
+    int y, yTop, yBottom, x0, x1, xs0, xs1, x;
+    uint8_t* pRow;
+
+    if (pClip)
+    {
+        if (pClip->left > left) left = pClip->left;
+        if (pClip->right < right) right = pClip->right;
+        if (pClip->top > top) top = pClip->top;
+        if (pClip->bottom < bottom) bottom = pClip->bottom;
+    }
+
+    yTop = (int)floor((pShape->dy0 < pShape->dy1 ? pShape->dy0 : pShape->dy1) - rOuter);
+    yBottom = (int)ceil((pShape->dy0 > pShape->dy1 ? pShape->dy0 : pShape->dy1) + rOuter);
+    if (yTop < top) yTop = top;
+    if (yBottom > bottom - 1) yBottom = bottom - 1;
+
+    for (y = yTop; y <= yBottom; y++)
+    {
+        if (!RasterCapsuleRow(pShape->dx0, pShape->dy0, pShape->dx1, pShape->dy1, rOuter, y + 0.5, &xl, &xr))
+            continue;
+        x0 = (int)floor(xl - 0.5);
+        x1 = (int)ceil(xr - 0.5) + 1;
+        if (x0 < left) x0 = left;
+        if (x1 > right) x1 = right;
+        if (x0 >= x1)
+            continue;
+
+        xs0 = xs1 = x1;
+        if (rInner > 0 &&
+            RasterCapsuleRow(pShape->dx0, pShape->dy0, pShape->dx1, pShape->dy1, rInner, y + 0.5, &xl, &xr))
+        {
+            xs0 = (int)ceil(xl - 0.5);
+            xs1 = (int)floor(xr - 0.5) + 1;
+            if (xs0 < x0) xs0 = x0;
+            if (xs1 > x1) xs1 = x1;
+            if (xs0 >= xs1)
+                xs0 = xs1 = x1;
+        }
+
+        pRow = pFb->pPixels + (size_t)y * pFb->cx * 4;
+        pfnRun(pShape, pRow + (size_t)x0 * 4, x0, xs0, (float)y + 0.5f);
+        for (x = xs0; x < xs1; x++)
+        {
+            pRow[x * 4] = pShape->rgb[0];
+            pRow[x * 4 + 1] = pShape->rgb[1];
+            pRow[x * 4 + 2] = pShape->rgb[2];
+            pRow[x * 4 + 3] = 255;
+        }
+        pfnRun(pShape, pRow + (size_t)xs1 * 4, xs1, x1, (float)y + 0.5f);
+    }
+}
+
+static double LineRadius(double width)
+{
+    return width / 2 < 0.5 ? 0.5 : width / 2;
+}
+
+void AAFillDisc(FRAMEBUFFER* pFb, const RASTERCLIP* pClip, double xc, double yc, double r, uint32_t color)
+{
+    AASHAPE shape;
+
+    InitShape(&shape, xc, yc, xc, yc, r, color);
+    DrawShape(pFb, pClip, &shape, RunSimd);
+}
+
+void AAThickLine(FRAMEBUFFER* pFb, const RASTERCLIP* pClip, double x0, double y0, double x1, double y1,
+    double width, uint32_t color)
+{
+    AASHAPE shape;
+
+    InitShape(&shape, x0, y0, x1, y1, LineRadius(width), color);
+    DrawShape(pFb, pClip, &shape, RunSimd);
+}
+
+void AAFillDiscScalar(FRAMEBUFFER* pFb, const RASTERCLIP* pClip, double xc, double yc, double r, uint32_t color)
+{
+    AASHAPE shape;
+
+    InitShape(&shape, xc, yc, xc, yc, r, color);
+    DrawShape(pFb, pClip, &shape, RunScalar);
+}
+
+void AAThickLineScalar(FRAMEBUFFER* pFb, const RASTERCLIP* pClip, double x0, double y0, double x1, double y1,
+    double width, uint32_t color)
+{
+    AASHAPE shape;
+
+    InitShape(&shape, x0, y0, x1, y1, LineRadius(width), color);
+    DrawShape(pFb, pClip, &shape, RunScalar);
+}
+
+// nGrid rows of samples per pixel, each crossing the shape in one interval.
+// Plain supersampling counts the nGrid points per pixel row inside it;
+// the reference adds up the exact length inside instead, which leaves
+// only the error of the row spacing.
+static void DrawSampled(FRAMEBUFFER* pFb, const RASTERCLIP* pClip, const AASHAPE* pShape, int nGrid, int bExact)
+{
+    double xl, xr, xa, xb, yc;
+    double* pCover;
+    int left = 0, right = pFb->cx, top = 0, bottom = pFb->cy;
+    int y, yTop, yBottom, x, x0, x1, j, iLo, iHi, iAlpha;
+
+    if (pClip)
+    {
+        if (pClip->left > left) left = pClip->left;
+        if (pClip->right < right) right = pClip->right;
+        if (pClip->top > top) top = pClip->top;
+        if (pClip->bottom < bottom) bottom = pClip->bottom;
+    }
+    if (left >= right || nGrid < 1)
+        return;
+    pCover = (double*)malloc((size_t)(right - left) * sizeof(double));
+    if (!pCover)
+        return;
+
+    yTop = (int)floor((pShape->dy0 < pShape->dy1 ? pShape->dy0 : pShape->dy1) - pShape->dr);
+    yBottom = (int)ceil((pShape->dy0 > pShape->dy1 ? pShape->dy0 : pShape->dy1) + pShape->dr);
+    if (yTop < top) yTop = top;
+    if (yBottom > bottom - 1) yBottom = bottom - 1;
+
+    for (y = yTop; y <= yBottom; y++)
+    {
+        x0 = right;
+        x1 = left;
+        for (j = 0; j < nGrid; j++)
+        {
+            yc = y + (j + 0.5) / nGrid;
+            if (!RasterCapsuleRow(pShape->dx0, pShape->dy0, pShape->dx1, pShape->dy1, pShape->dr, yc, &xl, &xr))
+                continue;
+            xa = floor(xl) > left ? floor(xl) : left;
+            xb = ceil(xr) < right ? ceil(xr) : right;
+            for (x = (int)xa; x < (int)xb; x++)
+            {
+                if (x < x0 || x >= x1)
+                {
+                    // First touch of this pixel on this row
+                    if (x0 >= x1)
+                        x0 = x1 = x;
+                    while (x < x0)
+                        pCover[--x0 - left] = 0;
+                    while (x >= x1)
+                        pCover[x1++ - left] = 0;
+                }
+                if (bExact)
+                    pCover[x - left] += ((xr < x + 1 ? xr : x + 1) - (xl > x ? xl : x)) / nGrid;
+                else
+                {
+                    iLo = (int)ceil((xl - x) * nGrid - 0.5);
+                    iHi = (int)floor((xr - x) * nGrid - 0.5);
+                    if (iLo < 0) iLo = 0;
+                    if (iHi > nGrid - 1) iHi = nGrid - 1;
+                    if (iHi >= iLo)
+                        pCover[x - left] += (double)(iHi - iLo + 1) / ((double)nGrid * nGrid);
+                }
+            }
+        }
+
+        for (x = x0; x < x1; x++)
+        {
+            iAlpha = (int)(pCover[x - left] * 255 + 0.5);
+            if (iAlpha > 0)
+                BlendPixel(pFb->pPixels + ((size_t)y * pFb->cx + x) * 4, iAlpha > 255 ? 255 : iAlpha, pShape->rgb);
+        }
+    }
+    free(pCover);
+}
+
+void AAFillDiscSampled(FRAMEBUFFER* pFb, const RASTERCLIP* pClip, double xc, double yc, double r, uint32_t color,
+    int nGrid)
+{
+    AASHAPE shape;
+
+    InitShape(&shape, xc, yc, xc, yc, r, color);
+    DrawSampled(pFb, pClip, &shape, nGrid, 0);
+}
+
+void AAThickLineSampled(FRAMEBUFFER* pFb, const RASTERCLIP* pClip, double x0, double y0, double x1, double y1,
+    double width, uint32_t color, int nGrid)
+{
+    AASHAPE shape;
+
+    InitShape(&shape, x0, y0, x1, y1, LineRadius(width), color);
+    DrawSampled(pFb, pClip, &shape, nGrid, 0);
+}
+
+void AAFillDiscReference(FRAMEBUFFER* pFb, const RASTERCLIP* pClip, double xc, double yc, double r, uint32_t color)
+{
+    AASHAPE shape;
+
+    InitShape(&shape, xc, yc, xc, yc, r, color);
+    DrawSampled(pFb, pClip, &shape, AA_REFERENCE_ROWS, 1);
+}
+
+void AAThickLineReference(FRAMEBUFFER* pFb, const RASTERCLIP* pClip, double x0, double y0, double x1, double y1,
+    double width, uint32_t color)
+{
+    AASHAPE shape;
+
+    InitShape(&shape, x0, y0, x1, y1, LineRadius(width), color);
+    DrawSampled(pFb, pClip, &shape, AA_REFERENCE_ROWS, 1);
+}
@@ -0,0 +1,38 @@
+/*--------------------------
+    AARASTER.H -- Anti-aliased discs and thick lines for the software rasterizer
+---------------------------*/
+
+#ifndef AARASTER_H
+#define AARASTER_H
+
+#include "raster.h"
+
+// Device-space shapes blended into pFb by how much of each pixel they
+// cover. Coverage is the exact area of the pixel on the inside of the
+// edge's tangent line at the pixel center, so it is off only by the
+// curvature of the edge within one pixel. pClip may be NULL.
+void AAFillDisc(FRAMEBUFFER* pFb, const RASTERCLIP* pClip, double xc, double yc, double r, uint32_t color);
+void AAThickLine(FRAMEBUFFER* pFb, const RASTERCLIP* pClip, double x0, double y0, double x1, double y1,
+    double width, uint32_t color);
+
+// Plain C paths; the calls above give exactly the same pixels
+void AAFillDiscScalar(FRAMEBUFFER* pFb, const RASTERCLIP* pClip, double xc, double yc, double r, uint32_t color);
+void AAThickLineScalar(FRAMEBUFFER* pFb, const RASTERCLIP* pClip, double x0, double y0, double x1, double y1,
+    double width, uint32_t color);
+
+// Plain supersampling: coverage counted from nGrid x nGrid points per pixel
+void AAFillDiscSampled(FRAMEBUFFER* pFb, const RASTERCLIP* pClip, double xc, double yc, double r, uint32_t color,
+    int nGrid);
+void AAThickLineSampled(FRAMEBUFFER* pFb, const RASTERCLIP* pClip, double x0, double y0, double x1, double y1,
+    double width, uint32_t color, int nGrid);
+
+// The coverage the kernels are checked against: the exact width inside
+// the shape on 1024 rows per pixel. Slow; for tests and benchmarks only.
+void AAFillDiscReference(FRAMEBUFFER* pFb, const RASTERCLIP* pClip, double xc, double yc, double r, uint32_t color);
+void AAThickLineReference(FRAMEBUFFER* pFb, const RASTERCLIP* pClip, double x0, double y0, double x1, double y1,
+    double width, uint32_t color);
+
+// Name of the path AAFillDisc and AAThickLine use ("avx2", "sse2" or "scalar")
+const char* AAKernelName(void);
+
+#endif
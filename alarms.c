@@ -0,0 +1,571 @@
+/*--------------------------
+    ALARMS.C -- One-shot, recurring and per-zone alarms on a hierarchical timing wheel
+---------------------------*/
+
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "alarms.h"
+
+#define ALARM_UNFILED 0xFFFF
+#define SEC_PER_DAY 86400
+
+static int64_t FloorDiv(int64_t a, int64_t b)
+{
+    return a / b - (a % b < 0);
+}
+
+int AlarmWheelInit(ALARMWHEEL* pWheel, int32_t nCapacity, int64_t llNowUtc, const TIMECLOCK* pClock)
+{
+    int32_t i;
+
+    memset(pWheel, 0, sizeof(*pWheel));
+    if (nCapacity < 1 || nCapacity > ALARM_MAX_CAPACITY)
+        return 0;
+    pWheel->pAlarms = (ALARM*)calloc(nCapacity, sizeof(ALARM));
+    if (!pWheel->pAlarms)
+        return 0;
+
+    pWheel->nCapacity = nCapacity;
+    for (i = 0; i < nCapacity; i++)
+    {
+        pWheel->pAlarms[i].iNext = i + 1 < nCapacity ? i + 1 : -1;
+        pWheel->pAlarms[i].iPrev = -2;
+        pWheel->pAlarms[i].wSlot = ALARM_UNFILED;
+    }
+    pWheel->iFree = 0;
+    for (i = 0; i < ALARM_LEVELS * ALARM_SLOTS; i++)
+        pWheel->heads[i] = -1;
+    pWheel->llNow = llNowUtc;
+    if (pClock)
+        pWheel->clock = *pClock;
+    return 1;
+}
+
+void AlarmWheelFree(ALARMWHEEL* pWheel)
+{
+    free(pWheel->pAlarms);
+    pWheel->pAlarms = NULL;
+    pWheel->nCapacity = 0;
+    pWheel->nPending = 0;
+}
+
+static uint32_t AlarmId(const ALARMWHEEL* pWheel, int32_t i)
+{
+    return ((uint32_t)pWheel->pAlarms[i].bGen << 24) | (uint32_t)(i + 1);
+}
+
+// Files alarm i in the slot it waits in until llAt, which must not be
+// before the current second: the lowest level whose block of seconds
+// holds both llAt and now, at llAt's place in it. An alarm left beyond
+// the horizon by a jump back waits in the last top-level slot and is
+// filed again from there.
+static void File(ALARMWHEEL* pWheel, int32_t i, int64_t llAt)
+{
+    ALARM* pAlarm = &pWheel->pAlarms[i];
+    int iLevel, iSlot;
+
+    if (llAt - pWheel->llNow > ALARM_HORIZON_SEC)
+        llAt = pWheel->llNow + ALARM_HORIZON_SEC;
+    for (iLevel = 0; iLevel < ALARM_LEVELS - 1; iLevel++)
+        if ((llAt >> (ALARM_SLOT_BITS * (iLevel + 1))) == (pWheel->llNow >> (ALARM_SLOT_BITS * (iLevel + 1))))
+            break;
+    iSlot = iLevel * ALARM_SLOTS + (int)((llAt >> (ALARM_SLOT_BITS * iLevel)) & (ALARM_SLOTS - 1));
+
+    pAlarm->wSlot = (uint16_t)iSlot;
+    pAlarm->iPrev = -1;
+    pAlarm->iNext = pWheel->heads[iSlot];
+    if (pAlarm->iNext >= 0)
+        pWheel->pAlarms[pAlarm->iNext].iPrev = i;
+    pWheel->heads[iSlot] = i;
+}
+
+static void Unfile(ALARMWHEEL* pWheel, int32_t i)
+{
+    ALARM* pAlarm = &pWheel->pAlarms[i];
+
+    if (pAlarm->wSlot == ALARM_UNFILED)
+        return;
+    if (pAlarm->iPrev >= 0)
+        pWheel->pAlarms[pAlarm->iPrev].iNext = pAlarm->iNext;
+    else
+        pWheel->heads[pAlarm->wSlot] = pAlarm->iNext;
+    if (pAlarm->iNext >= 0)
+        pWheel->pAlarms[pAlarm->iNext].iPrev = pAlarm->iPrev;
+    pAlarm->wSlot = ALARM_UNFILED;
+}
+
+static void Release(ALARMWHEEL* pWheel, int32_t i)
+{
+    ALARM* pAlarm = &pWheel->pAlarms[i];
+
+    pAlarm->bGen++;
+    pAlarm->bKind = ALARM_ONCE;
+    pAlarm->wSlot = ALARM_UNFILED;
+    pAlarm->iPrev = -2;
+    pAlarm->iNext = pWheel->iFree;
+    pWheel->iFree = i;
+    pWheel->nPending--;
+}
+
+static int32_t ZoneOffset(const ALARMWHEEL* pWheel, int bLocalZone, int32_t lOffset, int64_t llUtc)
+{
+    if (!bLocalZone || !pWheel->clock.pfnOffsetAt)
+        return lOffset;
+    return pWheel->clock.pfnOffsetAt(pWheel->clock.pCtx, llUtc);
+}
+
+// UTC second of a local second in the zone; the offset is looked up twice
+// so a time near a daylight saving change takes the offset in force then
+static int64_t LocalToUtc(const ALARMWHEEL* pWheel, int bLocalZone, int32_t lOffset, int64_t llLocal)
+{
+    int64_t llUtc = llLocal - ZoneOffset(pWheel, bLocalZone, lOffset, llLocal);
+
+    return llLocal - ZoneOffset(pWheel, bLocalZone, lOffset, llUtc);
+}
+
+// First time after llAfter that a daily alarm rings: its time of day on
+// the next of its weekdays, at most a week and a day on
+static int64_t NextDaily(const ALARMWHEEL* pWheel, const ALARM* pAlarm, int64_t llAfter)
+{
+    int64_t llDay, llUtc;
+    int k;
+
+    llDay = FloorDiv(llAfter + ZoneOffset(pWheel, pAlarm->bLocalZone, pAlarm->lOffset, llAfter), SEC_PER_DAY) - 1;
+    for (k = 0; k < 9; k++, llDay++)
+    {
+        if (!(pAlarm->bDays & (1 << DayOfWeek(llDay))))
+            continue;
+        llUtc = LocalToUtc(pWheel, pAlarm->bLocalZone, pAlarm->lOffset, llDay * SEC_PER_DAY + pAlarm->iSecondOfDay);
+        if (llUtc > llAfter)
+            return llUtc;
+    }
+    return INT64_MAX;
+}
+
+// Moves a recurring alarm to its first time after llAfter; 0 when it has
+// none within the horizon
+static int Reschedule(const ALARMWHEEL* pWheel, ALARM* pAlarm, int64_t llAfter)
+{
+    if (pAlarm->bKind == ALARM_EVERY)
+        pAlarm->llDue += ((llAfter - pAlarm->llDue) / pAlarm->dwPeriod + 1) * pAlarm->dwPeriod;
+    else if (pAlarm->bKind == ALARM_DAILY)
+    {
+        pAlarm->llDue = NextDaily(pWheel, pAlarm, llAfter);
+        if (pAlarm->llDue == INT64_MAX)
+            return 0;
+    }
+    else
+        return 0;
+    return pAlarm->llDue - llAfter <= ALARM_HORIZON_SEC;
+}
+
+static uint32_t AddAlarm(ALARMWHEEL* pWheel, const ALARM* pNew)
+{
+    ALARM* pAlarm;
+    int32_t i = pWheel->iFree;
+    uint8_t bGen;
+
+    if (i < 0 || pNew->llDue - pWheel->llNow > ALARM_HORIZON_SEC)
+        return 0;
+    pAlarm = &pWheel->pAlarms[i];
+    pWheel->iFree = pAlarm->iNext;
+    bGen = pAlarm->bGen;
+    *pAlarm = *pNew;
+    pAlarm->bGen = bGen;
+
+    File(pWheel, i, pAlarm->llDue);
+    pWheel->nPending++;
+    pWheel->dwAdded++;
+    return AlarmId(pWheel, i);
+}
+
+uint32_t AlarmAddAt(ALARMWHEEL* pWheel, int64_t llDueUtc, uint32_t dwPeriod, uint32_t dwTag)
+{
+    ALARM alarm;
+
+    memset(&alarm, 0, sizeof(alarm));
+    alarm.llDue = llDueUtc;
+    alarm.dwPeriod = dwPeriod;
+    alarm.dwTag = dwTag;
+    alarm.bKind = dwPeriod ? ALARM_EVERY : ALARM_ONCE;
+    if (llDueUtc <= pWheel->llNow && (!dwPeriod || !Reschedule(pWheel, &alarm, pWheel->llNow)))
+        return 0;
+    return AddAlarm(pWheel, &alarm);
+}
+
+uint32_t AlarmAdd(ALARMWHEEL* pWheel, const ALARMSPEC* pSpec, uint32_t dwTag)
+{
+    ALARM alarm;
+
+    if (pSpec->iKind != ALARM_DAILY)
+        return AlarmAddAt(pWheel, LocalToUtc(pWheel, pSpec->bLocalZone, pSpec->lOffset, pSpec->llLocal),
+            pSpec->iKind == ALARM_EVERY ? pSpec->dwPeriod : 0, dwTag);
+
+    memset(&alarm, 0, sizeof(alarm));
+    alarm.dwTag = dwTag;
+    alarm.lOffset = pSpec->lOffset;
+    alarm.iSecondOfDay = pSpec->iSecondOfDay;
+    alarm.bKind = ALARM_DAILY;
+    alarm.bDays = pSpec->bDays & ALARM_EVERY_DAY;
+    alarm.bLocalZone = (uint8_t)pSpec->bLocalZone;
+    if (!alarm.bDays)
+        return 0;
+    alarm.llDue = NextDaily(pWheel, &alarm, pWheel->llNow);
+    return AddAlarm(pWheel, &alarm);
+}
+
+int AlarmCancel(ALARMWHEEL* pWheel, uint32_t dwId)
+{
+    int32_t i = (int32_t)(dwId & 0xFFFFFF) - 1;
+    ALARM* pAlarm;
+
+    if (i < 0 || i >= pWheel->nCapacity)
+        return 0;
+    pAlarm = &pWheel->pAlarms[i];
+    if (pAlarm->iPrev == -2 || pAlarm->bGen != (uint8_t)(dwId >> 24))
+        return 0;
+
+    Unfile(pWheel, i);
+    Release(pWheel, i);
+    pWheel->dwCancelled++;
+    return 1;
+}
+
+// Takes alarm i off the wheel at second llNow: a recurring one is filed
+// for its next time, anything else is freed. Then tells the caller.
+static void Fire(ALARMWHEEL* pWheel, int32_t i, ALARMFIRE pfnFire, void* pCtx)
+{
+    ALARM* pAlarm = &pWheel->pAlarms[i];
+    uint32_t dwId = AlarmId(pWheel, i), dwTag = pAlarm->dwTag;
+    int64_t llDue = pAlarm->llDue;
+
+    if (pWheel->llNow - llDue > pWheel->dwMaxLateSec)
+        pWheel->dwMaxLateSec = (uint32_t)(pWheel->llNow - llDue);
+    if (pAlarm->bKind == ALARM_EVERY)
+        pWheel->dwMissed += (uint32_t)((pWheel->llNow - llDue) / pAlarm->dwPeriod);
+    if (Reschedule(pWheel, pAlarm, pWheel->llNow))
+        File(pWheel, i, pAlarm->llDue);
+    else
+        Release(pWheel, i);
+    pWheel->dwFired++;
+    pfnFire(pCtx, dwId, dwTag, llDue);
+}
+
+// One second on: at the start of a block of 64^n seconds the level n slot
+// for it is spread over the levels below, highest level first, then the
+// level 0 slot for this second fires
+static int Step(ALARMWHEEL* pWheel, ALARMFIRE pfnFire, void* pCtx)
+{
+    int64_t t = ++pWheel->llNow;
+    int32_t i, *pHead;
+    int iLevel, n = 0;
+
+    for (iLevel = ALARM_LEVELS - 1; iLevel > 0; iLevel--)
+    {
+        if (t & (((int64_t)1 << (ALARM_SLOT_BITS * iLevel)) - 1))
+            continue;
+        pHead = &pWheel->heads[iLevel * ALARM_SLOTS + (int)((t >> (ALARM_SLOT_BITS * iLevel)) & (ALARM_SLOTS - 1))];
+        while ((i = *pHead) >= 0)
+        {
+            Unfile(pWheel, i);
+            File(pWheel, i, pWheel->pAlarms[i].llDue);
+            pWheel->dwCascaded++;
+        }
+    }
+
+    pHead = &pWheel->heads[t & (ALARM_SLOTS - 1)];
+    while ((i = *pHead) >= 0)
+    {
+        Unfile(pWheel, i);
+        Fire(pWheel, i, pfnFire, pCtx);
+        n++;
+    }
+    return n;
+}
+
+// After a jump of the clock: every alarm is taken off the wheel, then
+// those due by now fire and the rest are filed again from the new time.
+// Going back, recurring alarms first find their next time after it.
+static int Rebuild(ALARMWHEEL* pWheel, int64_t llNowUtc, ALARMFIRE pfnFire, void* pCtx)
+{
+    ALARM* pAlarm;
+    int32_t i;
+    int iSlot, bBack = llNowUtc < pWheel->llNow, n = 0;
+
+    for (iSlot = 0; iSlot < ALARM_LEVELS * ALARM_SLOTS; iSlot++)
+    {
+        for (i = pWheel->heads[iSlot]; i >= 0; i = pWheel->pAlarms[i].iNext)
+            pWheel->pAlarms[i].wSlot = ALARM_UNFILED;
+        pWheel->heads[iSlot] = -1;
+    }
+    pWheel->llNow = llNowUtc;
+    pWheel->dwRebuilds++;
+
+    // Alarms pfnFire adds are filed already and skipped
+    for (i = 0; i < pWheel->nCapacity; i++)
+    {
+        pAlarm = &pWheel->pAlarms[i];
+        if (pAlarm->iPrev == -2 || pAlarm->wSlot != ALARM_UNFILED)
+            continue;
+        if (pAlarm->llDue > llNowUtc)
+        {
+            if (bBack && pAlarm->bKind == ALARM_EVERY)
+                pAlarm->llDue -= (pAlarm->llDue - llNowUtc - 1) / pAlarm->dwPeriod * pAlarm->dwPeriod;
+            else if (bBack && pAlarm->bKind == ALARM_DAILY)
+                pAlarm->llDue = NextDaily(pWheel, pAlarm, llNowUtc);
+            File(pWheel, i, pAlarm->llDue);
+        }
+        else
+        {
+            Fire(pWheel, i, pfnFire, pCtx);
+            n++;
+        }
+    }
+    return n;
+}
+
+int AlarmWheelAdvance(ALARMWHEEL* pWheel, int64_t llNowUtc, ALARMFIRE pfnFire, void* pCtx)
+{
+    int n = 0;
+
+    if (llNowUtc == pWheel->llNow)
+        return 0;
+    if (!pWheel->nPending)
+    {
+        pWheel->llNow = llNowUtc;
+        return 0;
+    }
+    if (llNowUtc < pWheel->llNow || llNowUtc - pWheel->llNow > ALARM_CATCHUP_SEC)
+        return Rebuild(pWheel, llNowUtc, pfnFire, pCtx);
+
+    while (pWheel->llNow < llNowUtc)
+        n += Step(pWheel, pfnFire, pCtx);
+    return n;
+}
+
+void AlarmWheelRezone(ALARMWHEEL* pWheel)
+{
+    ALARM* pAlarm;
+    int32_t i;
+
+    for (i = 0; i < pWheel->nCapacity; i++)
+    {
+        pAlarm = &pWheel->pAlarms[i];
+        if (pAlarm->iPrev == -2 || pAlarm->bKind != ALARM_DAILY || !pAlarm->bLocalZone)
+            continue;
+        Unfile(pWheel, i);
+        pAlarm->llDue = NextDaily(pWheel, pAlarm, pWheel->llNow);
+        File(pWheel, i, pAlarm->llDue);
+    }
+}
+
+static const char* SkipSpace(const char* p)
+{
+    while (isspace((unsigned char)*p))
+        p++;
+    return p;
+}
+
+// HH:MM or HH:MM:SS into seconds since midnight
+static const char* ParseTimeOfDay(const char* p, int* piSecond)
+{
+    int iHour, iMinute, iSecond = 0, cch = 0;
+
+    if (sscanf(p, "%2d:%2d%n", &iHour, &iMinute, &cch) != 2)
+        return NULL;
+    p += cch;
+    if (*p == ':' && sscanf(p, ":%2d%n", &iSecond, &cch) == 1)
+        p += cch;
+    if (iHour > 23 || iMinute > 59 || iSecond > 59 || iHour < 0 || iMinute < 0 || iSecond < 0)
+        return NULL;
+    *piSecond = iHour * 3600 + iMinute * 60 + iSecond;
+    return p;
+}
+
+// YYYY-MM-DD HH:MM[:SS] into seconds since 1970 in the zone
+static const char* ParseDateTime(const char* p, int64_t* pllLocal)
+{
+    int iYear, iMonth, iDay, iSecond, cch = 0;
+
+    if (sscanf(p, "%4d-%2d-%2d%n", &iYear, &iMonth, &iDay, &cch) != 3 ||
+        iMonth < 1 || iMonth > 12 || iDay < 1 || iDay > 31)
+        return NULL;
+    p = SkipSpace(p + cch);
+    if (!(p = ParseTimeOfDay(p, &iSecond)))
+        return NULL;
+    *pllLocal = DaysFromCivil(iYear, iMonth, iDay) * SEC_PER_DAY + iSecond;
+    return p;
+}
+
+static const char* ParseZone(const char* p, ALARMSPEC* pSpec)
+{
+    int iHours, iMinutes = 0, cch = 0;
+
+    p = SkipSpace(p);
+    pSpec->bLocalZone = 0;
+    pSpec->lOffset = 0;
+    if (strncmp(p, "local", 5) == 0)
+    {
+        pSpec->bLocalZone = 1;
+        return p + 5;
+    }
+    if (*p == 'Z')
+        return p + 1;
+    if ((*p != '+' && *p != '-') || sscanf(p + 1, "%2d%n", &iHours, &cch) != 1)
+        return NULL;
+    if (p[1 + cch] == ':' && sscanf(p + 2 + cch, "%2d", &iMinutes) == 1)
+        cch += 3;
+    if (iHours > 14 || iMinutes > 59)
+        return NULL;
+    pSpec->lOffset = (*p == '-' ? -1 : 1) * (iHours * 3600 + iMinutes * 60);
+    return p + 1 + cch;
+}
+
+static int DayIndex(const char* p)
+{
+    static const char days[] = "sunmontuewedthufrisat";
+    int i;
+
+    for (i = 0; i < 7; i++)
+        if (tolower((unsigned char)p[0]) == days[i * 3] && tolower((unsigned char)p[1]) == days[i * 3 + 1] &&
+            tolower((unsigned char)p[2]) == days[i * 3 + 2])
+            return i;
+    return -1;
+}
+
+// mon-fri, sat,sun and the like into weekday bits; NULL if the word at p
+// is not one, as when the label follows straight after the zone
+static const char* ParseDays(const char* p, uint8_t* pbDays)
+{
+    int iFrom, iTo;
+
+    *pbDays = 0;
+    for (;;)
+    {
+        if ((iFrom = DayIndex(p)) < 0)
+            return NULL;
+        p += 3;
+        iTo = iFrom;
+        if (*p == '-')
+        {
+            if ((iTo = DayIndex(p + 1)) < 0)
+                return NULL;
+            p += 4;
+        }
+        for (;; iFrom = (iFrom + 1) % 7)
+        {
+            *pbDays |= (uint8_t)(1 << iFrom);
+            if (iFrom == iTo)
+                break;
+        }
+        if (*p != ',')
+            break;
+        p++;
+    }
+    return *p == '\0' || isspace((unsigned char)*p) ? p : NULL;
+}
+
+static const char* ParsePeriod(const char* p, uint32_t* pdwPeriod)
+{
+    unsigned long ulCount;
+    char* pEnd;
+    uint32_t dwUnit = 1;
+
+    ulCount = strtoul(p, &pEnd, 10);
+    if (pEnd == p)
+        return NULL;
+    switch (*pEnd)
+    {
+        case 's': dwUnit = 1; pEnd++; break;
+        case 'm': dwUnit = 60; pEnd++; break;
+        case 'h': dwUnit = 3600; pEnd++; break;
+        case 'd': dwUnit = SEC_PER_DAY; pEnd++; break;
+    }
+    if (ulCount == 0 || ulCount > ALARM_HORIZON_SEC / dwUnit)
+        return NULL;
+    *pdwPeriod = (uint32_t)ulCount * dwUnit;
+    return pEnd;
+}
+
+int AlarmParse(const char* pszLine, ALARMSPEC* pSpec)
+{
+    const char* p = SkipSpace(pszLine);
+    const char* pDays;
+    size_t len;
+
+    if (!*p || *p == '#')
+        return 0;
+
+    memset(pSpec, 0, sizeof(*pSpec));
+    if (strncmp(p, "once ", 5) == 0)
+    {
+        pSpec->iKind = ALARM_ONCE;
+        p = ParseDateTime(SkipSpace(p + 5), &pSpec->llLocal);
+    }
+    else if (strncmp(p, "every ", 6) == 0)
+    {
+        pSpec->iKind = ALARM_EVERY;
+        p = ParsePeriod(SkipSpace(p + 6), &pSpec->dwPeriod);
+        if (p)
+            p = ParseDateTime(SkipSpace(p), &pSpec->llLocal);
+    }
+    else if (strncmp(p, "daily ", 6) == 0)
+    {
+        pSpec->iKind = ALARM_DAILY;
+        p = ParseTimeOfDay(SkipSpace(p + 6), &pSpec->iSecondOfDay);
+    }
+    else
+        return -1;
+
+    if (!p || !isspace((unsigned char)*p) || !(p = ParseZone(p, pSpec)))
+        return -1;
+    if (*p && !isspace((unsigned char)*p))
+        return -1;
+
+    p = SkipSpace(p);
+    if (pSpec->iKind == ALARM_DAILY && (pDays = ParseDays(p, &pSpec->bDays)) != NULL)
+        p = SkipSpace(pDays);
+    else
+        pSpec->bDays = ALARM_EVERY_DAY;
+
+    len = strcspn(p, "\r\n");
+    while (len && isspace((unsigned char)p[len - 1]))
+        len--;
+    if (len >= ALARM_LABEL_CHARS)
+        len = ALARM_LABEL_CHARS - 1;
+    memcpy(pSpec->szLabel, p, len);
+    pSpec->szLabel[len] = '\0';
+    return 1;
+}
+
+int AlarmLoad(ALARMWHEEL* pWheel, const char* pszPath, char (*pLabels)[ALARM_LABEL_CHARS], int nMaxLabels)
+{
+    FILE* fp = fopen(pszPath, "r");
+    char line[256];
+    ALARMSPEC spec;
+    int n = 0;
+
+    if (!fp)
+        return -1;
+
+    while (n < nMaxLabels && fgets(line, sizeof(line), fp))
+    {
+        if (AlarmParse(line, &spec) != 1 || !AlarmAdd(pWheel, &spec, (uint32_t)n))
+            continue;
+        memcpy(pLabels[n++], spec.szLabel, ALARM_LABEL_CHARS);
+    }
+
+    fclose(fp);
+    return n;
+}
+
+void AlarmWheelFormat(const ALARMWHEEL* pWheel, char* buf, size_t cb)
+{
+    snprintf(buf, cb, "Alarms: %ld pending, %lu added, %lu cancelled, %lu fired (latest %lu s late), "
+        "%lu moved down a level, %lu clock jumps re-filed, %lu recurrences skipped",
+        (long)pWheel->nPending, (unsigned long)pWheel->dwAdded, (unsigned long)pWheel->dwCancelled,
+        (unsigned long)pWheel->dwFired, (unsigned long)pWheel->dwMaxLateSec, (unsigned long)pWheel->dwCascaded,
+        (unsigned long)pWheel->dwRebuilds, (unsigned long)pWheel->dwMissed);
+}
@@ -0,0 +1,132 @@
+/*--------------------------
+    ALARMS.H -- One-shot, recurring and per-zone alarms on a hierarchical timing wheel
+---------------------------*/
+
+#ifndef ALARMS_H
+#define ALARMS_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "timesource.h"
+
+// Five levels of 64 one-second slots. Level n holds alarms due in a later
+// block of 64^n seconds than the current one, and its slot for a block is
+// spread over the level below when that block begins, so a tick touches
+// one slot however many alarms are pending.
+#define ALARM_LEVELS 5
+#define ALARM_SLOT_BITS 6
+#define ALARM_SLOTS (1 << ALARM_SLOT_BITS)
+
+// Furthest ahead an alarm can be due, about 33 years
+#define ALARM_HORIZON_SEC (((int64_t)1 << (ALARM_LEVELS * ALARM_SLOT_BITS)) - \
+    ((int64_t)1 << ((ALARM_LEVELS - 1) * ALARM_SLOT_BITS)))
+
+// A clock that moves further than this at once (a resume from sleep, the
+// time being set) is caught up by re-filing every alarm instead of second
+// by second
+#define ALARM_CATCHUP_SEC 3600
+
+#define ALARM_MAX_CAPACITY 0xFFFFFE
+#define ALARM_LABEL_CHARS 64
+#define ALARM_EVERY_DAY 0x7F
+
+enum
+{
+    ALARM_ONCE,                 // at one moment
+    ALARM_EVERY,                // every dwPeriod seconds from its first
+    ALARM_DAILY                 // at a time of day in a zone, on some weekdays
+};
+
+// An alarm as written in an alarm list, before its zone is resolved
+typedef struct
+{
+    int iKind;
+    int64_t llLocal;            // ONCE and EVERY: seconds since 1970 in the zone
+    uint32_t dwPeriod;          // EVERY
+    int iSecondOfDay;           // DAILY
+    uint8_t bDays;              // DAILY: bit 0 for Sunday to bit 6 for Saturday
+    int bLocalZone;             // the system's zone, with its daylight saving
+    int32_t lOffset;            // otherwise seconds east of UTC
+    char szLabel[ALARM_LABEL_CHARS];
+} ALARMSPEC;
+
+typedef struct
+{
+    int64_t llDue;              // UTC seconds
+    uint32_t dwPeriod;
+    uint32_t dwTag;             // the caller's, handed back when it fires
+    int32_t lOffset;
+    int32_t iSecondOfDay;
+    int32_t iNext, iPrev;       // neighbours in its slot, or in the free list
+    uint16_t wSlot;             // level * ALARM_SLOTS + slot
+    uint8_t bKind;
+    uint8_t bDays;
+    uint8_t bLocalZone;
+    uint8_t bGen;               // bumped when freed, so a stale id misses
+} ALARM;
+
+typedef void (*ALARMFIRE)(void* pCtx, uint32_t dwId, uint32_t dwTag, int64_t llDue);
+
+typedef struct
+{
+    ALARM* pAlarms;
+    int32_t nCapacity;
+    int32_t iFree;
+    int32_t nPending;
+    int32_t heads[ALARM_LEVELS * ALARM_SLOTS];
+    int64_t llNow;              // last UTC second handled
+    TIMECLOCK clock;            // zone offsets for ALARM_DAILY in the local zone
+
+    // Statistics
+    uint32_t dwAdded;
+    uint32_t dwCancelled;
+    uint32_t dwFired;
+    uint32_t dwCascaded;        // alarms moved down a level
+    uint32_t dwRebuilds;        // clock jumps handled by re-filing
+    uint32_t dwMissed;          // recurrences skipped over by a jump
+    uint32_t dwMaxLateSec;
+} ALARMWHEEL;
+
+// Room for nCapacity alarms, with llNowUtc as the last second handled
+int AlarmWheelInit(ALARMWHEEL* pWheel, int32_t nCapacity, int64_t llNowUtc, const TIMECLOCK* pClock);
+void AlarmWheelFree(ALARMWHEEL* pWheel);
+
+// Each returns the new alarm's id, or 0 when the wheel is full, a one-shot
+// alarm is due no later than the last second handled, or the alarm is
+// beyond ALARM_HORIZON_SEC. A recurring alarm whose first time has passed
+// starts at its next one. dwPeriod 0 is a one-shot alarm.
+uint32_t AlarmAddAt(ALARMWHEEL* pWheel, int64_t llDueUtc, uint32_t dwPeriod, uint32_t dwTag);
+uint32_t AlarmAdd(ALARMWHEEL* pWheel, const ALARMSPEC* pSpec, uint32_t dwTag);
+
+// Returns 0 if the alarm has already fired for the last time or was
+// cancelled
+int AlarmCancel(ALARMWHEEL* pWheel, uint32_t dwId);
+
+// Fires everything due up to llNowUtc, in order of the second it is due
+// when the clock moved by up to ALARM_CATCHUP_SEC. A recurring alarm is
+// filed again for its next time first, so pfnFire may cancel it, and may
+// add or cancel others. A jump back files recurring alarms again from
+// the new time. Returns how many fired.
+int AlarmWheelAdvance(ALARMWHEEL* pWheel, int64_t llNowUtc, ALARMFIRE pfnFire, void* pCtx);
+
+// Finds daily alarms in the local zone their next time again, for when
+// the system's zone has been changed
+void AlarmWheelRezone(ALARMWHEEL* pWheel);
+
+// One line of an alarm list:
+//     once YYYY-MM-DD HH:MM[:SS] ZONE label
+//     every PERIOD YYYY-MM-DD HH:MM[:SS] ZONE label
+//     daily HH:MM[:SS] ZONE [DAYS] label
+// ZONE is +HH:MM, -HH:MM, Z or local; PERIOD is seconds, or a number
+// with s, m, h or d; DAYS is a list like mon-fri or sat,sun. Returns 1
+// for an alarm, 0 for a blank or # comment line, -1 for anything else.
+int AlarmParse(const char* pszLine, ALARMSPEC* pSpec);
+
+// Adds every alarm in the file that is still to come, storing its label
+// in pLabels and tagging it with the label's index there. Returns how
+// many were added, or -1 if the file cannot be read.
+int AlarmLoad(ALARMWHEEL* pWheel, const char* pszPath, char (*pLabels)[ALARM_LABEL_CHARS], int nMaxLabels);
+
+void AlarmWheelFormat(const ALARMWHEEL* pWheel, char* buf, size_t cb);
+
+#endif
@@ -0,0 +1,186 @@
+/*--------------------------
+    ASSETPAK.C -- Indexed asset pack format
+---------------------------*/
+
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "assetpak.h"
+
+static uint32_t ReadLE32(const uint8_t* p)
+{
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static void WriteLE32(uint8_t* p, uint32_t v)
+{
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+    p[2] = (uint8_t)(v >> 16);
+    p[3] = (uint8_t)(v >> 24);
+}
+
+static int NameEquals(const char* pszEntry, const char* pszName)
+{
+    int i;
+
+    for (i = 0; i < PAK_NAME_MAX; i++)
+    {
+        if (tolower((unsigned char)pszEntry[i]) != tolower((unsigned char)pszName[i]))
+            return 0;
+        if (pszName[i] == '\0')
+            return 1;
+    }
+    return pszName[i] == '\0';
+}
+
+int PakOpenMemory(PAKFILE* pPak, const void* pBase, size_t cbSize)
+{
+    const uint8_t* p = (const uint8_t*)pBase;
+    uint32_t i, dwCount;
+
+    memset(pPak, 0, sizeof(*pPak));
+
+    if (!p || cbSize < PAK_HEADER_SIZE || memcmp(p, "CPAK", 4) != 0 || ReadLE32(p + 4) != PAK_VERSION)
+        return 0;
+
+    dwCount = ReadLE32(p + 8);
+    if (dwCount > (cbSize - PAK_HEADER_SIZE) / PAK_ENTRY_SIZE)
+        return 0;
+
+    for (i = 0; i < dwCount; i++)
+    {
+        const uint8_t* pEntry = p + PAK_HEADER_SIZE + (size_t)i * PAK_ENTRY_SIZE;
+        uint32_t dwOffset = ReadLE32(pEntry + PAK_NAME_MAX);
+        uint32_t dwSize = ReadLE32(pEntry + PAK_NAME_MAX + 4);
+
+        if (dwOffset > cbSize || dwSize > cbSize - dwOffset)
+            return 0;
+    }
+
+    pPak->pBase = p;
+    pPak->cbSize = cbSize;
+    pPak->dwCount = dwCount;
+    return 1;
+}
+
+const void* PakFind(const PAKFILE* pPak, const char* pszName, size_t* pcbSize)
+{
+    uint32_t i;
+
+    for (i = 0; i < pPak->dwCount; i++)
+    {
+        const uint8_t* pEntry = pPak->pBase + PAK_HEADER_SIZE + (size_t)i * PAK_ENTRY_SIZE;
+
+        if (NameEquals((const char*)pEntry, pszName))
+        {
+            if (pcbSize)
+                *pcbSize = ReadLE32(pEntry + PAK_NAME_MAX + 4);
+            return pPak->pBase + ReadLE32(pEntry + PAK_NAME_MAX);
+        }
+    }
+    return NULL;
+}
+
+static const char* BaseName(const char* pszPath)
+{
+    const char* p = pszPath + strlen(pszPath);
+
+    while (p > pszPath && p[-1] != '/' && p[-1] != '\\')
+        p--;
+    return p;
+}
+
+static long FileSize(FILE* fp)
+{
+    long cb;
+
+    if (fseek(fp, 0, SEEK_END) != 0 || (cb = ftell(fp)) < 0 || fseek(fp, 0, SEEK_SET) != 0)
+        return -1;
+    return cb;
+}
+
+int PakWriteFile(const char* pszOutPath, const char* const pszFiles[], int nFiles)
+{
+    uint8_t hdr[PAK_HEADER_SIZE];
+    uint8_t* pIndex;
+    uint8_t buf[4096];
+    uint32_t dwOffset;
+    FILE* fpOut;
+    FILE* fpIn;
+    int i, bOk = 1;
+    long cb;
+    size_t n;
+
+    if (nFiles < 0)
+        return 0;
+
+    pIndex = (uint8_t*)calloc(nFiles ? nFiles : 1, PAK_ENTRY_SIZE);
+    if (!pIndex)
+        return 0;
+
+    // First pass: sizes and offsets for the index
+    dwOffset = PAK_HEADER_SIZE + (uint32_t)nFiles * PAK_ENTRY_SIZE;
+    for (i = 0; i < nFiles && bOk; i++)
+    {
+        uint8_t* pEntry = pIndex + (size_t)i * PAK_ENTRY_SIZE;
+        const char* pszName = BaseName(pszFiles[i]);
+
+        fpIn = fopen(pszFiles[i], "rb");
+        cb = fpIn ? FileSize(fpIn) : -1;
+        if (fpIn)
+            fclose(fpIn);
+        if (cb < 0 || strlen(pszName) >= PAK_NAME_MAX)
+        {
+            bOk = 0;
+            break;
+        }
+
+        dwOffset = (dwOffset + PAK_ALIGN - 1) & ~(uint32_t)(PAK_ALIGN - 1);
+        memcpy(pEntry, pszName, strlen(pszName));
+        WriteLE32(pEntry + PAK_NAME_MAX, dwOffset);
+        WriteLE32(pEntry + PAK_NAME_MAX + 4, (uint32_t)cb);
+        dwOffset += (uint32_t)cb;
+    }
+
+    fpOut = bOk ? fopen(pszOutPath, "wb") : NULL;
+    if (!fpOut)
+    {
+        free(pIndex);
+        return 0;
+    }
+
+    memcpy(hdr, "CPAK", 4);
+    WriteLE32(hdr + 4, PAK_VERSION);
+    WriteLE32(hdr + 8, (uint32_t)nFiles);
+    WriteLE32(hdr + 12, 0);
+    bOk = fwrite(hdr, 1, sizeof(hdr), fpOut) == sizeof(hdr) &&
+        fwrite(pIndex, PAK_ENTRY_SIZE, nFiles, fpOut) == (size_t)nFiles;
+
+    // Second pass: padding and file contents
+    dwOffset = PAK_HEADER_SIZE + (uint32_t)nFiles * PAK_ENTRY_SIZE;
+    for (i = 0; i < nFiles && bOk; i++)
+    {
+        uint32_t dwStart = ReadLE32(pIndex + (size_t)i * PAK_ENTRY_SIZE + PAK_NAME_MAX);
+
+        for (; dwOffset < dwStart && bOk; dwOffset++)
+            bOk = fputc(0, fpOut) != EOF;
+
+        fpIn = fopen(pszFiles[i], "rb");
+        if (!fpIn)
+        {
+            bOk = 0;
+            break;
+        }
+        while (bOk && (n = fread(buf, 1, sizeof(buf), fpIn)) > 0)
+        {
+            bOk = fwrite(buf, 1, n, fpOut) == n;
+            dwOffset += (uint32_t)n;
+        }
+        fclose(fpIn);
+    }
+
+    free(pIndex);
+    return fclose(fpOut) == 0 && bOk;
+}
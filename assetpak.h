@@ -0,0 +1,41 @@
+/*--------------------------
+    ASSETPAK.H -- Indexed asset pack format
+---------------------------*/
+
+#ifndef ASSETPAK_H
+#define ASSETPAK_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Layout (all integers little-endian):
+//   header   "CPAK", version, entry count, reserved        (16 bytes)
+//   index    one PAK_ENTRY_SIZE record per asset:
+//            NUL-padded name, data offset, data size, reserved
+//   data     each asset starts on a PAK_ALIGN boundary
+#define PAK_VERSION 1
+#define PAK_HEADER_SIZE 16
+#define PAK_ENTRY_SIZE 64
+#define PAK_NAME_MAX 52
+#define PAK_ALIGN 16
+#define PAK_DEFAULT_NAME "clock.pak"
+
+// A pack image already in memory (normally a read-only file mapping)
+typedef struct
+{
+    const uint8_t* pBase;
+    size_t cbSize;
+    uint32_t dwCount;
+} PAKFILE;
+
+// Checks the header and that every entry lies inside the image. Returns 1
+// on success; the pack keeps pointing into pBase, nothing is copied.
+int PakOpenMemory(PAKFILE* pPak, const void* pBase, size_t cbSize);
+
+// Returns a view of the named asset (case-insensitive), or NULL
+const void* PakFind(const PAKFILE* pPak, const char* pszName, size_t* pcbSize);
+
+// Writes a pack holding the given files, each stored under its base name
+int PakWriteFile(const char* pszOutPath, const char* const pszFiles[], int nFiles);
+
+#endif
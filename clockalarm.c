@@ -0,0 +1,615 @@
+/*--------------------------
+    CLOCKALARM.C -- Checks the alarm wheel against a plain list, and times it
+
+    Usage: clockalarm check [STEPS]
+           clockalarm bench [ALARMS]
+
+    "check" runs a wheel and a plain list of due times side by side
+    through STEPS random operations (50000 by default): adding one-shot
+    and recurring alarms from a second to years ahead, cancelling, moving
+    the clock on by a second to an hour, and jumping it forward and back.
+    Every advance must fire the same alarms for the same due times. It
+    then walks alarms across every level boundary second by second, has a
+    callback cancel and add alarms as they fire, steps daily alarms
+    through a year of a zone with daylight saving and past a change of
+    zone, and parses a set of alarm list lines.
+    "bench" fills a wheel with ALARMS alarms (100000 by default) spread
+    over a year and prints the cost of an insert, a cancel, a tick with
+    nothing due and each alarm fired, next to scanning a plain list on
+    every tick. Exits 1 if a wheel tick is not the cheaper.
+---------------------------*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "alarms.h"
+#include "timesource.h"
+#include "phasetime.h"
+#include "clockcheck.h"
+
+#define CHECK_START 1792886400LL    // 2026-10-25, a Sunday
+#define CHECK_CAPACITY 4096
+#define MAX_FIRES 262144
+#define CHECK_PENDING 1024
+#define BENCH_TICKS 3600
+
+// Alarms the wheel reported, in the order it fired them
+typedef struct
+{
+    uint32_t dwIds[MAX_FIRES];
+    int64_t llDues[MAX_FIRES];
+    int64_t llAts[MAX_FIRES];
+    int nFires;
+    const ALARMWHEEL* pWheel;
+} FIRELOG;
+
+// The same alarms kept in a plain list
+typedef struct
+{
+    uint32_t dwId;
+    int64_t llDue;
+    uint32_t dwPeriod;
+} REFALARM;
+
+typedef struct
+{
+    REFALARM alarms[CHECK_CAPACITY];
+    int nAlarms;
+} REFLIST;
+
+static int64_t Random64(int64_t llRange)
+{
+    uint64_t qw = ((uint64_t)rand() << 42) ^ ((uint64_t)rand() << 21) ^ (uint64_t)rand();
+
+    return (int64_t)(qw % (uint64_t)llRange);
+}
+
+// Seconds ahead, mostly near but some years out, so every level is used
+static int64_t RandomDelta(void)
+{
+    static const int64_t llSpans[] = { 64, 4096, 262144, 16777216, ALARM_HORIZON_SEC };
+
+    return 1 + Random64(llSpans[rand() % 5]);
+}
+
+static void LogFire(void* pCtx, uint32_t dwId, uint32_t dwTag, int64_t llDue)
+{
+    FIRELOG* pLog = (FIRELOG*)pCtx;
+
+    (void)dwTag;
+    if (pLog->nFires < MAX_FIRES)
+    {
+        pLog->dwIds[pLog->nFires] = dwId;
+        pLog->llDues[pLog->nFires] = llDue;
+        pLog->llAts[pLog->nFires] = pLog->pWheel->llNow;
+        pLog->nFires++;
+    }
+}
+
+static void RefRemove(REFLIST* pRef, int i)
+{
+    pRef->alarms[i] = pRef->alarms[--pRef->nAlarms];
+}
+
+// What the list expects the wheel to fire moving from llFrom to llTo,
+// with the list moved on as the wheel should be
+static int RefAdvance(REFLIST* pRef, int64_t llFrom, int64_t llTo, FIRELOG* pExpect)
+{
+    REFALARM* pAlarm;
+    int i, bJump = llTo < llFrom || llTo - llFrom > ALARM_CATCHUP_SEC;
+
+    pExpect->nFires = 0;
+    for (i = 0; i < pRef->nAlarms; i++)
+    {
+        pAlarm = &pRef->alarms[i];
+        if (llTo < llFrom)
+        {
+            if (pAlarm->dwPeriod && pAlarm->llDue > llTo)
+                pAlarm->llDue -= (pAlarm->llDue - llTo - 1) / pAlarm->dwPeriod * pAlarm->dwPeriod;
+            continue;
+        }
+        while (pAlarm->llDue <= llTo && pExpect->nFires < MAX_FIRES)
+        {
+            pExpect->dwIds[pExpect->nFires] = pAlarm->dwId;
+            pExpect->llDues[pExpect->nFires] = pAlarm->llDue;
+            pExpect->llAts[pExpect->nFires] = bJump ? llTo : pAlarm->llDue;
+            pExpect->nFires++;
+            if (!pAlarm->dwPeriod)
+                break;
+            pAlarm->llDue += bJump ? ((llTo - pAlarm->llDue) / pAlarm->dwPeriod + 1) * pAlarm->dwPeriod
+                : pAlarm->dwPeriod;
+        }
+        if (!pAlarm->dwPeriod && pAlarm->llDue <= llTo)
+            RefRemove(pRef, i--);
+    }
+    return pExpect->nFires;
+}
+
+static int CompareFire(const void* p1, const void* p2)
+{
+    const int64_t* pll1 = (const int64_t*)p1;
+    const int64_t* pll2 = (const int64_t*)p2;
+    int i;
+
+    for (i = 0; i < 3; i++)
+        if (pll1[i] != pll2[i])
+            return pll1[i] < pll2[i] ? -1 : 1;
+    return 0;
+}
+
+// Fires as (second fired, due, id) triples in order, since alarms in the
+// same second come out in no particular order
+static void SortFires(const FIRELOG* pLog, int64_t* pll)
+{
+    int i;
+
+    for (i = 0; i < pLog->nFires; i++)
+    {
+        pll[i * 3] = pLog->llAts[i];
+        pll[i * 3 + 1] = pLog->llDues[i];
+        pll[i * 3 + 2] = pLog->dwIds[i];
+    }
+    qsort(pll, pLog->nFires, 3 * sizeof(int64_t), CompareFire);
+}
+
+static void CheckRandom(int nSteps)
+{
+    static ALARMWHEEL wheel;
+    static REFLIST ref;
+    static FIRELOG log, expect;
+    static int64_t llGot[MAX_FIRES * 3], llWant[MAX_FIRES * 3];
+    int64_t llDelta, llTo;
+    uint32_t dwId, dwPeriod;
+    int iStep, i, iOp, nJumps = 0, nFires = 0;
+
+    srand(2024);
+    AlarmWheelInit(&wheel, CHECK_CAPACITY, CHECK_START, NULL);
+    ref.nAlarms = 0;
+    log.pWheel = &wheel;
+
+    for (iStep = 0; iStep < nSteps && !g_nFailed; iStep++)
+    {
+        iOp = rand() % 100;
+        if (iOp < 45 && ref.nAlarms < CHECK_PENDING)
+        {
+            dwPeriod = rand() % 4 ? 0 : (uint32_t)(rand() % 4 == 0 ? 60 + Random64(120) : 1 + Random64(86400 * 7));
+            llDelta = RandomDelta();
+            dwId = AlarmAddAt(&wheel, wheel.llNow + llDelta, dwPeriod, 0);
+            CHECK(dwId != 0, "step %d: add %lld s ahead", iStep, (long long)llDelta);
+            ref.alarms[ref.nAlarms].dwId = dwId;
+            ref.alarms[ref.nAlarms].llDue = wheel.llNow + llDelta;
+            ref.alarms[ref.nAlarms].dwPeriod = dwPeriod;
+            ref.nAlarms++;
+        }
+        else if (iOp < 60 && ref.nAlarms)
+        {
+            i = rand() % ref.nAlarms;
+            CHECK(AlarmCancel(&wheel, ref.alarms[i].dwId), "step %d: cancel %08lx", iStep,
+                (unsigned long)ref.alarms[i].dwId);
+            CHECK(!AlarmCancel(&wheel, ref.alarms[i].dwId), "step %d: cancel %08lx twice", iStep,
+                (unsigned long)ref.alarms[i].dwId);
+            RefRemove(&ref, i);
+        }
+        else
+        {
+            if (iOp < 97)
+                llDelta = 1 + Random64(rand() % 4 ? 64 : ALARM_CATCHUP_SEC);
+            else if (iOp < 99)
+                llDelta = ALARM_CATCHUP_SEC + 1 + Random64(86400 * 30);
+            else
+                llDelta = -1 - Random64(86400 * 2);
+            nJumps += llDelta < 0 || llDelta > ALARM_CATCHUP_SEC;
+            llTo = wheel.llNow + llDelta;
+            RefAdvance(&ref, wheel.llNow, llTo, &expect);
+            log.nFires = 0;
+            AlarmWheelAdvance(&wheel, llTo, LogFire, &log);
+            nFires += log.nFires;
+            CHECK(expect.nFires < MAX_FIRES, "step %d: more than %d alarms fired at once", iStep, MAX_FIRES);
+            CHECK(log.nFires == expect.nFires, "step %d: moving %lld s fired %d alarms, expected %d", iStep,
+                (long long)llDelta, log.nFires, expect.nFires);
+            if (log.nFires != expect.nFires)
+                break;
+            SortFires(&log, llGot);
+            SortFires(&expect, llWant);
+            for (i = 0; i < log.nFires * 3; i += 3)
+                CHECK(llGot[i] == llWant[i] && llGot[i + 1] == llWant[i + 1] && llGot[i + 2] == llWant[i + 2],
+                    "step %d: fired %08llx due %lld at %lld, expected %08llx due %lld at %lld", iStep,
+                    (unsigned long long)llGot[i + 2], (long long)llGot[i + 1], (long long)llGot[i],
+                    (unsigned long long)llWant[i + 2], (long long)llWant[i + 1], (long long)llWant[i]);
+        }
+        CHECK(wheel.nPending == ref.nAlarms, "step %d: %ld pending, expected %d", iStep,
+            (long)wheel.nPending, ref.nAlarms);
+    }
+
+    printf("Random: %d steps, %d fired, %d jumps, %d left pending\n", iStep, nFires, nJumps, ref.nAlarms);
+    AlarmWheelFree(&wheel);
+}
+
+// Alarms just either side of each level's block boundaries, walked to
+// second by second, must fire in the second they are due
+static void CheckBoundaries(void)
+{
+    static ALARMWHEEL wheel;
+    static FIRELOG log;
+    int64_t llStart = (CHECK_START >> 24 << 24) + 5, llSpan, llEnd = 0;
+    int iLevel, i, n = 0;
+
+    AlarmWheelInit(&wheel, CHECK_CAPACITY, llStart, NULL);
+    log.pWheel = &wheel;
+    log.nFires = 0;
+    for (iLevel = 1; iLevel < ALARM_LEVELS; iLevel++)
+    {
+        llSpan = (int64_t)1 << (ALARM_SLOT_BITS * iLevel);
+        for (i = -1; i <= 1; i++)
+        {
+            AlarmAddAt(&wheel, (llStart & ~(llSpan - 1)) + llSpan + i, 0, 0);
+            AlarmAddAt(&wheel, (llStart & ~(llSpan - 1)) + 2 * llSpan + i, 0, 0);
+            n += 2;
+        }
+        llEnd = (llStart & ~(llSpan - 1)) + 2 * llSpan + 1;
+    }
+    while (wheel.llNow < llEnd)
+        AlarmWheelAdvance(&wheel, wheel.llNow + ALARM_CATCHUP_SEC < llEnd ? wheel.llNow + ALARM_CATCHUP_SEC : llEnd,
+            LogFire, &log);
+
+    CHECK(log.nFires == n, "boundaries: %d fired, expected %d", log.nFires, n);
+    for (i = 0; i < log.nFires; i++)
+        CHECK(log.llAts[i] == log.llDues[i], "boundaries: alarm due %lld fired at %lld",
+            (long long)log.llDues[i], (long long)log.llAts[i]);
+    CHECK(wheel.nPending == 0, "boundaries: %ld left pending", (long)wheel.nPending);
+    printf("Boundaries: %d alarms over %lld s, %lu moved down a level\n", log.nFires,
+        (long long)(llEnd - llStart), (unsigned long)wheel.dwCascaded);
+    AlarmWheelFree(&wheel);
+}
+
+typedef struct
+{
+    ALARMWHEEL* pWheel;
+    uint32_t dwSelf, dwVictim, dwAdded;
+    int nSelf, nVictim, nAdded;
+} EDITCTX;
+
+// The recurring alarm cancels a one-shot due later, adds another and
+// cancels itself the second time it fires
+static void EditFire(void* pCtx, uint32_t dwId, uint32_t dwTag, int64_t llDue)
+{
+    EDITCTX* p = (EDITCTX*)pCtx;
+
+    (void)dwTag;
+    (void)llDue;
+    if (dwId == p->dwSelf)
+    {
+        if (++p->nSelf == 1)
+        {
+            AlarmCancel(p->pWheel, p->dwVictim);
+            p->dwAdded = AlarmAddAt(p->pWheel, p->pWheel->llNow + 1, 0, 0);
+        }
+        else
+            AlarmCancel(p->pWheel, dwId);
+    }
+    else if (dwId == p->dwVictim)
+        p->nVictim++;
+    else if (dwId == p->dwAdded)
+        p->nAdded++;
+}
+
+static void CheckCallbackEdits(void)
+{
+    ALARMWHEEL wheel;
+    EDITCTX ctx;
+
+    AlarmWheelInit(&wheel, 16, CHECK_START, NULL);
+    memset(&ctx, 0, sizeof(ctx));
+    ctx.pWheel = &wheel;
+    ctx.dwSelf = AlarmAddAt(&wheel, CHECK_START + 5, 10, 0);
+    ctx.dwVictim = AlarmAddAt(&wheel, CHECK_START + 6, 0, 0);
+    AlarmWheelAdvance(&wheel, CHECK_START + 100, EditFire, &ctx);
+
+    CHECK(ctx.nSelf == 2, "edits: the recurring alarm fired %d times, expected 2", ctx.nSelf);
+    CHECK(ctx.nVictim == 0, "edits: a cancelled alarm fired");
+    CHECK(ctx.nAdded == 1, "edits: an alarm added while firing fired %d times", ctx.nAdded);
+    CHECK(wheel.nPending == 0, "edits: %ld left pending", (long)wheel.nPending);
+    CHECK(AlarmAddAt(&wheel, CHECK_START + 100, 0, 0) == 0, "edits: a one-shot alarm due now was added");
+    CHECK(AlarmAddAt(&wheel, CHECK_START + 100 + ALARM_HORIZON_SEC + 1, 0, 0) == 0,
+        "edits: an alarm beyond the horizon was added");
+    CHECK(AlarmCancel(&wheel, ctx.dwSelf) == 0, "edits: a stale id was cancelled");
+    AlarmWheelFree(&wheel);
+}
+
+// A zone an hour east of UTC with an hour more from the last Sunday in
+// March to the last in October, changing at 01:00 UTC
+static int32_t FakeOffsetAt(void* pCtx, int64_t llUtc)
+{
+    int64_t llDays = llUtc / 86400 - (llUtc % 86400 < 0);
+    int64_t llYear = 1970 + llDays / 366, llMarch, llOctober;
+
+    (void)pCtx;
+    while (DaysFromCivil(llYear + 1, 1, 1) <= llDays)
+        llYear++;
+    llMarch = DaysFromCivil(llYear, 3, 31);
+    llMarch -= DayOfWeek(llMarch);
+    llOctober = DaysFromCivil(llYear, 10, 31);
+    llOctober -= DayOfWeek(llOctober);
+    return llUtc >= llMarch * 86400 + 3600 && llUtc < llOctober * 86400 + 3600 ? 7200 : 3600;
+}
+
+typedef struct
+{
+    const ALARMWHEEL* pWheel;
+    int64_t llLastDay[4];
+    int nFires[4];
+    int nWrong;
+} DAILYCTX;
+
+// Tag 0 rings at 07:00 local every day, tag 1 at 02:30 local, which a
+// change skips or repeats, tag 2 at 09:15 at +05:30 on weekdays and tag
+// 3 at 18:00 UTC on weekends
+static void DailyFire(void* pCtx, uint32_t dwId, uint32_t dwTag, int64_t llDue)
+{
+    static const int iSeconds[] = { 7 * 3600, 9000, 9 * 3600 + 900, 18 * 3600 };
+    DAILYCTX* p = (DAILYCTX*)pCtx;
+    int32_t lOffset = dwTag < 2 ? FakeOffsetAt(NULL, llDue) : dwTag == 2 ? 19800 : 0;
+    int64_t llLocal = llDue + lOffset, llDay = llLocal / 86400;
+    int iDay = DayOfWeek(llDay), bOk;
+
+    (void)dwId;
+    bOk = p->pWheel->llNow == llDue && llDay != p->llLastDay[dwTag];
+    if (dwTag == 1)
+        bOk = bOk && (llLocal % 86400 == iSeconds[1] || llLocal % 86400 == iSeconds[1] + 3600);
+    else
+        bOk = bOk && llLocal % 86400 == iSeconds[dwTag];
+    if (dwTag == 2)
+        bOk = bOk && iDay >= 1 && iDay <= 5;
+    if (dwTag == 3)
+        bOk = bOk && (iDay == 0 || iDay == 6);
+    if (!bOk && p->nWrong++ < 5)
+        printf("  daily alarm %lu fired for local %lld (day %lld) at %lld\n", (unsigned long)dwTag,
+            (long long)llLocal, (long long)llDay, (long long)p->pWheel->llNow);
+    p->llLastDay[dwTag] = llDay;
+    p->nFires[dwTag]++;
+}
+
+static void CheckDaily(void)
+{
+    static const char* lines[] = {
+        "daily 07:00 local wake",
+        "daily 02:30 local ambiguous",
+        "daily 09:15 +05:30 mon-fri standup",
+        "daily 18:00 Z sat,sun weekend"
+    };
+    static ALARMWHEEL wheel;
+    TIMECLOCK clock;
+    ALARMSPEC spec;
+    DAILYCTX ctx;
+    int64_t llEnd = CHECK_START + 366 * 86400LL;
+    int i, nWeekdays = 0;
+
+    memset(&clock, 0, sizeof(clock));
+    clock.pfnOffsetAt = FakeOffsetAt;
+    AlarmWheelInit(&wheel, 16, CHECK_START, &clock);
+    for (i = 0; i < 4; i++)
+    {
+        CHECK(AlarmParse(lines[i], &spec) == 1, "daily: parse \"%s\"", lines[i]);
+        CHECK(AlarmAdd(&wheel, &spec, (uint32_t)i) != 0, "daily: add \"%s\"", lines[i]);
+    }
+    memset(&ctx, 0, sizeof(ctx));
+    ctx.pWheel = &wheel;
+    while (wheel.llNow < llEnd)
+        AlarmWheelAdvance(&wheel, wheel.llNow + ALARM_CATCHUP_SEC, DailyFire, &ctx);
+
+    for (i = 0; i < 366; i++)
+        nWeekdays += DayOfWeek((CHECK_START + 19800) / 86400 + i) % 6 != 0;
+    CHECK(ctx.nWrong == 0, "daily: %d alarms at the wrong time", ctx.nWrong);
+    CHECK(ctx.nFires[0] == 366 && ctx.nFires[1] == 366, "daily: %d and %d local alarms in 366 days",
+        ctx.nFires[0], ctx.nFires[1]);
+    CHECK(ctx.nFires[2] >= nWeekdays - 1 && ctx.nFires[2] <= nWeekdays + 1, "daily: %d weekday alarms, expected %d",
+        ctx.nFires[2], nWeekdays);
+    CHECK(ctx.nFires[2] + ctx.nFires[3] >= 364 && ctx.nFires[2] + ctx.nFires[3] <= 368,
+        "daily: %d weekday and %d weekend alarms", ctx.nFires[2], ctx.nFires[3]);
+    printf("Daily: %d, %d, %d and %d alarms over a year with two offset changes\n",
+        ctx.nFires[0], ctx.nFires[1], ctx.nFires[2], ctx.nFires[3]);
+    AlarmWheelFree(&wheel);
+}
+
+static int32_t FixedOffsetAt(void* pCtx, int64_t llUtc)
+{
+    (void)llUtc;
+    return *(int32_t*)pCtx;
+}
+
+// A daily alarm in the local zone follows the zone being changed
+static void CheckRezone(void)
+{
+    static FIRELOG log;
+    ALARMWHEEL wheel;
+    TIMECLOCK clock;
+    ALARMSPEC spec;
+    int32_t lOffset = 3600;
+
+    memset(&clock, 0, sizeof(clock));
+    clock.pfnOffsetAt = FixedOffsetAt;
+    clock.pCtx = &lOffset;
+    AlarmWheelInit(&wheel, 4, CHECK_START, &clock);
+    AlarmParse("daily 07:00 local wake", &spec);
+    AlarmAdd(&wheel, &spec, 0);
+    lOffset = -5 * 3600;
+    AlarmWheelRezone(&wheel);
+
+    log.pWheel = &wheel;
+    log.nFires = 0;
+    while (wheel.llNow < CHECK_START + 86400)
+        AlarmWheelAdvance(&wheel, wheel.llNow + ALARM_CATCHUP_SEC, LogFire, &log);
+    CHECK(log.nFires == 1 && log.llDues[0] == CHECK_START + 12 * 3600 && log.llAts[0] == log.llDues[0],
+        "rezone: %d fired, the first due %lld, expected %lld", log.nFires,
+        (long long)(log.nFires ? log.llDues[0] : 0), CHECK_START + 12 * 3600);
+    AlarmWheelFree(&wheel);
+}
+
+static void CheckParse(void)
+{
+    ALARMSPEC spec;
+
+    CHECK(AlarmParse("   ", &spec) == 0, "parse: blank line");
+    CHECK(AlarmParse("# once 2026-01-01 00:00 Z x", &spec) == 0, "parse: comment");
+    CHECK(AlarmParse("once 2026-10-25 07:30 +01:00 Dentist", &spec) == 1 && spec.iKind == ALARM_ONCE &&
+        spec.llLocal == CHECK_START + 27000 && spec.lOffset == 3600 && !spec.bLocalZone &&
+        strcmp(spec.szLabel, "Dentist") == 0, "parse: once");
+    CHECK(AlarmParse("every 90m 2026-10-25 00:00:30 local Stretch  \r\n", &spec) == 1 && spec.iKind == ALARM_EVERY &&
+        spec.dwPeriod == 5400 && spec.llLocal == CHECK_START + 30 && spec.bLocalZone &&
+        strcmp(spec.szLabel, "Stretch") == 0, "parse: every");
+    CHECK(AlarmParse("daily 06:45 -03:30 mon-wed,fri Run", &spec) == 1 && spec.iKind == ALARM_DAILY &&
+        spec.iSecondOfDay == 24300 && spec.lOffset == -12600 && spec.bDays == 0x2E &&
+        strcmp(spec.szLabel, "Run") == 0, "parse: daily on some days");
+    CHECK(AlarmParse("daily 23:59:59 Z fri-mon", &spec) == 1 && spec.bDays == 0x63 && spec.szLabel[0] == '\0',
+        "parse: days across the weekend");
+    CHECK(AlarmParse("daily 12:00 Z Lunch", &spec) == 1 && spec.bDays == ALARM_EVERY_DAY &&
+        strcmp(spec.szLabel, "Lunch") == 0, "parse: a label that is not a day");
+    CHECK(AlarmParse("once 2026-13-01 00:00 Z x", &spec) == -1, "parse: month 13");
+    CHECK(AlarmParse("once 2026-01-01 24:00 Z x", &spec) == -1, "parse: hour 24");
+    CHECK(AlarmParse("daily 07:00 +15:00 x", &spec) == -1, "parse: offset past +14:00");
+    CHECK(AlarmParse("every 0s 2026-01-01 00:00 Z x", &spec) == -1, "parse: zero period");
+    CHECK(AlarmParse("daily 07:00Z x", &spec) == -1, "parse: zone run into the time");
+    CHECK(AlarmParse("weekly 07:00 Z x", &spec) == -1, "parse: unknown kind");
+    printf("Parse: done\n");
+}
+
+static int Check(int argc, char* argv[])
+{
+    int nSteps = argc > 0 && atoi(argv[0]) > 0 ? atoi(argv[0]) : 50000;
+
+    CheckRandom(nSteps);
+    CheckBoundaries();
+    CheckCallbackEdits();
+    CheckDaily();
+    CheckRezone();
+    CheckParse();
+
+    return CheckResult();
+}
+
+static void CountFire(void* pCtx, uint32_t dwId, uint32_t dwTag, int64_t llDue)
+{
+    (void)dwId;
+    (void)dwTag;
+    (void)llDue;
+    (*(long*)pCtx)++;
+}
+
+static int CompareU64(const void* p1, const void* p2)
+{
+    uint64_t qw1 = *(const uint64_t*)p1, qw2 = *(const uint64_t*)p2;
+
+    return qw1 < qw2 ? -1 : qw1 > qw2;
+}
+
+// Mean and 99th percentile of one-second advances with nothing due soon
+static void TimeTicks(ALARMWHEEL* pWheel, uint64_t* pqwTicks, double* pdMean, double* pdP99)
+{
+    uint64_t qwStart, qwTotal = 0;
+    long nFired = 0;
+    int i;
+
+    for (i = 0; i < BENCH_TICKS; i++)
+    {
+        qwStart = PhaseNowNs();
+        AlarmWheelAdvance(pWheel, pWheel->llNow + 1, CountFire, &nFired);
+        pqwTicks[i] = PhaseNowNs() - qwStart;
+        qwTotal += pqwTicks[i];
+    }
+    qsort(pqwTicks, BENCH_TICKS, sizeof(uint64_t), CompareU64);
+    *pdMean = (double)qwTotal / BENCH_TICKS;
+    *pdP99 = (double)pqwTicks[BENCH_TICKS * 99 / 100];
+}
+
+static volatile long lScanSink;
+
+// The same ticks over a plain array of due times, each scanned in full
+static void TimeScan(const int64_t* pllDue, int n, int64_t llNow, uint64_t* pqwTicks, double* pdMean, double* pdP99)
+{
+    uint64_t qwStart, qwTotal = 0;
+    long nFired = 0;
+    int i, j;
+
+    for (i = 0; i < BENCH_TICKS; i++)
+    {
+        qwStart = PhaseNowNs();
+        llNow++;
+        for (j = 0; j < n; j++)
+            nFired += pllDue[j] == llNow;
+        lScanSink = nFired;
+        pqwTicks[i] = PhaseNowNs() - qwStart;
+        qwTotal += pqwTicks[i];
+    }
+    qsort(pqwTicks, BENCH_TICKS, sizeof(uint64_t), CompareU64);
+    *pdMean = (double)qwTotal / BENCH_TICKS;
+    *pdP99 = (double)pqwTicks[BENCH_TICKS * 99 / 100];
+}
+
+static int Bench(int argc, char* argv[])
+{
+    static uint64_t qwTicks[BENCH_TICKS];
+    ALARMWHEEL wheel;
+    uint32_t* pdwIds;
+    int64_t* pllDue;
+    uint64_t qwStart, qwInsert, qwCancel, qwExpire;
+    double dWheelMean, dWheelP99, dScanMean, dScanP99;
+    char buf[256];
+    long nFired = 0;
+    int i, n = argc > 0 && atoi(argv[0]) > 0 ? atoi(argv[0]) : 100000;
+
+    pdwIds = (uint32_t*)malloc(n * sizeof(uint32_t));
+    pllDue = (int64_t*)malloc(n * sizeof(int64_t));
+    if (!pdwIds || !pllDue || !AlarmWheelInit(&wheel, n, CHECK_START, NULL))
+        return 2;
+
+    // Due a day to a year on, so the ticks below fire nothing
+    srand(7);
+    for (i = 0; i < n; i++)
+        pllDue[i] = CHECK_START + 86400 + Random64(365 * 86400LL);
+    qwStart = PhaseNowNs();
+    for (i = 0; i < n; i++)
+        pdwIds[i] = AlarmAddAt(&wheel, pllDue[i], 0, 0);
+    qwInsert = PhaseNowNs() - qwStart;
+
+    TimeTicks(&wheel, qwTicks, &dWheelMean, &dWheelP99);
+    TimeScan(pllDue, n, CHECK_START, qwTicks, &dScanMean, &dScanP99);
+
+    qwStart = PhaseNowNs();
+    for (i = 0; i < n; i += 2)
+        AlarmCancel(&wheel, pdwIds[i]);
+    qwCancel = PhaseNowNs() - qwStart;
+
+    // Everything left, then a fresh set, due within the next hour
+    AlarmWheelAdvance(&wheel, CHECK_START + 366 * 86400LL, CountFire, &nFired);
+    for (i = 0; i < n; i++)
+        AlarmAddAt(&wheel, wheel.llNow + 1 + Random64(ALARM_CATCHUP_SEC), 0, 0);
+    nFired = 0;
+    qwStart = PhaseNowNs();
+    AlarmWheelAdvance(&wheel, wheel.llNow + ALARM_CATCHUP_SEC, CountFire, &nFired);
+    qwExpire = PhaseNowNs() - qwStart;
+
+    printf("%d alarms\n", n);
+    printf("%-34s %8.1f ns\n", "insert", (double)qwInsert / n);
+    printf("%-34s %8.1f ns\n", "cancel", (double)qwCancel / ((n + 1) / 2));
+    printf("%-34s %8.1f ns\n", "expire, per alarm fired", nFired ? (double)qwExpire / nFired : 0.0);
+    printf("%-34s %8.1f ns mean, %8.1f ns p99\n", "wheel tick, nothing due", dWheelMean, dWheelP99);
+    printf("%-34s %8.1f ns mean, %8.1f ns p99\n", "plain list scan per tick", dScanMean, dScanP99);
+    AlarmWheelFormat(&wheel, buf, sizeof(buf));
+    printf("  %s\n", buf);
+
+    AlarmWheelFree(&wheel);
+    free(pdwIds);
+    free(pllDue);
+    if (nFired != n || dWheelMean >= dScanMean)
+    {
+        printf("FAIL: %ld of %d fired, wheel tick %.1f ns against %.1f ns\n", nFired, n, dWheelMean, dScanMean);
+        return 1;
+    }
+    printf("PASS\n");
+    return 0;
+}
+
+int main(int argc, char* argv[])
+{
+    return CheckMain(argc, argv, Check, "[STEPS]", Bench, "[ALARMS]");
+}
@@ -0,0 +1,1091 @@
+/*--------------------------
+    CLOCKBENCH.C -- Headless benchmarks for clock geometry, faces, frames
+                    and the world-time grid
+
+    Usage: clockbench [--quick] [--baseline FILE] [--save FILE] [--threshold PCT]
+           clockbench grid [clocks] [width] [height] [frames] [sites.txt|-] [out.png]
+           clockbench sweep [width] [height] [hz] [seconds] [smooth|mechanical|tick] [out.png]
+           clockbench resize [trace.txt|-] [out.png]
+
+    The suite times rotation, hand poses, face construction and full frames
+    at client sizes from 200x200 to 7680x4320, single-threaded and tiled
+    on every processor, and the anti-aliasing kernels against plain 2x2
+    and 4x4 supersampling. With --baseline it exits 1 if any benchmark is
+    slower than the baseline by more than the threshold, if a tiled frame
+    differs from the single-threaded one, or if the anti-aliasing kernels
+    stray more than 1/255 from the reference coverage.
+
+    "sweep" animates the hands for the given seconds of clock time at hz
+    frames a second, each frame redrawing only the damaged box over a
+    cached face as WM_PAINT does. It prints the cost per frame and the
+    share of one core that rate takes. It exits 1 if the p99 frame misses
+    its refresh period, or if the last frame differs from a full redraw.
+
+    "resize" replays a drag of the window frame, one "width height" line a
+    WM_SIZE (a built-in drag from 480x360 to 1920x1080 and back to 800x600
+    without a trace), painting each size from scratch and as a live resize
+    does, scaled from the nearest of the cached faces. It prints both frame
+    times and the final full-quality paint, and exits 1 if the scaled p99
+    misses 60 fps or the final paint differs from a full redraw.
+---------------------------*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "aaraster.h"
+#include "clockgrid.h"
+#include "facecache.h"
+#include "phasetime.h"
+#include "rastertile.h"
+#include "sweep.h"
+
+#define BENCH_MAX_CLOCKS 4096
+#define BENCH_TARGET_FPS 60
+
+// Offsets in use somewhere on Earth, in minutes, to spread the sites over
+static const int zoneOffsets[] = {
+    -720, -660, -600, -570, -540, -480, -420, -360, -300, -240, -210, -180,
+    -120, -60, 0, 60, 120, 180, 210, 240, 270, 300, 330, 345, 360, 390, 420,
+    480, 525, 540, 570, 600, 630, 660, 720, 765, 780, 840
+};
+
+static CLOCKINSTANCE clocks[BENCH_MAX_CLOCKS];
+static CLOCKGRID grid;
+
+static double NowMs(void)
+{
+    return PhaseNowNs() / 1e6;
+}
+
+static int CompareDouble(const void* a, const void* b)
+{
+    double d = *(const double*)a - *(const double*)b;
+    return d < 0 ? -1 : d > 0;
+}
+
+// argv[0] is "grid"; the rest are the grid arguments
+static int RunGrid(int argc, char* argv[])
+{
+    int nClocks = argc > 1 ? atoi(argv[1]) : 240;
+    int cx = argc > 2 ? atoi(argv[2]) : 1920;
+    int cy = argc > 3 ? atoi(argv[3]) : 1080;
+    int nFrames = argc > 4 ? atoi(argv[4]) : 600;
+    const char* pszSites = argc > 5 && strcmp(argv[5], "-") != 0 ? argv[5] : NULL;
+    const char* pszOut = argc > 6 ? argv[6] : NULL;
+    FRAMEBUFFER fb;
+    double* pFrameMs;
+    double msStart, msTotal = 0;
+    int64_t llUtc = (int64_t)time(NULL);
+    int i, nZones = sizeof(zoneOffsets) / sizeof(zoneOffsets[0]);
+
+    if (pszSites)
+    {
+        nClocks = ClockGridLoad(pszSites, clocks, BENCH_MAX_CLOCKS);
+        if (nClocks <= 0)
+        {
+            fprintf(stderr, "%s: no clocks in %s\n", argv[0], pszSites);
+            return 1;
+        }
+    }
+    else
+    {
+        if (nClocks < 1 || nClocks > BENCH_MAX_CLOCKS)
+        {
+            fprintf(stderr, "%s: clocks must be 1..%d\n", argv[0], BENCH_MAX_CLOCKS);
+            return 2;
+        }
+        for (i = 0; i < nClocks; i++)
+        {
+            clocks[i].iUtcOffsetMin = zoneOffsets[i % nZones];
+            clocks[i].style.bDarkMode = i / nZones % 2;
+            clocks[i].style.bShowDots = 1;
+            sprintf(clocks[i].szLabel, "Site %d", i + 1);
+        }
+    }
+
+    if (nFrames < 1 || !RasterCreate(&fb, cx, cy))
+    {
+        fprintf(stderr, "usage: %s [clocks] [width] [height] [frames] [sites.txt|-] [out.png]\n", argv[0]);
+        return 2;
+    }
+    pFrameMs = (double*)malloc(sizeof(double) * nFrames);
+    if (!pFrameMs)
+        return 1;
+
+    InitRotateTable();
+    ClockGridInit(&grid);
+
+    // Every frame is a new second, so every hand moves
+    for (i = 0; i < nFrames; i++)
+    {
+        msStart = NowMs();
+        ClockGridRender(&grid, &fb, clocks, nClocks, llUtc + i, CLOCK_RGB(32, 32, 32));
+        pFrameMs[i] = NowMs() - msStart;
+        msTotal += pFrameMs[i];
+    }
+
+    qsort(pFrameMs, nFrames, sizeof(double), CompareDouble);
+
+    printf("%d clocks in %dx%d (%dx%d cells of %d px), %d frames\n", nClocks, cx, cy,
+        grid.layout.nCols, grid.layout.nRows, grid.layout.iCell, nFrames);
+    printf("frame ms: mean %.3f, p50 %.3f, p99 %.3f, max %.3f\n", msTotal / nFrames,
+        pFrameMs[nFrames / 2], pFrameMs[nFrames * 99 / 100], pFrameMs[nFrames - 1]);
+    printf("%.1f fps, target %d: %s\n", 1000.0 * nFrames / msTotal, BENCH_TARGET_FPS,
+        pFrameMs[nFrames * 99 / 100] <= 1000.0 / BENCH_TARGET_FPS ? "PASS" : "FAIL");
+
+    if (pszOut && !RasterWritePNG(&fb, pszOut))
+        fprintf(stderr, "%s: could not write %s\n", argv[0], pszOut);
+
+    i = pFrameMs[nFrames * 99 / 100] <= 1000.0 / BENCH_TARGET_FPS ? 0 : 1;
+    free(pFrameMs);
+    ClockGridFree(&grid);
+    RasterFree(&fb);
+    return i;
+}
+
+// Copies the damaged box of the cached face back into the frame
+static void RestoreFace(FRAMEBUFFER* pFb, const FRAMEBUFFER* pFace, const DAMAGERECT* pDamage)
+{
+    int y;
+
+    for (y = pDamage->top; y < pDamage->bottom; y++)
+        memcpy(pFb->pPixels + ((size_t)y * pFb->cx + pDamage->left) * 4,
+            pFace->pPixels + ((size_t)y * pFace->cx + pDamage->left) * 4,
+            (size_t)(pDamage->right - pDamage->left) * 4);
+}
+
+// argv[0] is "sweep"; the rest are the sweep arguments
+static int RunSweep(int argc, char* argv[])
+{
+    int cx = argc > 1 ? atoi(argv[1]) : 1920;
+    int cy = argc > 2 ? atoi(argv[2]) : 1080;
+    int iHz = argc > 3 ? atoi(argv[3]) : 144;
+    double seconds = argc > 4 ? atof(argv[4]) : 10;
+    const char* pszMode = argc > 5 ? argv[5] : "mechanical";
+    const char* pszOut = argc > 6 ? argv[6] : NULL;
+    int iMode = strcmp(pszMode, "smooth") == 0 ? SWEEP_SMOOTH : strcmp(pszMode, "tick") == 0 ? SWEEP_OFF :
+        strcmp(pszMode, "mechanical") == 0 ? SWEEP_MECHANICAL : -1;
+    FRAMEBUFFER fb, face, check;
+    CLOCKBACKEND backend, checkBackend;
+    RASTERVIEW view, checkView;
+    CLOCKSTYLE style = { 0 };
+    SWEEPHANDS hands;
+    DAMAGERECT damage;
+    double* pFrameUs;
+    double usStart, usTotal = 0, pixels = 0, usFull;
+    long nFrames = (long)(seconds * iHz), i, nDrawn = 0;
+    int64_t llMs;
+    int iTenths[3], bSame, iResult;
+
+    if (iMode < 0 || iHz < SWEEP_MIN_HZ || iHz > SWEEP_MAX_HZ || nFrames < 1 ||
+        !RasterCreate(&fb, cx, cy) || !RasterCreate(&face, cx, cy) || !RasterCreate(&check, cx, cy))
+    {
+        fprintf(stderr, "usage: %s [width] [height] [hz %d..%d] [seconds] [smooth|mechanical|tick] [out.png]\n",
+            argv[0], SWEEP_MIN_HZ, SWEEP_MAX_HZ);
+        return 2;
+    }
+    pFrameUs = (double*)malloc(sizeof(double) * nFrames);
+    if (!pFrameUs)
+        return 1;
+
+    InitRotateTable();
+    InitSweepTable();
+    style.bShowDots = 1;
+
+    // The face cache, and the first frame over it
+    RasterViewInit(&view, &face, 0, 0, cx, cy);
+    RasterBackend(&backend, &view);
+    RasterClear(&face, ClockBackground(&style));
+    ClockDrawFace(&backend, &style);
+    memcpy(fb.pPixels, face.pPixels, (size_t)cx * cy * 4);
+    RasterViewInit(&view, &fb, 0, 0, cx, cy);
+    RasterBackend(&backend, &view);
+    SweepHandsInit(&hands);
+
+    // From 10:08:29.5, so a minute goes by in the first 30 seconds
+    for (i = 0; i < nFrames; i++)
+    {
+        llMs = 36509500 + i * 1000 / iHz;
+        usStart = PhaseNowNs() / 1e3;
+        SweepHandAngles(iMode, (int)(llMs / 3600000 % 24), (int)(llMs / 60000 % 60), (int)(llMs / 1000 % 60),
+            (int)(llMs % 1000), iTenths);
+        DamageEmpty(&damage);
+        if (SweepHandsMove(&hands, iTenths, cx, cy, &damage))
+        {
+            DamageClip(&damage, cx, cy);
+            RestoreFace(&fb, &face, &damage);
+            ClockDrawHandOutlines(&backend, &style, (const ROTPOINT(*)[CLOCK_HAND_POINTS])hands.pt);
+            pixels += (double)(damage.right - damage.left) * (damage.bottom - damage.top);
+            nDrawn++;
+        }
+        pFrameUs[i] = PhaseNowNs() / 1e3 - usStart;
+        usTotal += pFrameUs[i];
+    }
+
+    // The same last frame drawn from scratch, which also times a full redraw
+    RasterViewInit(&checkView, &check, 0, 0, cx, cy);
+    RasterBackend(&checkBackend, &checkView);
+    usStart = PhaseNowNs() / 1e3;
+    RasterClear(&check, ClockBackground(&style));
+    ClockDrawFace(&checkBackend, &style);
+    ClockDrawHandOutlines(&checkBackend, &style, (const ROTPOINT(*)[CLOCK_HAND_POINTS])hands.pt);
+    usFull = PhaseNowNs() / 1e3 - usStart;
+    bSame = memcmp(fb.pPixels, check.pPixels, (size_t)cx * cy * 4) == 0;
+
+    qsort(pFrameUs, nFrames, sizeof(double), CompareDouble);
+    printf("%s sweep of %dx%d at %d Hz, %ld frames over %.1f s, %ld drawn\n", pszMode, cx, cy, iHz, nFrames,
+        seconds, nDrawn);
+    printf("frame us: mean %.1f, p50 %.1f, p99 %.1f, max %.1f; full redraw %.1f\n", usTotal / nFrames,
+        pFrameUs[nFrames / 2], pFrameUs[nFrames * 99 / 100], pFrameUs[nFrames - 1], usFull);
+    printf("damaged %.0f pixels per drawn frame (%.2f%% of the frame), %.2f%% of one core\n",
+        nDrawn ? pixels / nDrawn : 0.0, nDrawn ? pixels / nDrawn * 100 / ((double)cx * cy) : 0.0,
+        usTotal / nFrames * iHz / 1e4);
+    printf("p99 within the %.2f ms period: %s; last frame matches a full redraw: %s\n", 1000.0 / iHz,
+        pFrameUs[nFrames * 99 / 100] <= 1e6 / iHz ? "PASS" : "FAIL", bSame ? "PASS" : "FAIL");
+
+    if (pszOut && !RasterWritePNG(&fb, pszOut))
+        fprintf(stderr, "%s: could not write %s\n", argv[0], pszOut);
+
+    iResult = pFrameUs[nFrames * 99 / 100] <= 1e6 / iHz && bSame ? 0 : 1;
+    free(pFrameUs);
+    RasterFree(&fb);
+    RasterFree(&face);
+    RasterFree(&check);
+    return iResult;
+}
+
+#define RESIZE_MAX_SIZES 65536
+
+static void FreeFaceFb(void* pCtx, void* pFace)
+{
+    (void)pCtx;
+    RasterFree((FRAMEBUFFER*)pFace);
+    free(pFace);
+}
+
+// Draws the face for a cx by cy client into a new framebuffer and caches it
+static FACEENTRY* RenderResizeFace(FACECACHE* pCache, const CLOCKSTYLE* pStyle, int cx, int cy)
+{
+    FRAMEBUFFER* pFace = (FRAMEBUFFER*)malloc(sizeof(FRAMEBUFFER));
+    CLOCKBACKEND backend;
+    RASTERVIEW view;
+    FACEENTRY* pEntry;
+    uint64_t qwStart = PhaseNowNs();
+
+    if (!pFace || !RasterCreate(pFace, cx, cy))
+    {
+        free(pFace);
+        return NULL;
+    }
+    RasterViewInit(&view, pFace, 0, 0, cx, cy);
+    RasterBackend(&backend, &view);
+    RasterClear(pFace, ClockBackground(pStyle));
+    ClockDrawFace(&backend, pStyle);
+    pEntry = FaceCacheInsert(pCache, cx, cy, FACE_DOTS, pFace);
+    pCache->qwRenderNs += PhaseNowNs() - qwStart;
+    return pEntry;
+}
+
+// One WM_SIZE per line as "width height"; anything else is skipped
+static int LoadTrace(const char* pszPath, int (*pSizes)[2], int nMax)
+{
+    FILE* fp = strcmp(pszPath, "-") == 0 ? stdin : fopen(pszPath, "r");
+    char szLine[128];
+    int n = 0;
+
+    if (!fp)
+        return -1;
+    while (n < nMax && fgets(szLine, sizeof(szLine), fp))
+        if (sscanf(szLine, "%d %d", &pSizes[n][0], &pSizes[n][1]) == 2 && pSizes[n][0] > 0 && pSizes[n][1] > 0)
+            n++;
+    if (fp != stdin)
+        fclose(fp);
+    return n;
+}
+
+// A drag of the corner from 480x360 out to 1920x1080 over two seconds and
+// back in to 800x600 over one, at 60 WM_SIZEs a second
+static int SyntheticTrace(int (*pSizes)[2])
+{
+    int i, n = 0;
+
+    for (i = 0; i < 120; i++, n++)
+    {
+        pSizes[n][0] = 480 + (1920 - 480) * i / 119;
+        pSizes[n][1] = 360 + (1080 - 360) * i / 119;
+    }
+    for (i = 1; i <= 60; i++, n++)
+    {
+        pSizes[n][0] = 1920 - (1920 - 800) * i / 60;
+        pSizes[n][1] = 1080 - (1080 - 600) * i / 60;
+    }
+    return n;
+}
+
+// A drag frame as the single-size face cache painted it: every new size
+// dropped the face bitmap and drew one from scratch before the hands
+static void RedrawnFrame(const CLOCKSTYLE* pStyle, FRAMEBUFFER* pFb)
+{
+    CLOCKBACKEND backend;
+    RASTERVIEW view;
+    FRAMEBUFFER face;
+
+    if (!RasterCreate(&face, pFb->cx, pFb->cy))
+        return;
+    RasterViewInit(&view, &face, 0, 0, face.cx, face.cy);
+    RasterBackend(&backend, &view);
+    RasterClear(&face, ClockBackground(pStyle));
+    ClockDrawFace(&backend, pStyle);
+    RasterBlit(pFb, 0, 0, &face);
+    RasterFree(&face);
+
+    RasterViewInit(&view, pFb, 0, 0, pFb->cx, pFb->cy);
+    RasterBackend(&backend, &view);
+    ClockDrawHands(&backend, pStyle, 10, 8, 30, 1);
+}
+
+// The drag frame DrawScaledFace paints: the nearest cached face stretched
+// over the face square, the bands beside it cleared, then the hands
+static void ScaledFrame(FACECACHE* pCache, const CLOCKSTYLE* pStyle, FRAMEBUFFER* pFb)
+{
+    CLOCKBACKEND backend;
+    RASTERVIEW view;
+    DAMAGERECT rcDst, rcSrc;
+    RASTERCLIP dst, src;
+    FACEENTRY* pEntry;
+    uint32_t crBack = ClockBackground(pStyle);
+    uint64_t qwStart;
+    int iBucket;
+
+    FaceSquare(pFb->cx, pFb->cy, &rcDst);
+    iBucket = FaceBucketIndex(rcDst.right - rcDst.left);
+    pEntry = FaceCacheNearest(pCache, iBucket, FACE_DOTS, FACE_SCALE_STEPS);
+    if (!pEntry)
+        pEntry = RenderResizeFace(pCache, pStyle, FaceBucketSide(iBucket), FaceBucketSide(iBucket));
+    if (!pEntry)
+        return;
+
+    qwStart = PhaseNowNs();
+    RasterFillRect(pFb, 0, 0, pFb->cx, rcDst.top, crBack);
+    RasterFillRect(pFb, 0, rcDst.bottom, pFb->cx, pFb->cy, crBack);
+    RasterFillRect(pFb, 0, rcDst.top, rcDst.left, rcDst.bottom, crBack);
+    RasterFillRect(pFb, rcDst.right, rcDst.top, pFb->cx, rcDst.bottom, crBack);
+    FaceSquare(pEntry->cx, pEntry->cy, &rcSrc);
+    dst.left = rcDst.left;
+    dst.top = rcDst.top;
+    dst.right = rcDst.right;
+    dst.bottom = rcDst.bottom;
+    src.left = rcSrc.left;
+    src.top = rcSrc.top;
+    src.right = rcSrc.right;
+    src.bottom = rcSrc.bottom;
+    RasterStretch(pFb, &dst, (const FRAMEBUFFER*)pEntry->pFace, &src);
+    pCache->qwScaleNs += PhaseNowNs() - qwStart;
+
+    RasterViewInit(&view, pFb, 0, 0, pFb->cx, pFb->cy);
+    RasterBackend(&backend, &view);
+    ClockDrawHands(&backend, pStyle, 10, 8, 30, 1);
+}
+
+// argv[0] is "resize"; the rest are the resize arguments
+static int RunResize(int argc, char* argv[])
+{
+    const char* pszTrace = argc > 1 ? argv[1] : NULL;
+    const char* pszOut = argc > 2 ? argv[2] : NULL;
+    static int sizes[RESIZE_MAX_SIZES][2];
+    CLOCKSTYLE style = { 0 };
+    CLOCKBACKEND backend;
+    RASTERVIEW view;
+    FACECACHE cache;
+    FACEENTRY* pEntry;
+    FRAMEBUFFER big, frame, check;
+    double *pFullMs, *pScaledMs;
+    double msStart, msFull = 0, msScaled = 0, msRelease;
+    char szLine[320];
+    int i, n, cxMax = 1, cyMax = 1, bSame, iResult;
+
+    n = pszTrace && strcmp(pszTrace, "-") != 0 ? LoadTrace(pszTrace, sizes, RESIZE_MAX_SIZES) :
+        pszTrace ? LoadTrace("-", sizes, RESIZE_MAX_SIZES) : SyntheticTrace(sizes);
+    if (n <= 0)
+    {
+        fprintf(stderr, "usage: %s [trace.txt|-] [out.png]\n", argv[0]);
+        return 2;
+    }
+    for (i = 0; i < n; i++)
+    {
+        cxMax = sizes[i][0] > cxMax ? sizes[i][0] : cxMax;
+        cyMax = sizes[i][1] > cyMax ? sizes[i][1] : cyMax;
+    }
+    pFullMs = (double*)malloc(sizeof(double) * n);
+    pScaledMs = (double*)malloc(sizeof(double) * n);
+    if (!pFullMs || !pScaledMs || !RasterCreate(&big, cxMax, cyMax))
+        return 1;
+
+    InitRotateTable();
+    style.bShowDots = 1;
+    FaceCacheInit(&cache, FACE_CACHE_BUDGET, FreeFaceFb, NULL);
+    frame.pPixels = big.pPixels;
+
+    // Each size twice: redrawn, as every WM_SIZE used to be, and scaled
+    // from the cache as a paint during the drag is now
+    for (i = 0; i < n; i++)
+    {
+        frame.cx = sizes[i][0];
+        frame.cy = sizes[i][1];
+        msStart = NowMs();
+        RedrawnFrame(&style, &frame);
+        pFullMs[i] = NowMs() - msStart;
+        msFull += pFullMs[i];
+
+        msStart = NowMs();
+        ScaledFrame(&cache, &style, &frame);
+        pScaledMs[i] = NowMs() - msStart;
+        msScaled += pScaledMs[i];
+    }
+
+    // The release: the face drawn for the final size, then the hands
+    msStart = NowMs();
+    pEntry = FaceCacheFind(&cache, frame.cx, frame.cy, FACE_DOTS);
+    if (!pEntry)
+        pEntry = RenderResizeFace(&cache, &style, frame.cx, frame.cy);
+    if (pEntry)
+        RasterBlit(&frame, 0, 0, (const FRAMEBUFFER*)pEntry->pFace);
+    RasterViewInit(&view, &frame, 0, 0, frame.cx, frame.cy);
+    RasterBackend(&backend, &view);
+    ClockDrawHands(&backend, &style, 10, 8, 30, 1);
+    msRelease = NowMs() - msStart;
+
+    bSame = pEntry && RasterCreate(&check, frame.cx, frame.cy);
+    if (bSame)
+    {
+        RasterDrawClock(&check, &style, 10, 8, 30);
+        bSame = memcmp(frame.pPixels, check.pPixels, (size_t)frame.cx * frame.cy * 4) == 0;
+        RasterFree(&check);
+    }
+
+    qsort(pFullMs, n, sizeof(double), CompareDouble);
+    qsort(pScaledMs, n, sizeof(double), CompareDouble);
+    printf("resize trace of %d sizes up to %dx%d, ending at %dx%d\n", n, cxMax, cyMax, frame.cx, frame.cy);
+    printf("redrawn face ms: mean %.3f, p50 %.3f, p99 %.3f, max %.3f\n", msFull / n,
+        pFullMs[n / 2], pFullMs[n * 99 / 100], pFullMs[n - 1]);
+    printf("scaled face ms: mean %.3f, p50 %.3f, p99 %.3f, max %.3f\n", msScaled / n,
+        pScaledMs[n / 2], pScaledMs[n * 99 / 100], pScaledMs[n - 1]);
+    FaceCacheFormat(&cache, szLine, sizeof(szLine));
+    printf("%s\n", szLine);
+    printf("release %.3f ms; p99 within %.2f ms: %s; release matches a full redraw: %s\n", msRelease,
+        1000.0 / BENCH_TARGET_FPS, pScaledMs[n * 99 / 100] <= 1000.0 / BENCH_TARGET_FPS ? "PASS" : "FAIL",
+        bSame ? "PASS" : "FAIL");
+
+    if (pszOut && !RasterWritePNG(&frame, pszOut))
+        fprintf(stderr, "%s: could not write %s\n", argv[0], pszOut);
+
+    iResult = pScaledMs[n * 99 / 100] <= 1000.0 / BENCH_TARGET_FPS && bSame ? 0 : 1;
+    FaceCacheFree(&cache);
+    free(pFullMs);
+    free(pScaledMs);
+    RasterFree(&big);
+    return iResult;
+}
+
+#define BENCH_MAX_RESULTS 64
+#define BENCH_NAME_CHARS 48
+#define BENCH_ROTATE_POINTS 1024
+#define BENCH_REPEATS 3
+
+typedef struct
+{
+    char szName[BENCH_NAME_CHARS];
+    long nIterations;
+    double nsPerOp;
+    double allocsPerOp;
+} BENCHRESULT;
+
+static BENCHRESULT results[BENCH_MAX_RESULTS];
+static int nResults = 0;
+static double msMinRun = 200;
+
+// Client sizes SetIsotropic has to cope with, smallest to an 8K wall
+static const int benchSizes[][2] = {
+    { 200, 200 }, { 640, 480 }, { 1280, 720 }, { 1920, 1080 }, { 3840, 2160 }, { 7680, 4320 }
+};
+
+typedef struct
+{
+    ROTPOINT pt[BENCH_ROTATE_POINTS];
+    FRAMEBUFFER fb;
+    CLOCKBACKEND backend;
+    RASTERVIEW view;
+    CLOCKSTYLE style;
+    FRAMEBUFFER tileFb;
+    TILERENDER tiles;
+    int nTileMismatches;
+    FRAMEBUFFER aaFb;
+    double aaSize;              // disc radius or line width
+    int nAAErrors;
+} BENCHCTX;
+
+// Tiled sizes; below 4K one thread fills a frame faster than the pool starts
+#define BENCH_TILED_MIN_CX 3840
+
+static BENCHCTX ctx;
+
+static void RunRotate(long nIter)
+{
+    long i;
+
+    for (i = 0; i < nIter; i++)
+        RotatePoints(ctx.pt, BENCH_ROTATE_POINTS, (int)(i * 37 % 3600));
+}
+
+static void RunRotateScalar(long nIter)
+{
+    long i;
+
+    for (i = 0; i < nIter; i++)
+        RotatePointsScalar(ctx.pt, BENCH_ROTATE_POINTS, (int)(i * 37 % 3600));
+}
+
+// One point at a time, the way RotatePoint is called for a single dot
+static void RotateOne(long nIter)
+{
+    long i;
+
+    for (i = 0; i < nIter; i++)
+        RotatePoints(&ctx.pt[i & (BENCH_ROTATE_POINTS - 1)], 1, (int)(i * 60 % 3600));
+}
+
+static void RunHands(long nIter)
+{
+    ROTPOINT pt[3][CLOCK_HAND_POINTS];
+    long i;
+
+    for (i = 0; i < nIter; i++)
+    {
+        ClockComputeHands((int)(i % 24), (int)(i % 60), (int)(i * 7 % 60), pt);
+        ctx.pt[i & (BENCH_ROTATE_POINTS - 1)] = pt[2][4];
+    }
+}
+
+// The same hands rotated at run time, as before the pose tables
+static void RunHandsRotate(long nIter)
+{
+    ROTPOINT pt[3][CLOCK_HAND_POINTS];
+    int iAngle[3], iHand;
+    long i;
+
+    for (i = 0; i < nIter; i++)
+    {
+        ClockHandAngles((int)(i % 24), (int)(i % 60), (int)(i * 7 % 60), iAngle);
+        for (iHand = 0; iHand < 3; iHand++)
+            ClockComputeHand(iHand, iAngle[iHand], pt[iHand]);
+        ctx.pt[i & (BENCH_ROTATE_POINTS - 1)] = pt[2][4];
+    }
+}
+
+static void RunFace(long nIter)
+{
+    long i;
+
+    for (i = 0; i < nIter; i++)
+    {
+        RasterClear(&ctx.fb, ClockBackground(&ctx.style));
+        ClockDrawFace(&ctx.backend, &ctx.style);
+    }
+}
+
+static void RunFrame(long nIter)
+{
+    long i;
+
+    for (i = 0; i < nIter; i++)
+        RasterDrawClock(&ctx.fb, &ctx.style, (int)(i % 12), (int)(i % 60), (int)(i * 7 % 60));
+}
+
+// RunFrame through ctx.view, which may have anti-aliasing on
+static void RunFrameView(long nIter)
+{
+    long i;
+
+    for (i = 0; i < nIter; i++)
+    {
+        RasterClear(&ctx.fb, ClockBackground(&ctx.style));
+        ClockDrawFace(&ctx.backend, &ctx.style);
+        ClockDrawHands(&ctx.backend, &ctx.style, (int)(i % 12), (int)(i % 60), (int)(i * 7 % 60), 1);
+    }
+}
+
+// One frame a second, as a wall clock ticks: only tiles under the hands
+// are redrawn
+static void RunTiled(long nIter)
+{
+    long i;
+
+    for (i = 0; i < nIter; i++)
+        TileRenderClock(&ctx.tiles, &ctx.tileFb, &ctx.style, (int)(i % 12), (int)(i % 60), (int)(i * 7 % 60));
+}
+
+// Every tile every frame, as after a resize or style change
+static void RunTiledFull(long nIter)
+{
+    long i;
+
+    for (i = 0; i < nIter; i++)
+    {
+        TileRenderInvalidate(&ctx.tiles);
+        TileRenderClock(&ctx.tiles, &ctx.tileFb, &ctx.style, (int)(i % 12), (int)(i % 60), (int)(i * 7 % 60));
+    }
+}
+
+// Tiled frames, skipped tiles included, must match RasterDrawClock exactly
+static void VerifyTiled(void)
+{
+    static const int times[][3] = { { 10, 8, 30 }, { 10, 8, 31 }, { 3, 59, 59 }, { 4, 0, 0 } };
+    size_t i;
+
+    TileRenderInvalidate(&ctx.tiles);
+    for (i = 0; i < sizeof(times) / sizeof(times[0]); i++)
+    {
+        RasterDrawClock(&ctx.fb, &ctx.style, times[i][0], times[i][1], times[i][2]);
+        if (!TileRenderClock(&ctx.tiles, &ctx.tileFb, &ctx.style, times[i][0], times[i][1], times[i][2]) ||
+            memcmp(ctx.fb.pPixels, ctx.tileFb.pPixels, (size_t)ctx.fb.cx * ctx.fb.cy * 4) != 0)
+        {
+            fprintf(stderr, "tiled frame %dx%d at %d:%02d:%02d differs from the single-threaded one\n",
+                ctx.fb.cx, ctx.fb.cy, times[i][0], times[i][1], times[i][2]);
+            ctx.nTileMismatches++;
+            return;
+        }
+    }
+}
+
+// Tick dots at 4K are discs of radius 16 and 49; hands are hairlines
+#define BENCH_AA_CX 256
+#define BENCH_AA_SHAPES 16
+
+static void AAShape(long i, double* px0, double* py0, double* px1, double* py1)
+{
+    *px0 = 64 + (double)(i * 37 % 128) + (i % 7) * 0.13;
+    *py0 = 64 + (double)(i * 53 % 128) + (i % 5) * 0.21;
+    *px1 = 128 + 100 * ((i * 11 % 9) - 4) / 4.0;
+    *py1 = 128 + 100 * ((i * 13 % 9) - 4) / 4.0;
+}
+
+static void RunAADisc(long nIter)
+{
+    double x0, y0, x1, y1;
+    long i;
+
+    for (i = 0; i < nIter; i++)
+    {
+        AAShape(i, &x0, &y0, &x1, &y1);
+        AAFillDisc(&ctx.aaFb, NULL, x0, y0, ctx.aaSize, (uint32_t)i & 0xFFFFFF);
+    }
+}
+
+static void RunAADiscScalar(long nIter)
+{
+    double x0, y0, x1, y1;
+    long i;
+
+    for (i = 0; i < nIter; i++)
+    {
+        AAShape(i, &x0, &y0, &x1, &y1);
+        AAFillDiscScalar(&ctx.aaFb, NULL, x0, y0, ctx.aaSize, (uint32_t)i & 0xFFFFFF);
+    }
+}
+
+static void RunSS2Disc(long nIter)
+{
+    double x0, y0, x1, y1;
+    long i;
+
+    for (i = 0; i < nIter; i++)
+    {
+        AAShape(i, &x0, &y0, &x1, &y1);
+        AAFillDiscSampled(&ctx.aaFb, NULL, x0, y0, ctx.aaSize, (uint32_t)i & 0xFFFFFF, 2);
+    }
+}
+
+static void RunSS4Disc(long nIter)
+{
+    double x0, y0, x1, y1;
+    long i;
+
+    for (i = 0; i < nIter; i++)
+    {
+        AAShape(i, &x0, &y0, &x1, &y1);
+        AAFillDiscSampled(&ctx.aaFb, NULL, x0, y0, ctx.aaSize, (uint32_t)i & 0xFFFFFF, 4);
+    }
+}
+
+static void RunAALine(long nIter)
+{
+    double x0, y0, x1, y1;
+    long i;
+
+    for (i = 0; i < nIter; i++)
+    {
+        AAShape(i, &x0, &y0, &x1, &y1);
+        AAThickLine(&ctx.aaFb, NULL, x0, y0, x1, y1, ctx.aaSize, (uint32_t)i & 0xFFFFFF);
+    }
+}
+
+static void RunAALineScalar(long nIter)
+{
+    double x0, y0, x1, y1;
+    long i;
+
+    for (i = 0; i < nIter; i++)
+    {
+        AAShape(i, &x0, &y0, &x1, &y1);
+        AAThickLineScalar(&ctx.aaFb, NULL, x0, y0, x1, y1, ctx.aaSize, (uint32_t)i & 0xFFFFFF);
+    }
+}
+
+static void RunSS2Line(long nIter)
+{
+    double x0, y0, x1, y1;
+    long i;
+
+    for (i = 0; i < nIter; i++)
+    {
+        AAShape(i, &x0, &y0, &x1, &y1);
+        AAThickLineSampled(&ctx.aaFb, NULL, x0, y0, x1, y1, ctx.aaSize, (uint32_t)i & 0xFFFFFF, 2);
+    }
+}
+
+static void RunSS4Line(long nIter)
+{
+    double x0, y0, x1, y1;
+    long i;
+
+    for (i = 0; i < nIter; i++)
+    {
+        AAShape(i, &x0, &y0, &x1, &y1);
+        AAThickLineSampled(&ctx.aaFb, NULL, x0, y0, x1, y1, ctx.aaSize, (uint32_t)i & 0xFFFFFF, 4);
+    }
+}
+
+// Largest channel difference between two framebuffers of the same size
+static int MaxPixelError(const FRAMEBUFFER* pA, const FRAMEBUFFER* pB)
+{
+    size_t i, n = (size_t)pA->cx * pA->cy * 4;
+    int d, dMax = 0;
+
+    for (i = 0; i < n; i++)
+    {
+        d = pA->pPixels[i] > pB->pPixels[i] ? pA->pPixels[i] - pB->pPixels[i] : pB->pPixels[i] - pA->pPixels[i];
+        if (d > dMax)
+            dMax = d;
+    }
+    return dMax;
+}
+
+// Black on white, so a pixel's error is its coverage error. The SIMD path
+// must match the scalar one exactly and both must be within 1/255 of the
+// reference. Radii start at 4.5 pixels, the smallest dot at 800x600;
+// below that the curve within one pixel is too tight for the kernel's
+// correction, as at the rounded ends of hairlines.
+static void VerifyAntiAlias(void)
+{
+    static const double sizes[] = { 4.5, 9, 16, 49 };
+    FRAMEBUFFER fbScalar, fbRef;
+    double x0, y0, x1, y1;
+    size_t iSize;
+    int i, iLine, dScalar, dRef, dWorst = 0;
+
+    if (!RasterCreate(&fbScalar, BENCH_AA_CX, BENCH_AA_CX) || !RasterCreate(&fbRef, BENCH_AA_CX, BENCH_AA_CX))
+    {
+        RasterFree(&fbScalar);
+        return;
+    }
+    for (iSize = 0; iSize < sizeof(sizes) / sizeof(sizes[0]); iSize++)
+    {
+        for (i = 0; i < BENCH_AA_SHAPES * 2; i++)
+        {
+            iLine = i & 1;
+            AAShape(i / 2, &x0, &y0, &x1, &y1);
+            RasterClear(&ctx.aaFb, CLOCK_RGB(255, 255, 255));
+            RasterClear(&fbScalar, CLOCK_RGB(255, 255, 255));
+            RasterClear(&fbRef, CLOCK_RGB(255, 255, 255));
+            if (iLine)
+            {
+                AAThickLine(&ctx.aaFb, NULL, x0, y0, x1, y1, sizes[iSize] * 2, 0);
+                AAThickLineScalar(&fbScalar, NULL, x0, y0, x1, y1, sizes[iSize] * 2, 0);
+                AAThickLineReference(&fbRef, NULL, x0, y0, x1, y1, sizes[iSize] * 2, 0);
+            }
+            else
+            {
+                AAFillDisc(&ctx.aaFb, NULL, x0, y0, sizes[iSize], 0);
+                AAFillDiscScalar(&fbScalar, NULL, x0, y0, sizes[iSize], 0);
+                AAFillDiscReference(&fbRef, NULL, x0, y0, sizes[iSize], 0);
+            }
+
+            dScalar = MaxPixelError(&ctx.aaFb, &fbScalar);
+            dRef = MaxPixelError(&ctx.aaFb, &fbRef);
+            if (dRef > dWorst)
+                dWorst = dRef;
+            if (dScalar != 0 || dRef > 1)
+            {
+                fprintf(stderr, "anti-aliased %s of radius %g at (%g, %g): %d/255 from the scalar path, "
+                    "%d/255 from the reference\n", iLine ? "line" : "disc", sizes[iSize], x0, y0, dScalar, dRef);
+                ctx.nAAErrors++;
+            }
+        }
+    }
+    printf("anti-aliasing kernel: %s, at most %d/255 from the reference coverage\n", AAKernelName(), dWorst);
+    RasterFree(&fbScalar);
+    RasterFree(&fbRef);
+}
+
+// Doubles the iteration count until one run takes msMinRun, then keeps
+// the fastest of BENCH_REPEATS runs so scheduler noise does not read as a
+// regression. An untimed first call faults in the framebuffer pages.
+static void Measure(const char* pszName, void (*pfnRun)(long nIter))
+{
+    BENCHRESULT* pResult;
+    long nIter = 1;
+    double msStart, ms, msBest;
+    uint32_t dwAllocs;
+    int i;
+
+    pfnRun(1);
+    for (;;)
+    {
+        msStart = NowMs();
+        pfnRun(nIter);
+        ms = NowMs() - msStart;
+        if (ms >= msMinRun || nIter >= (1L << 28))
+            break;
+        nIter *= ms < msMinRun / 16 ? 8 : 2;
+    }
+
+    msBest = ms;
+    dwAllocs = RasterAllocCount();
+    for (i = 0; i < BENCH_REPEATS; i++)
+    {
+        msStart = NowMs();
+        pfnRun(nIter);
+        ms = NowMs() - msStart;
+        if (ms < msBest)
+            msBest = ms;
+    }
+    dwAllocs = RasterAllocCount() - dwAllocs;
+
+    if (nResults >= BENCH_MAX_RESULTS)
+        return;
+    pResult = &results[nResults++];
+    snprintf(pResult->szName, sizeof(pResult->szName), "%s", pszName);
+    pResult->nIterations = nIter;
+    pResult->nsPerOp = msBest * 1e6 / nIter;
+    pResult->allocsPerOp = (double)dwAllocs / ((double)nIter * BENCH_REPEATS);
+}
+
+static int SetSize(int cx, int cy)
+{
+    RasterFree(&ctx.fb);
+    RasterFree(&ctx.tileFb);
+    if (!RasterCreate(&ctx.fb, cx, cy) || !RasterCreate(&ctx.tileFb, cx, cy))
+        return 0;
+    RasterViewInit(&ctx.view, &ctx.fb, 0, 0, cx, cy);
+    RasterBackend(&ctx.backend, &ctx.view);
+    return 1;
+}
+
+static void RunSuite(void)
+{
+    char szName[BENCH_NAME_CHARS];
+    size_t iSize;
+    int i, cx, cy;
+
+    for (i = 0; i < BENCH_ROTATE_POINTS; i++)
+    {
+        ctx.pt[i].x = i % 600;
+        ctx.pt[i].y = 500 - i % 1000;
+    }
+
+    Measure("rotate/1024pts", RunRotate);
+    Measure("rotate/1024pts-scalar", RunRotateScalar);
+    Measure("rotate/1pt", RotateOne);
+    Measure("hands/pose", RunHands);
+    Measure("hands/rotate", RunHandsRotate);
+
+    if (RasterCreate(&ctx.aaFb, BENCH_AA_CX, BENCH_AA_CX))
+    {
+        VerifyAntiAlias();
+        RasterClear(&ctx.aaFb, CLOCK_RGB(255, 255, 255));
+        ctx.aaSize = 16;
+        Measure("aa/disc-r16", RunAADisc);
+        Measure("aa/disc-r16-scalar", RunAADiscScalar);
+        Measure("ss2/disc-r16", RunSS2Disc);
+        Measure("ss4/disc-r16", RunSS4Disc);
+        ctx.aaSize = 49;
+        Measure("aa/disc-r49", RunAADisc);
+        Measure("ss4/disc-r49", RunSS4Disc);
+        ctx.aaSize = 0;
+        Measure("aa/hairline", RunAALine);
+        Measure("aa/hairline-scalar", RunAALineScalar);
+        Measure("ss2/hairline", RunSS2Line);
+        Measure("ss4/hairline", RunSS4Line);
+        ctx.aaSize = 12;
+        Measure("aa/line-w12", RunAALine);
+        Measure("ss4/line-w12", RunSS4Line);
+        RasterFree(&ctx.aaFb);
+    }
+
+    for (iSize = 0; iSize < sizeof(benchSizes) / sizeof(benchSizes[0]); iSize++)
+    {
+        cx = benchSizes[iSize][0];
+        cy = benchSizes[iSize][1];
+        if (!SetSize(cx, cy))
+        {
+            fprintf(stderr, "no memory for %dx%d\n", cx, cy);
+            continue;
+        }
+
+        // Faces with dots on/off and Roman on/off
+        for (i = 0; i < 4; i++)
+        {
+            memset(&ctx.style, 0, sizeof(ctx.style));
+            ctx.style.bShowDots = !(i & 1);
+            ctx.style.bRomanMode = (i & 2) != 0;
+            snprintf(szName, sizeof(szName), "face/%dx%d/%s/%s", cx, cy,
+                ctx.style.bShowDots ? "dots" : "nodots", ctx.style.bRomanMode ? "roman" : "arabic");
+            Measure(szName, RunFace);
+        }
+
+        memset(&ctx.style, 0, sizeof(ctx.style));
+        ctx.style.bShowDots = 1;
+        snprintf(szName, sizeof(szName), "frame/%dx%d", cx, cy);
+        Measure(szName, RunFrame);
+        ctx.view.bAntiAlias = 1;
+        snprintf(szName, sizeof(szName), "frame-aa/%dx%d", cx, cy);
+        Measure(szName, RunFrameView);
+        ctx.view.bAntiAlias = 0;
+
+        if (cx < BENCH_TILED_MIN_CX || !ctx.tiles.pPool)
+            continue;
+        VerifyTiled();
+        snprintf(szName, sizeof(szName), "tiled/%dx%d", cx, cy);
+        Measure(szName, RunTiled);
+        snprintf(szName, sizeof(szName), "tiled-full/%dx%d", cx, cy);
+        Measure(szName, RunTiledFull);
+    }
+
+    RasterFree(&ctx.fb);
+    RasterFree(&ctx.tileFb);
+}
+
+// Baseline files hold "name ns_per_op" lines
+static double FindBaseline(FILE* fp, const char* pszName)
+{
+    char line[128], szName[BENCH_NAME_CHARS];
+    double ns;
+
+    rewind(fp);
+    while (fgets(line, sizeof(line), fp))
+    {
+        if (sscanf(line, "%47s %lf", szName, &ns) == 2 && strcmp(szName, pszName) == 0)
+            return ns;
+    }
+    return 0;
+}
+
+static int SaveBaseline(const char* pszPath)
+{
+    FILE* fp = fopen(pszPath, "w");
+    int i;
+
+    if (!fp)
+        return 0;
+    fprintf(fp, "# clockbench baseline: name ns_per_op (%s rotation)\n", RotateKernelName());
+    for (i = 0; i < nResults; i++)
+        fprintf(fp, "%s %.1f\n", results[i].szName, results[i].nsPerOp);
+    return fclose(fp) == 0;
+}
+
+int main(int argc, char* argv[])
+{
+    const char* pszBaseline = NULL;
+    const char* pszSave = NULL;
+    double pctThreshold = 20, nsBase, pctChange;
+    FILE* fpBase = NULL;
+    int i, nRegressed = 0;
+
+    if (argc > 1 && strcmp(argv[1], "grid") == 0)
+        return RunGrid(argc - 1, argv + 1);
+    if (argc > 1 && strcmp(argv[1], "sweep") == 0)
+        return RunSweep(argc - 1, argv + 1);
+    if (argc > 1 && strcmp(argv[1], "resize") == 0)
+        return RunResize(argc - 1, argv + 1);
+
+    for (i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--quick") == 0)
+            msMinRun = 20;
+        else if (strcmp(argv[i], "--baseline") == 0 && i + 1 < argc)
+            pszBaseline = argv[++i];
+        else if (strcmp(argv[i], "--save") == 0 && i + 1 < argc)
+            pszSave = argv[++i];
+        else if (strcmp(argv[i], "--threshold") == 0 && i + 1 < argc)
+            pctThreshold = atof(argv[++i]);
+        else
+        {
+            fprintf(stderr, "usage: %s [--quick] [--baseline FILE] [--save FILE] [--threshold PCT]\n"
+                "       %s grid [clocks] [width] [height] [frames] [sites.txt|-] [out.png]\n"
+                "       %s sweep [width] [height] [hz] [seconds] [smooth|mechanical|tick] [out.png]\n"
+                "       %s resize [trace.txt|-] [out.png]\n",
+                argv[0], argv[0], argv[0], argv[0]);
+            return 2;
+        }
+    }
+
+    if (pszBaseline && !(fpBase = fopen(pszBaseline, "r")))
+    {
+        fprintf(stderr, "%s: cannot read %s\n", argv[0], pszBaseline);
+        return 2;
+    }
+
+    InitRotateTable();
+    if (!TileRenderInit(&ctx.tiles, 0))
+        fprintf(stderr, "%s: no worker threads, skipping tiled frames\n", argv[0]);
+    RunSuite();
+
+    printf("%-32s %12s %14s %14s %10s %10s\n", "benchmark", "iterations", "ns/op", "ops/s",
+        "allocs/op", "vs base");
+    for (i = 0; i < nResults; i++)
+    {
+        printf("%-32s %12ld %14.1f %14.1f %10.2f", results[i].szName, results[i].nIterations,
+            results[i].nsPerOp, 1e9 / results[i].nsPerOp, results[i].allocsPerOp);
+
+        nsBase = fpBase ? FindBaseline(fpBase, results[i].szName) : 0;
+        if (nsBase > 0)
+        {
+            pctChange = (results[i].nsPerOp / nsBase - 1) * 100;
+            printf(" %+9.1f%%%s", pctChange, pctChange > pctThreshold ? "  REGRESSED" : "");
+            if (pctChange > pctThreshold)
+                nRegressed++;
+        }
+        printf("\n");
+    }
+    printf("rotation kernel: %s, %d tile workers\n", RotateKernelName(),
+        ctx.tiles.pPool ? WorkPoolWorkers(ctx.tiles.pPool) : 0);
+    if (ctx.nTileMismatches)
+        printf("%d tiled sizes differ from the single-threaded frame\n", ctx.nTileMismatches);
+    if (ctx.nAAErrors)
+        printf("%d anti-aliased shapes are off the reference\n", ctx.nAAErrors);
+    TileRenderFree(&ctx.tiles);
+
+    if (fpBase)
+    {
+        fclose(fpBase);
+        printf("%d of %d benchmarks regressed more than %.0f%% against %s\n",
+            nRegressed, nResults, pctThreshold, pszBaseline);
+    }
+    if (pszSave && !SaveBaseline(pszSave))
+    {
+        fprintf(stderr, "%s: cannot write %s\n", argv[0], pszSave);
+        return 2;
+    }
+    return nRegressed || ctx.nTileMismatches || ctx.nAAErrors ? 1 : 0;
+}
@@ -0,0 +1,52 @@
+/*--------------------------
+    CLOCKCHECK.C -- What the check tools share: the failure tally, a fake
+                    clock and the command line
+---------------------------*/
+
+#include <string.h>
+#include "clockcheck.h"
+
+int g_nFailed;
+
+void FakeStart(FAKECLOCK* pFake, uint64_t qwNow, uint64_t qwStep)
+{
+    pFake->qwNow = qwNow;
+    pFake->qwStep = qwStep;
+    pFake->qwReads = 0;
+    pFake->qwCpu = 0;
+}
+
+uint64_t FakeNow(void* pCtx)
+{
+    FAKECLOCK* pFake = (FAKECLOCK*)pCtx;
+    uint64_t qwNow = pFake->qwNow;
+
+    pFake->qwNow += pFake->qwStep;
+    pFake->qwReads++;
+    return qwNow;
+}
+
+uint64_t FakeCpu(void* pCtx)
+{
+    return ((FAKECLOCK*)pCtx)->qwCpu;
+}
+
+int CheckResult(void)
+{
+    printf(g_nFailed ? "%d checks failed\n" : "All checks passed\n", g_nFailed);
+    return g_nFailed ? 1 : 0;
+}
+
+int CheckMain(int argc, char* argv[], CHECKFN pfnCheck, const char* pszCheckArgs,
+    CHECKFN pfnBench, const char* pszBenchArgs)
+{
+    if (argc > 1 && strcmp(argv[1], "check") == 0)
+        return pfnCheck(argc - 2, argv + 2);
+    if (pfnBench && argc > 1 && strcmp(argv[1], "bench") == 0)
+        return pfnBench(argc - 2, argv + 2);
+
+    fprintf(stderr, "usage: %s check%s%s\n", argv[0], *pszCheckArgs ? " " : "", pszCheckArgs);
+    if (pfnBench)
+        fprintf(stderr, "       %s bench%s%s\n", argv[0], *pszBenchArgs ? " " : "", pszBenchArgs);
+    return 2;
+}
@@ -0,0 +1,48 @@
+/*--------------------------
+    CLOCKCHECK.H -- What the check tools share: the failure tally, a fake
+                    clock and the command line
+
+    The tools are portable C unless their header says otherwise. "check"
+    prints the first ten failures and the tally, and exits 1 if anything
+    failed; a bad command line prints the usage and exits 2.
+---------------------------*/
+
+#ifndef CLOCKCHECK_H
+#define CLOCKCHECK_H
+
+#include <stdint.h>
+#include <stdio.h>
+
+// Failed checks so far; only the first ten are printed
+extern int g_nFailed;
+
+#define CHECK(cond, ...) do { if (!(cond)) { if (g_nFailed++ < 10) { printf("  FAILED: "); \
+    printf(__VA_ARGS__); printf("\n"); } } } while (0)
+
+// Stands in for a module's clock callbacks. Each read of FakeNow returns
+// qwNow and then moves it on by qwStep; with a step of 0 it only moves
+// when a check moves it by hand. qwCpu is a second counter for modules
+// that also read process CPU time.
+typedef struct
+{
+    uint64_t qwNow;
+    uint64_t qwStep;
+    uint64_t qwReads;
+    uint64_t qwCpu;
+} FAKECLOCK;
+
+void FakeStart(FAKECLOCK* pFake, uint64_t qwNow, uint64_t qwStep);
+uint64_t FakeNow(void* pCtx);
+uint64_t FakeCpu(void* pCtx);
+
+// Prints the tally; returns the exit code, 1 if anything failed
+int CheckResult(void);
+
+// Runs "check" or, with pfnBench, "bench" with the arguments after it;
+// anything else prints the usage and returns 2
+typedef int (*CHECKFN)(int argc, char* argv[]);
+
+int CheckMain(int argc, char* argv[], CHECKFN pfnCheck, const char* pszCheckArgs,
+    CHECKFN pfnBench, const char* pszBenchArgs);
+
+#endif
@@ -0,0 +1,354 @@
+/*--------------------------
+    CLOCKCTRL.C -- Checks the control layer's layout, hit-testing, states and damage
+
+    Usage: clockctrl check [WIDTH HEIGHT]
+
+    Lays out the window's six buttons the way CLOCK.c does and checks them
+    against the MoveWindow positions the child windows used to have, at
+    several client sizes. It checks hit-testing on and just off every
+    edge, hover, press, drag-off and capture loss, and that each change
+    damages exactly the controls whose look changed. Random damage boxes
+    are cut around the controls and compared pixel by pixel with the box
+    less the controls. Every hand movement of a 12-hour day at WIDTH x
+    HEIGHT (300x300 by default, small enough for the hands to reach the
+    top button) is cut the same way, and no piece may touch a control.
+---------------------------*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "controls.h"
+#include "clockdraw.h"
+#include "clockcheck.h"
+
+// The button ids and layout in CLOCK.c
+enum { ID_DARKMODE_BTN = 2, ID_ROMAN_BTN, ID_FONT_BTN, ID_SOUND_BTN, ID_DOTS_BTN, ID_MYSTERY_BTN };
+
+static void AddClockButtons(CONTROLLAYER* pLayer)
+{
+    CtrlLayerInit(pLayer);
+    CtrlAdd(pLayer, ID_SOUND_BTN, CTRL_LEFT | CTRL_TOP, 10, 10, 40, 40);
+    CtrlAdd(pLayer, ID_ROMAN_BTN, CTRL_HCENTER | CTRL_TOP, 0, 10, 260, 50);
+    CtrlAdd(pLayer, ID_DARKMODE_BTN, CTRL_HCENTER | CTRL_BOTTOM, 0, 10, 180, 50);
+    CtrlAdd(pLayer, ID_FONT_BTN, CTRL_RIGHT | CTRL_TOP, 10, 10, 180, 50);
+    CtrlAdd(pLayer, ID_DOTS_BTN, CTRL_LEFT | CTRL_BOTTOM, 10, 10, 220, 50);
+    CtrlAdd(pLayer, ID_MYSTERY_BTN, CTRL_RIGHT | CTRL_BOTTOM, 10, 10, 50, 50);
+}
+
+static int SameRect(const DAMAGERECT* pa, const DAMAGERECT* pb)
+{
+    if (DamageIsEmpty(pa) && DamageIsEmpty(pb))
+        return 1;
+    return pa->left == pb->left && pa->top == pb->top && pa->right == pb->right && pa->bottom == pb->bottom;
+}
+
+static void Rect(DAMAGERECT* pr, int x, int y, int cx, int cy)
+{
+    pr->left = x;
+    pr->top = y;
+    pr->right = x + cx;
+    pr->bottom = y + cy;
+}
+
+static const DAMAGERECT* CtrlRectOf(const CONTROLLAYER* pLayer, int iId)
+{
+    return &pLayer->ctrls[CtrlFind(pLayer, iId)].rc;
+}
+
+static void CheckLayout(void)
+{
+    static const int sizes[][2] = { { 800, 600 }, { 300, 200 }, { 1920, 1080 }, { 61, 61 }, { 0, 0 } };
+    CONTROLLAYER layer;
+    DAMAGERECT rc;
+    int i, cx, cy;
+
+    AddClockButtons(&layer);
+    for (i = 0; i < (int)(sizeof(sizes) / sizeof(sizes[0])); i++)
+    {
+        cx = sizes[i][0];
+        cy = sizes[i][1];
+        CtrlLayout(&layer, cx, cy);
+
+        // The MoveWindow calls of the WM_SIZE handler
+        Rect(&rc, (cx - 260) / 2, 10, 260, 50);
+        CHECK(SameRect(CtrlRectOf(&layer, ID_ROMAN_BTN), &rc), "Roman button at %dx%d", cx, cy);
+        Rect(&rc, (cx - 180) / 2, cy - 60, 180, 50);
+        CHECK(SameRect(CtrlRectOf(&layer, ID_DARKMODE_BTN), &rc), "dark button at %dx%d", cx, cy);
+        Rect(&rc, cx - 190, 10, 180, 50);
+        CHECK(SameRect(CtrlRectOf(&layer, ID_FONT_BTN), &rc), "font button at %dx%d", cx, cy);
+        Rect(&rc, 10, 10, 40, 40);
+        CHECK(SameRect(CtrlRectOf(&layer, ID_SOUND_BTN), &rc), "sound button at %dx%d", cx, cy);
+        Rect(&rc, 10, cy - 60, 220, 50);
+        CHECK(SameRect(CtrlRectOf(&layer, ID_DOTS_BTN), &rc), "dots button at %dx%d", cx, cy);
+        Rect(&rc, cx - 60, cy - 60, 50, 50);
+        CHECK(SameRect(CtrlRectOf(&layer, ID_MYSTERY_BTN), &rc), "mystery button at %dx%d", cx, cy);
+    }
+}
+
+static void CheckHitTest(void)
+{
+    CONTROLLAYER layer;
+    const DAMAGERECT* pr;
+    DAMAGERECT rc;
+    int i;
+
+    AddClockButtons(&layer);
+    CtrlLayout(&layer, 800, 600);
+    for (i = 0; i < layer.nCtrls; i++)
+    {
+        pr = &layer.ctrls[i].rc;
+        CHECK(CtrlHitTest(&layer, pr->left, pr->top) == i, "top left of control %d", i);
+        CHECK(CtrlHitTest(&layer, pr->right - 1, pr->bottom - 1) == i, "bottom right of control %d", i);
+        CHECK(CtrlHitTest(&layer, pr->right, pr->top) != i, "right edge of control %d is outside", i);
+        CHECK(CtrlHitTest(&layer, pr->left, pr->bottom) != i, "bottom edge of control %d is outside", i);
+        CHECK(CtrlHitTest(&layer, pr->left - 1, pr->top) != i, "left of control %d", i);
+        CHECK(CtrlHitTest(&layer, pr->left, pr->top - 1) != i, "above control %d", i);
+    }
+    CHECK(CtrlHitTest(&layer, 400, 300) == -1, "the face is not a control");
+    CHECK(CtrlHitTest(&layer, 5, 5) == -1, "the margin is not a control");
+    CHECK(CtrlFind(&layer, 99) == -1, "unknown id");
+    CHECK(CtrlContains(&layer, &layer.ctrls[0].rc), "a control contains itself");
+    Rect(&rc, layer.ctrls[0].rc.left + 1, layer.ctrls[0].rc.top + 1, 5, 5);
+    CHECK(CtrlContains(&layer, &rc), "a box inside a control");
+    Rect(&rc, layer.ctrls[0].rc.left, layer.ctrls[0].rc.top, 400, 300);
+    CHECK(!CtrlContains(&layer, &rc), "a box reaching over the face");
+}
+
+// Runs one input step and checks the damage it reports against the
+// controls listed (by id, 0-terminated)
+static void ExpectDamage(const CONTROLLAYER* pLayer, const DAMAGERECT* pDamage, const int* piIds, const char* pszStep)
+{
+    DAMAGERECT rc;
+
+    DamageEmpty(&rc);
+    for (; *piIds; piIds++)
+        CtrlDamage(pLayer, *piIds, &rc);
+    CHECK(SameRect(pDamage, &rc), "damage after %s is (%d,%d)-(%d,%d), expected (%d,%d)-(%d,%d)", pszStep,
+        pDamage->left, pDamage->top, pDamage->right, pDamage->bottom, rc.left, rc.top, rc.right, rc.bottom);
+}
+
+static void CheckInput(void)
+{
+    static const int none[] = { 0 };
+    static const int roman[] = { ID_ROMAN_BTN, 0 };
+    static const int romanDark[] = { ID_ROMAN_BTN, ID_DARKMODE_BTN, 0 };
+    static const int dark[] = { ID_DARKMODE_BTN, 0 };
+    static const int dots[] = { ID_DOTS_BTN, 0 };
+    CONTROLLAYER layer;
+    DAMAGERECT damage;
+    const DAMAGERECT* prRoman;
+    const DAMAGERECT* prDark;
+    const DAMAGERECT* prDots;
+    int iRoman, iDark, iDots;
+
+    AddClockButtons(&layer);
+    CtrlLayout(&layer, 800, 600);
+    iRoman = CtrlFind(&layer, ID_ROMAN_BTN);
+    iDark = CtrlFind(&layer, ID_DARKMODE_BTN);
+    iDots = CtrlFind(&layer, ID_DOTS_BTN);
+    prRoman = &layer.ctrls[iRoman].rc;
+    prDark = &layer.ctrls[iDark].rc;
+    prDots = &layer.ctrls[iDots].rc;
+
+    // Hover
+    DamageEmpty(&damage);
+    CtrlMouseMove(&layer, 400, 300, &damage);
+    ExpectDamage(&layer, &damage, none, "moving over the face");
+    DamageEmpty(&damage);
+    CtrlMouseMove(&layer, prRoman->left + 5, prRoman->top + 5, &damage);
+    ExpectDamage(&layer, &damage, roman, "entering the Roman button");
+    CHECK(CtrlState(&layer, iRoman) == CTRL_HOT, "Roman button is hot");
+    DamageEmpty(&damage);
+    CtrlMouseMove(&layer, prRoman->left + 6, prRoman->top + 6, &damage);
+    ExpectDamage(&layer, &damage, none, "moving within the Roman button");
+    DamageEmpty(&damage);
+    CtrlMouseMove(&layer, prDark->left + 1, prDark->top + 1, &damage);
+    ExpectDamage(&layer, &damage, romanDark, "moving to the dark button");
+    DamageEmpty(&damage);
+    CtrlMouseLeave(&layer, &damage);
+    ExpectDamage(&layer, &damage, dark, "leaving the window");
+    CHECK(CtrlState(&layer, iDark) == 0, "nothing is hot after leaving");
+
+    // A click
+    DamageEmpty(&damage);
+    CHECK(!CtrlMouseDown(&layer, 400, 300, &damage), "pressing the face captures nothing");
+    CHECK(CtrlMouseUp(&layer, 400, 300, &damage) == -1, "releasing on the face clicks nothing");
+    DamageEmpty(&damage);
+    CHECK(CtrlMouseDown(&layer, prDots->left + 3, prDots->top + 3, &damage), "pressing the dots button captures");
+    ExpectDamage(&layer, &damage, dots, "pressing the dots button");
+    CHECK(CtrlState(&layer, iDots) == (CTRL_HOT | CTRL_PRESSED), "dots button is pressed");
+    DamageEmpty(&damage);
+    CHECK(CtrlMouseUp(&layer, prDots->left + 4, prDots->top + 4, &damage) == ID_DOTS_BTN, "dots button clicks");
+    ExpectDamage(&layer, &damage, dots, "releasing the dots button");
+    CHECK(CtrlState(&layer, iDots) == CTRL_HOT, "dots button is hot after the click");
+
+    // Press, drag off over another button, come back, drag off and release
+    DamageEmpty(&damage);
+    CtrlMouseDown(&layer, prDots->left + 3, prDots->top + 3, &damage);
+    DamageEmpty(&damage);
+    CtrlMouseMove(&layer, prDark->left + 3, prDark->top + 3, &damage);
+    ExpectDamage(&layer, &damage, dots, "dragging off onto the dark button");
+    CHECK(CtrlState(&layer, iDark) == 0, "another button does not light up during a press");
+    CHECK(CtrlState(&layer, iDots) == 0, "a pressed button dragged off looks up");
+    DamageEmpty(&damage);
+    CtrlMouseMove(&layer, prDots->left + 3, prDots->top + 3, &damage);
+    ExpectDamage(&layer, &damage, dots, "dragging back");
+    CHECK(CtrlState(&layer, iDots) == (CTRL_HOT | CTRL_PRESSED), "dragged back looks pressed");
+    CtrlMouseMove(&layer, prDark->left + 3, prDark->top + 3, &damage);
+    DamageEmpty(&damage);
+    CHECK(CtrlMouseUp(&layer, prDark->left + 3, prDark->top + 3, &damage) == -1, "released elsewhere clicks nothing");
+    ExpectDamage(&layer, &damage, dark, "releasing over the dark button");
+    CHECK(CtrlState(&layer, iDark) == CTRL_HOT, "the dark button lights once the press ends");
+
+    // Capture lost mid-press
+    CtrlMouseDown(&layer, prDark->left + 3, prDark->top + 3, &damage);
+    DamageEmpty(&damage);
+    CtrlCancel(&layer, &damage);
+    ExpectDamage(&layer, &damage, dark, "losing the capture");
+    CHECK(CtrlState(&layer, iDark) == CTRL_HOT, "cancelled press leaves the button hot");
+    CHECK(CtrlMouseUp(&layer, prDark->left + 3, prDark->top + 3, &damage) == -1, "no click after a cancel");
+    CHECK(layer.dwClicks == 1 && layer.dwPresses == 3 && layer.dwCancels == 2,
+        "%lu clicks, %lu presses, %lu cancels", (unsigned long)layer.dwClicks, (unsigned long)layer.dwPresses,
+        (unsigned long)layer.dwCancels);
+}
+
+// Every pixel of *pDamage outside the controls is in exactly one piece
+// and no piece reaches into a control or outside the box
+static int CheckPieces(const CONTROLLAYER* pLayer, const DAMAGERECT* pDamage, const DAMAGERECT* pPieces, int n,
+    uint8_t* pCount)
+{
+    int cx = pDamage->right - pDamage->left, cy = pDamage->bottom - pDamage->top;
+    int x, y, i, bControl, bOk = 1;
+
+    memset(pCount, 0, (size_t)cx * cy);
+    for (i = 0; i < n; i++)
+    {
+        if (pPieces[i].left < pDamage->left || pPieces[i].top < pDamage->top ||
+            pPieces[i].right > pDamage->right || pPieces[i].bottom > pDamage->bottom)
+            return 0;
+        for (y = pPieces[i].top; y < pPieces[i].bottom; y++)
+            for (x = pPieces[i].left; x < pPieces[i].right; x++)
+                pCount[(y - pDamage->top) * cx + x - pDamage->left]++;
+    }
+
+    for (y = pDamage->top; y < pDamage->bottom && bOk; y++)
+        for (x = pDamage->left; x < pDamage->right; x++)
+        {
+            bControl = CtrlHitTest(pLayer, x, y) >= 0;
+            if (pCount[(y - pDamage->top) * cx + x - pDamage->left] != (bControl ? 0 : 1))
+            {
+                bOk = 0;
+                break;
+            }
+        }
+    return bOk;
+}
+
+static void CheckDamageOutside(void)
+{
+    static uint8_t count[400 * 400];
+    CONTROLLAYER layer;
+    DAMAGERECT damage, pieces[CTRL_MAX_PIECES];
+    int i, n, nMaxPieces = 0;
+
+    AddClockButtons(&layer);
+    CtrlLayout(&layer, 800, 600);
+    srand(1);
+    for (i = 0; i < 2000; i++)
+    {
+        Rect(&damage, rand() % 800 - 50, rand() % 600 - 50, 1 + rand() % 400, 1 + rand() % 400);
+        DamageClip(&damage, 800, 600);
+        if (DamageIsEmpty(&damage))
+            continue;
+        n = CtrlDamageOutside(&layer, &damage, pieces, CTRL_MAX_PIECES);
+        if (n > nMaxPieces)
+            nMaxPieces = n;
+        CHECK(CheckPieces(&layer, &damage, pieces, n, count), "box (%d,%d)-(%d,%d) cut into %d pieces",
+            damage.left, damage.top, damage.right, damage.bottom, n);
+    }
+
+    // All of one control: nothing left
+    damage = *CtrlRectOf(&layer, ID_MYSTERY_BTN);
+    CHECK(CtrlDamageOutside(&layer, &damage, pieces, CTRL_MAX_PIECES) == 0, "a box inside a control is all gone");
+
+    // Too few pieces allowed: the box comes back whole
+    Rect(&damage, 0, 0, 800, 600);
+    n = CtrlDamageOutside(&layer, &damage, pieces, 2);
+    CHECK(n == 1 && SameRect(&pieces[0], &damage), "whole box when the pieces run out");
+    printf("Random boxes: up to %d pieces\n", nMaxPieces);
+}
+
+// The damage WM_TIMER makes for each second of a day, at cx by cy
+static void CheckTicks(int cx, int cy)
+{
+    static uint8_t count[4096 * 4096 / 16];
+    CONTROLLAYER layer;
+    ROTPOINT ptPrev[3][CLOCK_HAND_POINTS], pt[3][CLOCK_HAND_POINTS];
+    DAMAGERECT damage, rcHand, pieces[CTRL_MAX_PIECES];
+    int iSec, i, n, nTouched = 0, bChange;
+    long lArea = 0;
+
+    AddClockButtons(&layer);
+    CtrlLayout(&layer, cx, cy);
+    ClockComputeHands(0, 0, 0, ptPrev);
+    for (iSec = 1; iSec <= 43200; iSec++)
+    {
+        ClockComputeHands(iSec / 3600 % 12, iSec / 60 % 60, iSec % 60, pt);
+        bChange = iSec % 60 == 0;
+
+        DamageEmpty(&damage);
+        for (i = bChange ? 0 : 2; i < 3; i++)
+        {
+            DamageFromPolygon(&rcHand, ptPrev[i], CLOCK_HAND_POINTS, cx, cy, 2);
+            DamageUnion(&damage, &rcHand);
+            DamageFromPolygon(&rcHand, pt[i], CLOCK_HAND_POINTS, cx, cy, 2);
+            DamageUnion(&damage, &rcHand);
+        }
+        DamageClip(&damage, cx, cy);
+        memcpy(ptPrev, pt, sizeof(pt));
+
+        for (i = 0; i < layer.nCtrls; i++)
+            if (damage.left < layer.ctrls[i].rc.right && layer.ctrls[i].rc.left < damage.right &&
+                damage.top < layer.ctrls[i].rc.bottom && layer.ctrls[i].rc.top < damage.bottom)
+            {
+                nTouched++;
+                break;
+            }
+
+        n = CtrlDamageOutside(&layer, &damage, pieces, CTRL_MAX_PIECES);
+        if ((long)(damage.right - damage.left) * (damage.bottom - damage.top) <= (long)sizeof(count))
+            CHECK(CheckPieces(&layer, &damage, pieces, n, count), "tick %d cut into %d pieces", iSec, n);
+        for (i = 0; i < n; i++)
+        {
+            CHECK(CtrlHitTest(&layer, pieces[i].left, pieces[i].top) < 0, "tick %d piece on a control", iSec);
+            lArea += (long)(pieces[i].right - pieces[i].left) * (pieces[i].bottom - pieces[i].top);
+        }
+    }
+    printf("%dx%d: %d of 43200 tick boxes overlap a control and would redraw it; after cutting, none do "
+        "(%.0f pixels a tick)\n", cx, cy, nTouched, lArea / 43200.0);
+}
+
+static int Check(int argc, char* argv[])
+{
+    int cx = 300, cy = 300;
+
+    if (argc >= 2 && atoi(argv[0]) > 0 && atoi(argv[1]) > 0)
+    {
+        cx = atoi(argv[0]);
+        cy = atoi(argv[1]);
+    }
+
+    InitRotateTable();
+    CheckLayout();
+    CheckHitTest();
+    CheckInput();
+    CheckDamageOutside();
+    CheckTicks(cx, cy);
+
+    return CheckResult();
+}
+
+int main(int argc, char* argv[])
+{
+    return CheckMain(argc, argv, Check, "[WIDTH HEIGHT]", NULL, NULL);
+}
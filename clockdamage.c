@@ -0,0 +1,225 @@
+/*--------------------------
+    CLOCKDAMAGE.C -- Checks the hand damage boxes against the pixels drawn
+
+    Usage: clockdamage check [STEP]
+
+    At client sizes from 1x1 up to 1920x1080, odd and not square among
+    them, it draws each hand alone with the software rasterizer, plain and
+    anti-aliased, at every STEP-th tenth of a degree (37 by default), and
+    the box DamageFromPolygon gives with the padding CLOCK.c uses must
+    hold every pixel drawn. Single points from -700 to 700 logical units,
+    either side of each rounding edge, must map to boxes that hold the
+    exact device position, and IsoToDevice must land inside them.
+    DamageUnion and DamageClip are checked against empty, nested,
+    overlapping and outside boxes.
+---------------------------*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "damage.h"
+#include "clockdraw.h"
+#include "raster.h"
+#include "clockcheck.h"
+
+// What AddHandDamage in CLOCK.c pads each hand by
+#define HAND_PAD 2
+
+static const int iSizes[][2] =
+{
+    { 1, 1 }, { 2, 3 }, { 17, 9 }, { 99, 100 }, { 300, 300 }, { 301, 187 }, { 640, 480 }, { 799, 1201 },
+    { 1920, 1080 }
+};
+
+static void Rect(DAMAGERECT* pr, int left, int top, int right, int bottom)
+{
+    pr->left = left;
+    pr->top = top;
+    pr->right = right;
+    pr->bottom = bottom;
+}
+
+static int SameRect(const DAMAGERECT* pa, const DAMAGERECT* pb)
+{
+    return pa->left == pb->left && pa->top == pb->top && pa->right == pb->right && pa->bottom == pb->bottom;
+}
+
+// Box of every pixel that is not the background, cleared back as it goes;
+// empty if none
+static void TakeDrawn(FRAMEBUFFER* pFb, uint32_t background, DAMAGERECT* pr)
+{
+    uint32_t* pRow;
+    int x, y;
+
+    DamageEmpty(pr);
+    for (y = 0; y < pFb->cy; y++)
+    {
+        pRow = (uint32_t*)(pFb->pPixels + (size_t)y * pFb->cx * 4);
+        for (x = 0; x < pFb->cx; x++)
+        {
+            if (pRow[x] == background)
+                continue;
+            pRow[x] = background;
+            if (DamageIsEmpty(pr))
+                Rect(pr, x, y, x + 1, y + 1);
+            else
+            {
+                if (x < pr->left) pr->left = x;
+                if (x + 1 > pr->right) pr->right = x + 1;
+                pr->bottom = y + 1;
+            }
+        }
+    }
+}
+
+static int Contains(const DAMAGERECT* pOuter, const DAMAGERECT* pInner)
+{
+    return DamageIsEmpty(pInner) || (pInner->left >= pOuter->left && pInner->top >= pOuter->top &&
+        pInner->right <= pOuter->right && pInner->bottom <= pOuter->bottom);
+}
+
+static void CheckHands(int iStep)
+{
+    CLOCKSTYLE style = { 0, 0, 0, 1 };
+    CLOCKBACKEND backend;
+    RASTERVIEW view;
+    FRAMEBUFFER fb;
+    ROTPOINT pt[CLOCK_HAND_POINTS];
+    DAMAGERECT rcBox, rcDrawn;
+    uint32_t background;
+    size_t i;
+    int iHand, iTenths, bAntiAlias, nDrawn = 0;
+
+    for (i = 0; i < sizeof(iSizes) / sizeof(iSizes[0]); i++)
+    {
+        if (!RasterCreate(&fb, iSizes[i][0], iSizes[i][1]))
+        {
+            CHECK(0, "no %dx%d framebuffer", iSizes[i][0], iSizes[i][1]);
+            return;
+        }
+        RasterClear(&fb, ClockBackground(&style));
+        memcpy(&background, fb.pPixels, 4);
+
+        for (bAntiAlias = 0; bAntiAlias < 2; bAntiAlias++)
+        {
+            RasterViewInit(&view, &fb, 0, 0, fb.cx, fb.cy);
+            view.bAntiAlias = bAntiAlias;
+            RasterBackend(&backend, &view);
+            for (iHand = 0; iHand < 3; iHand++)
+            {
+                for (iTenths = 0; iTenths < 3600; iTenths += iStep)
+                {
+                    ClockComputeHandTenths(iHand, iTenths, pt);
+                    backend.pfnPolyline(backend.pCtx, pt, CLOCK_HAND_POINTS, 0, ClockForeground(&style));
+                    TakeDrawn(&fb, background, &rcDrawn);
+                    DamageFromPolygon(&rcBox, pt, CLOCK_HAND_POINTS, fb.cx, fb.cy, HAND_PAD);
+                    CHECK(Contains(&rcBox, &rcDrawn), "%dx%d%s hand %d at %d tenths: drawn %d,%d-%d,%d outside "
+                        "%d,%d-%d,%d", fb.cx, fb.cy, bAntiAlias ? " aa" : "", iHand, iTenths, rcDrawn.left,
+                        rcDrawn.top, rcDrawn.right, rcDrawn.bottom, rcBox.left, rcBox.top, rcBox.right,
+                        rcBox.bottom);
+                    nDrawn += !DamageIsEmpty(&rcDrawn);
+                }
+            }
+        }
+        RasterFree(&fb);
+    }
+    CHECK(nDrawn > 0, "no hand drew a pixel");
+}
+
+// Around every multiple of ISO_WINDOW_EXT / iScale, where DivFloor and
+// DivCeil change, and on both sides of 0
+static void CheckRounding(void)
+{
+    ROTPOINT pt, line[2] = { { -1, -1 }, { 1, 1 } };
+    DAMAGERECT rc;
+    double dScale, dx, dy;
+    size_t i;
+    int x, y, iScale, xDev, yDev;
+
+    for (i = 0; i < sizeof(iSizes) / sizeof(iSizes[0]); i++)
+    {
+        iScale = IsoScale(iSizes[i][0], iSizes[i][1]);
+        dScale = (double)iScale / ISO_WINDOW_EXT;
+        for (x = -700; x <= 700; x++)
+        {
+            y = -x / 3 + x % 7;
+            pt.x = x;
+            pt.y = y;
+            DamageFromPolygon(&rc, &pt, 1, iSizes[i][0], iSizes[i][1], 0);
+
+            // Exact position, and the box must be as tight as the rounding allows
+            dx = iSizes[i][0] / 2 + x * dScale;
+            dy = iSizes[i][1] / 2 - y * dScale;
+            CHECK(rc.left == (int)floor(dx) && rc.right == (int)ceil(dx) + 1, "%dx%d: x %d maps to %d-%d for %.4f",
+                iSizes[i][0], iSizes[i][1], x, rc.left, rc.right, dx);
+            CHECK(rc.top == (int)floor(dy) && rc.bottom == (int)ceil(dy) + 1, "%dx%d: y %d maps to %d-%d for %.4f",
+                iSizes[i][0], iSizes[i][1], y, rc.top, rc.bottom, dy);
+
+            IsoToDevice(iSizes[i][0], iSizes[i][1], x, y, &xDev, &yDev);
+            CHECK(xDev >= rc.left && xDev < rc.right && yDev >= rc.top && yDev < rc.bottom,
+                "%dx%d: IsoToDevice(%d, %d) = %d, %d outside its box", iSizes[i][0], iSizes[i][1], x, y, xDev, yDev);
+        }
+    }
+
+    // A line from negative to positive keeps both ends
+    DamageFromPolygon(&rc, line, 2, 601, 601, 0);
+    CHECK(rc.left == 299 && rc.right == 302 && rc.top == 299 && rc.bottom == 302,
+        "-1..1 at 601x601 maps to %d,%d-%d,%d", rc.left, rc.top, rc.right, rc.bottom);
+    DamageFromPolygon(&rc, line, 0, 300, 300, HAND_PAD);
+    CHECK(DamageIsEmpty(&rc), "no points gave a box");
+}
+
+static void CheckUnionClip(void)
+{
+    DAMAGERECT rc, rcAdd, rcExpect, rcEmpty;
+
+    DamageEmpty(&rcEmpty);
+    DamageEmpty(&rc);
+    CHECK(DamageIsEmpty(&rc), "an empty box is not empty");
+    Rect(&rcAdd, -5, -5, 10, 20);
+    DamageUnion(&rc, &rcAdd);
+    CHECK(SameRect(&rc, &rcAdd), "union into empty is not the box added");
+    DamageUnion(&rc, &rcEmpty);
+    CHECK(SameRect(&rc, &rcAdd), "union with empty changed the box");
+
+    // An empty box far away must not stretch it
+    Rect(&rcAdd, 500, 500, 500, 900);
+    DamageUnion(&rc, &rcAdd);
+    Rect(&rcExpect, -5, -5, 10, 20);
+    CHECK(SameRect(&rc, &rcExpect), "union with a zero-width box changed it");
+
+    Rect(&rcAdd, 0, 0, 5, 5);
+    DamageUnion(&rc, &rcAdd);
+    CHECK(SameRect(&rc, &rcExpect), "union with a box inside changed it");
+    Rect(&rcAdd, 8, -9, 30, 0);
+    DamageUnion(&rc, &rcAdd);
+    Rect(&rcExpect, -5, -9, 30, 20);
+    CHECK(SameRect(&rc, &rcExpect), "overlapping union %d,%d-%d,%d", rc.left, rc.top, rc.right, rc.bottom);
+
+    DamageClip(&rc, 17, 9);
+    Rect(&rcExpect, 0, 0, 17, 9);
+    CHECK(SameRect(&rc, &rcExpect), "clip %d,%d-%d,%d", rc.left, rc.top, rc.right, rc.bottom);
+    Rect(&rc, 20, 2, 40, 5);
+    DamageClip(&rc, 17, 9);
+    CHECK(DamageIsEmpty(&rc) && rc.left == 0 && rc.right == 0, "a box outside did not clip to empty");
+    Rect(&rc, -10, -10, -1, 4);
+    DamageClip(&rc, 17, 9);
+    CHECK(DamageIsEmpty(&rc), "a box left of the client did not clip to empty");
+}
+
+static int Check(int argc, char* argv[])
+{
+    int iStep = argc > 0 && atoi(argv[0]) > 0 ? atoi(argv[0]) : 37;
+
+    CheckHands(iStep);
+    CheckRounding();
+    CheckUnionClip();
+
+    return CheckResult();
+}
+
+int main(int argc, char* argv[])
+{
+    return CheckMain(argc, argv, Check, "[STEP]", NULL, NULL);
+}
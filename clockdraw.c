@@ -0,0 +1,180 @@
+/*--------------------------
+    CLOCKDRAW.C -- Clock face and hand geometry behind a drawing backend
+---------------------------*/
+
+#include <stdio.h>
+#include <string.h>
+#include "clockdraw.h"
+#include "handposes.h"
+
+static const char* romanNumerals[] = {
+    "", "I", "II", "III", "IV", "V",
+    "VI", "VII", "VIII", "IX", "X", "XI", "XII"
+};
+
+// Hand outlines at 12 o'clock: hour, minute, second
+static const ROTPOINT handOutlines[3][CLOCK_HAND_POINTS] = {
+    { {0, -110}, {70, 0}, {0, 300}, {-70, 0}, {0, -110} },
+    { {0, -150}, {40, 0}, {0, 420}, {-40, 0}, {0, -150} },
+    { {0, 0}, {0, 0}, {0, 0}, {0, 0}, {0, 420} }
+};
+
+uint32_t ClockForeground(const CLOCKSTYLE* pStyle)
+{
+    return pStyle->bDarkMode ? CLOCK_WHITE : CLOCK_BLACK;
+}
+
+uint32_t ClockBackground(const CLOCKSTYLE* pStyle)
+{
+    return pStyle->bDarkMode ? CLOCK_BLACK : CLOCK_WHITE;
+}
+
+const char* ClockLabel(int iHour, int bRoman, char buf[8])
+{
+    if (bRoman)
+        strcpy(buf, romanNumerals[iHour]);
+    else
+        sprintf(buf, "%d", iHour);
+    return buf;
+}
+
+void ClockHandAngles(int iHour, int iMinute, int iSecond, int iAngle[3])
+{
+    iAngle[0] = (iHour * 30) % 360 + iMinute / 2;
+    iAngle[1] = iMinute * 6;
+    iAngle[2] = iSecond * 6;
+}
+
+void ClockComputeHand(int iHand, int iAngle, ROTPOINT pt[CLOCK_HAND_POINTS])
+{
+    memcpy(pt, handOutlines[iHand], sizeof(handOutlines[iHand]));
+    RotatePoints(pt, CLOCK_HAND_POINTS, iAngle * ROT_STEPS_PER_DEGREE);
+}
+
+void ClockComputeHandTenths(int iHand, int iTenths, ROTPOINT pt[CLOCK_HAND_POINTS])
+{
+    const ROTPOINT* pPose = iTenths % ROT_STEPS_PER_DEGREE ? NULL :
+        ClockHandPose(iHand, iTenths / ROT_STEPS_PER_DEGREE);
+
+    if (pPose)
+        memcpy(pt, pPose, sizeof(ROTPOINT) * CLOCK_HAND_POINTS);
+    else
+    {
+        memcpy(pt, handOutlines[iHand], sizeof(handOutlines[iHand]));
+        RotatePoints(pt, CLOCK_HAND_POINTS, iTenths);
+    }
+}
+
+const ROTPOINT* ClockHandPose(int iHand, int iAngle)
+{
+    if (iAngle < 0 || iAngle >= 360)
+        return NULL;
+    if (iHand == 0)
+        return handPoseHour[iAngle];
+    if (iAngle % POSE_STEP_DEGREES)
+        return NULL;
+    return iHand == 1 ? handPoseMinute[iAngle / POSE_STEP_DEGREES] :
+        handPoseSecond[iAngle / POSE_STEP_DEGREES];
+}
+
+void ClockComputeHands(int iHour, int iMinute, int iSecond, ROTPOINT pt[3][CLOCK_HAND_POINTS])
+{
+    int i, iAngle[3];
+    const ROTPOINT* pPose;
+
+    ClockHandAngles(iHour, iMinute, iSecond, iAngle);
+
+    for (i = 0; i < 3; i++)
+    {
+        pPose = ClockHandPose(i, iAngle[i]);
+        if (pPose)
+            memcpy(pt[i], pPose, sizeof(pt[i]));
+        else
+            ClockComputeHand(i, iAngle[i], pt[i]);
+    }
+}
+
+void ClockLabelAnchor(int iHour, ROTPOINT* pt)
+{
+    pt->x = 0;
+    pt->y = 450;
+    RotatePoints(pt, 1, (iHour % 12) * 30 * ROT_STEPS_PER_DEGREE);
+    pt->y += 35;
+}
+
+void ClockDrawDots(const CLOCKBACKEND* pBackend, const CLOCKSTYLE* pStyle)
+{
+    int iAngle, iSize;
+    ROTPOINT pt;
+    uint32_t color = ClockForeground(pStyle);
+
+    if (!pStyle->bShowDots)
+        return;
+
+    for (iAngle = 0; iAngle < 360; iAngle += 6)
+    {
+        pt.x = 0;
+        pt.y = 500;
+        RotatePoints(&pt, 1, iAngle * ROT_STEPS_PER_DEGREE);
+
+        iSize = iAngle % 5 ? 18 : 55;
+        pt.x -= iSize / 2;
+        pt.y -= iSize / 2;
+
+        pBackend->pfnDisc(pBackend->pCtx, pt.x, pt.y, pt.x + iSize, pt.y + iSize, color);
+    }
+}
+
+void ClockDrawLabels(const CLOCKBACKEND* pBackend, const CLOCKSTYLE* pStyle)
+{
+    int iHour;
+    ROTPOINT pt;
+    char buf[8];
+    uint32_t color = ClockForeground(pStyle);
+    int iTextHeight = pStyle->bUseLightFont ? CLOCK_LIGHT_TEXT_HEIGHT : CLOCK_HEAVY_TEXT_HEIGHT;
+
+    for (iHour = 1; iHour <= 12; iHour++)
+    {
+        ClockLabelAnchor(iHour, &pt);
+        pBackend->pfnText(pBackend->pCtx, pt.x, pt.y,
+            ClockLabel(iHour, pStyle->bRomanMode, buf), iTextHeight, color);
+    }
+}
+
+void ClockDrawFace(const CLOCKBACKEND* pBackend, const CLOCKSTYLE* pStyle)
+{
+    ClockDrawDots(pBackend, pStyle);
+    ClockDrawLabels(pBackend, pStyle);
+}
+
+void ClockDrawHands(const CLOCKBACKEND* pBackend, const CLOCKSTYLE* pStyle,
+    int iHour, int iMinute, int iSecond, int bAll)
+{
+    int i, iAngle[3];
+    ROTPOINT pt[CLOCK_HAND_POINTS];
+    const ROTPOINT* pPose;
+    uint32_t color = ClockForeground(pStyle);
+
+    ClockHandAngles(iHour, iMinute, iSecond, iAngle);
+
+    for (i = bAll ? 0 : 2; i < 3; i++)
+    {
+        pPose = ClockHandPose(i, iAngle[i]);
+        if (!pPose)
+        {
+            ClockComputeHand(i, iAngle[i], pt);
+            pPose = pt;
+        }
+        pBackend->pfnPolyline(pBackend->pCtx, pPose, CLOCK_HAND_POINTS, 0, color);
+    }
+}
+
+void ClockDrawHandOutlines(const CLOCKBACKEND* pBackend, const CLOCKSTYLE* pStyle,
+    const ROTPOINT pt[3][CLOCK_HAND_POINTS])
+{
+    int i;
+    uint32_t color = ClockForeground(pStyle);
+
+    for (i = 0; i < 3; i++)
+        pBackend->pfnPolyline(pBackend->pCtx, pt[i], CLOCK_HAND_POINTS, 0, color);
+}
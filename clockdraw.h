@@ -0,0 +1,87 @@
+/*--------------------------
+    CLOCKDRAW.H -- Clock face and hand geometry behind a drawing backend
+---------------------------*/
+
+#ifndef CLOCKDRAW_H
+#define CLOCKDRAW_H
+
+#include "rotate.h"
+
+// Colors are 0x00RRGGBB
+#define CLOCK_RGB(r, g, b) ((uint32_t)(((r) << 16) | ((g) << 8) | (b)))
+#define CLOCK_BLACK CLOCK_RGB(0, 0, 0)
+#define CLOCK_WHITE CLOCK_RGB(255, 255, 255)
+
+// Numeral heights in logical units, matching the -40 and -24 CreateFont calls
+#define CLOCK_HEAVY_TEXT_HEIGHT 40
+#define CLOCK_LIGHT_TEXT_HEIGHT 24
+
+#define CLOCK_HAND_POINTS 5
+
+// The face toggles, as in g_bDarkMode and friends
+typedef struct
+{
+    int bDarkMode;
+    int bRomanMode;
+    int bUseLightFont;
+    int bShowDots;
+} CLOCKSTYLE;
+
+// Everything a renderer must provide. All coordinates are logical units in
+// the 600-unit isotropic space set up by SetIsotropic (y points up).
+typedef struct
+{
+    void* pCtx;
+
+    // Fills the ellipse inscribed in the box, like GDI Ellipse
+    void (*pfnDisc)(void* pCtx, int left, int top, int right, int bottom, uint32_t color);
+
+    // Open polyline; iWidth 0 means one device pixel, like a GDI cosmetic pen
+    void (*pfnPolyline)(void* pCtx, const ROTPOINT pt[], int iNum, int iWidth, uint32_t color);
+
+    // Text placed the way DrawClock always placed it: TextOut at
+    // (x - cx / 2, y - cy / 2), where cx, cy is the extent of the text
+    void (*pfnText)(void* pCtx, int x, int y, const char* psz, int iHeight, uint32_t color);
+} CLOCKBACKEND;
+
+uint32_t ClockForeground(const CLOCKSTYLE* pStyle);
+uint32_t ClockBackground(const CLOCKSTYLE* pStyle);
+
+// Numeral for hour 1..12 in the chosen style
+const char* ClockLabel(int iHour, int bRoman, char buf[8]);
+
+// Angles in whole degrees for the hour, minute and second hands
+void ClockHandAngles(int iHour, int iMinute, int iSecond, int iAngle[3]);
+
+// Outline of one hand (0 hour, 1 minute, 2 second) rotated to iAngle degrees
+// at run time; mkposes builds the pose tables from this
+void ClockComputeHand(int iHand, int iAngle, ROTPOINT pt[CLOCK_HAND_POINTS]);
+
+// Outline of one hand at iTenths tenths of a degree, for sweeping hands;
+// from the pose tables when that is a whole degree they hold
+void ClockComputeHandTenths(int iHand, int iTenths, ROTPOINT pt[CLOCK_HAND_POINTS]);
+
+// Outline of one hand at iAngle degrees from the tables in handposes.c, or
+// NULL for an angle no whole-second time produces
+const ROTPOINT* ClockHandPose(int iHand, int iAngle);
+
+// Rotated outlines of the hour, minute and second hands
+void ClockComputeHands(int iHour, int iMinute, int iSecond, ROTPOINT pt[3][CLOCK_HAND_POINTS]);
+
+// Logical point each numeral is centered on (see pfnText), hour 1..12
+void ClockLabelAnchor(int iHour, ROTPOINT* pt);
+
+// Dots and numerals, without the background
+void ClockDrawFace(const CLOCKBACKEND* pBackend, const CLOCKSTYLE* pStyle);
+void ClockDrawDots(const CLOCKBACKEND* pBackend, const CLOCKSTYLE* pStyle);
+void ClockDrawLabels(const CLOCKBACKEND* pBackend, const CLOCKSTYLE* pStyle);
+
+// The three hands, or just the second hand if bAll is 0
+void ClockDrawHands(const CLOCKBACKEND* pBackend, const CLOCKSTYLE* pStyle,
+    int iHour, int iMinute, int iSecond, int bAll);
+
+// Three hand outlines already computed, hour, minute and second
+void ClockDrawHandOutlines(const CLOCKBACKEND* pBackend, const CLOCKSTYLE* pStyle,
+    const ROTPOINT pt[3][CLOCK_HAND_POINTS]);
+
+#endif
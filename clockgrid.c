@@ -0,0 +1,215 @@
+/*--------------------------
+    CLOCKGRID.C -- World-time grid of many clocks in one framebuffer
+---------------------------*/
+
+#include <ctype.h>
+#include <stdio.h>
+#include <string.h>
+#include "clockgrid.h"
+
+#define SECONDS_PER_DAY 86400
+
+void ClockGridLayout(GRIDLAYOUT* pLayout, int nClocks, int cx, int cy)
+{
+    int nCols, nRows, iCell;
+
+    memset(pLayout, 0, sizeof(*pLayout));
+    if (nClocks <= 0 || cx <= 0 || cy <= 0)
+        return;
+
+    for (nCols = 1; nCols <= nClocks; nCols++)
+    {
+        nRows = (nClocks + nCols - 1) / nCols;
+        iCell = cx / nCols < cy / nRows ? cx / nCols : cy / nRows;
+        if (iCell > pLayout->iCell)
+        {
+            pLayout->nCols = nCols;
+            pLayout->nRows = nRows;
+            pLayout->iCell = iCell;
+        }
+    }
+
+    pLayout->xOrigin = (cx - pLayout->nCols * pLayout->iCell) / 2;
+    pLayout->yOrigin = (cy - pLayout->nRows * pLayout->iCell) / 2;
+}
+
+void ClockGridCell(const GRIDLAYOUT* pLayout, int i, int* px, int* py)
+{
+    *px = pLayout->xOrigin + (i % pLayout->nCols) * pLayout->iCell;
+    *py = pLayout->yOrigin + (i / pLayout->nCols) * pLayout->iCell;
+}
+
+void ClockInstanceTime(const CLOCKINSTANCE* pClock, int64_t llUtcSeconds,
+    int* piHour, int* piMinute, int* piSecond)
+{
+    int64_t llLocal = llUtcSeconds + (int64_t)pClock->iUtcOffsetMin * 60;
+    int iDay = (int)(((llLocal % SECONDS_PER_DAY) + SECONDS_PER_DAY) % SECONDS_PER_DAY);
+
+    *piHour = iDay / 3600;
+    *piMinute = iDay / 60 % 60;
+    *piSecond = iDay % 60;
+}
+
+void ClockGridInit(CLOCKGRID* pGrid)
+{
+    memset(pGrid, 0, sizeof(*pGrid));
+}
+
+static void FreeFaces(CLOCKGRID* pGrid)
+{
+    int i;
+
+    for (i = 0; i < GRID_FACE_STYLES; i++)
+        RasterFree(&pGrid->faces[i]);
+}
+
+void ClockGridFree(CLOCKGRID* pGrid)
+{
+    FreeFaces(pGrid);
+    ClockGridInit(pGrid);
+}
+
+static const FRAMEBUFFER* FaceTile(CLOCKGRID* pGrid, const CLOCKSTYLE* pStyle)
+{
+    int iCell = pGrid->layout.iCell;
+    int iStyle = (pStyle->bDarkMode ? 1 : 0) | (pStyle->bRomanMode ? 2 : 0) |
+        (pStyle->bUseLightFont ? 4 : 0) | (pStyle->bShowDots ? 8 : 0);
+    FRAMEBUFFER* pFace = &pGrid->faces[iStyle];
+    CLOCKBACKEND backend;
+    RASTERVIEW view;
+
+    if (pFace->pPixels)
+        return pFace;
+    if (!RasterCreate(pFace, iCell, iCell))
+        return NULL;
+
+    RasterViewInit(&view, pFace, 0, 0, iCell, iCell);
+    RasterBackend(&backend, &view);
+    RasterClear(pFace, ClockBackground(pStyle));
+    ClockDrawFace(&backend, pStyle);
+    pGrid->dwFaceRenders++;
+    return pFace;
+}
+
+void ClockGridRender(CLOCKGRID* pGrid, FRAMEBUFFER* pFb, const CLOCKINSTANCE* pClocks, int n,
+    int64_t llUtcSeconds, uint32_t bgColor)
+{
+    GRIDLAYOUT layout;
+    CLOCKBACKEND backend;
+    RASTERVIEW view;
+    const FRAMEBUFFER* pFace;
+    int i, iHand, x, y, iHour, iMinute, iSecond, iAngle[3];
+    uint32_t color;
+
+    ClockGridLayout(&layout, n, pFb->cx, pFb->cy);
+    if (layout.iCell != pGrid->layout.iCell)
+        FreeFaces(pGrid);
+    pGrid->layout = layout;
+    pGrid->dwFaceRenders = 0;
+
+    if (layout.xOrigin > 0 || layout.yOrigin > 0 || layout.nCols * layout.nRows > n)
+        RasterClear(pFb, bgColor);
+    if (layout.iCell <= 0)
+        return;
+
+    RasterBackend(&backend, &view);
+
+    for (i = 0; i < n; i++)
+    {
+        ClockGridCell(&layout, i, &x, &y);
+
+        pFace = FaceTile(pGrid, &pClocks[i].style);
+        if (pFace)
+            RasterBlit(pFb, x, y, pFace);
+
+        RasterViewInit(&view, pFb, x, y, layout.iCell, layout.iCell);
+        ClockInstanceTime(&pClocks[i], llUtcSeconds, &iHour, &iMinute, &iSecond);
+        ClockHandAngles(iHour, iMinute, iSecond, iAngle);
+        color = ClockForeground(&pClocks[i].style);
+
+        // Whole-second times always land on a precomputed pose
+        for (iHand = 0; iHand < 3; iHand++)
+            backend.pfnPolyline(backend.pCtx, ClockHandPose(iHand, iAngle[iHand]),
+                CLOCK_HAND_POINTS, 0, color);
+    }
+}
+
+static int ParseOffset(const char* psz, int* piMinutes, int* pcch)
+{
+    int iSign = 1, iHours = 0, iMinutes = 0, cch = 0;
+
+    if (*psz == '+' || *psz == '-')
+    {
+        iSign = *psz == '-' ? -1 : 1;
+        cch++;
+    }
+    if (!isdigit((unsigned char)psz[cch]))
+        return 0;
+    while (isdigit((unsigned char)psz[cch]))
+        iHours = iHours * 10 + psz[cch++] - '0';
+    if (psz[cch] == ':')
+    {
+        cch++;
+        while (isdigit((unsigned char)psz[cch]))
+            iMinutes = iMinutes * 10 + psz[cch++] - '0';
+    }
+    if (iHours > 14 || iMinutes > 59)
+        return 0;
+
+    *piMinutes = iSign * (iHours * 60 + iMinutes);
+    *pcch = cch;
+    return 1;
+}
+
+int ClockGridLoad(const char* pszPath, CLOCKINSTANCE* pClocks, int nMax)
+{
+    FILE* fp = fopen(pszPath, "r");
+    char line[256], word[16];
+    const char* p;
+    CLOCKINSTANCE clock;
+    int n = 0, cch;
+    size_t len;
+
+    if (!fp)
+        return -1;
+
+    while (n < nMax && fgets(line, sizeof(line), fp))
+    {
+        for (p = line; isspace((unsigned char)*p); p++)
+            ;
+        if (!*p || *p == '#')
+            continue;
+
+        memset(&clock, 0, sizeof(clock));
+        clock.style.bShowDots = 1;
+        if (!ParseOffset(p, &clock.iUtcOffsetMin, &cch))
+            continue;
+        p += cch;
+
+        // Style words, then everything left is the label
+        for (;;)
+        {
+            while (isspace((unsigned char)*p))
+                p++;
+            if (sscanf(p, "%15s%n", word, &cch) != 1)
+                break;
+            if (strcmp(word, "dark") == 0) clock.style.bDarkMode = 1;
+            else if (strcmp(word, "roman") == 0) clock.style.bRomanMode = 1;
+            else if (strcmp(word, "light") == 0) clock.style.bUseLightFont = 1;
+            else if (strcmp(word, "nodots") == 0) clock.style.bShowDots = 0;
+            else break;
+            p += cch;
+        }
+
+        len = strcspn(p, "\r\n");
+        if (len >= GRID_LABEL_CHARS)
+            len = GRID_LABEL_CHARS - 1;
+        memcpy(clock.szLabel, p, len);
+        clock.szLabel[len] = '\0';
+
+        pClocks[n++] = clock;
+    }
+
+    fclose(fp);
+    return n;
+}
@@ -0,0 +1,61 @@
+/*--------------------------
+    CLOCKGRID.H -- World-time grid of many clocks in one framebuffer
+---------------------------*/
+
+#ifndef CLOCKGRID_H
+#define CLOCKGRID_H
+
+#include "raster.h"
+
+#define GRID_LABEL_CHARS 32
+#define GRID_FACE_STYLES 16     // one per combination of the four toggles
+
+// One clock on the wall: its own zone and look
+typedef struct
+{
+    CLOCKSTYLE style;
+    int iUtcOffsetMin;          // minutes east of UTC
+    char szLabel[GRID_LABEL_CHARS];
+} CLOCKINSTANCE;
+
+// Square cells, row-major, centered in the target
+typedef struct
+{
+    int nCols, nRows;
+    int iCell;                  // cell edge in pixels
+    int xOrigin, yOrigin;       // top-left of cell 0
+} GRIDLAYOUT;
+
+typedef struct
+{
+    GRIDLAYOUT layout;
+
+    // Face tiles rendered once per style at the current cell size; every
+    // clock of that style is a copy of its tile plus three hands
+    FRAMEBUFFER faces[GRID_FACE_STYLES];
+
+    // Statistics for the last frame
+    uint32_t dwFaceRenders;
+} CLOCKGRID;
+
+// Picks the column count that gives n clocks the largest cells in cx by cy
+void ClockGridLayout(GRIDLAYOUT* pLayout, int nClocks, int cx, int cy);
+void ClockGridCell(const GRIDLAYOUT* pLayout, int i, int* px, int* py);
+
+// Wall time of an instance at llUtcSeconds since the epoch, 24-hour
+void ClockInstanceTime(const CLOCKINSTANCE* pClock, int64_t llUtcSeconds,
+    int* piHour, int* piMinute, int* piSecond);
+
+void ClockGridInit(CLOCKGRID* pGrid);
+void ClockGridFree(CLOCKGRID* pGrid);
+
+// Draws all n clocks into pFb in one pass; the gaps are filled with bgColor
+void ClockGridRender(CLOCKGRID* pGrid, FRAMEBUFFER* pFb, const CLOCKINSTANCE* pClocks, int n,
+    int64_t llUtcSeconds, uint32_t bgColor);
+
+// Reads a site list, one clock per line: "+HH:MM [dark] [roman] [light]
+// [nodots] label". Blank lines and lines starting with '#' are skipped.
+// Returns the number of clocks read, or -1 if the file cannot be opened.
+int ClockGridLoad(const char* pszPath, CLOCKINSTANCE* pClocks, int nMax);
+
+#endif
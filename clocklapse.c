@@ -0,0 +1,338 @@
+/*--------------------------
+    CLOCKLAPSE.C -- Renders a time range as a PPM sequence or Y4M video
+
+    Usage: clocklapse OUT WIDTH HEIGHT START END STEP [dark] [roman] [light] [nodots]
+                      [threads=N] [fps=N]
+
+    START and END are HH:MM:SS, END exclusive (24:00:00 for a whole day,
+    earlier than START to run past midnight), STEP in seconds. OUT ending
+    in ".y4m", or "-" for stdout, is one 4:2:0 YUV4MPEG2 stream; anything
+    else is a printf pattern for one PPM per frame, e.g. out/clock%05d.ppm.
+
+    Frames are rendered by a work-stealing pool (all processors unless
+    threads=N) and written in order from the main thread.
+---------------------------*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "raster.h"
+#include "phasetime.h"
+#include "workpool.h"
+
+#define SECONDS_PER_DAY 86400
+
+// Upper bound for frames buffered in memory, both windows together
+#define LAPSE_BUFFER_BYTES (256 << 20)
+
+typedef struct
+{
+    CLOCKSTYLE style;
+    FRAMEBUFFER face;           // background, dots and numerals, shared read-only
+    FRAMEBUFFER* pScratch;      // one per worker
+    int iStartSecond;
+    int iStep;
+    int bY4M;
+    size_t cbFrame;             // encoded bytes per frame, including any header
+    int nWindow;                // frames per window; two windows alternate
+    uint8_t* pSlots;            // 2 * nWindow encoded frames
+} LAPSE;
+
+static int ParseTime(const char* psz, int* piSecond)
+{
+    int iHour, iMinute, iSecond;
+
+    if (sscanf(psz, "%d:%d:%d", &iHour, &iMinute, &iSecond) != 3 ||
+        iHour < 0 || iHour > 24 || iMinute < 0 || iMinute > 59 || iSecond < 0 || iSecond > 59)
+        return 0;
+    *piSecond = iHour * 3600 + iMinute * 60 + iSecond;
+    return *piSecond <= SECONDS_PER_DAY;
+}
+
+static int IsY4MPath(const char* psz)
+{
+    size_t cch = strlen(psz);
+
+    return strcmp(psz, "-") == 0 || (cch > 4 && strcmp(psz + cch - 4, ".y4m") == 0);
+}
+
+static void EncodePPM(const FRAMEBUFFER* pFb, uint8_t* pOut, size_t cbHeader)
+{
+    const uint8_t* pSrc = pFb->pPixels;
+    size_t i, n = (size_t)pFb->cx * pFb->cy;
+
+    sprintf((char*)pOut, "P6\n%d %d\n255\n", pFb->cx, pFb->cy);
+    for (pOut += cbHeader, i = 0; i < n; i++, pSrc += 4, pOut += 3)
+    {
+        pOut[0] = pSrc[0];
+        pOut[1] = pSrc[1];
+        pOut[2] = pSrc[2];
+    }
+}
+
+// BT.601 studio range, the Y4M default; chroma is the average of each 2x2
+// block, sited at its center as C420jpeg says
+static void EncodeY4M(const FRAMEBUFFER* pFb, uint8_t* pOut)
+{
+    int x, y, dx, dy, r, g, b, n, cxC = (pFb->cx + 1) / 2, cyC = (pFb->cy + 1) / 2;
+    const uint8_t* p;
+    uint8_t* pY;
+    uint8_t* pU;
+    uint8_t* pV;
+
+    memcpy(pOut, "FRAME\n", 6);
+    pY = pOut + 6;
+    pU = pY + (size_t)pFb->cx * pFb->cy;
+    pV = pU + (size_t)cxC * cyC;
+
+    for (y = 0; y < pFb->cy; y++)
+    {
+        p = pFb->pPixels + (size_t)y * pFb->cx * 4;
+        for (x = 0; x < pFb->cx; x++, p += 4)
+            *pY++ = (uint8_t)(((66 * p[0] + 129 * p[1] + 25 * p[2] + 128) >> 8) + 16);
+    }
+
+    for (y = 0; y < cyC; y++)
+    {
+        for (x = 0; x < cxC; x++)
+        {
+            r = g = b = n = 0;
+            for (dy = 0; dy < 2 && y * 2 + dy < pFb->cy; dy++)
+            {
+                for (dx = 0; dx < 2 && x * 2 + dx < pFb->cx; dx++)
+                {
+                    p = pFb->pPixels + ((size_t)(y * 2 + dy) * pFb->cx + x * 2 + dx) * 4;
+                    r += p[0];
+                    g += p[1];
+                    b += p[2];
+                    n++;
+                }
+            }
+            r /= n;
+            g /= n;
+            b /= n;
+            *pU++ = (uint8_t)(((-38 * r - 74 * g + 112 * b + 128) >> 8) + 128);
+            *pV++ = (uint8_t)(((112 * r - 94 * g - 18 * b + 128) >> 8) + 128);
+        }
+    }
+}
+
+static size_t PPMHeaderBytes(int cx, int cy)
+{
+    char buf[64];
+
+    return (size_t)sprintf(buf, "P6\n%d %d\n255\n", cx, cy);
+}
+
+// One frame: copy of the face, the hands for its time, then encoded into
+// its slot. Runs on any worker.
+static void RenderFrame(void* pCtx, int iFrame, int iWorker)
+{
+    LAPSE* pLapse = (LAPSE*)pCtx;
+    FRAMEBUFFER* pFb = &pLapse->pScratch[iWorker];
+    uint8_t* pSlot = pLapse->pSlots + (size_t)(iFrame % (2 * pLapse->nWindow)) * pLapse->cbFrame;
+    int iDay = (int)(((int64_t)pLapse->iStartSecond + (int64_t)iFrame * pLapse->iStep) % SECONDS_PER_DAY);
+    CLOCKBACKEND backend;
+    RASTERVIEW view;
+
+    RasterBlit(pFb, 0, 0, &pLapse->face);
+    RasterViewInit(&view, pFb, 0, 0, pFb->cx, pFb->cy);
+    RasterBackend(&backend, &view);
+    ClockDrawHands(&backend, &pLapse->style, iDay / 3600, iDay / 60 % 60, iDay % 60, 1);
+
+    if (pLapse->bY4M)
+        EncodeY4M(pFb, pSlot);
+    else
+        EncodePPM(pFb, pSlot, pLapse->cbFrame - (size_t)pFb->cx * pFb->cy * 3);
+}
+
+static int WriteFrame(const LAPSE* pLapse, FILE* fpY4M, const char* pszPattern, int iFrame)
+{
+    const uint8_t* pSlot = pLapse->pSlots + (size_t)(iFrame % (2 * pLapse->nWindow)) * pLapse->cbFrame;
+    char szPath[1024];
+    FILE* fp;
+    int bOk;
+
+    if (fpY4M)
+        return fwrite(pSlot, 1, pLapse->cbFrame, fpY4M) == pLapse->cbFrame;
+
+    snprintf(szPath, sizeof(szPath), pszPattern, iFrame);
+    fp = fopen(szPath, "wb");
+    if (!fp)
+        return 0;
+    bOk = fwrite(pSlot, 1, pLapse->cbFrame, fp) == pLapse->cbFrame;
+    return fclose(fp) == 0 && bOk;
+}
+
+// Exactly one integer conversion, so the pattern cannot read past its argument
+static int IsFramePattern(const char* psz)
+{
+    int nConversions = 0;
+
+    for (; *psz; psz++)
+    {
+        if (*psz != '%')
+            continue;
+        if (psz[1] == '%')
+        {
+            psz++;
+            continue;
+        }
+        for (psz++; *psz && strchr("0123456789-+ #", *psz); psz++)
+            ;
+        if (*psz != 'd' && *psz != 'u')
+            return 0;
+        nConversions++;
+    }
+    return nConversions == 1;
+}
+
+// Frames in window iWindow, the last one possibly short
+static int WindowFrames(const LAPSE* pLapse, int nFrames, int iWindow)
+{
+    int nLeft = nFrames - iWindow * pLapse->nWindow;
+
+    return nLeft < pLapse->nWindow ? nLeft : pLapse->nWindow;
+}
+
+int main(int argc, char* argv[])
+{
+    LAPSE lapse;
+    CLOCKBACKEND backend;
+    RASTERVIEW view;
+    WORKPOOL* pPool;
+    FILE* fpY4M = NULL;
+    int cx, cy, i, iEnd, nFrames, nThreads = 0, iFps = 30, iWindow, nWindows, iFirst;
+    int bOk = 1;
+    uint64_t qwStart;
+    double dSeconds;
+
+    memset(&lapse, 0, sizeof(lapse));
+    lapse.style.bShowDots = 1;
+
+    if (argc < 7 || !ParseTime(argv[4], &lapse.iStartSecond) || !ParseTime(argv[5], &iEnd) ||
+        (lapse.iStep = atoi(argv[6])) <= 0)
+    {
+        fprintf(stderr, "usage: %s <out.y4m|-|pattern%%05d.ppm> <width> <height> <HH:MM:SS> <HH:MM:SS> "
+            "<step-seconds> [dark] [roman] [light] [nodots] [threads=N] [fps=N]\n", argv[0]);
+        return 2;
+    }
+
+    for (i = 7; i < argc; i++)
+    {
+        if (strcmp(argv[i], "dark") == 0) lapse.style.bDarkMode = 1;
+        else if (strcmp(argv[i], "roman") == 0) lapse.style.bRomanMode = 1;
+        else if (strcmp(argv[i], "light") == 0) lapse.style.bUseLightFont = 1;
+        else if (strcmp(argv[i], "nodots") == 0) lapse.style.bShowDots = 0;
+        else if (strncmp(argv[i], "threads=", 8) == 0) nThreads = atoi(argv[i] + 8);
+        else if (strncmp(argv[i], "fps=", 4) == 0) iFps = atoi(argv[i] + 4);
+    }
+
+    lapse.bY4M = IsY4MPath(argv[1]);
+    if (!lapse.bY4M && !IsFramePattern(argv[1]))
+    {
+        fprintf(stderr, "%s: %s needs one %%d for the frame number\n", argv[0], argv[1]);
+        return 2;
+    }
+
+    if (iEnd <= lapse.iStartSecond)
+        iEnd += SECONDS_PER_DAY;
+    nFrames = (iEnd - lapse.iStartSecond + lapse.iStep - 1) / lapse.iStep;
+
+    cx = atoi(argv[2]);
+    cy = atoi(argv[3]);
+    if (!RasterCreate(&lapse.face, cx, cy))
+    {
+        fprintf(stderr, "%s: bad size %dx%d\n", argv[0], cx, cy);
+        return 1;
+    }
+
+    InitRotateTable();
+    RasterViewInit(&view, &lapse.face, 0, 0, cx, cy);
+    RasterBackend(&backend, &view);
+    RasterClear(&lapse.face, ClockBackground(&lapse.style));
+    ClockDrawFace(&backend, &lapse.style);
+
+    pPool = WorkPoolCreate(nThreads > 0 ? nThreads : WorkPoolCpuCount());
+    if (!pPool)
+    {
+        fprintf(stderr, "%s: could not start worker threads\n", argv[0]);
+        return 1;
+    }
+
+    lapse.cbFrame = lapse.bY4M ? 6 + (size_t)cx * cy + 2 * (size_t)((cx + 1) / 2) * ((cy + 1) / 2) :
+        PPMHeaderBytes(cx, cy) + (size_t)cx * cy * 3;
+
+    // A few frames per worker keeps stealing rare; memory caps it for big frames
+    lapse.nWindow = 4 * WorkPoolWorkers(pPool);
+    if ((size_t)lapse.nWindow * 2 * lapse.cbFrame > LAPSE_BUFFER_BYTES)
+        lapse.nWindow = (int)(LAPSE_BUFFER_BYTES / 2 / lapse.cbFrame);
+    if (lapse.nWindow < 1)
+        lapse.nWindow = 1;
+
+    lapse.pScratch = (FRAMEBUFFER*)calloc(WorkPoolWorkers(pPool), sizeof(FRAMEBUFFER));
+    lapse.pSlots = (uint8_t*)malloc((size_t)lapse.nWindow * 2 * lapse.cbFrame);
+    for (i = 0; lapse.pScratch && i < WorkPoolWorkers(pPool); i++)
+        bOk = bOk && RasterCreate(&lapse.pScratch[i], cx, cy);
+    if (!lapse.pScratch || !lapse.pSlots || !bOk)
+    {
+        fprintf(stderr, "%s: no memory for %d frames of %dx%d\n", argv[0], lapse.nWindow * 2, cx, cy);
+        return 1;
+    }
+
+    if (lapse.bY4M)
+    {
+        fpY4M = strcmp(argv[1], "-") == 0 ? stdout : fopen(argv[1], "wb");
+        if (!fpY4M || fprintf(fpY4M, "YUV4MPEG2 W%d H%d F%d:1 Ip A1:1 C420jpeg\n", cx, cy,
+            iFps > 0 ? iFps : 30) < 0)
+        {
+            fprintf(stderr, "%s: could not write %s\n", argv[0], argv[1]);
+            return 1;
+        }
+    }
+
+    // Workers render window n + 1 while this thread writes window n
+    qwStart = PhaseNowNs();
+    nWindows = (nFrames + lapse.nWindow - 1) / lapse.nWindow;
+    WorkPoolRun(pPool, RenderFrame, &lapse, 0, WindowFrames(&lapse, nFrames, 0));
+
+    for (iWindow = 0; iWindow < nWindows && bOk; iWindow++)
+    {
+        WorkPoolWait(pPool);
+
+        iFirst = iWindow * lapse.nWindow;
+        if (iWindow + 1 < nWindows)
+        {
+            WorkPoolRun(pPool, RenderFrame, &lapse, iFirst + lapse.nWindow,
+                WindowFrames(&lapse, nFrames, iWindow + 1));
+        }
+
+        for (i = iFirst; i < iFirst + WindowFrames(&lapse, nFrames, iWindow) && bOk; i++)
+            bOk = WriteFrame(&lapse, fpY4M, argv[1], i);
+    }
+    WorkPoolWait(pPool);
+
+    if (fpY4M && fpY4M != stdout)
+        bOk = fclose(fpY4M) == 0 && bOk;
+    else if (fpY4M)
+        bOk = fflush(fpY4M) == 0 && bOk;
+
+    dSeconds = (double)(PhaseNowNs() - qwStart) / 1e9;
+    fprintf(stderr, "%d frames of %dx%d in %.2f s: %.1f fps on %d threads, %u steals\n",
+        nFrames, cx, cy, dSeconds, dSeconds > 0 ? nFrames / dSeconds : 0.0,
+        WorkPoolWorkers(pPool), WorkPoolSteals(pPool));
+
+    for (i = 0; i < WorkPoolWorkers(pPool); i++)
+        RasterFree(&lapse.pScratch[i]);
+    WorkPoolDestroy(pPool);
+    free(lapse.pScratch);
+    free(lapse.pSlots);
+    RasterFree(&lapse.face);
+
+    if (!bOk)
+    {
+        fprintf(stderr, "%s: could not write %s\n", argv[0], argv[1]);
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,308 @@
+/*--------------------------
+    CLOCKMIX.C -- Checks the tick mixer by rendering to a file
+
+    Usage: clockmix check [Tick.wav] [out.wav]
+
+    Parses Tick.wav and schedules it into a mixer of its own format: on
+    frames inside and across render blocks, overlapping up to five deep,
+    and once on a frame already rendered, which must start at the write
+    head. Rendering runs in odd-sized blocks, short and long in turn, as
+    the audio thread's buffers never line up with ticks. Each start must
+    be on its frame, and the output must match the ticks summed sample by
+    sample.
+    The result goes to out.wav (clockmix.wav by default) and must read
+    back unchanged. A loud synthetic sound, stacked three deep in a stereo
+    mixer from one channel, must clamp at full scale both ways, and voices
+    of +30000, +30000 and -30000 must sum to 30000 in every order,
+    together and staggered.
+---------------------------*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "mixer.h"
+#include "wavfile.h"
+#include "clockcheck.h"
+
+#define CHECK_FRAMES 132300         // 3 s at 44.1 kHz
+#define CHECK_BLOCK 441             // never a divisor of a tick's frame
+#define CHECK_BLOCK_LONG 2205       // several of the mixer's passes long
+#define LOUD_FRAMES 64
+
+// A tick due on qwDue that must really start on qwStart. Each has a copy
+// of the sound of its own, so its voice can be told from the others.
+typedef struct
+{
+    WAVSOUND sound;
+    uint64_t qwDue;
+    uint64_t qwStart;
+    uint64_t qwStarted;
+    int bStarted;
+} TICK;
+
+static int16_t Clamp16(int32_t v)
+{
+    return (int16_t)(v > 32767 ? 32767 : v < -32768 ? -32768 : v);
+}
+
+// The ticks summed sample by sample; the tick is too quiet to clip
+static void MixReference(const WAVSOUND* pTick, const TICK* pTicks, int nTicks, int16_t* pOut, uint32_t dwFrames)
+{
+    uint32_t f, c, wCh = pTick->wChannels;
+    int32_t acc;
+    int i;
+
+    for (f = 0; f < dwFrames; f++)
+    {
+        for (c = 0; c < wCh; c++)
+        {
+            acc = 0;
+            for (i = 0; i < nTicks; i++)
+            {
+                if (f >= pTicks[i].qwStart && f - pTicks[i].qwStart < pTick->dwFrames)
+                    acc += pTick->pSamples[(size_t)(f - pTicks[i].qwStart) * wCh + c];
+            }
+            pOut[(size_t)f * wCh + c] = Clamp16(acc);
+        }
+    }
+}
+
+static void CheckTicks(const char* pszTick, const char* pszOut)
+{
+    // Two in one long block, one on a block edge and one a frame past it,
+    // three over an edge a frame apart, and one due before the write head.
+    // Blocks go 441, 2205, 441, ..., so an edge is 441 * k for k 0 or 1
+    // mod 6.
+    static const uint64_t qwDues[] = { 1000, 1200, 44982, 44983, 66149, 66150, 66151, 88200 };
+    TICK ticks[sizeof(qwDues) / sizeof(qwDues[0]) + 1];
+    WAVSOUND tick, back;
+    MIXER mixer;
+    const MIXVOICE* pVoice;
+    int16_t *pOut, *pExpect;
+    uint64_t qwFrame = 0;
+    uint32_t dwBlock;
+    size_t cbOut, i;
+    int v, nTicks = 0, iLate = -1, nBlocks = 0;
+
+    if (!WavLoadFile(pszTick, &tick))
+    {
+        CHECK(0, "could not parse %s", pszTick);
+        return;
+    }
+    MixerInit(&mixer, tick.wChannels, tick.dwSampleRate);
+    cbOut = (size_t)CHECK_FRAMES * tick.wChannels * sizeof(int16_t);
+    pOut = (int16_t*)malloc(cbOut);
+    pExpect = (int16_t*)malloc(cbOut);
+    if (!pOut || !pExpect)
+    {
+        CHECK(0, "out of memory");
+        return;
+    }
+
+    memset(ticks, 0, sizeof(ticks));
+    for (i = 0; i < sizeof(qwDues) / sizeof(qwDues[0]); i++)
+    {
+        ticks[nTicks].sound = tick;
+        ticks[nTicks].qwDue = ticks[nTicks].qwStart = qwDues[i];
+        CHECK(MixerSchedule(&mixer, &ticks[nTicks].sound, qwDues[i]), "tick due on %llu not scheduled",
+            (unsigned long long)qwDues[i]);
+        nTicks++;
+    }
+
+    while (qwFrame < CHECK_FRAMES)
+    {
+        dwBlock = nBlocks++ % 2 ? CHECK_BLOCK_LONG : CHECK_BLOCK;
+        if (dwBlock > CHECK_FRAMES - qwFrame)
+            dwBlock = (uint32_t)(CHECK_FRAMES - qwFrame);
+
+        // Late by half a second: plays from the top of the next block
+        if (iLate < 0 && qwFrame >= 99000)
+        {
+            iLate = nTicks;
+            ticks[nTicks].sound = tick;
+            ticks[nTicks].qwDue = qwFrame - 22050;
+            ticks[nTicks].qwStart = qwFrame;
+            CHECK(MixerSchedule(&mixer, &ticks[nTicks].sound, ticks[nTicks].qwDue), "late tick not scheduled");
+            nTicks++;
+        }
+
+        // A tick lasts longer than a block, so every voice that starts is
+        // still there afterwards
+        MixerRender(&mixer, pOut + (size_t)qwFrame * tick.wChannels, dwBlock);
+        for (v = 0; v < mixer.nVoices; v++)
+        {
+            pVoice = &mixer.voices[v];
+            i = (size_t)((const TICK*)pVoice->pSound - ticks);
+            if (pVoice->bStarted && !ticks[i].bStarted)
+            {
+                ticks[i].bStarted = 1;
+                ticks[i].qwStarted = pVoice->qwStarted;
+            }
+        }
+        if (iLate >= 0 && qwFrame == ticks[iLate].qwStart)
+            CHECK(mixer.qwLastStart == qwFrame && mixer.dwLastLateFrames == 22050,
+                "the late tick reported starting on %llu, %lu frames late", (unsigned long long)mixer.qwLastStart,
+                (unsigned long)mixer.dwLastLateFrames);
+        qwFrame += dwBlock;
+    }
+    CHECK((int)mixer.dwStarts == nTicks, "%lu ticks started of %d", (unsigned long)mixer.dwStarts, nTicks);
+    for (i = 0; i < (size_t)nTicks; i++)
+        CHECK(ticks[i].bStarted && ticks[i].qwStarted == ticks[i].qwStart, "tick %lu due on %llu started on %llu, "
+            "not %llu", (unsigned long)i, (unsigned long long)ticks[i].qwDue, (unsigned long long)ticks[i].qwStarted,
+            (unsigned long long)ticks[i].qwStart);
+    CHECK(iLate >= 0, "no late tick");
+    CHECK(mixer.nVoices == 2, "%d voices left playing, not the last two", mixer.nVoices);
+
+    MixReference(&tick, ticks, nTicks, pExpect, CHECK_FRAMES);
+    for (i = 0; i < (size_t)CHECK_FRAMES * tick.wChannels; i++)
+    {
+        if (pOut[i] != pExpect[i])
+        {
+            CHECK(0, "frame %lu channel %lu is %d, not %d", (unsigned long)(i / tick.wChannels),
+                (unsigned long)(i % tick.wChannels), pOut[i], pExpect[i]);
+            break;
+        }
+    }
+
+    // Every start is on its frame: the first sample of the tick is not 0
+    for (i = 0; i < (size_t)nTicks; i++)
+        CHECK(pOut[ticks[i].qwStart * tick.wChannels] != 0, "silence where tick %lu starts", (unsigned long)i);
+
+    CHECK(WavWriteFile(pszOut, pOut, CHECK_FRAMES, tick.wChannels, tick.dwSampleRate), "could not write %s",
+        pszOut);
+    if (WavLoadFile(pszOut, &back))
+    {
+        CHECK(back.dwFrames == CHECK_FRAMES && back.wChannels == tick.wChannels &&
+            back.dwSampleRate == tick.dwSampleRate && memcmp(back.pSamples, pOut, cbOut) == 0,
+            "%s did not read back the same", pszOut);
+        WavFree(&back);
+    }
+    else
+        CHECK(0, "could not read back %s", pszOut);
+
+    free(pOut);
+    free(pExpect);
+    WavFree(&tick);
+}
+
+static void CheckClamp(void)
+{
+    int16_t samples[2][LOUD_FRAMES], out[LOUD_FRAMES * 2 * 2];
+    WAVSOUND loud[2];
+    MIXER mixer;
+    int i, j;
+
+    for (i = 0; i < LOUD_FRAMES; i++)
+    {
+        samples[0][i] = 20000;
+        samples[1][i] = -20000;
+    }
+    for (j = 0; j < 2; j++)
+    {
+        loud[j].wChannels = 1;
+        loud[j].dwSampleRate = 44100;
+        loud[j].dwFrames = LOUD_FRAMES;
+        loud[j].pSamples = samples[j];
+    }
+
+    // Up three times, then down three times, one channel into two
+    MixerInit(&mixer, 2, 44100);
+    for (i = 0; i < 3; i++)
+    {
+        CHECK(MixerSchedule(&mixer, &loud[0], 0), "loud voice %d not scheduled", i);
+        CHECK(MixerSchedule(&mixer, &loud[1], LOUD_FRAMES), "quiet voice %d not scheduled", i);
+    }
+    MixerRender(&mixer, out, LOUD_FRAMES * 2);
+    for (i = 0; i < LOUD_FRAMES * 2; i++)
+    {
+        for (j = 0; j < 2; j++)
+        {
+            if (out[i * 2 + j] != (i < LOUD_FRAMES ? 32767 : -32768))
+            {
+                CHECK(0, "frame %d channel %d is %d, not clamped", i, j, out[i * 2 + j]);
+                return;
+            }
+        }
+    }
+
+    // One voice alone is not touched
+    MixerSchedule(&mixer, &loud[1], mixer.qwFrame);
+    MixerRender(&mixer, out, LOUD_FRAMES);
+    CHECK(out[0] == -20000 && out[1] == -20000, "one voice came out as %d, %d", out[0], out[1]);
+
+    // A stereo sound does not fit a mono mixer, and voices run out
+    MixerInit(&mixer, 1, 44100);
+    loud[0].wChannels = 2;
+    CHECK(!MixerSchedule(&mixer, &loud[0], 0), "a stereo sound went into a mono mixer");
+    loud[0].dwSampleRate = 48000;
+    loud[0].wChannels = 1;
+    CHECK(!MixerSchedule(&mixer, &loud[0], 0), "a 48 kHz sound went into a 44.1 kHz mixer");
+    loud[0].dwSampleRate = 44100;
+    for (i = 0; i < MIXER_MAX_VOICES; i++)
+        MixerSchedule(&mixer, &loud[0], 0);
+    CHECK(!MixerSchedule(&mixer, &loud[0], 0), "more than %d voices", MIXER_MAX_VOICES);
+}
+
+// Voices that clip only part way through their sum: the total must be
+// clamped, not each step, so every order gives the same samples
+static void CheckOrder(void)
+{
+    static const int16_t wLevels[3] = { 30000, 30000, -30000 };
+    static const int iOrders[6][3] = { { 0, 1, 2 }, { 0, 2, 1 }, { 1, 0, 2 }, { 1, 2, 0 }, { 2, 0, 1 }, { 2, 1, 0 } };
+    int16_t samples[3][LOUD_FRAMES], out[LOUD_FRAMES * 3];
+    WAVSOUND voice[3];
+    MIXER mixer;
+    int i, j, iExpect;
+
+    for (j = 0; j < 3; j++)
+    {
+        for (i = 0; i < LOUD_FRAMES; i++)
+            samples[j][i] = wLevels[j];
+        voice[j].wChannels = 1;
+        voice[j].dwSampleRate = 44100;
+        voice[j].dwFrames = LOUD_FRAMES;
+        voice[j].pSamples = samples[j];
+    }
+
+    // All three from frame 0, then staggered by a third so the sum goes
+    // 30000, 60000 (clamped), 30000 and back down
+    for (j = 0; j < 6; j++)
+    {
+        MixerInit(&mixer, 1, 44100);
+        for (i = 0; i < 3; i++)
+            MixerSchedule(&mixer, &voice[iOrders[j][i]], 0);
+        MixerRender(&mixer, out, LOUD_FRAMES);
+        CHECK(out[0] == 30000 && out[LOUD_FRAMES - 1] == 30000, "+30000 +30000 -30000 in order %d%d%d mixed to %d",
+            iOrders[j][0], iOrders[j][1], iOrders[j][2], out[0]);
+
+        MixerInit(&mixer, 1, 44100);
+        for (i = 0; i < 3; i++)
+            MixerSchedule(&mixer, &voice[iOrders[j][i]], (uint64_t)iOrders[j][i] * LOUD_FRAMES / 3);
+        MixerRender(&mixer, out, LOUD_FRAMES * 3);
+        for (i = 0; i < LOUD_FRAMES * 3; i++)
+        {
+            iExpect = (i < LOUD_FRAMES ? 30000 : 0) + (i >= LOUD_FRAMES / 3 && i < LOUD_FRAMES / 3 + LOUD_FRAMES ?
+                30000 : 0) - (i >= LOUD_FRAMES * 2 / 3 && i < LOUD_FRAMES * 2 / 3 + LOUD_FRAMES ? 30000 : 0);
+            if (out[i] != Clamp16(iExpect))
+            {
+                CHECK(0, "staggered voices in order %d%d%d: frame %d is %d, not %d", iOrders[j][0], iOrders[j][1],
+                    iOrders[j][2], i, out[i], Clamp16(iExpect));
+                break;
+            }
+        }
+    }
+}
+
+static int Check(int argc, char* argv[])
+{
+    CheckTicks(argc > 0 ? argv[0] : "Tick.wav", argc > 1 ? argv[1] : "clockmix.wav");
+    CheckClamp();
+    CheckOrder();
+
+    return CheckResult();
+}
+
+int main(int argc, char* argv[])
+{
+    return CheckMain(argc, argv, Check, "[Tick.wav] [out.wav]", NULL, NULL);
+}
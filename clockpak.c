@@ -0,0 +1,299 @@
+/*--------------------------
+    CLOCKPAK.C -- Checks the asset pack writer and reader round trip
+
+    Usage: clockpak check [DIR]
+
+    Writes a few files of awkward sizes (empty, one byte, just past a
+    PAK_ALIGN boundary, several buffers long) into DIR (the current
+    directory by default), packs them with PakWriteFile, reads the pack
+    back into memory and opens it with PakOpenMemory. Every asset must be
+    found by PakFind under its name in any case, hold the same bytes and
+    start on a PAK_ALIGN boundary; missing names and near misses must not
+    be found. Copies of the image with a truncated header, a bad magic or
+    version, a truncated index or data, and an entry whose offset or size
+    runs past the end must all be refused. The files it writes are removed
+    again.
+---------------------------*/
+
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "assetpak.h"
+#include "clockcheck.h"
+
+#define CHECK_FILES 5
+#define PATH_CHARS 512
+
+// Names in mixed case, sizes either side of the alignment and the
+// writer's 4096-byte copy buffer
+static const char* const pszNames[CHECK_FILES] =
+{
+    "Empty.bin", "one.BIN", "Seventeen.dat", "tick.wav", "Minecraft.TTF"
+};
+static const size_t cbSizes[CHECK_FILES] = { 0, 1, 17, 33, 3 * 4096 + 5 };
+
+static void WriteLE32(uint8_t* p, uint32_t v)
+{
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+    p[2] = (uint8_t)(v >> 16);
+    p[3] = (uint8_t)(v >> 24);
+}
+
+static uint8_t FileByte(int iFile, size_t i)
+{
+    return (uint8_t)(i * 31 + iFile * 7 + 1);
+}
+
+static void JoinPath(char* pszPath, const char* pszDir, const char* pszName)
+{
+    snprintf(pszPath, PATH_CHARS, "%s/%s", pszDir, pszName);
+}
+
+static int WriteBytes(const char* pszPath, const uint8_t* p, size_t cb)
+{
+    FILE* fp = fopen(pszPath, "wb");
+    int bOk;
+
+    if (!fp)
+        return 0;
+    bOk = fwrite(p, 1, cb, fp) == cb;
+    return fclose(fp) == 0 && bOk;
+}
+
+static uint8_t* ReadBytes(const char* pszPath, size_t* pcb)
+{
+    FILE* fp = fopen(pszPath, "rb");
+    uint8_t* p = NULL;
+    long cb;
+
+    if (!fp)
+        return NULL;
+    if (fseek(fp, 0, SEEK_END) == 0 && (cb = ftell(fp)) >= 0 && fseek(fp, 0, SEEK_SET) == 0)
+    {
+        p = (uint8_t*)malloc(cb ? (size_t)cb : 1);
+        if (p && fread(p, 1, (size_t)cb, fp) != (size_t)cb)
+        {
+            free(p);
+            p = NULL;
+        }
+        *pcb = (size_t)cb;
+    }
+    fclose(fp);
+    return p;
+}
+
+static void ChangeCase(char* pszOut, const char* pszName, int bUpper)
+{
+    for (; *pszName; pszName++)
+        *pszOut++ = (char)(bUpper ? toupper((unsigned char)*pszName) : tolower((unsigned char)*pszName));
+    *pszOut = '\0';
+}
+
+// Opens a patched copy of the image; the copy is exactly cb bytes, so a
+// reader that looks past it trips the address sanitizer too
+static int OpenPatched(const uint8_t* pImage, size_t cb, size_t iPatch, uint32_t dwValue)
+{
+    PAKFILE pak;
+    uint8_t* p = (uint8_t*)malloc(cb ? cb : 1);
+    int bOpened;
+
+    if (!p)
+        return -1;
+    memcpy(p, pImage, cb);
+    if (iPatch + 4 <= cb)
+        WriteLE32(p + iPatch, dwValue);
+    bOpened = PakOpenMemory(&pak, p, cb);
+    free(p);
+    return bOpened;
+}
+
+static void CheckFind(const PAKFILE* pPak)
+{
+    char szName[PAK_NAME_MAX + 2];
+    const uint8_t* p;
+    const uint8_t* pCase;
+    size_t cb, cbCase, i;
+    int iFile, bUpper, bSame;
+
+    CHECK(pPak->dwCount == CHECK_FILES, "%lu entries, not %d", (unsigned long)pPak->dwCount, CHECK_FILES);
+    for (iFile = 0; iFile < CHECK_FILES; iFile++)
+    {
+        cb = (size_t)-1;
+        p = (const uint8_t*)PakFind(pPak, pszNames[iFile], &cb);
+        if (!p)
+        {
+            CHECK(0, "%s not found", pszNames[iFile]);
+            continue;
+        }
+        CHECK(cb == cbSizes[iFile], "%s is %lu bytes, not %lu", pszNames[iFile], (unsigned long)cb,
+            (unsigned long)cbSizes[iFile]);
+        CHECK((size_t)(p - pPak->pBase) % PAK_ALIGN == 0, "%s starts at %lu, off the %d-byte alignment",
+            pszNames[iFile], (unsigned long)(p - pPak->pBase), PAK_ALIGN);
+        CHECK((size_t)(p - pPak->pBase) >= PAK_HEADER_SIZE + (size_t)CHECK_FILES * PAK_ENTRY_SIZE,
+            "%s overlaps the index", pszNames[iFile]);
+        for (i = 0, bSame = 1; i < cb && i < cbSizes[iFile]; i++)
+            bSame &= p[i] == FileByte(iFile, i);
+        CHECK(bSame, "%s does not hold what was written", pszNames[iFile]);
+
+        for (bUpper = 0; bUpper < 2; bUpper++)
+        {
+            ChangeCase(szName, pszNames[iFile], bUpper);
+            pCase = (const uint8_t*)PakFind(pPak, szName, &cbCase);
+            CHECK(pCase == p && cbCase == cb, "%s not found as %s", pszNames[iFile], szName);
+        }
+
+        // Near misses: a name cut short or run on
+        strcpy(szName, pszNames[iFile]);
+        szName[strlen(szName) - 1] = '\0';
+        CHECK(!PakFind(pPak, szName, NULL), "%s found as %s", pszNames[iFile], szName);
+        strcpy(szName, pszNames[iFile]);
+        strcat(szName, "x");
+        CHECK(!PakFind(pPak, szName, NULL), "%s found as %s", pszNames[iFile], szName);
+    }
+    CHECK(!PakFind(pPak, "Dogica.ttf", NULL), "a missing name was found");
+    CHECK(!PakFind(pPak, "", NULL), "an empty name was found");
+
+    // Assets back to back, the index then the data, and nothing after
+    p = (const uint8_t*)PakFind(pPak, pszNames[CHECK_FILES - 1], &cb);
+    CHECK(p && (size_t)(p - pPak->pBase) + cb == pPak->cbSize, "%lu bytes after the last asset",
+        p ? (unsigned long)(pPak->cbSize - (size_t)(p - pPak->pBase) - cb) : 0ul);
+}
+
+static void CheckBroken(const uint8_t* pImage, size_t cbImage)
+{
+    size_t cb, iEntry, iLast = PAK_HEADER_SIZE + (size_t)(CHECK_FILES - 1) * PAK_ENTRY_SIZE + PAK_NAME_MAX;
+    uint32_t dwOffset;
+    int bOpened;
+
+    CHECK(OpenPatched(pImage, cbImage, cbImage, 0) == 1, "the unpatched copy did not open");
+
+    for (cb = 0; cb < PAK_HEADER_SIZE; cb++)
+        CHECK(OpenPatched(pImage, cb, cb, 0) == 0, "a header cut to %lu bytes opened", (unsigned long)cb);
+    CHECK(OpenPatched(pImage, cbImage, 0, 0x4B415058) == 0, "a bad magic opened");       // "XPAK"
+    CHECK(OpenPatched(pImage, cbImage, 4, PAK_VERSION + 1) == 0, "version %d opened", PAK_VERSION + 1);
+
+    // An index that does not fit, a count past the image, and data one byte short
+    CHECK(OpenPatched(pImage, PAK_HEADER_SIZE + CHECK_FILES * PAK_ENTRY_SIZE - 1, cbImage, 0) == 0,
+        "a truncated index opened");
+    CHECK(OpenPatched(pImage, cbImage, 8, 0xFFFFFFFF) == 0, "an entry count of 0xFFFFFFFF opened");
+    CHECK(OpenPatched(pImage, cbImage - 1, cbImage, 0) == 0, "an image one byte short opened");
+
+    // Offsets and sizes past the end, including ones that wrap in 32 bits
+    for (iEntry = 0; iEntry < CHECK_FILES; iEntry++)
+    {
+        size_t iOffset = PAK_HEADER_SIZE + iEntry * PAK_ENTRY_SIZE + PAK_NAME_MAX;
+
+        CHECK(OpenPatched(pImage, cbImage, iOffset, (uint32_t)cbImage + 1) == 0,
+            "entry %lu with an offset past the end opened", (unsigned long)iEntry);
+        CHECK(OpenPatched(pImage, cbImage, iOffset, 0xFFFFFFF0) == 0,
+            "entry %lu with an offset of 0xFFFFFFF0 opened", (unsigned long)iEntry);
+        CHECK(OpenPatched(pImage, cbImage, iOffset + 4, (uint32_t)cbImage) == 0,
+            "entry %lu with a size of the whole image opened", (unsigned long)iEntry);
+        CHECK(OpenPatched(pImage, cbImage, iOffset + 4, 0xFFFFFFFF) == 0,
+            "entry %lu with a size of 0xFFFFFFFF opened", (unsigned long)iEntry);
+    }
+
+    // The last asset runs to the very end: one byte more must be refused,
+    // and an empty asset right at the end is fine
+    dwOffset = (uint32_t)(cbImage - cbSizes[CHECK_FILES - 1]);
+    CHECK(OpenPatched(pImage, cbImage, iLast, dwOffset + 1) == 0, "the last asset one byte past the end opened");
+    CHECK(OpenPatched(pImage, cbImage, iLast + 4, (uint32_t)cbSizes[CHECK_FILES - 1] + 1) == 0,
+        "the last asset one byte too long opened");
+    bOpened = OpenPatched(pImage, cbImage, PAK_HEADER_SIZE + PAK_NAME_MAX, (uint32_t)cbImage);
+    CHECK(bOpened == 1, "an empty asset at the very end was refused");
+}
+
+static void CheckEmptyPack(const char* pszDir)
+{
+    char szPak[PATH_CHARS];
+    PAKFILE pak;
+    uint8_t* p;
+    size_t cb = 0;
+
+    JoinPath(szPak, pszDir, "clockpak-empty.pak");
+    CHECK(PakWriteFile(szPak, NULL, 0), "could not write an empty pack");
+    p = ReadBytes(szPak, &cb);
+    CHECK(p && cb == PAK_HEADER_SIZE, "an empty pack is %lu bytes, not %d", (unsigned long)cb, PAK_HEADER_SIZE);
+    CHECK(p && PakOpenMemory(&pak, p, cb) && pak.dwCount == 0 && !PakFind(&pak, pszNames[0], NULL),
+        "an empty pack did not open empty");
+    free(p);
+    remove(szPak);
+}
+
+static void CheckRoundTrip(const char* pszDir)
+{
+    char szPaths[CHECK_FILES][PATH_CHARS], szPak[PATH_CHARS], szOut[PATH_CHARS], szLong[PAK_NAME_MAX + 1];
+    const char* pszFiles[CHECK_FILES + 1];
+    uint8_t* p;
+    PAKFILE pak;
+    size_t cb, i;
+    int iFile;
+
+    for (iFile = 0; iFile < CHECK_FILES; iFile++)
+    {
+        p = (uint8_t*)malloc(cbSizes[iFile] ? cbSizes[iFile] : 1);
+        if (!p)
+        {
+            CHECK(0, "out of memory");
+            return;
+        }
+        for (i = 0; i < cbSizes[iFile]; i++)
+            p[i] = FileByte(iFile, i);
+        JoinPath(szPaths[iFile], pszDir, pszNames[iFile]);
+        pszFiles[iFile] = szPaths[iFile];
+        CHECK(WriteBytes(szPaths[iFile], p, cbSizes[iFile]), "could not write %s", szPaths[iFile]);
+        free(p);
+    }
+
+    JoinPath(szPak, pszDir, "clockpak.pak");
+    p = NULL;
+    if (PakWriteFile(szPak, pszFiles, CHECK_FILES) && (p = ReadBytes(szPak, &cb)) != NULL)
+    {
+        if (PakOpenMemory(&pak, p, cb))
+            CheckFind(&pak);
+        else
+            CHECK(0, "%s did not open", szPak);
+        CheckBroken(p, cb);
+    }
+    else
+        CHECK(0, "could not write and read back %s", szPak);
+    free(p);
+
+    // A name too long for the index, or a file that is not there
+    memset(szLong, 'n', PAK_NAME_MAX);
+    szLong[PAK_NAME_MAX] = '\0';
+    JoinPath(szPak, pszDir, szLong);
+    pszFiles[CHECK_FILES] = szPak;
+    if (WriteBytes(szPak, (const uint8_t*)"x", 1))
+    {
+        JoinPath(szOut, pszDir, "clockpak-long.pak");
+        CHECK(!PakWriteFile(szOut, pszFiles + CHECK_FILES, 1), "a %d-character name was packed", PAK_NAME_MAX);
+        remove(szPak);
+        remove(szOut);
+    }
+    JoinPath(szOut, pszDir, "clockpak-missing.pak");
+    CHECK(!PakWriteFile(szOut, pszFiles + CHECK_FILES, 1), "a missing file was packed");
+    remove(szOut);
+
+    for (iFile = 0; iFile < CHECK_FILES; iFile++)
+        remove(szPaths[iFile]);
+    JoinPath(szPak, pszDir, "clockpak.pak");
+    remove(szPak);
+}
+
+static int Check(int argc, char* argv[])
+{
+    const char* pszDir = argc > 0 ? argv[0] : ".";
+
+    CheckRoundTrip(pszDir);
+    CheckEmptyPack(pszDir);
+
+    return CheckResult();
+}
+
+int main(int argc, char* argv[])
+{
+    return CheckMain(argc, argv, Check, "[DIR]", NULL, NULL);
+}
@@ -0,0 +1,224 @@
+/*--------------------------
+    CLOCKPOLICY.C -- Checks the render policy against a fake clock
+
+    Usage: clockpolicy check
+
+    Drives the policy with fake wall and CPU clocks through minimizing,
+    covering and locking in every overlap, released in every order: only
+    the first reason set and the last cleared may change visibility, and
+    the repaint comes exactly once, after the last. It checks which of
+    RUN, AUDIO_ONLY and SUSPENDED each state picks, with and without the
+    tick sound kept, including turning the sound on while locked. Wake-ups
+    and CPU time per hour are checked for both states over hours of fake
+    time, finished stretches and the one in progress alike.
+---------------------------*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "renderpolicy.h"
+#include "clockcheck.h"
+
+#define NS_PER_SEC 1000000000ULL
+#define NS_PER_MS 1000000ULL
+
+// Wall time in qwNow and CPU time in qwCpu, moved on by hand
+static void StartPolicy(RENDERPOLICY* pPolicy, FAKECLOCK* pFake, int bKeepAudio)
+{
+    POLICYCLOCK clock;
+
+    // Far from 0, so a stretch measured from 0 would show
+    FakeStart(pFake, 1000 * 3600 * NS_PER_SEC, 0);
+    pFake->qwCpu = 77 * NS_PER_SEC;
+    clock.pfnWallNs = FakeNow;
+    clock.pfnCpuNs = FakeCpu;
+    clock.pCtx = pFake;
+    RenderPolicyInit(pPolicy, &clock, bKeepAudio);
+}
+
+// Sets the three reasons in one order and clears them in another
+static void CheckOverlap(const uint32_t dwSet[3], const uint32_t dwClear[3])
+{
+    RENDERPOLICY policy;
+    FAKECLOCK fake;
+    int i, bChanged;
+
+    StartPolicy(&policy, &fake, 0);
+    CHECK(RenderPolicyVisible(&policy) && RenderPolicyMode(&policy) == POLICY_RUN, "not running at the start");
+    CHECK(!RenderPolicyTakeRepaint(&policy), "a repaint before anything was hidden");
+
+    for (i = 0; i < 3; i++)
+    {
+        bChanged = RenderPolicySet(&policy, dwSet[i], 1);
+        CHECK(bChanged == (i == 0), "setting reason %lx as number %d returned %d", (unsigned long)dwSet[i], i + 1,
+            bChanged);
+        CHECK(!RenderPolicyVisible(&policy), "visible with reason %lx set", (unsigned long)dwSet[i]);
+        CHECK(!RenderPolicySet(&policy, dwSet[i], 1), "setting reason %lx twice changed something",
+            (unsigned long)dwSet[i]);
+    }
+    CHECK(policy.dwHidden == (POLICY_MINIMIZED | POLICY_OCCLUDED | POLICY_LOCKED), "reasons %lx after all three",
+        (unsigned long)policy.dwHidden);
+    CHECK(RenderPolicyMode(&policy) == POLICY_SUSPENDED, "not suspended with all three");
+
+    for (i = 0; i < 3; i++)
+    {
+        bChanged = RenderPolicySet(&policy, dwClear[i], 0);
+        CHECK(bChanged == (i == 2), "clearing reason %lx as number %d returned %d", (unsigned long)dwClear[i],
+            i + 1, bChanged);
+        CHECK(RenderPolicyVisible(&policy) == (i == 2), "visible is wrong after clearing %d reasons", i + 1);
+        CHECK(RenderPolicyTakeRepaint(&policy) == (i == 2), "repaint is wrong after clearing %d reasons", i + 1);
+        CHECK(!RenderPolicySet(&policy, dwClear[i], 0), "clearing reason %lx twice changed something",
+            (unsigned long)dwClear[i]);
+    }
+    CHECK(!RenderPolicyTakeRepaint(&policy), "the repaint came twice");
+    CHECK(RenderPolicyMode(&policy) == POLICY_RUN, "not running once visible again");
+    CHECK(policy.dwHides == 1, "%lu hides counted for one", (unsigned long)policy.dwHides);
+}
+
+static void CheckOrders(void)
+{
+    static const int iOrders[6][3] = { { 0, 1, 2 }, { 0, 2, 1 }, { 1, 0, 2 }, { 1, 2, 0 }, { 2, 0, 1 }, { 2, 1, 0 } };
+    static const uint32_t dwReasons[3] = { POLICY_MINIMIZED, POLICY_OCCLUDED, POLICY_LOCKED };
+    uint32_t dwSet[3], dwClear[3];
+    int i, j, k;
+
+    for (i = 0; i < 6; i++)
+    {
+        for (j = 0; j < 6; j++)
+        {
+            for (k = 0; k < 3; k++)
+            {
+                dwSet[k] = dwReasons[iOrders[i][k]];
+                dwClear[k] = dwReasons[iOrders[j][k]];
+            }
+            CheckOverlap(dwSet, dwClear);
+        }
+    }
+}
+
+static void CheckModes(void)
+{
+    RENDERPOLICY policy;
+    FAKECLOCK fake;
+
+    // Without the sound kept, any reason stops the timer
+    StartPolicy(&policy, &fake, 0);
+    RenderPolicySet(&policy, POLICY_MINIMIZED, 1);
+    CHECK(RenderPolicyMode(&policy) == POLICY_SUSPENDED, "minimized without sound not suspended");
+    RenderPolicySet(&policy, POLICY_MINIMIZED, 0);
+    RenderPolicySet(&policy, POLICY_OCCLUDED, 1);
+    CHECK(RenderPolicyMode(&policy) == POLICY_SUSPENDED, "covered without sound not suspended");
+    RenderPolicySet(&policy, POLICY_OCCLUDED, 0);
+    CHECK(RenderPolicyMode(&policy) == POLICY_RUN, "visible without sound not running");
+    CHECK(RenderPolicyTakeRepaint(&policy) && !RenderPolicyTakeRepaint(&policy), "no single repaint on restore");
+
+    // With it, minimized or covered still ticks, but a locked session never does
+    RenderPolicyKeepAudio(&policy, 1);
+    CHECK(RenderPolicyMode(&policy) == POLICY_RUN, "keeping the sound changed a visible window");
+    RenderPolicySet(&policy, POLICY_MINIMIZED, 1);
+    CHECK(RenderPolicyMode(&policy) == POLICY_AUDIO_ONLY, "minimized with sound not audio only");
+    RenderPolicySet(&policy, POLICY_OCCLUDED, 1);
+    CHECK(RenderPolicyMode(&policy) == POLICY_AUDIO_ONLY, "minimized and covered with sound not audio only");
+    RenderPolicySet(&policy, POLICY_LOCKED, 1);
+    CHECK(RenderPolicyMode(&policy) == POLICY_SUSPENDED, "locked with sound not suspended");
+    RenderPolicySet(&policy, POLICY_MINIMIZED, 0);
+    RenderPolicySet(&policy, POLICY_OCCLUDED, 0);
+    CHECK(RenderPolicyMode(&policy) == POLICY_SUSPENDED, "locked alone with sound not suspended");
+
+    // Turning the sound off and on while locked changes nothing
+    RenderPolicyKeepAudio(&policy, 0);
+    CHECK(RenderPolicyMode(&policy) == POLICY_SUSPENDED, "locked, sound off, not suspended");
+    RenderPolicyKeepAudio(&policy, 1);
+    CHECK(RenderPolicyMode(&policy) == POLICY_SUSPENDED, "sound turned on while locked woke the timer");
+
+    // Unlocked but still minimized, the sound comes back
+    RenderPolicySet(&policy, POLICY_MINIMIZED, 1);
+    RenderPolicySet(&policy, POLICY_LOCKED, 0);
+    CHECK(RenderPolicyMode(&policy) == POLICY_AUDIO_ONLY, "unlocked while minimized not audio only");
+    CHECK(!RenderPolicyTakeRepaint(&policy), "a repaint while still minimized");
+    RenderPolicyKeepAudio(&policy, 0);
+    CHECK(RenderPolicyMode(&policy) == POLICY_SUSPENDED, "sound turned off while minimized not suspended");
+    RenderPolicySet(&policy, POLICY_MINIMIZED, 0);
+    CHECK(RenderPolicyMode(&policy) == POLICY_RUN && RenderPolicyTakeRepaint(&policy), "not back on restore");
+}
+
+// Wakes once a second, or once a minute while hidden, for qwSeconds
+static void Run(RENDERPOLICY* pPolicy, FAKECLOCK* pFake, uint64_t qwSeconds, uint64_t qwCpuMs)
+{
+    uint64_t i, qwEvery = RenderPolicyVisible(pPolicy) ? 1 : 60;
+
+    for (i = 0; i < qwSeconds; i++)
+    {
+        pFake->qwNow += NS_PER_SEC;
+        if (i % qwEvery == 0)
+            RenderPolicyWake(pPolicy);
+    }
+    pFake->qwCpu += qwCpuMs * NS_PER_MS;
+}
+
+static void CheckCounters(void)
+{
+    RENDERPOLICY policy;
+    FAKECLOCK fake;
+    char buf[256];
+
+    StartPolicy(&policy, &fake, 0);
+
+    // Nothing to go on yet
+    CHECK(RenderPolicyWakeupsPerHour(&policy, 0) == 0 && RenderPolicyCpuMsPerHour(&policy, 0) == 0,
+        "rates before any time passed");
+    RenderPolicyWake(&policy);
+    fake.qwNow += NS_PER_SEC / 2;
+    CHECK(RenderPolicyWakeupsPerHour(&policy, 0) == 0, "a rate from half a second");
+    StartPolicy(&policy, &fake, 0);
+
+    // An hour visible at 500 ms CPU, then two hours hidden at 20 ms
+    Run(&policy, &fake, 3600, 500);
+    CHECK(RenderPolicyWakeupsPerHour(&policy, 0) == 3600, "%lu visible wakeups/h while visible, not 3600",
+        (unsigned long)RenderPolicyWakeupsPerHour(&policy, 0));
+    CHECK(RenderPolicyCpuMsPerHour(&policy, 0) == 500, "%lu visible ms/h while visible, not 500",
+        (unsigned long)RenderPolicyCpuMsPerHour(&policy, 0));
+    CHECK(RenderPolicyWakeupsPerHour(&policy, 1) == 0, "hidden wakeups before it was hidden");
+
+    RenderPolicySet(&policy, POLICY_MINIMIZED, 1);
+    Run(&policy, &fake, 7200, 20);
+    CHECK(RenderPolicyWakeupsPerHour(&policy, 1) == 60, "%lu hidden wakeups/h, not 60",
+        (unsigned long)RenderPolicyWakeupsPerHour(&policy, 1));
+    CHECK(RenderPolicyCpuMsPerHour(&policy, 1) == 10, "%lu hidden ms/h, not 10",
+        (unsigned long)RenderPolicyCpuMsPerHour(&policy, 1));
+    CHECK(RenderPolicyWakeupsPerHour(&policy, 0) == 3600 && RenderPolicyCpuMsPerHour(&policy, 0) == 500,
+        "the visible rates moved while hidden");
+
+    // Half an hour visible again counts with the first hour
+    RenderPolicySet(&policy, POLICY_MINIMIZED, 0);
+    Run(&policy, &fake, 1800, 250);
+    CHECK(RenderPolicyWakeupsPerHour(&policy, 0) == 3600, "%lu visible wakeups/h over 1.5 h, not 3600",
+        (unsigned long)RenderPolicyWakeupsPerHour(&policy, 0));
+    CHECK(RenderPolicyCpuMsPerHour(&policy, 0) == 500, "%lu visible ms/h over 1.5 h, not 500",
+        (unsigned long)RenderPolicyCpuMsPerHour(&policy, 0));
+    CHECK(RenderPolicyWakeupsPerHour(&policy, 1) == 60 && RenderPolicyCpuMsPerHour(&policy, 1) == 10,
+        "the hidden rates moved once visible");
+    CHECK(policy.qwWallNs[0] == 3600 * NS_PER_SEC && policy.qwWallNs[1] == 7200 * NS_PER_SEC,
+        "finished stretches %llu s visible, %llu s hidden", (unsigned long long)(policy.qwWallNs[0] / NS_PER_SEC),
+        (unsigned long long)(policy.qwWallNs[1] / NS_PER_SEC));
+
+    RenderPolicyFormat(&policy, buf, sizeof(buf));
+    CHECK(strstr(buf, "visible 5400s") && strstr(buf, "hidden 7200s (1 times)"), "summary %s", buf);
+}
+
+static int Check(int argc, char* argv[])
+{
+    (void)argc;
+    (void)argv;
+
+    CheckOrders();
+    CheckModes();
+    CheckCounters();
+
+    return CheckResult();
+}
+
+int main(int argc, char* argv[])
+{
+    return CheckMain(argc, argv, Check, "", NULL, NULL);
+}
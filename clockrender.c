@@ -0,0 +1,147 @@
+/*--------------------------
+    CLOCKRENDER.C -- Renders one clock frame headlessly to PNG or PPM
+
+    Usage: clockrender out.png WIDTH HEIGHT HH:MM:SS [dark] [roman] [light] [nodots] [atlas]
+                       [frames=N] [phases=timing.csv|timing.json] [tiles=N] [aa]
+
+    With "atlas" the output is the numeral atlas for that size and style
+    instead of the clock. "frames=N" renders N frames a second apart and
+    "phases=" writes their per-phase timing histograms. "tiles=N" draws
+    the frame in tiles on N threads (0 for every processor); the pixels
+    are the same. "aa" draws dots and hands anti-aliased, on one thread.
+---------------------------*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "raster.h"
+#include "damage.h"
+#include "phasetime.h"
+#include "rastertile.h"
+
+// Packs the numerals at the pixel height a cx by cy client would use
+static int DrawAtlas(FRAMEBUFFER* pFb, const CLOCKSTYLE* pStyle, int cx, int cy)
+{
+    GLYPHATLAS atlas;
+    GLYPHSOURCE source;
+    RASTERFONT font;
+    int iHeight = (pStyle->bUseLightFont ? CLOCK_LIGHT_TEXT_HEIGHT : CLOCK_HEAVY_TEXT_HEIGHT) *
+        IsoScale(cx, cy) / ISO_WINDOW_EXT;
+
+    font.pFb = pFb;
+    font.iHeight = iHeight;
+    RasterGlyphSource(&source, &font);
+
+    GlyphAtlasInit(&atlas, pStyle->bUseLightFont, iHeight, ClockBackground(pStyle));
+    GlyphAtlasAddNumerals(&atlas, ClockForeground(pStyle));
+    GlyphAtlasPack(&atlas, &source, 256 > cx ? 256 : cx);
+
+    if (!RasterCreate(pFb, atlas.cx, atlas.cy))
+        return 0;
+    RasterClear(pFb, atlas.bgColor);
+    GlyphAtlasRender(&atlas, &source);
+    return 1;
+}
+
+// Renders nFrames frames a second apart, timing the phases WM_PAINT has;
+// the last frame is left in pFb
+static void RenderTimed(FRAMEBUFFER* pFb, const CLOCKSTYLE* pStyle, int iHour, int iMinute, int iSecond,
+    int nFrames, int bAntiAlias, PHASESTATS* pStats)
+{
+    CLOCKBACKEND backend;
+    RASTERVIEW view;
+    uint64_t qwStart;
+    int i, iDay;
+
+    RasterViewInit(&view, pFb, 0, 0, pFb->cx, pFb->cy);
+    view.bAntiAlias = bAntiAlias;
+    RasterBackend(&backend, &view);
+
+    for (i = 0; i < nFrames; i++)
+    {
+        iDay = (iHour * 3600 + iMinute * 60 + iSecond + i) % 86400;
+
+        qwStart = PhaseNowNs();
+        RasterClear(pFb, ClockBackground(pStyle));
+        PhaseLap(pStats, PHASE_CLEAR, &qwStart);
+        ClockDrawDots(&backend, pStyle);
+        PhaseLap(pStats, PHASE_DOTS, &qwStart);
+        ClockDrawLabels(&backend, pStyle);
+        PhaseLap(pStats, PHASE_LABELS, &qwStart);
+        ClockDrawHands(&backend, pStyle, iDay / 3600, iDay / 60 % 60, iDay % 60, 1);
+        PhaseLap(pStats, PHASE_HANDS, &qwStart);
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    static PHASESTATS stats;
+    const char* pszPhases = NULL;
+    int nFrames = 1, nTileWorkers = -1;
+    FRAMEBUFFER fb;
+    CLOCKSTYLE style = { 0, 0, 0, 1 };
+    int cx, cy, iHour, iMinute, iSecond, i, bOk, bAtlas = 0, bAntiAlias = 0;
+    size_t cchPath;
+
+    if (argc < 5 || sscanf(argv[4], "%d:%d:%d", &iHour, &iMinute, &iSecond) != 3)
+    {
+        fprintf(stderr, "usage: %s <out.png|out.ppm> <width> <height> <HH:MM:SS> "
+            "[dark] [roman] [light] [nodots] [atlas] [frames=N] [phases=out.csv|out.json] [tiles=N] [aa]\n", argv[0]);
+        return 2;
+    }
+
+    for (i = 5; i < argc; i++)
+    {
+        if (strcmp(argv[i], "dark") == 0) style.bDarkMode = 1;
+        else if (strcmp(argv[i], "roman") == 0) style.bRomanMode = 1;
+        else if (strcmp(argv[i], "light") == 0) style.bUseLightFont = 1;
+        else if (strcmp(argv[i], "nodots") == 0) style.bShowDots = 0;
+        else if (strcmp(argv[i], "atlas") == 0) bAtlas = 1;
+        else if (strcmp(argv[i], "aa") == 0) bAntiAlias = 1;
+        else if (strncmp(argv[i], "frames=", 7) == 0) nFrames = atoi(argv[i] + 7);
+        else if (strncmp(argv[i], "phases=", 7) == 0) pszPhases = argv[i] + 7;
+        else if (strncmp(argv[i], "tiles=", 6) == 0) nTileWorkers = atoi(argv[i] + 6);
+    }
+
+    cx = atoi(argv[2]);
+    cy = atoi(argv[3]);
+    if (bAtlas ? !DrawAtlas(&fb, &style, cx, cy) : !RasterCreate(&fb, cx, cy))
+    {
+        fprintf(stderr, "%s: bad size %dx%d\n", argv[0], cx, cy);
+        return 1;
+    }
+
+    if (!bAtlas && (pszPhases || nFrames > 1 || bAntiAlias))
+        RenderTimed(&fb, &style, iHour, iMinute, iSecond, nFrames > 0 ? nFrames : 1, bAntiAlias, &stats);
+    else if (!bAtlas && nTileWorkers >= 0)
+    {
+        TILERENDER tiles;
+
+        if (!TileRenderInit(&tiles, nTileWorkers) ||
+            !TileRenderClock(&tiles, &fb, &style, iHour, iMinute, iSecond))
+        {
+            fprintf(stderr, "%s: could not start tiled rendering\n", argv[0]);
+            return 1;
+        }
+        TileRenderFree(&tiles);
+    }
+    else if (!bAtlas)
+        RasterDrawClock(&fb, &style, iHour, iMinute, iSecond);
+
+    if (pszPhases && !PhaseDumpFile(&stats, pszPhases))
+        fprintf(stderr, "%s: could not write %s\n", argv[0], pszPhases);
+
+    cchPath = strlen(argv[1]);
+    if (cchPath > 4 && strcmp(argv[1] + cchPath - 4, ".ppm") == 0)
+        bOk = RasterWritePPM(&fb, argv[1]);
+    else
+        bOk = RasterWritePNG(&fb, argv[1]);
+
+    RasterFree(&fb);
+    if (!bOk)
+    {
+        fprintf(stderr, "%s: could not write %s\n", argv[0], argv[1]);
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,136 @@
+/*--------------------------
+    CLOCKROTATE.C -- Checks the SIMD rotation paths against the plain C one
+
+    Usage: clockrotate check [SEED]
+
+    Rotates runs of 0 to CHECK_MAX_POINTS points, so every remainder the
+    four-point SSE2 and AVX2 loops leave for the scalar tail comes up, at
+    every tenth of a degree, from two starts a point apart so the loads
+    see both 8-byte alignments. RotatePoints must give exactly what
+    RotatePointsScalar gives and leave the points either side of the run
+    alone. The coordinates are random (SEED, 1 by default), at the corners
+    of the +/-ROT_MAX_COORD square, or within a few units of its edges,
+    where the Q16 products come closest to 32 bits. The scalar results
+    must also match the rotation worked out in double precision from the
+    same table entries. Build it with -mavx2 as well to check the AVX2
+    path.
+---------------------------*/
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include "rotate.h"
+#include "clockcheck.h"
+
+#define CHECK_MAX_POINTS 67         // sixteen four-point loops and a tail of three
+#define CHECK_GUARD 4               // untouched points either side of each run
+#define CHECK_GUARD_VALUE 0x5A5A5A5A
+
+enum { FILL_RANDOM, FILL_CORNERS, FILL_EDGES, FILL_KINDS };
+
+static const char* s_pszFill[FILL_KINDS] = { "random", "corner", "edge" };
+
+static int32_t RandomCoord(void)
+{
+    return rand() % (2 * ROT_MAX_COORD + 1) - ROT_MAX_COORD;
+}
+
+static void FillPoints(ROTPOINT pt[], int iNum, int iKind)
+{
+    int i;
+
+    for (i = 0; i < iNum; i++)
+    {
+        switch (iKind)
+        {
+        case FILL_CORNERS:
+            pt[i].x = (i & 1) ? -ROT_MAX_COORD : ROT_MAX_COORD;
+            pt[i].y = (i & 2) ? -ROT_MAX_COORD : ROT_MAX_COORD;
+            break;
+
+        case FILL_EDGES:
+            pt[i].x = (ROT_MAX_COORD - rand() % 4) * (rand() & 1 ? -1 : 1);
+            pt[i].y = i % 3 ? (ROT_MAX_COORD - rand() % 4) * (rand() & 1 ? -1 : 1) : RandomCoord();
+            break;
+
+        default:
+            pt[i].x = RandomCoord();
+            pt[i].y = RandomCoord();
+            break;
+        }
+    }
+}
+
+// What the Q16 rotation rounds to, without any 32-bit intermediate
+static int32_t RotateExact(int32_t a, int32_t b, int32_t lMulA, int32_t lMulB)
+{
+    return (int32_t)floor(((double)a * lMulA + (double)b * lMulB + ROT_Q16_ONE / 2) / ROT_Q16_ONE);
+}
+
+static void CheckRun(int iNum, int iOffset, int iKind, int iTenths)
+{
+    ROTPOINT in[CHECK_MAX_POINTS + 2 * CHECK_GUARD + 1];
+    ROTPOINT simd[CHECK_MAX_POINTS + 2 * CHECK_GUARD + 1];
+    ROTPOINT scalar[CHECK_MAX_POINTS + 2 * CHECK_GUARD + 1];
+    int32_t c = RotCosQ16(iTenths), s = RotSinQ16(iTenths);
+    int i, iFirst = CHECK_GUARD + iOffset, nTotal = CHECK_MAX_POINTS + 2 * CHECK_GUARD + 1;
+
+    for (i = 0; i < nTotal; i++)
+        in[i].x = in[i].y = CHECK_GUARD_VALUE;
+    FillPoints(in + iFirst, iNum, iKind);
+    for (i = 0; i < nTotal; i++)
+        simd[i] = scalar[i] = in[i];
+
+    RotatePoints(simd + iFirst, iNum, iTenths);
+    RotatePointsScalar(scalar + iFirst, iNum, iTenths);
+
+    for (i = 0; i < nTotal; i++)
+    {
+        if (i < iFirst || i >= iFirst + iNum)
+        {
+            if (simd[i].x != CHECK_GUARD_VALUE || simd[i].y != CHECK_GUARD_VALUE)
+            {
+                CHECK(0, "%d points at +%d, %d tenths: wrote to slot %d outside the run", iNum, iOffset, iTenths,
+                    i - iFirst);
+                return;
+            }
+        }
+        else if (simd[i].x != scalar[i].x || simd[i].y != scalar[i].y)
+        {
+            CHECK(0, "%s points, %d at +%d, %d tenths: point %d is (%ld,%ld), not (%ld,%ld)", s_pszFill[iKind],
+                iNum, iOffset, iTenths, i - iFirst, (long)simd[i].x, (long)simd[i].y, (long)scalar[i].x,
+                (long)scalar[i].y);
+            return;
+        }
+        else if (scalar[i].x != RotateExact(in[i].x, in[i].y, c, s) ||
+            scalar[i].y != RotateExact(in[i].y, in[i].x, c, -s))
+        {
+            CHECK(0, "%s point (%ld,%ld), %d tenths: (%ld,%ld), not (%ld,%ld)", s_pszFill[iKind], (long)in[i].x,
+                (long)in[i].y, iTenths, (long)scalar[i].x, (long)scalar[i].y,
+                (long)RotateExact(in[i].x, in[i].y, c, s), (long)RotateExact(in[i].y, in[i].x, c, -s));
+            return;
+        }
+    }
+}
+
+static int Check(int argc, char* argv[])
+{
+    int iNum, iOffset, iKind, iTenths;
+
+    srand(argc > 0 ? (unsigned int)strtoul(argv[0], NULL, 10) : 1);
+    InitRotateTable();
+    printf("Rotation: %s path against scalar, 0 to %d points\n", RotateKernelName(), CHECK_MAX_POINTS);
+
+    for (iNum = 0; iNum <= CHECK_MAX_POINTS; iNum++)
+        for (iOffset = 0; iOffset < 2; iOffset++)
+            for (iKind = 0; iKind < FILL_KINDS; iKind++)
+                for (iTenths = 0; iTenths < ROT_TABLE_SIZE; iTenths++)
+                    CheckRun(iNum, iOffset, iKind, iTenths);
+
+    return CheckResult();
+}
+
+int main(int argc, char* argv[])
+{
+    return CheckMain(argc, argv, Check, "[SEED]", NULL, NULL);
+}
@@ -0,0 +1,241 @@
+/*--------------------------
+    CLOCKSCHED.C -- Checks the tick scheduler against a fake clock
+
+    Usage: clocksched check [SEED]
+
+    Drives the scheduler with a fake microsecond clock. The delay to the
+    next boundary must round up to a whole millisecond, never short of the
+    boundary plus the guard and never a full millisecond past it. Timers
+    that fire a little early, even twice in a row, must re-arm without
+    showing a second again; a timer that fires seconds late must count the
+    seconds in between as skipped; a clock set back must show the second
+    it went back to without counting it skipped or measuring it. Ticks
+    placed on known microseconds must land in the expected histogram
+    buckets, open-ended bucket included. A long run of timers with random
+    jitter (SEED, 1 by default) must show every second exactly once.
+---------------------------*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "ticksched.h"
+#include "clockcheck.h"
+
+#define US_PER_SEC 1000000ULL
+#define GUARD_US 1000               // what CLOCK.c passes as TICK_GUARD_US
+#define RUN_TIMERS 20000
+
+// Microseconds in qwNow, moved on by hand
+static void StartSched(TICKSCHED* pSched, FAKECLOCK* pFake, uint64_t qwNowUs, uint32_t dwGuardUs)
+{
+    TICKCLOCK clock;
+
+    FakeStart(pFake, qwNowUs, 0);
+    clock.pfnNowUs = FakeNow;
+    clock.pCtx = pFake;
+    TickSchedInit(pSched, &clock, dwGuardUs);
+}
+
+// Fires the timer at qwNowUs; returns what TickSchedOnTimer said
+static int FireAt(TICKSCHED* pSched, FAKECLOCK* pFake, uint64_t qwNowUs, uint32_t* pdwNextMs)
+{
+    pFake->qwNow = qwNowUs;
+    return TickSchedOnTimer(pSched, pdwNextMs);
+}
+
+static void CheckDelay(void)
+{
+    static const struct { uint64_t qwNowUs; uint32_t dwGuardUs, dwMs; } cases[] =
+    {
+        { 5 * US_PER_SEC, GUARD_US, 1001 },             // on the boundary: the whole next second
+        { 5 * US_PER_SEC + 1, GUARD_US, 1001 },
+        { 5 * US_PER_SEC + 999000, GUARD_US, 2 },       // exact milliseconds are not rounded
+        { 5 * US_PER_SEC + 999001, GUARD_US, 2 },       // 1999 us up to 2 ms
+        { 5 * US_PER_SEC + 998999, GUARD_US, 3 },       // 2001 us up to 3 ms
+        { 5 * US_PER_SEC + 999999, GUARD_US, 2 },
+        { 5 * US_PER_SEC + 999999, 0, 1 },
+        { 5 * US_PER_SEC, 0, 1000 },
+        { 5 * US_PER_SEC + 500, 0, 1000 },
+        { 0, 0, 1000 },
+    };
+    TICKSCHED sched;
+    FAKECLOCK fake;
+    uint64_t qwNow, qwAim;
+    uint32_t dwMs, dwGuard;
+    size_t i;
+
+    for (i = 0; i < sizeof(cases) / sizeof(cases[0]); i++)
+    {
+        StartSched(&sched, &fake, cases[i].qwNowUs, cases[i].dwGuardUs);
+        dwMs = TickSchedNextDelayMs(&sched);
+        CHECK(dwMs == cases[i].dwMs, "%llu us with a %u us guard: %u ms, not %u", (unsigned long long)cases[i].qwNowUs,
+            cases[i].dwGuardUs, dwMs, cases[i].dwMs);
+    }
+
+    // Every phase of a second: at or past the aim, by less than a millisecond
+    for (dwGuard = 0; dwGuard <= 2500; dwGuard += 1250)
+    {
+        for (qwNow = 7 * US_PER_SEC; qwNow < 8 * US_PER_SEC; qwNow += 7)
+        {
+            StartSched(&sched, &fake, qwNow, dwGuard);
+            dwMs = TickSchedNextDelayMs(&sched);
+            qwAim = 8 * US_PER_SEC + dwGuard;
+            if (qwNow + dwMs * 1000ULL < qwAim || qwNow + dwMs * 1000ULL >= qwAim + 1000)
+            {
+                CHECK(0, "%llu us with a %u us guard: %u ms misses %llu", (unsigned long long)qwNow, dwGuard, dwMs,
+                    (unsigned long long)qwAim);
+                break;
+            }
+        }
+    }
+}
+
+static void CheckEarlyAndSkipped(void)
+{
+    TICKSCHED sched;
+    FAKECLOCK fake;
+    uint64_t qwBase = 1000 * US_PER_SEC;
+    uint32_t dwMs;
+
+    // The first tick shows its second but is not measured
+    StartSched(&sched, &fake, qwBase + 123456, GUARD_US);
+    CHECK(FireAt(&sched, &fake, qwBase + 123456, &dwMs) == 1, "the first timer showed nothing");
+    CHECK(sched.dwTicks == 0 && sched.dwMaxLateUs == 0, "the first tick was measured");
+    CHECK(dwMs == 878, "re-armed for %u ms after the first tick, not 878", dwMs);
+
+    // Early twice, then on time: the second is shown once
+    CHECK(FireAt(&sched, &fake, qwBase + 999000, &dwMs) == 0, "a timer 1 ms early showed the second again");
+    CHECK(dwMs == 2, "re-armed for %u ms after an early timer, not 2", dwMs);
+    CHECK(FireAt(&sched, &fake, qwBase + 999999, &dwMs) == 0, "a timer 1 us early showed the second again");
+    CHECK(dwMs == 2, "re-armed for %u ms after a second early timer, not 2", dwMs);
+    CHECK(sched.dwEarly == 2 && sched.dwTicks == 0, "%u early and %u ticks, not 2 and 0", sched.dwEarly,
+        sched.dwTicks);
+    CHECK(FireAt(&sched, &fake, qwBase + US_PER_SEC + 1500, &dwMs) == 1, "the next second was not shown");
+    CHECK(sched.llLastSecond == 1001 && sched.dwTicks == 1 && sched.dwSkipped == 0,
+        "second %lld, %u ticks, %u skipped after the early timers", (long long)sched.llLastSecond, sched.dwTicks,
+        sched.dwSkipped);
+    CHECK(FireAt(&sched, &fake, qwBase + US_PER_SEC + 1600, &dwMs) == 0, "a timer in the same second showed it again");
+
+    // Three seconds late: two never shown
+    CHECK(FireAt(&sched, &fake, qwBase + 4 * US_PER_SEC + 2000, &dwMs) == 1, "a late timer showed nothing");
+    CHECK(sched.dwSkipped == 2, "%u skipped, not 2", sched.dwSkipped);
+    CHECK(FireAt(&sched, &fake, qwBase + 5 * US_PER_SEC + 1000, &dwMs) == 1 && sched.dwSkipped == 2,
+        "the second after the skip was not shown, or counted %u skipped", sched.dwSkipped);
+
+    // Set back 1.5 s: the earlier second is shown, nothing skipped or measured
+    CHECK(FireAt(&sched, &fake, qwBase + 3 * US_PER_SEC + 501000, &dwMs) == 1,
+        "the second the clock went back to was not shown");
+    CHECK(sched.llLastSecond == 1003 && sched.dwSkipped == 2 && sched.dwTicks == 3 && sched.dwMaxLateUs == 2000,
+        "setting the clock back left second %lld, %u skipped, %u ticks, max %u us", (long long)sched.llLastSecond,
+        sched.dwSkipped, sched.dwTicks, sched.dwMaxLateUs);
+    CHECK(dwMs == 500, "re-armed for %u ms after the clock went back, not 500", dwMs);
+    CHECK(FireAt(&sched, &fake, qwBase + 3 * US_PER_SEC + 600000, &dwMs) == 0,
+        "a timer in the second the clock went back to showed it again");
+    CHECK(FireAt(&sched, &fake, qwBase + 4 * US_PER_SEC + 1000, &dwMs) == 1 && sched.dwSkipped == 2 &&
+        sched.dwTicks == 4, "the second after the clock went back: %u skipped, %u ticks", sched.dwSkipped,
+        sched.dwTicks);
+
+    // Back within the same second: an early wake-up, not a new second
+    CHECK(FireAt(&sched, &fake, qwBase + 4 * US_PER_SEC + 500, &dwMs) == 0, "a clock set back 500 us showed a tick");
+
+    // A timer stopped on purpose does not count its seconds as skipped
+    TickSchedResync(&sched);
+    CHECK(FireAt(&sched, &fake, qwBase + 3600 * US_PER_SEC + 777000, &dwMs) == 1 && sched.dwSkipped == 2 &&
+        sched.dwTicks == 4 && sched.dwMaxLateUs == 2000, "an hour after a resync: %u skipped, %u ticks, max %u us",
+        sched.dwSkipped, sched.dwTicks, sched.dwMaxLateUs);
+}
+
+static void CheckHistogram(void)
+{
+    // Lateness in us and the bucket each must land in
+    static const uint32_t dwLate[] = { 0, 999, 1000, 1999, 2500, 4999, 5000, 30999, 31000, 500000, 999999 };
+    static const uint32_t dwBucket[] = { 0, 0, 1, 1, 2, 4, 5, 30, 31, 31, 31 };
+    uint32_t hist[TICK_HIST_BUCKETS] = { 0 };
+    TICKSCHED sched;
+    FAKECLOCK fake;
+    uint64_t qwSecond = 50 * US_PER_SEC;
+    uint32_t dwMs, i;
+    char buf[512];
+
+    StartSched(&sched, &fake, qwSecond, GUARD_US);
+    FireAt(&sched, &fake, qwSecond, &dwMs);
+    for (i = 0; i < sizeof(dwLate) / sizeof(dwLate[0]); i++)
+    {
+        qwSecond += US_PER_SEC;
+        CHECK(FireAt(&sched, &fake, qwSecond + dwLate[i], &dwMs) == 1, "%u us late showed nothing", dwLate[i]);
+        hist[dwBucket[i]]++;
+    }
+    for (i = 0; i < TICK_HIST_BUCKETS; i++)
+        CHECK(sched.hist[i] == hist[i], "bucket %u holds %u, not %u", i, sched.hist[i], hist[i]);
+    CHECK(sched.dwTicks == 11 && sched.dwMaxLateUs == 999999 && sched.dwSkipped == 0,
+        "%u ticks, max %u us, %u skipped", sched.dwTicks, sched.dwMaxLateUs, sched.dwSkipped);
+
+    // Buckets 0..4 hold 6 of 11; a bound inside a bucket leaves it out
+    CHECK(TickSchedWithinPercent(&sched, 5000) == 54, "%u%% within 5 ms, not 54", TickSchedWithinPercent(&sched, 5000));
+    CHECK(TickSchedWithinPercent(&sched, 1000) == 18, "%u%% within 1 ms, not 18", TickSchedWithinPercent(&sched, 1000));
+    CHECK(TickSchedWithinPercent(&sched, 999) == 0, "%u%% within 999 us, not 0", TickSchedWithinPercent(&sched, 999));
+    CHECK(TickSchedWithinPercent(&sched, 60000000) == 72, "%u%% within a minute, not 72 (31+ is open-ended)",
+        TickSchedWithinPercent(&sched, 60000000));
+
+    TickSchedFormat(&sched, buf, sizeof(buf));
+    CHECK(strstr(buf, "11 ticks, 54% within 5 ms, max 999999 us late, 0 early, 0 skipped") != NULL &&
+        strstr(buf, "late ms: 0=2 1=2 2=1 4=1 5=1 30=1 31+=3") != NULL, "formatted as \"%s\"", buf);
+}
+
+// Timers that fire up to 1.5 ms early or 3 ms late, as a coarse timer
+// would; every second must be shown once, in order
+static void CheckRun(unsigned int uSeed)
+{
+    TICKSCHED sched;
+    FAKECLOCK fake;
+    uint64_t qwNow = 86400 * US_PER_SEC + 314159;
+    int64_t llShown, llFirst;
+    uint32_t dwMs, i, dwShown = 0;
+    int32_t lJitter;
+
+    srand(uSeed);
+    StartSched(&sched, &fake, qwNow, GUARD_US);
+    CHECK(FireAt(&sched, &fake, qwNow, &dwMs) == 1, "the first timer showed nothing");
+    llFirst = llShown = sched.llLastSecond;
+    for (i = 0; i < RUN_TIMERS; i++)
+    {
+        lJitter = rand() % 4501 - 1500;
+        qwNow += (uint64_t)((int64_t)dwMs * 1000 + lJitter);
+        if (FireAt(&sched, &fake, qwNow, &dwMs))
+        {
+            dwShown++;
+            if (sched.llLastSecond != llShown + 1)
+            {
+                CHECK(0, "second %lld shown after %lld", (long long)sched.llLastSecond, (long long)llShown);
+                break;
+            }
+            llShown = sched.llLastSecond;
+        }
+        else
+        {
+            CHECK(qwNow / US_PER_SEC == (uint64_t)llShown, "an early timer at %llu us held back second %lld",
+                (unsigned long long)qwNow, (long long)llShown);
+        }
+    }
+    CHECK(sched.dwTicks == dwShown && sched.dwTicks + sched.dwEarly == RUN_TIMERS,
+        "%u ticks and %u early of %d timers, %u shown", sched.dwTicks, sched.dwEarly, RUN_TIMERS, dwShown);
+    CHECK(sched.dwSkipped == 0 && (int64_t)dwShown == llShown - llFirst, "%u skipped over %u seconds shown",
+        sched.dwSkipped, dwShown);
+    CHECK(sched.dwEarly > 0 && sched.dwMaxLateUs <= GUARD_US + 1000 + 3000, "%u early, max %u us late",
+        sched.dwEarly, sched.dwMaxLateUs);
+}
+
+static int Check(int argc, char* argv[])
+{
+    CheckDelay();
+    CheckEarlyAndSkipped();
+    CheckHistogram();
+    CheckRun(argc > 0 ? (unsigned int)strtoul(argv[0], NULL, 10) : 1);
+
+    return CheckResult();
+}
+
+int main(int argc, char* argv[])
+{
+    return CheckMain(argc, argv, Check, "[SEED]", NULL, NULL);
+}
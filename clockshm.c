@@ -0,0 +1,419 @@
+/*--------------------------
+    CLOCKSHM.C -- Reference publisher, consumer and benchmark for the frame ring
+
+    Usage: clockshm publish [NAME] [WIDTH HEIGHT] [fps=N] [seconds=N] [slots=N]
+           clockshm watch [NAME] [frames=N] [save=FILE.png]
+           clockshm bench [WIDTH HEIGHT] [frames=N] [readers=N] [slots=N] [fps=N] [render]
+
+    POSIX only. "publish" draws the local time into the ring the way
+    CLOCK /publish does. "watch" maps a ring read-only and reports every
+    frame it sees with its time, damage and latency, reading the pixels in
+    place; "save=" writes the last intact frame straight from the mapping.
+    "bench" forks reader processes and publishes as fast as it can (or at
+    fps=N). Each frame is stamped with its number at both ends, and readers
+    check the stamps of every frame that passes FrameShmEndRead. It prints
+    publish throughput and per-reader latency from publish to read. It exits
+    1 if a reader accepts a torn frame or sees none.
+---------------------------*/
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <sched.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include "frameshm.h"
+#include "phasetime.h"
+
+#define SHM_MAX_READERS 16
+#define SHM_BENCH_NAME "ClockFramesBench"
+
+// What one bench reader saw, sent back to the parent through a pipe
+typedef struct
+{
+    uint32_t dwSeen;            // frames read intact
+    uint32_t dwSkipped;         // frames published while reading others
+    uint32_t dwLapped;          // views the publisher overwrote before EndRead
+    uint32_t dwTorn;            // intact by the seqlock but with wrong stamps
+    uint64_t qwP50Ns, qwP99Ns, qwMaxNs;
+} READERSTATS;
+
+static void SleepNs(uint64_t qwNs)
+{
+    struct timespec ts;
+
+    ts.tv_sec = (time_t)(qwNs / 1000000000);
+    ts.tv_nsec = (long)(qwNs % 1000000000);
+    nanosleep(&ts, NULL);
+}
+
+static void LocalFrameTime(FRAMETIME* pTime)
+{
+    struct timespec ts;
+    struct tm tm;
+
+    clock_gettime(CLOCK_REALTIME, &ts);
+    localtime_r(&ts.tv_sec, &tm);
+    pTime->wYear = (uint16_t)(tm.tm_year + 1900);
+    pTime->wMonth = (uint16_t)(tm.tm_mon + 1);
+    pTime->wDayOfWeek = (uint16_t)tm.tm_wday;
+    pTime->wDay = (uint16_t)tm.tm_mday;
+    pTime->wHour = (uint16_t)tm.tm_hour;
+    pTime->wMinute = (uint16_t)tm.tm_min;
+    pTime->wSecond = (uint16_t)tm.tm_sec;
+    pTime->wMilliseconds = (uint16_t)(ts.tv_nsec / 1000000);
+}
+
+// Grows *pDamage by the hands at *pTime, as CLOCK's AddHandDamage does
+static void AddHandDamage(DAMAGERECT* pDamage, const FRAMETIME* pTime, int bChange, int cx, int cy)
+{
+    ROTPOINT pt[3][CLOCK_HAND_POINTS];
+    DAMAGERECT rcHand;
+    int i;
+
+    ClockComputeHands(pTime->wHour, pTime->wMinute, pTime->wSecond, pt);
+    for (i = bChange ? 0 : 2; i < 3; i++)
+    {
+        DamageFromPolygon(&rcHand, pt[i], CLOCK_HAND_POINTS, cx, cy, 2);
+        DamageUnion(pDamage, &rcHand);
+    }
+}
+
+static int Publish(int argc, char* argv[])
+{
+    const char* pszName = FRAMESHM_DEFAULT_NAME;
+    CLOCKSTYLE style = { 0 };
+    FRAMETIME time, timePrev;
+    DAMAGERECT damage;
+    FRAMEBUFFER fb;
+    FRAMESHM shm;
+    double fps = 1, seconds = 0;
+    int cx = 512, cy = 512, nSlots = 4, i, bChange;
+    uint64_t qwStart, qwFrame = 0;
+
+    for (i = 0; i < argc; i++)
+    {
+        if (strncmp(argv[i], "fps=", 4) == 0)
+            fps = atof(argv[i] + 4);
+        else if (strncmp(argv[i], "seconds=", 8) == 0)
+            seconds = atof(argv[i] + 8);
+        else if (strncmp(argv[i], "slots=", 6) == 0)
+            nSlots = atoi(argv[i] + 6);
+        else if (i + 1 < argc && atoi(argv[i]) > 0 && atoi(argv[i + 1]) > 0)
+        {
+            cx = atoi(argv[i]);
+            cy = atoi(argv[++i]);
+        }
+        else
+            pszName = argv[i];
+    }
+    if (fps <= 0 || !FrameShmCreate(&shm, pszName, cx, cy, nSlots))
+    {
+        fprintf(stderr, "clockshm: cannot publish %dx%d in %d slots as %s\n", cx, cy, nSlots, pszName);
+        return 1;
+    }
+    printf("publishing %dx%d as %s, %d slots, %.1f fps\n", cx, cy, pszName, nSlots, fps);
+
+    style.bShowDots = 1;
+    qwStart = PhaseNowNs();
+    memset(&timePrev, 0, sizeof(timePrev));
+    for (qwFrame = 0; seconds <= 0 || qwFrame < seconds * fps; qwFrame++)
+    {
+        LocalFrameTime(&time);
+        bChange = time.wHour != timePrev.wHour || time.wMinute != timePrev.wMinute;
+
+        DamageEmpty(&damage);
+        AddHandDamage(&damage, &timePrev, bChange, cx, cy);
+        AddHandDamage(&damage, &time, bChange, cx, cy);
+        DamageClip(&damage, cx, cy);
+
+        FrameShmBeginWrite(&shm, &fb);
+        RasterDrawClock(&fb, &style, time.wHour, time.wMinute, time.wSecond);
+        FrameShmPublish(&shm, &time, qwFrame ? &damage : NULL);
+        timePrev = time;
+
+        if (PhaseNowNs() < qwStart + (uint64_t)((qwFrame + 1) * 1e9 / fps))
+            SleepNs(qwStart + (uint64_t)((qwFrame + 1) * 1e9 / fps) - PhaseNowNs());
+    }
+
+    FrameShmClose(&shm);
+    return 0;
+}
+
+// Sums the damaged pixels where they lie, as a consumer compositing them would
+static uint32_t SumDamage(const FRAMEVIEW* pView)
+{
+    const uint8_t* pRow;
+    uint32_t dwSum = 0;
+    int x, y;
+
+    for (y = pView->damage.top; y < pView->damage.bottom; y++)
+    {
+        pRow = pView->pPixels + ((size_t)y * pView->cx + pView->damage.left) * 4;
+        for (x = 0; x < (pView->damage.right - pView->damage.left) * 4; x++)
+            dwSum += pRow[x];
+    }
+    return dwSum;
+}
+
+static int Watch(int argc, char* argv[])
+{
+    const char* pszName = FRAMESHM_DEFAULT_NAME;
+    const char* pszSave = NULL;
+    FRAMESHM shm;
+    FRAMEVIEW view;
+    FRAMEBUFFER fb;
+    uint32_t dwLast = 0, dwSum;
+    long nFrames = 0, nSeen = 0;
+    int i, bSaved = 0;
+
+    for (i = 0; i < argc; i++)
+    {
+        if (strncmp(argv[i], "frames=", 7) == 0)
+            nFrames = atol(argv[i] + 7);
+        else if (strncmp(argv[i], "save=", 5) == 0)
+            pszSave = argv[i] + 5;
+        else
+            pszName = argv[i];
+    }
+
+    while (!FrameShmOpen(&shm, pszName))
+        SleepNs(100000000);
+    printf("watching %s: %ux%u, %u slots\n", pszName, shm.pHeader->cx, shm.pHeader->cy, shm.pHeader->nSlots);
+
+    while (nFrames <= 0 || nSeen < nFrames)
+    {
+        if (FrameShmLatest(&shm) == dwLast || !FrameShmBeginRead(&shm, &view))
+        {
+            SleepNs(1000000);
+            continue;
+        }
+
+        dwSum = SumDamage(&view);
+        if (pszSave)
+        {
+            fb.cx = view.cx;
+            fb.cy = view.cy;
+            fb.pPixels = (uint8_t*)view.pPixels;
+            bSaved = RasterWritePNG(&fb, pszSave);
+        }
+        if (!FrameShmEndRead(&shm, &view))
+            continue;
+
+        printf("frame %u%s %02u:%02u:%02u.%03u damage %d,%d-%d,%d sum %u latency %.0f us\n", view.dwFrame,
+            dwLast && view.dwFrame != dwLast + 1 ? " (skipped some)" : "",
+            view.time.wHour, view.time.wMinute, view.time.wSecond, view.time.wMilliseconds,
+            view.damage.left, view.damage.top, view.damage.right, view.damage.bottom, dwSum,
+            (PhaseNowNs() - view.qwPublishNs) / 1e3);
+        fflush(stdout);
+        dwLast = view.dwFrame;
+        nSeen++;
+    }
+
+    FrameShmClose(&shm);
+    if (pszSave && !bSaved)
+    {
+        fprintf(stderr, "clockshm: cannot write %s\n", pszSave);
+        return 1;
+    }
+    return 0;
+}
+
+static int CompareU64(const void* p1, const void* p2)
+{
+    uint64_t a = *(const uint64_t*)p1, b = *(const uint64_t*)p2;
+
+    return a < b ? -1 : a > b;
+}
+
+static uint32_t LastStamp(const uint8_t* pPixels, int cx, int cy)
+{
+    uint32_t dw;
+
+    memcpy(&dw, pPixels + ((size_t)cx * cy - 1) * 4, 4);
+    return dw;
+}
+
+// Reads every frame it can until frame dwFrames is out
+static void BenchReader(uint32_t dwFrames, int fdOut)
+{
+    READERSTATS stats = { 0 };
+    FRAMESHM shm;
+    FRAMEVIEW view;
+    uint64_t* pLatency = (uint64_t*)malloc(sizeof(uint64_t) * dwFrames);
+    uint64_t qwNow;
+    uint32_t dwLast = 0, dwFirst, dwEnd;
+
+    while (!FrameShmOpen(&shm, SHM_BENCH_NAME))
+        sched_yield();
+
+    while (pLatency && dwLast < dwFrames)
+    {
+        if (FrameShmLatest(&shm) == dwLast || !FrameShmBeginRead(&shm, &view))
+        {
+            sched_yield();
+            continue;
+        }
+        qwNow = PhaseNowNs();
+        memcpy(&dwFirst, view.pPixels, 4);
+        dwEnd = LastStamp(view.pPixels, view.cx, view.cy);
+        if (!FrameShmEndRead(&shm, &view))
+        {
+            stats.dwLapped++;
+            continue;
+        }
+
+        if (dwFirst != view.dwFrame || dwEnd != view.dwFrame)
+            stats.dwTorn++;
+        if (view.dwFrame > dwLast + 1)
+            stats.dwSkipped += view.dwFrame - dwLast - 1;
+        pLatency[stats.dwSeen++] = qwNow > view.qwPublishNs ? qwNow - view.qwPublishNs : 0;
+        dwLast = view.dwFrame;
+    }
+
+    if (stats.dwSeen)
+    {
+        qsort(pLatency, stats.dwSeen, sizeof(uint64_t), CompareU64);
+        stats.qwP50Ns = pLatency[(stats.dwSeen - 1) / 2];
+        stats.qwP99Ns = pLatency[(uint64_t)(stats.dwSeen - 1) * 99 / 100];
+        stats.qwMaxNs = pLatency[stats.dwSeen - 1];
+    }
+    free(pLatency);
+    FrameShmClose(&shm);
+    if (write(fdOut, &stats, sizeof(stats)) != (ssize_t)sizeof(stats))
+        _exit(1);
+    _exit(0);
+}
+
+static int Bench(int argc, char* argv[])
+{
+    static READERSTATS stats[SHM_MAX_READERS];
+    CLOCKSTYLE style = { 0 };
+    FRAMESHM shm;
+    FRAMEBUFFER fb;
+    FRAMETIME time;
+    pid_t pid[SHM_MAX_READERS];
+    int fd[SHM_MAX_READERS][2];
+    int cx = 800, cy = 600, nReaders = 2, nSlots = 4, bRender = 0, nFailed = 0, i;
+    uint32_t dwFrames = 10000, dwFrame, dwLast;
+    double fps = 0, sec;
+    uint64_t qwStart;
+
+    for (i = 0; i < argc; i++)
+    {
+        if (strncmp(argv[i], "frames=", 7) == 0)
+            dwFrames = (uint32_t)atol(argv[i] + 7);
+        else if (strncmp(argv[i], "readers=", 8) == 0)
+            nReaders = atoi(argv[i] + 8);
+        else if (strncmp(argv[i], "slots=", 6) == 0)
+            nSlots = atoi(argv[i] + 6);
+        else if (strncmp(argv[i], "fps=", 4) == 0)
+            fps = atof(argv[i] + 4);
+        else if (strcmp(argv[i], "render") == 0)
+            bRender = 1;
+        else if (i + 1 < argc && atoi(argv[i]) > 0 && atoi(argv[i + 1]) > 0)
+        {
+            cx = atoi(argv[i]);
+            cy = atoi(argv[++i]);
+        }
+        else
+        {
+            fprintf(stderr, "clockshm: unknown bench option %s\n", argv[i]);
+            return 2;
+        }
+    }
+    if (nReaders < 1 || nReaders > SHM_MAX_READERS || !dwFrames)
+    {
+        fprintf(stderr, "clockshm: readers must be 1..%d and frames at least 1\n", SHM_MAX_READERS);
+        return 2;
+    }
+
+    FrameShmRemove(SHM_BENCH_NAME);
+    if (!FrameShmCreate(&shm, SHM_BENCH_NAME, cx, cy, nSlots))
+    {
+        fprintf(stderr, "clockshm: cannot create a %dx%d ring of %d slots\n", cx, cy, nSlots);
+        return 1;
+    }
+
+    for (i = 0; i < nReaders; i++)
+    {
+        if (pipe(fd[i]) != 0 || (pid[i] = fork()) < 0)
+        {
+            fprintf(stderr, "clockshm: cannot start reader %d\n", i);
+            return 1;
+        }
+        if (pid[i] == 0)
+        {
+            close(fd[i][0]);
+            BenchReader(dwFrames, fd[i][1]);
+        }
+        close(fd[i][1]);
+    }
+
+    // Give the readers time to map the ring before the first frame
+    SleepNs(50000000);
+
+    style.bShowDots = 1;
+    LocalFrameTime(&time);
+    qwStart = PhaseNowNs();
+    for (dwFrame = 1; dwFrame <= dwFrames; dwFrame++)
+    {
+        FrameShmBeginWrite(&shm, &fb);
+        if (bRender)
+            RasterDrawClock(&fb, &style, time.wHour, time.wMinute, (time.wSecond + dwFrame) % 60);
+        memcpy(fb.pPixels, &dwFrame, 4);
+        memcpy(fb.pPixels + ((size_t)fb.cx * fb.cy - 1) * 4, &dwFrame, 4);
+        FrameShmPublish(&shm, &time, NULL);
+
+        if (fps > 0 && PhaseNowNs() < qwStart + (uint64_t)(dwFrame * 1e9 / fps))
+            SleepNs(qwStart + (uint64_t)(dwFrame * 1e9 / fps) - PhaseNowNs());
+        else if (fps <= 0)
+            sched_yield();
+    }
+    sec = (PhaseNowNs() - qwStart) / 1e9;
+
+    printf("%u frames of %dx%d in %d slots, %d readers%s: %.0f frames/s, %.2f us per frame\n",
+        dwFrames, cx, cy, nSlots, nReaders, bRender ? ", rendered" : "", dwFrames / sec, sec * 1e6 / dwFrames);
+    printf("%-8s %8s %8s %8s %8s %10s %10s %10s\n", "reader", "seen", "skipped", "lapped", "torn",
+        "p50 us", "p99 us", "max us");
+
+    for (i = 0; i < nReaders; i++)
+    {
+        if (read(fd[i][0], &stats[i], sizeof(stats[i])) != (ssize_t)sizeof(stats[i]))
+            memset(&stats[i], 0, sizeof(stats[i]));
+        close(fd[i][0]);
+        waitpid(pid[i], NULL, 0);
+
+        printf("%-8d %8u %8u %8u %8u %10.1f %10.1f %10.1f\n", i, stats[i].dwSeen, stats[i].dwSkipped,
+            stats[i].dwLapped, stats[i].dwTorn, stats[i].qwP50Ns / 1e3, stats[i].qwP99Ns / 1e3,
+            stats[i].qwMaxNs / 1e3);
+        if (!stats[i].dwSeen || stats[i].dwTorn)
+            nFailed++;
+    }
+
+    dwLast = FrameShmLatest(&shm);
+    FrameShmClose(&shm);
+    FrameShmRemove(SHM_BENCH_NAME);
+    if (dwLast != dwFrames)
+        nFailed++;
+    return nFailed ? 1 : 0;
+}
+
+int main(int argc, char* argv[])
+{
+    if (argc > 1 && strcmp(argv[1], "publish") == 0)
+        return Publish(argc - 2, argv + 2);
+    if (argc > 1 && strcmp(argv[1], "watch") == 0)
+        return Watch(argc - 2, argv + 2);
+    if (argc > 1 && strcmp(argv[1], "bench") == 0)
+        return Bench(argc - 2, argv + 2);
+
+    fprintf(stderr, "usage: %s publish [NAME] [WIDTH HEIGHT] [fps=N] [seconds=N] [slots=N]\n"
+        "       %s watch [NAME] [frames=N] [save=FILE.png]\n"
+        "       %s bench [WIDTH HEIGHT] [frames=N] [readers=N] [slots=N] [fps=N] [render]\n",
+        argv[0], argv[0], argv[0]);
+    return 2;
+}
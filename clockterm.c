@@ -0,0 +1,263 @@
+/*--------------------------
+    CLOCKTERM.C -- The clock on a text terminal, for headless consoles
+
+    Usage: clockterm [braille|half] [dark] [roman] [nodots] [COLS ROWS] [frames=N] [stats]
+           clockterm bench [braille|half] [COLS ROWS] [frames=N]
+
+    POSIX only. Draws the local time once a second into the terminal it
+    runs in, in braille dots (2x4 a cell, the default) or half blocks (1x2),
+    through the same isotropic mapping as the window. Only the cells that
+    changed since the last second are written, in one write() a tick. The
+    size follows the terminal unless COLS ROWS is given. "frames=N" stops
+    after N ticks, otherwise Ctrl+C does. "stats" keeps the bytes and time
+    of the last tick on the bottom row. Totals go to stderr at exit.
+
+    "bench" draws frames=N ticks (3600 by default) a second apart offline
+    and compares the bytes the diffs took with clearing and redrawing each
+    tick whole, and prints the draw and diff time a tick.
+---------------------------*/
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <signal.h>
+#include <time.h>
+#include <sys/ioctl.h>
+#include <unistd.h>
+#include "termdraw.h"
+#include "timesource.h"
+#include "phasetime.h"
+
+#define TERM_DEFAULT_COLS 80
+#define TERM_DEFAULT_ROWS 24
+#define TERM_RESYNC_NS 1000000000ULL
+#define TERM_JUMP_US 2000
+
+static volatile sig_atomic_t g_bStop;
+
+static void OnSignal(int iSignal)
+{
+    (void)iSignal;
+    g_bStop = 1;
+}
+
+// The terminal's size, then $COLUMNS and $LINES, then 80x24
+static void TerminalSize(int* pnCols, int* pnRows)
+{
+    struct winsize ws;
+    const char* psz;
+
+    if (ioctl(STDOUT_FILENO, TIOCGWINSZ, &ws) == 0 && ws.ws_col > 0 && ws.ws_row > 0)
+    {
+        *pnCols = ws.ws_col;
+        *pnRows = ws.ws_row;
+        return;
+    }
+    *pnCols = (psz = getenv("COLUMNS")) && atoi(psz) > 0 ? atoi(psz) : TERM_DEFAULT_COLS;
+    *pnRows = (psz = getenv("LINES")) && atoi(psz) > 0 ? atoi(psz) : TERM_DEFAULT_ROWS;
+}
+
+static int WriteAll(const char* p, size_t cb)
+{
+    ssize_t cbDone;
+
+    while (cb)
+    {
+        cbDone = write(STDOUT_FILENO, p, cb);
+        if (cbDone <= 0)
+            return 0;
+        p += cbDone;
+        cb -= (size_t)cbDone;
+    }
+    return 1;
+}
+
+// Sleeps to the next whole second of wall time; a signal ends it early
+static void SleepToSecond(int iMilliseconds)
+{
+    struct timespec ts;
+    long lNs = (1000 - iMilliseconds) * 1000000L;
+
+    ts.tv_sec = lNs / 1000000000;
+    ts.tv_nsec = lNs % 1000000000;
+    nanosleep(&ts, NULL);
+}
+
+// Options both modes take: the cell mode and the face toggles
+static int ParseOption(const char* psz, CLOCKSTYLE* pStyle, int* piMode)
+{
+    if (strcmp(psz, "braille") == 0)
+        *piMode = TERM_BRAILLE;
+    else if (strcmp(psz, "half") == 0)
+        *piMode = TERM_HALFBLOCK;
+    else if (strcmp(psz, "dark") == 0)
+        pStyle->bDarkMode = 1;
+    else if (strcmp(psz, "roman") == 0)
+        pStyle->bRomanMode = 1;
+    else if (strcmp(psz, "nodots") == 0)
+        pStyle->bShowDots = 0;
+    else
+        return 0;
+    return 1;
+}
+
+static int Run(int argc, char* argv[])
+{
+    CLOCKSTYLE style = { 0, 0, 0, 1 };
+    TERMSCREEN screen;
+    TIMESOURCE src;
+    TIMECLOCK clock;
+    WALLTIME now;
+    char szLine[160];
+    int iMode = TERM_BRAILLE, nCols = 0, nRows = 0, nWantCols, nWantRows, nFrames = -1, bStats = 0, bFixed = 0;
+    int i, iFrame;
+    size_t cbLast = 0;
+    uint64_t qwLastNs = 0, qwStart;
+
+    for (i = 0; i < argc; i++)
+    {
+        if (ParseOption(argv[i], &style, &iMode))
+            continue;
+        if (strncmp(argv[i], "frames=", 7) == 0)
+            nFrames = atoi(argv[i] + 7);
+        else if (strcmp(argv[i], "stats") == 0)
+            bStats = 1;
+        else if (i + 1 < argc && atoi(argv[i]) > 0 && atoi(argv[i + 1]) > 0)
+        {
+            nCols = atoi(argv[i]);
+            nRows = atoi(argv[++i]);
+            bFixed = 1;
+        }
+        else
+        {
+            fprintf(stderr, "clockterm: unknown option %s\n", argv[i]);
+            return 2;
+        }
+    }
+
+    signal(SIGINT, OnSignal);
+    signal(SIGTERM, OnSignal);
+    InitRotateTable();
+    TimeSourceSystemClock(&clock);
+    TimeSourceInit(&src, &clock, TERM_RESYNC_NS, TERM_JUMP_US);
+    screen.pCells = NULL;
+
+    for (iFrame = 0; !g_bStop && (nFrames < 0 || iFrame < nFrames); iFrame++)
+    {
+        // A resized terminal is cleared and drawn whole at the new size
+        nWantCols = nCols;
+        nWantRows = nRows;
+        if (!bFixed)
+            TerminalSize(&nWantCols, &nWantRows);
+        if (!screen.pCells || nWantCols != screen.nCols || nWantRows != screen.nRows)
+        {
+            if (screen.pCells)
+                TermScreenFree(&screen);
+            if (!TermScreenInit(&screen, nWantCols, nWantRows, iMode))
+            {
+                fprintf(stderr, "clockterm: out of memory for %dx%d\n", nWantCols, nWantRows);
+                return 1;
+            }
+            nCols = nWantCols;
+            nRows = nWantRows;
+        }
+
+        TimeSourceNow(&src, &now);
+        qwStart = PhaseNowNs();
+        TermDrawClock(&screen, &style, now.iHour, now.iMinute, now.iSecond, bStats);
+        if (bStats)
+        {
+            snprintf(szLine, sizeof(szLine), "%02d:%02d:%02d  last tick %lu bytes, %.1f us",
+                now.iHour, now.iMinute, now.iSecond, (unsigned long)cbLast, qwLastNs / 1000.0);
+            TermScreenText(&screen, nRows - 1, 0, szLine);
+        }
+        cbLast = TermScreenDiff(&screen);
+        qwLastNs = PhaseNowNs() - qwStart;
+        if (cbLast && !WriteAll(screen.pOut, cbLast))
+            break;
+
+        if (nFrames < 0 || iFrame + 1 < nFrames)
+        {
+            TimeSourceNow(&src, &now);
+            SleepToSecond(now.iMilliseconds);
+        }
+    }
+
+    // Leave the prompt below the clock, in the terminal's own colors
+    if (screen.pCells)
+    {
+        snprintf(szLine, sizeof(szLine), "\x1b[%d;1H%s\n", nRows, TermRestoreSequence());
+        WriteAll(szLine, strlen(szLine));
+        TermScreenFormat(&screen, szLine, sizeof(szLine));
+        fprintf(stderr, "%s\n", szLine);
+        TermScreenFree(&screen);
+    }
+    return 0;
+}
+
+static int Bench(int argc, char* argv[])
+{
+    CLOCKSTYLE style = { 0, 0, 0, 1 };
+    TERMSCREEN screen;
+    char szLine[200];
+    int iMode = TERM_BRAILLE, nCols = TERM_DEFAULT_COLS, nRows = TERM_DEFAULT_ROWS, nFrames = 3600;
+    int i, iFrame, iDay;
+    uint64_t qwDiffBytes, qwFullBytes;
+
+    for (i = 0; i < argc; i++)
+    {
+        if (ParseOption(argv[i], &style, &iMode))
+            continue;
+        if (strncmp(argv[i], "frames=", 7) == 0)
+            nFrames = atoi(argv[i] + 7);
+        else if (i + 1 < argc && atoi(argv[i]) > 0 && atoi(argv[i + 1]) > 0)
+        {
+            nCols = atoi(argv[i]);
+            nRows = atoi(argv[++i]);
+        }
+        else
+        {
+            fprintf(stderr, "clockterm: unknown option %s\n", argv[i]);
+            return 2;
+        }
+    }
+    if (nFrames < 1)
+        nFrames = 1;
+
+    InitRotateTable();
+    if (!TermScreenInit(&screen, nCols, nRows, iMode))
+    {
+        fprintf(stderr, "clockterm: out of memory for %dx%d\n", nCols, nRows);
+        return 1;
+    }
+
+    // 10:08:00 onward, so the hour and minute hands cross the numerals too
+    for (iFrame = 0; iFrame < nFrames; iFrame++)
+    {
+        iDay = (10 * 3600 + 8 * 60 + iFrame) % 86400;
+        TermDrawClock(&screen, &style, iDay / 3600, iDay / 60 % 60, iDay % 60, 0);
+        TermScreenDiff(&screen);
+    }
+    TermScreenFormat(&screen, szLine, sizeof(szLine));
+
+    // What redrawing the last tick whole would have taken
+    qwDiffBytes = screen.qwBytes;
+    TermScreenInvalidate(&screen);
+    qwFullBytes = TermScreenDiff(&screen);
+
+    printf("%s\n", szLine);
+    printf("Diff %.0f bytes a tick against %lu for a whole redraw (%.1f%%)\n",
+        (double)qwDiffBytes / nFrames, (unsigned long)qwFullBytes,
+        100.0 * qwDiffBytes / nFrames / (qwFullBytes ? qwFullBytes : 1));
+    TermScreenFree(&screen);
+    return 0;
+}
+
+int main(int argc, char* argv[])
+{
+    if (argc > 1 && strcmp(argv[1], "bench") == 0)
+        return Bench(argc - 2, argv + 2);
+    return Run(argc - 1, argv + 1);
+}
@@ -0,0 +1,319 @@
+/*--------------------------
+    CLOCKTIME.C -- Checks the cached local-time source against localtime_r, and times it
+
+    Usage: clocktime check [ZONE...]
+           clocktime bench [ZONE] [calls=N]
+
+    POSIX only. "check" sets TZ to each zone in turn (a list of awkward
+    ones by default) and drives a TIMESOURCE with fake counters through
+    every offset change from 2005 to 2035: three hours either side of
+    each, with fine steps around the change itself. It also sets the wall
+    clock forward and back under it, and tries random times from 1970 to
+    2037 on a fresh source. Every result must match localtime_r. A source
+    should look the zone up about once per transition. Exits 1 on any
+    mismatch.
+    "bench" prints the cost of one call for localtime_r on the current
+    time, the time source on the system clocks, and the time source
+    re-reading the wall clock on every call.
+---------------------------*/
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "timesource.h"
+#include "phasetime.h"
+
+#define SCAN_FROM 1104537600LL  // 2005-01-01
+#define SCAN_TO 2082758400LL    // 2036-01-01
+#define MAX_TRANSITIONS 256
+
+static const char* defaultZones[] = {
+    "UTC", "America/New_York", "America/Los_Angeles", "America/St_Johns", "America/Sao_Paulo",
+    "America/Santiago", "Europe/London", "Europe/Berlin", "Europe/Dublin", "Europe/Moscow",
+    "Africa/Casablanca", "Asia/Kolkata", "Asia/Kathmandu", "Asia/Tehran", "Australia/Sydney",
+    "Australia/Lord_Howe", "Pacific/Chatham", "Pacific/Apia", "Antarctica/Troll"
+};
+
+// Counters the check moves by hand
+typedef struct
+{
+    uint64_t qwSteadyNs;
+    int64_t llUtcUs;
+} FAKECLOCK;
+
+typedef struct
+{
+    long nChecked;
+    long nWrong;
+} CHECKRESULT;
+
+static uint64_t FakeSteadyNs(void* pCtx)
+{
+    return ((FAKECLOCK*)pCtx)->qwSteadyNs;
+}
+
+static int64_t FakeUtcUs(void* pCtx)
+{
+    return ((FAKECLOCK*)pCtx)->llUtcUs;
+}
+
+static void FakeAdvance(FAKECLOCK* pFake, int64_t llUs)
+{
+    pFake->qwSteadyNs += (uint64_t)llUs * 1000;
+    pFake->llUtcUs += llUs;
+}
+
+// Minutes the zone is ahead of UTC at t, from localtime_r and gmtime_r
+// wall-clock minutes only, so it does not share code with the source
+static int ZoneMinutes(time_t t)
+{
+    struct tm tmLocal, tmUtc;
+    int iDiff;
+
+    localtime_r(&t, &tmLocal);
+    gmtime_r(&t, &tmUtc);
+    iDiff = (tmLocal.tm_hour * 60 + tmLocal.tm_min) - (tmUtc.tm_hour * 60 + tmUtc.tm_min);
+    if (tmLocal.tm_yday != tmUtc.tm_yday)
+        iDiff += (tmLocal.tm_year > tmUtc.tm_year || (tmLocal.tm_year == tmUtc.tm_year &&
+            tmLocal.tm_yday > tmUtc.tm_yday)) ? 1440 : -1440;
+    return iDiff;
+}
+
+// UTC seconds at which the offset changes, to the second
+static int FindTransitions(int64_t* pllAt, int nMax)
+{
+    int64_t t, llLo, llHi, llMid;
+    int n = 0, iPrev = ZoneMinutes((time_t)SCAN_FROM);
+
+    for (t = SCAN_FROM + 3600; t < SCAN_TO && n < nMax; t += 3600)
+    {
+        if (ZoneMinutes((time_t)t) == iPrev)
+            continue;
+        for (llLo = t - 3600, llHi = t; llHi - llLo > 1; )
+        {
+            llMid = llLo + (llHi - llLo) / 2;
+            if (ZoneMinutes((time_t)llMid) == iPrev)
+                llLo = llMid;
+            else
+                llHi = llMid;
+        }
+        pllAt[n++] = llHi;
+        iPrev = ZoneMinutes((time_t)t);
+    }
+    return n;
+}
+
+static int64_t FloorSec(int64_t llUs)
+{
+    return llUs / 1000000 - (llUs % 1000000 < 0);
+}
+
+static void Compare(const char* pszZone, const WALLTIME* pTime, int64_t llUtcUs, CHECKRESULT* pResult)
+{
+    time_t t = (time_t)FloorSec(llUtcUs);
+    int iMs = (int)((llUtcUs - FloorSec(llUtcUs) * 1000000) / 1000);
+    struct tm tm;
+
+    localtime_r(&t, &tm);
+    pResult->nChecked++;
+    if (pTime->iYear == tm.tm_year + 1900 && pTime->iMonth == tm.tm_mon + 1 && pTime->iDay == tm.tm_mday &&
+        pTime->iDayOfWeek == tm.tm_wday && pTime->iHour == tm.tm_hour && pTime->iMinute == tm.tm_min &&
+        pTime->iSecond == tm.tm_sec && pTime->iMilliseconds == iMs)
+        return;
+
+    if (pResult->nWrong++ < 5)
+        printf("  %s at %lld.%06lld: got %04d-%02d-%02d (%d) %02d:%02d:%02d.%03d, "
+            "localtime_r %04d-%02d-%02d (%d) %02d:%02d:%02d.%03d\n",
+            pszZone, (long long)FloorSec(llUtcUs), (long long)(llUtcUs - FloorSec(llUtcUs) * 1000000),
+            pTime->iYear, pTime->iMonth, pTime->iDay, pTime->iDayOfWeek,
+            pTime->iHour, pTime->iMinute, pTime->iSecond, pTime->iMilliseconds,
+            tm.tm_year + 1900, tm.tm_mon + 1, tm.tm_mday, tm.tm_wday, tm.tm_hour, tm.tm_min, tm.tm_sec, iMs);
+}
+
+static void InitFake(TIMESOURCE* pSrc, FAKECLOCK* pFake, int64_t llUtcUs)
+{
+    TIMECLOCK clock;
+
+    TimeSourceSystemClock(&clock);
+    clock.pfnSteadyNs = FakeSteadyNs;
+    clock.pfnUtcUs = FakeUtcUs;
+    clock.pCtx = pFake;
+    pFake->qwSteadyNs = 1000000000;
+    pFake->llUtcUs = llUtcUs;
+    TimeSourceInit(pSrc, &clock, 1000000000, 1000);
+}
+
+// Three hours either side of a transition: coarse steps, then fine ones
+// across the change
+static void SweepTransition(const char* pszZone, int64_t llAt, CHECKRESULT* pResult, long* pnLookups)
+{
+    TIMESOURCE src;
+    FAKECLOCK fake;
+    WALLTIME wt;
+    int64_t llEndUs = (llAt + 3 * 3600) * 1000000LL;
+
+    InitFake(&src, &fake, (llAt - 3 * 3600) * 1000000LL + 123457);
+    while (fake.llUtcUs < llEndUs)
+    {
+        TimeSourceNow(&src, &wt);
+        Compare(pszZone, &wt, fake.llUtcUs, pResult);
+        FakeAdvance(&fake, fake.llUtcUs > (llAt - 5) * 1000000LL && fake.llUtcUs < (llAt + 5) * 1000000LL ?
+            249997 : 61700013);
+    }
+    *pnLookups += src.dwZoneLookups;
+    if (src.dwTransitions != 1 && pResult->nWrong++ < 5)
+        printf("  %s at %lld: %lu transitions seen instead of 1\n", pszZone, (long long)llAt,
+            (unsigned long)src.dwTransitions);
+}
+
+// The wall clock set under a running source must show within a resync
+static void CheckJump(const char* pszZone, int64_t llUtc, int64_t llJumpSec, CHECKRESULT* pResult)
+{
+    TIMESOURCE src;
+    FAKECLOCK fake;
+    WALLTIME wt;
+
+    InitFake(&src, &fake, llUtc * 1000000LL + 500000);
+    TimeSourceNow(&src, &wt);
+    fake.llUtcUs += llJumpSec * 1000000;
+    FakeAdvance(&fake, 1000000);
+    TimeSourceNow(&src, &wt);
+    Compare(pszZone, &wt, fake.llUtcUs, pResult);
+    if (src.dwJumps != 1 && pResult->nWrong++ < 5)
+        printf("  %s: a %lld s jump was not noticed\n", pszZone, (long long)llJumpSec);
+}
+
+static int CheckZone(const char* pszZone)
+{
+    static int64_t llAt[MAX_TRANSITIONS];
+    CHECKRESULT result = { 0, 0 };
+    TIMESOURCE src;
+    FAKECLOCK fake;
+    WALLTIME wt;
+    long nLookups = 0;
+    int i, n;
+
+    setenv("TZ", pszZone, 1);
+    tzset();
+    n = FindTransitions(llAt, MAX_TRANSITIONS);
+
+    for (i = 0; i < n; i++)
+    {
+        SweepTransition(pszZone, llAt[i], &result, &nLookups);
+        CheckJump(pszZone, llAt[i] - 1800, 3600, &result);
+        CheckJump(pszZone, llAt[i] + 1800, -3600, &result);
+    }
+    CheckJump(pszZone, SCAN_FROM, 86400 * 400, &result);
+
+    // Fresh sources at random times, for the calendar arithmetic
+    srand(12345);
+    for (i = 0; i < 2000; i++)
+    {
+        InitFake(&src, &fake, ((int64_t)rand() * 65537 % 2145916800) * 1000000 + rand() % 1000000);
+        TimeSourceNow(&src, &wt);
+        Compare(pszZone, &wt, fake.llUtcUs, &result);
+    }
+
+    printf("%-22s %4d transitions, %7ld times checked, %5.1f zone lookups per transition, %ld wrong\n",
+        pszZone, n, result.nChecked, n ? (double)nLookups / n : 0.0, result.nWrong);
+    return result.nWrong == 0;
+}
+
+static int Check(int argc, char* argv[])
+{
+    int i, nFailed = 0;
+
+    if (argc)
+    {
+        for (i = 0; i < argc; i++)
+            nFailed += !CheckZone(argv[i]);
+    }
+    else
+    {
+        for (i = 0; i < (int)(sizeof(defaultZones) / sizeof(defaultZones[0])); i++)
+            nFailed += !CheckZone(defaultZones[i]);
+    }
+    return nFailed ? 1 : 0;
+}
+
+static double BenchLocaltime(long nCalls)
+{
+    struct timespec ts;
+    struct tm tm;
+    uint64_t qwStart = PhaseNowNs();
+    long i, lSum = 0;
+
+    for (i = 0; i < nCalls; i++)
+    {
+        clock_gettime(CLOCK_REALTIME, &ts);
+        localtime_r(&ts.tv_sec, &tm);
+        lSum += tm.tm_sec;
+    }
+    if (lSum < 0)
+        printf(" ");
+    return (double)(PhaseNowNs() - qwStart) / nCalls;
+}
+
+static double BenchSource(long nCalls, uint64_t qwResyncNs, char* buf, size_t cb)
+{
+    TIMESOURCE src;
+    TIMECLOCK clock;
+    WALLTIME wt;
+    uint64_t qwStart;
+    long i, lSum = 0;
+
+    TimeSourceSystemClock(&clock);
+    TimeSourceInit(&src, &clock, qwResyncNs, 1000);
+    qwStart = PhaseNowNs();
+    for (i = 0; i < nCalls; i++)
+    {
+        TimeSourceNow(&src, &wt);
+        lSum += wt.iSecond;
+    }
+    qwStart = PhaseNowNs() - qwStart;
+    if (lSum < 0)
+        printf(" ");
+    TimeSourceFormat(&src, buf, cb);
+    return (double)qwStart / nCalls;
+}
+
+static int Bench(int argc, char* argv[])
+{
+    char buf[256];
+    long nCalls = 2000000;
+    int i;
+
+    for (i = 0; i < argc; i++)
+    {
+        if (strncmp(argv[i], "calls=", 6) == 0)
+            nCalls = atol(argv[i] + 6);
+        else
+        {
+            setenv("TZ", argv[i], 1);
+            tzset();
+        }
+    }
+    if (nCalls < 1)
+        return 2;
+
+    printf("%-34s %8.1f ns/call\n", "clock_gettime + localtime_r", BenchLocaltime(nCalls));
+    printf("%-34s %8.1f ns/call\n", "TimeSourceNow, resync every 1 s", BenchSource(nCalls, 1000000000, buf, sizeof(buf)));
+    printf("  %s\n", buf);
+    printf("%-34s %8.1f ns/call\n", "TimeSourceNow, resync every call", BenchSource(nCalls, 0, buf, sizeof(buf)));
+    printf("  %s\n", buf);
+    return 0;
+}
+
+int main(int argc, char* argv[])
+{
+    if (argc > 1 && strcmp(argv[1], "check") == 0)
+        return Check(argc - 2, argv + 2);
+    if (argc > 1 && strcmp(argv[1], "bench") == 0)
+        return Bench(argc - 2, argv + 2);
+
+    fprintf(stderr, "usage: %s check [ZONE...]\n       %s bench [ZONE] [calls=N]\n", argv[0], argv[0]);
+    return 2;
+}
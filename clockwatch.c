@@ -0,0 +1,483 @@
+/*--------------------------
+    CLOCKWATCH.C -- Checks the stopwatch against a fake counter, and times lap capture
+
+    Usage: clockwatch check [STEPS]
+           clockwatch bench [LAPS]
+
+    POSIX only. "check" drives a stopwatch from a fake counter through
+    STEPS random starts, stops and waits (20000 by default), from
+    nanoseconds to hours, and the elapsed time must match the sum of the
+    running spans to the nanosecond. It checks presses from before a start
+    or stop, lap numbers and splits, reset, the ring dropping the oldest
+    laps, the hands and readouts, the CSV export, and that a lap is in the
+    ring one counter reading after its press whether or not a reader is
+    copying laps on another thread. That reader checks every lap it copies
+    for tearing.
+    "bench" takes LAPS laps (1000000 by default) on the real counter,
+    alone and then with a reader thread copying the ring as fast as it can,
+    and prints the cost of a lap, press-to-stored latency and the cost of a
+    read. Exits 1 if the p99 latency with the reader passes BENCH_P99_NS.
+---------------------------*/
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <sched.h>
+#include "stopwatch.h"
+#include "sweep.h"
+#include "phasetime.h"
+#include "clockcheck.h"
+
+#define CHECK_BASE 0x0123456789ABCDEFULL    // far from 0, so nothing passes for a default
+#define CHECK_STEP 1000                     // fake counter moves per reading
+#define THREAD_LAPS 200000
+#define THREAD_YIELD_LAPS 4096           // laps between giving a single CPU to the reader
+#define BENCH_P99_NS 50000
+
+static uint64_t RealNowNs(void* pCtx)
+{
+    (void)pCtx;
+    return PhaseNowNs();
+}
+
+static uint64_t Random64(uint64_t qwRange)
+{
+    uint64_t qw = ((uint64_t)rand() << 42) ^ ((uint64_t)rand() << 21) ^ (uint64_t)rand();
+
+    return qw % qwRange;
+}
+
+// Nanoseconds to hours, so every digit of the counter is exercised
+static uint64_t RandomWait(void)
+{
+    static const uint64_t qwSpans[] = { 1000, 1000000, 1000000000, 3600000000000ULL };
+
+    return Random64(qwSpans[rand() % 4]);
+}
+
+// Nanoseconds moving on by qwStep every read; only the writer reads it
+static void StartWatch(STOPWATCH* pWatch, FAKECLOCK* pFake, uint64_t qwStep)
+{
+    WATCHCLOCK clock;
+
+    FakeStart(pFake, CHECK_BASE, qwStep);
+    clock.pfnNowNs = FakeNow;
+    clock.pCtx = pFake;
+    StopwatchInit(pWatch, &clock);
+}
+
+static void CheckElapsed(int nSteps)
+{
+    static STOPWATCH watch;
+    FAKECLOCK fake;
+    uint64_t qwExpect = 0, qwStart = 0, qwNow, qwGot;
+    int i;
+
+    StartWatch(&watch, &fake, 0);
+    srand(1);
+    for (i = 0; i < nSteps; i++)
+    {
+        fake.qwNow += RandomWait();
+        qwNow = fake.qwNow;
+        if (rand() % 2)
+        {
+            if (!watch.bRunning)
+                qwStart = qwNow;
+            StopwatchStart(&watch, qwNow);
+        }
+        else
+        {
+            if (watch.bRunning)
+                qwExpect += qwNow - qwStart;
+            StopwatchStop(&watch, qwNow);
+        }
+
+        qwNow += RandomWait();
+        qwGot = StopwatchElapsedNs(&watch, qwNow);
+        if (watch.bRunning)
+            CHECK(qwGot == qwExpect + (qwNow - qwStart), "step %d: running, %llu ns for %llu", i,
+                (unsigned long long)qwGot, (unsigned long long)(qwExpect + (qwNow - qwStart)));
+        else
+            CHECK(qwGot == qwExpect, "step %d: stopped, %llu ns for %llu", i, (unsigned long long)qwGot,
+                (unsigned long long)qwExpect);
+    }
+}
+
+static void CheckPresses(void)
+{
+    static STOPWATCH watch;
+    FAKECLOCK fake;
+
+    StartWatch(&watch, &fake, 0);
+    StopwatchStart(&watch, CHECK_BASE + 1000);
+    StopwatchStop(&watch, CHECK_BASE + 500);
+    CHECK(StopwatchElapsedNs(&watch, CHECK_BASE + 9000) == 0, "a stop pressed before the start counted");
+
+    StopwatchStart(&watch, CHECK_BASE + 2000);
+    StopwatchStop(&watch, CHECK_BASE + 5000);
+    StopwatchStart(&watch, CHECK_BASE + 4000);
+    CHECK(watch.qwStartNs == CHECK_BASE + 5000, "a start pressed before the stop was not held at it");
+    CHECK(StopwatchElapsedNs(&watch, CHECK_BASE + 6000) == 4000, "%llu ns after a late start",
+        (unsigned long long)StopwatchElapsedNs(&watch, CHECK_BASE + 6000));
+    CHECK(StopwatchElapsedNs(&watch, CHECK_BASE + 4500) == 3000, "elapsed went back for a time before the start");
+
+    // A press of 0 is now
+    fake.qwNow = CHECK_BASE + 7000;
+    StopwatchStop(&watch, 0);
+    CHECK(StopwatchElapsedNs(&watch, 0) == 5000, "a stop pressed at 0 was not now");
+    CHECK(watch.dwStarts == 3, "%lu starts counted, not 3", (unsigned long)watch.dwStarts);
+}
+
+static void CheckLaps(void)
+{
+    static STOPWATCH watch;
+    static LAP laps[LAP_RING_SLOTS + 8];
+    FAKECLOCK fake;
+    uint64_t qwPress = CHECK_BASE, qwSum;
+    uint32_t dwLap;
+    int i, n;
+
+    StartWatch(&watch, &fake, CHECK_STEP);
+    CHECK(StopwatchLap(&watch, 0) == 0, "a lap was taken while stopped");
+    StopwatchStart(&watch, qwPress);
+    for (i = 1; i <= 10; i++)
+    {
+        qwPress += 1000000 * i;
+        dwLap = StopwatchLap(&watch, qwPress);
+        CHECK(dwLap == (uint32_t)i, "lap %lu for the %dth", (unsigned long)dwLap, i);
+    }
+    n = LapRingRead(&watch.ring, 1, laps, LAP_RING_SLOTS);
+    CHECK(n == 10, "%d laps read of 10", n);
+    for (i = 0, qwSum = 0; i < n; i++)
+    {
+        qwSum += laps[i].qwSplitNs;
+        CHECK(laps[i].qwSplitNs == 1000000ULL * (i + 1), "lap %d split %llu", i + 1,
+            (unsigned long long)laps[i].qwSplitNs);
+        CHECK(laps[i].qwElapsedNs == qwSum, "lap %d elapsed %llu, splits to it %llu", i + 1,
+            (unsigned long long)laps[i].qwElapsedNs, (unsigned long long)qwSum);
+    }
+    n = LapRingRead(&watch.ring, 8, laps, LAP_RING_SLOTS);
+    CHECK(n == 3 && laps[0].dwLap == 8, "%d laps read from lap 8", n);
+    CHECK(LapRingRead(&watch.ring, 11, laps, LAP_RING_SLOTS) == 0, "a lap read past the last");
+    CHECK(LapRingRead(&watch.ring, 1, laps, 4) == 4, "nMax not kept to");
+
+    StopwatchReset(&watch);
+    CHECK(!watch.bRunning && StopwatchElapsedNs(&watch, fake.qwNow) == 0, "reset left time on the watch");
+    CHECK(LapRingRead(&watch.ring, 1, laps, LAP_RING_SLOTS) == 0, "laps read after a reset");
+    StopwatchStart(&watch, 0);
+    dwLap = StopwatchLap(&watch, 0);
+    CHECK(dwLap == 1, "lap %lu after a reset, not 1", (unsigned long)dwLap);
+
+    // More than the ring holds: the oldest go, the rest come back in order
+    for (i = 0; i < LAP_RING_SLOTS + 44; i++)
+        StopwatchLap(&watch, 0);
+    n = LapRingRead(&watch.ring, 1, laps, LAP_RING_SLOTS + 8);
+    CHECK(n == LAP_RING_SLOTS, "%d laps read from a full ring", n);
+    CHECK(laps[0].dwLap == 46 && laps[n - 1].dwLap == LAP_RING_SLOTS + 45, "laps %lu to %lu read from a full ring",
+        (unsigned long)laps[0].dwLap, (unsigned long)laps[n - 1].dwLap);
+    for (i = 1; i < n; i++)
+        CHECK(laps[i].dwLap == laps[i - 1].dwLap + 1 &&
+            laps[i].qwElapsedNs - laps[i - 1].qwElapsedNs == laps[i].qwSplitNs, "laps out of order at %d", i);
+}
+
+// Storing a lap pressed now reads the counter twice, so on a counter
+// that moves CHECK_STEP a reading the capture is exactly one step
+static void CheckCapture(void)
+{
+    static STOPWATCH watch;
+    static LAP lap;
+    FAKECLOCK fake;
+    uint64_t qwReads;
+    int i;
+
+    StartWatch(&watch, &fake, CHECK_STEP);
+    StopwatchStart(&watch, 0);
+    for (i = 0; i < 1000; i++)
+    {
+        qwReads = fake.qwReads;
+        StopwatchLap(&watch, 0);
+        CHECK(fake.qwReads - qwReads == 2, "lap %d read the counter %llu times", i,
+            (unsigned long long)(fake.qwReads - qwReads));
+    }
+    CHECK(watch.qwCaptureMaxNs == CHECK_STEP && watch.qwCaptureTotalNs == 1000ULL * CHECK_STEP,
+        "capture %llu ns max, %llu ns total for 1000 laps", (unsigned long long)watch.qwCaptureMaxNs,
+        (unsigned long long)watch.qwCaptureTotalNs);
+
+    // A press from the message queue is counted from when it happened
+    StopwatchLap(&watch, fake.qwNow - 250000);
+    LapRingRead(&watch.ring, 1001, &lap, 1);
+    CHECK(lap.qwStoredNs - lap.qwPressNs == 250000, "capture %llu ns for a press 250 us back",
+        (unsigned long long)(lap.qwStoredNs - lap.qwPressNs));
+}
+
+static void CheckHands(void)
+{
+    static const uint64_t qwCases[] = { 0, 999999, 1000000, 59999000000ULL, 60000000000ULL, 3599999000000ULL,
+        3600000000000ULL, 43199999000000ULL, 43200000000000ULL, 100000000123456ULL };
+    int iGot[3], iExpect[3];
+    uint64_t qwMs;
+    size_t i;
+
+    for (i = 0; i < sizeof(qwCases) / sizeof(qwCases[0]); i++)
+    {
+        qwMs = qwCases[i] / 1000000;
+        StopwatchHandAngles(qwCases[i], iGot);
+        SweepHandAngles(SWEEP_SMOOTH, (int)(qwMs / 3600000 % 12), (int)(qwMs / 60000 % 60),
+            (int)(qwMs / 1000 % 60), (int)(qwMs % 1000), iExpect);
+        CHECK(memcmp(iGot, iExpect, sizeof(iGot)) == 0, "hands at %llu ns: %d %d %d, not %d %d %d",
+            (unsigned long long)qwCases[i], iGot[0], iGot[1], iGot[2], iExpect[0], iExpect[1], iExpect[2]);
+    }
+    StopwatchHandAngles(0, iGot);
+    CHECK(iGot[0] == 0 && iGot[1] == 0 && iGot[2] == 0, "hands not at 12 at zero");
+}
+
+static void CheckFormat(void)
+{
+    static const struct { uint64_t qwNs; const char* psz; } cases[] =
+    {
+        { 0, "00:00.000" },
+        { 999999, "00:00.000" },
+        { 1234567890ULL, "00:01.234" },
+        { 3599999999999ULL, "59:59.999" },
+        { 3600000000000ULL, "1:00:00.000" },
+        { 45296789000000ULL, "12:34:56.789" },
+        { 363599999000000ULL, "100:59:59.999" },
+    };
+    char buf[32];
+    size_t i;
+
+    for (i = 0; i < sizeof(cases) / sizeof(cases[0]); i++)
+    {
+        StopwatchFormatElapsed(cases[i].qwNs, buf, sizeof(buf));
+        CHECK(strcmp(buf, cases[i].psz) == 0, "%llu ns shown as %s, not %s", (unsigned long long)cases[i].qwNs,
+            buf, cases[i].psz);
+    }
+}
+
+static void CheckCsv(void)
+{
+    static STOPWATCH watch;
+    FAKECLOCK fake;
+    char line[128];
+    FILE* fp;
+    int i, nLines = 0;
+
+    StartWatch(&watch, &fake, CHECK_STEP);
+    StopwatchStart(&watch, 0);
+    for (i = 0; i < 5; i++)
+    {
+        fake.qwNow += 1500000;
+        StopwatchLap(&watch, 0);
+    }
+    fp = tmpfile();
+    if (!fp)
+    {
+        CHECK(0, "no temporary file for the CSV");
+        return;
+    }
+    CHECK(StopwatchWriteCsv(&watch.ring, fp), "CSV write failed");
+    rewind(fp);
+    while (fgets(line, sizeof(line), fp))
+    {
+        if (nLines == 0)
+            CHECK(strcmp(line, "lap,split_ms,elapsed_ms,capture_us\n") == 0, "CSV header %s", line);
+        else if (nLines == 2)
+            CHECK(strcmp(line, "2,1.502000,3.003000,1.000\n") == 0, "CSV lap 2 %s", line);
+        nLines++;
+    }
+    fclose(fp);
+    CHECK(nLines == 6, "%d CSV lines for 5 laps", nLines);
+}
+
+// A reader copying laps while the writer takes them
+typedef struct
+{
+    const STOPWATCH* pWatch;
+    int bCheck;                 // the watch is not stopped or reset meanwhile
+    uint64_t qwStartNs;
+    volatile int bStarted;
+    volatile int bDone;
+    long nReads;
+    long nLaps;
+    long nTorn;
+    double dReadNs;
+} READER;
+
+static void* ReadLaps(void* pArg)
+{
+    static LAP laps[LAP_RING_SLOTS];
+    READER* pReader = (READER*)pArg;
+    uint64_t qwStart = PhaseNowNs();
+    int i, n, bDone;
+
+    __atomic_store_n(&pReader->bStarted, 1, __ATOMIC_RELEASE);
+    do
+    {
+        // One more whole read after the writer is done, so the last laps
+        // are always checked
+        bDone = __atomic_load_n(&pReader->bDone, __ATOMIC_ACQUIRE);
+        n = LapRingRead(&pReader->pWatch->ring, 1, laps, LAP_RING_SLOTS);
+        for (i = 0; i < n && pReader->bCheck; i++)
+        {
+            // Never stopped, so the elapsed time is the press less the start
+            if (laps[i].qwElapsedNs != laps[i].qwPressNs - pReader->qwStartNs ||
+                laps[i].dwLap != laps[i].dwIndex + 1 || laps[i].qwStoredNs < laps[i].qwPressNs ||
+                (i && (laps[i].dwLap != laps[i - 1].dwLap + 1 ||
+                laps[i].qwElapsedNs - laps[i - 1].qwElapsedNs != laps[i].qwSplitNs)))
+                pReader->nTorn++;
+        }
+        pReader->nReads++;
+        pReader->nLaps += n;
+    } while (!bDone);
+    pReader->dReadNs = pReader->nReads ? (double)(PhaseNowNs() - qwStart) / pReader->nReads : 0.0;
+    return NULL;
+}
+
+// Returns once the reader is running, so the writer cannot finish first
+static int StartReader(pthread_t* pThread, READER* pReader)
+{
+    if (pthread_create(pThread, NULL, ReadLaps, pReader) != 0)
+        return 0;
+    while (!__atomic_load_n(&pReader->bStarted, __ATOMIC_ACQUIRE))
+        sched_yield();
+    return 1;
+}
+
+static void CheckThreaded(void)
+{
+    static STOPWATCH watch;
+    FAKECLOCK fake;
+    READER reader;
+    pthread_t thread;
+    int i;
+
+    StartWatch(&watch, &fake, CHECK_STEP);
+    StopwatchStart(&watch, 0);
+    memset(&reader, 0, sizeof(reader));
+    reader.pWatch = &watch;
+    reader.bCheck = 1;
+    reader.qwStartNs = watch.qwStartNs;
+    if (!StartReader(&thread, &reader))
+    {
+        CHECK(0, "no reader thread");
+        return;
+    }
+    for (i = 0; i < THREAD_LAPS; i++)
+    {
+        StopwatchLap(&watch, 0);
+        if (i % THREAD_YIELD_LAPS == THREAD_YIELD_LAPS - 1)
+            sched_yield();
+    }
+    __atomic_store_n(&reader.bDone, 1, __ATOMIC_RELEASE);
+    pthread_join(thread, NULL);
+
+    CHECK(reader.nTorn == 0, "%ld torn laps of %ld read", reader.nTorn, reader.nLaps);
+    CHECK(reader.nReads > 0, "the reader never ran");
+    CHECK(watch.qwCaptureMaxNs == CHECK_STEP, "capture %llu ns with a reader, not %d",
+        (unsigned long long)watch.qwCaptureMaxNs, CHECK_STEP);
+    printf("  %ld reads copied %ld laps while %d were taken\n", reader.nReads, reader.nLaps, THREAD_LAPS);
+}
+
+static int Check(int argc, char* argv[])
+{
+    int nSteps = argc > 0 && atoi(argv[0]) > 0 ? atoi(argv[0]) : 20000;
+
+    CheckElapsed(nSteps);
+    CheckPresses();
+    CheckLaps();
+    CheckCapture();
+    CheckHands();
+    CheckFormat();
+    CheckCsv();
+    CheckThreaded();
+
+    return CheckResult();
+}
+
+static int CompareU64(const void* p1, const void* p2)
+{
+    uint64_t qw1 = *(const uint64_t*)p1, qw2 = *(const uint64_t*)p2;
+
+    return qw1 < qw2 ? -1 : qw1 > qw2;
+}
+
+// Takes n laps and leaves each one's press-to-stored time in pqwCapture,
+// sorted; returns the mean cost of a lap
+static double TimeLaps(STOPWATCH* pWatch, int n, uint64_t* pqwCapture)
+{
+    uint64_t qwStart, qwTotal;
+    int i;
+
+    StopwatchReset(pWatch);
+    StopwatchStart(pWatch, 0);
+    qwStart = PhaseNowNs();
+    for (i = 0; i < n; i++)
+    {
+        qwTotal = pWatch->qwCaptureTotalNs;
+        StopwatchLap(pWatch, 0);
+        pqwCapture[i] = pWatch->qwCaptureTotalNs - qwTotal;
+    }
+    qwStart = PhaseNowNs() - qwStart;
+    qsort(pqwCapture, n, sizeof(uint64_t), CompareU64);
+    return (double)qwStart / n;
+}
+
+static void PrintLaps(const char* pszName, double dLapNs, const uint64_t* pqwCapture, int n)
+{
+    printf("%-22s %8.1f ns a lap, capture %6llu ns p50, %6llu ns p99, %8llu ns max\n", pszName, dLapNs,
+        (unsigned long long)pqwCapture[n / 2], (unsigned long long)pqwCapture[n - n / 100 - 1],
+        (unsigned long long)pqwCapture[n - 1]);
+}
+
+static int Bench(int argc, char* argv[])
+{
+    static STOPWATCH watch;
+    WATCHCLOCK clock = { RealNowNs, NULL };
+    READER reader;
+    pthread_t thread;
+    uint64_t* pqwCapture;
+    uint64_t qwP99;
+    double dLapNs;
+    char buf[256];
+    int n = argc > 0 && atoi(argv[0]) > 0 ? atoi(argv[0]) : 1000000;
+
+    pqwCapture = (uint64_t*)malloc(n * sizeof(uint64_t));
+    if (!pqwCapture)
+        return 2;
+    StopwatchInit(&watch, &clock);
+
+    printf("%d laps\n", n);
+    dLapNs = TimeLaps(&watch, n, pqwCapture);
+    PrintLaps("alone", dLapNs, pqwCapture, n);
+
+    memset(&reader, 0, sizeof(reader));
+    reader.pWatch = &watch;
+    if (!StartReader(&thread, &reader))
+        return 2;
+    dLapNs = TimeLaps(&watch, n, pqwCapture);
+    __atomic_store_n(&reader.bDone, 1, __ATOMIC_RELEASE);
+    pthread_join(thread, NULL);
+    PrintLaps("with a reader", dLapNs, pqwCapture, n);
+    printf("%-22s %8.1f ns a read of up to %d laps, %ld reads\n", "reader", reader.dReadNs, LAP_RING_SLOTS,
+        reader.nReads);
+    StopwatchFormat(&watch, buf, sizeof(buf));
+    printf("  %s\n", buf);
+
+    qwP99 = pqwCapture[n - n / 100 - 1];
+    free(pqwCapture);
+    if (qwP99 > BENCH_P99_NS)
+    {
+        printf("FAIL: capture p99 %llu ns with a reader\n", (unsigned long long)qwP99);
+        return 1;
+    }
+    printf("PASS\n");
+    return 0;
+}
+
+int main(int argc, char* argv[])
+{
+    return CheckMain(argc, argv, Check, "[STEPS]", Bench, "[LAPS]");
+}
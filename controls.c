@@ -0,0 +1,271 @@
+/*--------------------------
+    CONTROLS.C -- Buttons drawn on the clock surface: layout, hit-testing and state
+---------------------------*/
+
+#include <stdio.h>
+#include "controls.h"
+
+void CtrlLayerInit(CONTROLLAYER* pLayer)
+{
+    pLayer->nCtrls = 0;
+    pLayer->iHot = -1;
+    pLayer->iPressed = -1;
+    pLayer->dwHotChanges = 0;
+    pLayer->dwPresses = 0;
+    pLayer->dwClicks = 0;
+    pLayer->dwCancels = 0;
+    pLayer->dwDrawn = 0;
+    pLayer->dwSplits = 0;
+}
+
+int CtrlAdd(CONTROLLAYER* pLayer, int iId, int iAnchor, int iMarginX, int iMarginY, int cx, int cy)
+{
+    CONTROL* pCtrl;
+
+    if (pLayer->nCtrls >= CTRL_MAX)
+        return 0;
+
+    pCtrl = &pLayer->ctrls[pLayer->nCtrls++];
+    pCtrl->iId = iId;
+    pCtrl->iAnchor = iAnchor;
+    pCtrl->iMarginX = iMarginX;
+    pCtrl->iMarginY = iMarginY;
+    pCtrl->cx = cx;
+    pCtrl->cy = cy;
+    DamageEmpty(&pCtrl->rc);
+    return 1;
+}
+
+void CtrlLayout(CONTROLLAYER* pLayer, int cxClient, int cyClient)
+{
+    CONTROL* pCtrl;
+    int i;
+
+    for (i = 0; i < pLayer->nCtrls; i++)
+    {
+        pCtrl = &pLayer->ctrls[i];
+        if (pCtrl->iAnchor & CTRL_RIGHT)
+            pCtrl->rc.left = cxClient - pCtrl->iMarginX - pCtrl->cx;
+        else if (pCtrl->iAnchor & CTRL_HCENTER)
+            pCtrl->rc.left = (cxClient - pCtrl->cx) / 2;
+        else
+            pCtrl->rc.left = pCtrl->iMarginX;
+
+        if (pCtrl->iAnchor & CTRL_BOTTOM)
+            pCtrl->rc.top = cyClient - pCtrl->iMarginY - pCtrl->cy;
+        else
+            pCtrl->rc.top = pCtrl->iMarginY;
+
+        pCtrl->rc.right = pCtrl->rc.left + pCtrl->cx;
+        pCtrl->rc.bottom = pCtrl->rc.top + pCtrl->cy;
+    }
+}
+
+static int RectContains(const DAMAGERECT* pr, int x, int y)
+{
+    return x >= pr->left && x < pr->right && y >= pr->top && y < pr->bottom;
+}
+
+int CtrlHitTest(const CONTROLLAYER* pLayer, int x, int y)
+{
+    int i;
+
+    for (i = 0; i < pLayer->nCtrls; i++)
+        if (RectContains(&pLayer->ctrls[i].rc, x, y))
+            return i;
+    return -1;
+}
+
+int CtrlFind(const CONTROLLAYER* pLayer, int iId)
+{
+    int i;
+
+    for (i = 0; i < pLayer->nCtrls; i++)
+        if (pLayer->ctrls[i].iId == iId)
+            return i;
+    return -1;
+}
+
+// While a press is held only that control lights up, as with a captured
+// push button
+int CtrlState(const CONTROLLAYER* pLayer, int iIndex)
+{
+    if (iIndex != pLayer->iHot || (pLayer->iPressed >= 0 && pLayer->iPressed != iIndex))
+        return 0;
+    return pLayer->iPressed == iIndex ? CTRL_HOT | CTRL_PRESSED : CTRL_HOT;
+}
+
+int CtrlContains(const CONTROLLAYER* pLayer, const DAMAGERECT* pr)
+{
+    const DAMAGERECT* prCtrl;
+    int i;
+
+    for (i = 0; i < pLayer->nCtrls; i++)
+    {
+        prCtrl = &pLayer->ctrls[i].rc;
+        if (pr->left >= prCtrl->left && pr->top >= prCtrl->top &&
+            pr->right <= prCtrl->right && pr->bottom <= prCtrl->bottom)
+            return 1;
+    }
+    return 0;
+}
+
+void CtrlDamage(const CONTROLLAYER* pLayer, int iId, DAMAGERECT* pDamage)
+{
+    int i = CtrlFind(pLayer, iId);
+
+    if (i >= 0)
+        DamageUnion(pDamage, &pLayer->ctrls[i].rc);
+}
+
+// Moves the hot and pressed controls, damaging those whose look changes;
+// at most the old and new of each can
+static void SetHotPressed(CONTROLLAYER* pLayer, int iHot, int iPressed, DAMAGERECT* pDamage)
+{
+    int iTouched[4] = { pLayer->iHot, pLayer->iPressed, iHot, iPressed };
+    int iBefore[4], i;
+
+    for (i = 0; i < 4; i++)
+        iBefore[i] = iTouched[i] >= 0 ? CtrlState(pLayer, iTouched[i]) : 0;
+
+    if (iHot != pLayer->iHot)
+        pLayer->dwHotChanges++;
+    pLayer->iHot = iHot;
+    pLayer->iPressed = iPressed;
+
+    for (i = 0; i < 4; i++)
+        if (iTouched[i] >= 0 && CtrlState(pLayer, iTouched[i]) != iBefore[i])
+            DamageUnion(pDamage, &pLayer->ctrls[iTouched[i]].rc);
+}
+
+void CtrlMouseMove(CONTROLLAYER* pLayer, int x, int y, DAMAGERECT* pDamage)
+{
+    SetHotPressed(pLayer, CtrlHitTest(pLayer, x, y), pLayer->iPressed, pDamage);
+}
+
+int CtrlMouseDown(CONTROLLAYER* pLayer, int x, int y, DAMAGERECT* pDamage)
+{
+    int iHit = CtrlHitTest(pLayer, x, y);
+
+    SetHotPressed(pLayer, iHit, iHit, pDamage);
+    if (iHit < 0)
+        return 0;
+    pLayer->dwPresses++;
+    return 1;
+}
+
+int CtrlMouseUp(CONTROLLAYER* pLayer, int x, int y, DAMAGERECT* pDamage)
+{
+    int iHit = CtrlHitTest(pLayer, x, y), iPressed = pLayer->iPressed;
+
+    SetHotPressed(pLayer, iHit, -1, pDamage);
+    if (iPressed < 0)
+        return -1;
+    if (iHit != iPressed)
+    {
+        pLayer->dwCancels++;
+        return -1;
+    }
+    pLayer->dwClicks++;
+    return pLayer->ctrls[iHit].iId;
+}
+
+void CtrlMouseLeave(CONTROLLAYER* pLayer, DAMAGERECT* pDamage)
+{
+    SetHotPressed(pLayer, -1, pLayer->iPressed, pDamage);
+}
+
+void CtrlCancel(CONTROLLAYER* pLayer, DAMAGERECT* pDamage)
+{
+    if (pLayer->iPressed < 0)
+        return;
+    pLayer->dwCancels++;
+    SetHotPressed(pLayer, pLayer->iHot, -1, pDamage);
+}
+
+// Adds to rcOut what is left of *pr around *prHole: up to a band above,
+// a band below and the two sides between them. Returns the new count, or
+// -1 if rcOut is full.
+static int CutAround(const DAMAGERECT* pr, const DAMAGERECT* prHole, DAMAGERECT rcOut[], int n, int nMax)
+{
+    DAMAGERECT piece[4];
+    int32_t top = pr->top > prHole->top ? pr->top : prHole->top;
+    int32_t bottom = pr->bottom < prHole->bottom ? pr->bottom : prHole->bottom;
+    int i;
+
+    piece[0] = *pr;
+    piece[0].bottom = prHole->top;
+    piece[1] = *pr;
+    piece[1].top = prHole->bottom;
+    piece[2].left = pr->left;
+    piece[2].right = prHole->left;
+    piece[3].left = prHole->right;
+    piece[3].right = pr->right;
+    piece[2].top = piece[3].top = top;
+    piece[2].bottom = piece[3].bottom = bottom;
+
+    for (i = 0; i < 4; i++)
+    {
+        if (DamageIsEmpty(&piece[i]))
+            continue;
+        if (n >= nMax)
+            return -1;
+        rcOut[n++] = piece[i];
+    }
+    return n;
+}
+
+static int Overlaps(const DAMAGERECT* pa, const DAMAGERECT* pb)
+{
+    return pa->left < pb->right && pb->left < pa->right && pa->top < pb->bottom && pb->top < pa->bottom;
+}
+
+int CtrlDamageOutside(CONTROLLAYER* pLayer, const DAMAGERECT* pDamage, DAMAGERECT rcOut[], int nMax)
+{
+    DAMAGERECT rcNext[CTRL_MAX_PIECES];
+    int i, j, n, nNext;
+
+    if (DamageIsEmpty(pDamage))
+        return 0;
+    if (nMax > CTRL_MAX_PIECES)
+        nMax = CTRL_MAX_PIECES;
+    if (nMax < 1)
+        return 0;
+
+    rcOut[0] = *pDamage;
+    n = 1;
+    for (i = 0; i < pLayer->nCtrls; i++)
+    {
+        if (!Overlaps(pDamage, &pLayer->ctrls[i].rc))
+            continue;
+
+        nNext = 0;
+        for (j = 0; j < n && nNext >= 0; j++)
+        {
+            if (Overlaps(&rcOut[j], &pLayer->ctrls[i].rc))
+                nNext = CutAround(&rcOut[j], &pLayer->ctrls[i].rc, rcNext, nNext, nMax);
+            else if (nNext < nMax)
+                rcNext[nNext++] = rcOut[j];
+            else
+                nNext = -1;
+        }
+        if (nNext < 0)
+        {
+            rcOut[0] = *pDamage;
+            return 1;
+        }
+        for (j = 0; j < nNext; j++)
+            rcOut[j] = rcNext[j];
+        n = nNext;
+        pLayer->dwSplits++;
+    }
+    return n;
+}
+
+void CtrlLayerFormat(const CONTROLLAYER* pLayer, char* buf, size_t cb)
+{
+    snprintf(buf, cb, "Controls: %lu hover changes, %lu presses, %lu clicks, %lu cancelled, "
+        "%lu drawn, %lu damage boxes cut around them",
+        (unsigned long)pLayer->dwHotChanges, (unsigned long)pLayer->dwPresses, (unsigned long)pLayer->dwClicks,
+        (unsigned long)pLayer->dwCancels, (unsigned long)pLayer->dwDrawn, (unsigned long)pLayer->dwSplits);
+}
@@ -0,0 +1,98 @@
+/*--------------------------
+    CONTROLS.H -- Buttons drawn on the clock surface: layout, hit-testing and state
+---------------------------*/
+
+#ifndef CONTROLS_H
+#define CONTROLS_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "damage.h"
+
+#define CTRL_MAX 8
+
+// Pieces a damage box may be cut into around the controls
+#define CTRL_MAX_PIECES 32
+
+// Where a control sits on each axis: against an edge, at iMarginX or
+// iMarginY pixels from it, or centered
+#define CTRL_LEFT    0x01
+#define CTRL_HCENTER 0x02
+#define CTRL_RIGHT   0x04
+#define CTRL_TOP     0x10
+#define CTRL_BOTTOM  0x20
+
+// Look of a control, from CtrlState
+#define CTRL_HOT     0x1        // under the pointer
+#define CTRL_PRESSED 0x2        // pressed and still under the pointer
+
+typedef struct
+{
+    int iId;                    // reported by CtrlMouseUp, like a WM_COMMAND id
+    int iAnchor;
+    int iMarginX, iMarginY;
+    int cx, cy;
+    DAMAGERECT rc;              // client pixels, from CtrlLayout
+} CONTROL;
+
+typedef struct
+{
+    CONTROL ctrls[CTRL_MAX];
+    int nCtrls;
+    int iHot;                   // control under the pointer, -1 for none
+    int iPressed;               // control the button went down on, -1 while up
+
+    // Statistics
+    uint32_t dwHotChanges;
+    uint32_t dwPresses;
+    uint32_t dwClicks;
+    uint32_t dwCancels;         // presses released elsewhere or lost
+    uint32_t dwDrawn;           // controls drawn, counted by the caller
+    uint32_t dwSplits;          // damage boxes cut around the controls
+} CONTROLLAYER;
+
+void CtrlLayerInit(CONTROLLAYER* pLayer);
+
+// Returns 0 when the layer is full
+int CtrlAdd(CONTROLLAYER* pLayer, int iId, int iAnchor, int iMarginX, int iMarginY, int cx, int cy);
+
+// Places every control for a client area of cxClient by cyClient
+void CtrlLayout(CONTROLLAYER* pLayer, int cxClient, int cyClient);
+
+// Index of the control at client pixel (x, y), or -1; the first added wins
+// where controls overlap
+int CtrlHitTest(const CONTROLLAYER* pLayer, int x, int y);
+
+// Index of the control with iId, or -1
+int CtrlFind(const CONTROLLAYER* pLayer, int iId);
+
+// CTRL_HOT and CTRL_PRESSED for the control at iIndex
+int CtrlState(const CONTROLLAYER* pLayer, int iIndex);
+
+// Whether *pr lies inside a single control, as a paint for a hover does
+int CtrlContains(const CONTROLLAYER* pLayer, const DAMAGERECT* pr);
+
+// Grows *pDamage by the control with iId, for a change in what it shows
+void CtrlDamage(const CONTROLLAYER* pLayer, int iId, DAMAGERECT* pDamage);
+
+// Pointer input in client pixels. Each grows *pDamage by the controls
+// whose look changed. CtrlMouseDown returns 1 when it landed on a control
+// and the pointer should be captured; CtrlMouseUp returns the id of the
+// control clicked, when it goes up over the one it went down on, or -1.
+// CtrlMouseLeave is for the pointer leaving the client area, CtrlCancel
+// for losing the capture.
+void CtrlMouseMove(CONTROLLAYER* pLayer, int x, int y, DAMAGERECT* pDamage);
+int CtrlMouseDown(CONTROLLAYER* pLayer, int x, int y, DAMAGERECT* pDamage);
+int CtrlMouseUp(CONTROLLAYER* pLayer, int x, int y, DAMAGERECT* pDamage);
+void CtrlMouseLeave(CONTROLLAYER* pLayer, DAMAGERECT* pDamage);
+void CtrlCancel(CONTROLLAYER* pLayer, DAMAGERECT* pDamage);
+
+// Cuts *pDamage into rectangles that cover it except where the controls
+// are, so moving hands never make a control draw again. Returns how many
+// went into rcOut (0 when the box is all controls). If that takes more
+// than nMax, rcOut[0] is the whole box and 1 is returned.
+int CtrlDamageOutside(CONTROLLAYER* pLayer, const DAMAGERECT* pDamage, DAMAGERECT rcOut[], int nMax);
+
+void CtrlLayerFormat(const CONTROLLAYER* pLayer, char* buf, size_t cb);
+
+#endif
@@ -0,0 +1,95 @@
+/*--------------------------
+    DAMAGE.C -- Device-space damage rectangles for the clock hands
+---------------------------*/
+
+#include "damage.h"
+
+int IsoScale(int cxClient, int cyClient)
+{
+    int iScale = (cxClient < cyClient ? cxClient : cyClient) / 2;
+    return iScale == 0 ? 1 : iScale;
+}
+
+// Division rounding towards minus / plus infinity, so a box mapped edge by
+// edge never comes out smaller than the true one
+static int DivFloor(int a, int b)
+{
+    return a >= 0 ? a / b : -((-a + b - 1) / b);
+}
+
+static int DivCeil(int a, int b)
+{
+    return -DivFloor(-a, b);
+}
+
+void IsoToDevice(int cxClient, int cyClient, int x, int y, int* px, int* py)
+{
+    int iScale = IsoScale(cxClient, cyClient);
+
+    // Viewport y extent is negative in SetIsotropic, so logical y points up
+    *px = cxClient / 2 + x * iScale / ISO_WINDOW_EXT;
+    *py = cyClient / 2 - y * iScale / ISO_WINDOW_EXT;
+}
+
+void DamageEmpty(DAMAGERECT* pr)
+{
+    pr->left = pr->top = pr->right = pr->bottom = 0;
+}
+
+int DamageIsEmpty(const DAMAGERECT* pr)
+{
+    return pr->right <= pr->left || pr->bottom <= pr->top;
+}
+
+void DamageUnion(DAMAGERECT* pr, const DAMAGERECT* prAdd)
+{
+    if (DamageIsEmpty(prAdd))
+        return;
+    if (DamageIsEmpty(pr))
+    {
+        *pr = *prAdd;
+        return;
+    }
+    if (prAdd->left < pr->left) pr->left = prAdd->left;
+    if (prAdd->top < pr->top) pr->top = prAdd->top;
+    if (prAdd->right > pr->right) pr->right = prAdd->right;
+    if (prAdd->bottom > pr->bottom) pr->bottom = prAdd->bottom;
+}
+
+void DamageClip(DAMAGERECT* pr, int cxClient, int cyClient)
+{
+    if (pr->left < 0) pr->left = 0;
+    if (pr->top < 0) pr->top = 0;
+    if (pr->right > cxClient) pr->right = cxClient;
+    if (pr->bottom > cyClient) pr->bottom = cyClient;
+    if (DamageIsEmpty(pr))
+        DamageEmpty(pr);
+}
+
+void DamageFromPolygon(DAMAGERECT* pr, const ROTPOINT pt[], int iNum,
+    int cxClient, int cyClient, int iPad)
+{
+    int i, iScale;
+    int32_t xMin, xMax, yMin, yMax;
+
+    DamageEmpty(pr);
+    if (iNum <= 0)
+        return;
+
+    xMin = xMax = pt[0].x;
+    yMin = yMax = pt[0].y;
+    for (i = 1; i < iNum; i++)
+    {
+        if (pt[i].x < xMin) xMin = pt[i].x;
+        if (pt[i].x > xMax) xMax = pt[i].x;
+        if (pt[i].y < yMin) yMin = pt[i].y;
+        if (pt[i].y > yMax) yMax = pt[i].y;
+    }
+
+    // Logical y grows upwards, so the top edge comes from yMax
+    iScale = IsoScale(cxClient, cyClient);
+    pr->left = cxClient / 2 + DivFloor(xMin * iScale, ISO_WINDOW_EXT) - iPad;
+    pr->right = cxClient / 2 + DivCeil(xMax * iScale, ISO_WINDOW_EXT) + iPad + 1;
+    pr->top = cyClient / 2 - DivCeil(yMax * iScale, ISO_WINDOW_EXT) - iPad;
+    pr->bottom = cyClient / 2 - DivFloor(yMin * iScale, ISO_WINDOW_EXT) + iPad + 1;
+}
@@ -0,0 +1,38 @@
+/*--------------------------
+    DAMAGE.H -- Device-space damage rectangles for the clock hands
+---------------------------*/
+
+#ifndef DAMAGE_H
+#define DAMAGE_H
+
+#include "rotate.h"
+
+// Logical extent used by SetIsotropic: the face spans -600..600 units
+#define ISO_WINDOW_EXT 600
+
+// Same layout as the Win32 RECT; right and bottom are exclusive
+typedef struct
+{
+    int32_t left;
+    int32_t top;
+    int32_t right;
+    int32_t bottom;
+} DAMAGERECT;
+
+// Device pixels per ISO_WINDOW_EXT logical units, as SetIsotropic picks it
+int IsoScale(int cxClient, int cyClient);
+
+// Maps a logical point to device pixels with the SetIsotropic mapping
+void IsoToDevice(int cxClient, int cyClient, int x, int y, int* px, int* py);
+
+void DamageEmpty(DAMAGERECT* pr);
+int DamageIsEmpty(const DAMAGERECT* pr);
+void DamageUnion(DAMAGERECT* pr, const DAMAGERECT* prAdd);
+void DamageClip(DAMAGERECT* pr, int cxClient, int cyClient);
+
+// Bounding box in device pixels of a polygon given in logical units,
+// grown by iPad pixels on every side to cover the pen and GDI rounding
+void DamageFromPolygon(DAMAGERECT* pr, const ROTPOINT pt[], int iNum,
+    int cxClient, int cyClient, int iPad);
+
+#endif
@@ -0,0 +1,162 @@
+/*--------------------------
+    FACECACHE.C -- Clock faces kept at several sizes under a memory budget
+---------------------------*/
+
+#include <math.h>
+#include <stdio.h>
+#include "facecache.h"
+
+void FaceCacheInit(FACECACHE* pCache, size_t cbBudget, void (*pfnFree)(void* pCtx, void* pFace), void* pCtx)
+{
+    pCache->nEntries = 0;
+    pCache->cbBudget = cbBudget;
+    pCache->cbUsed = 0;
+    pCache->qwUse = 0;
+    pCache->pfnFree = pfnFree;
+    pCache->pCtx = pCtx;
+    pCache->dwHits = 0;
+    pCache->dwScaled = 0;
+    pCache->dwMisses = 0;
+    pCache->dwEvictions = 0;
+    pCache->cbPeak = 0;
+    pCache->qwRenderNs = 0;
+    pCache->qwBlitNs = 0;
+    pCache->qwScaleNs = 0;
+}
+
+static void RemoveEntry(FACECACHE* pCache, int i)
+{
+    pCache->pfnFree(pCache->pCtx, pCache->entries[i].pFace);
+    pCache->cbUsed -= pCache->entries[i].cb;
+    pCache->entries[i] = pCache->entries[--pCache->nEntries];
+}
+
+void FaceCacheFree(FACECACHE* pCache)
+{
+    while (pCache->nEntries)
+        RemoveEntry(pCache, pCache->nEntries - 1);
+}
+
+int FaceBucketIndex(int iSide)
+{
+    if (iSide <= FACE_BUCKET_MIN)
+        return 0;
+    return (int)floor(FACE_BUCKET_STEPS * log2((double)iSide / FACE_BUCKET_MIN) + 0.5);
+}
+
+int FaceBucketSide(int iBucket)
+{
+    return 2 * (int)floor(FACE_BUCKET_MIN / 2 * pow(2.0, (double)iBucket / FACE_BUCKET_STEPS) + 0.5);
+}
+
+void FaceSquare(int cxClient, int cyClient, DAMAGERECT* pr)
+{
+    int iScale = IsoScale(cxClient, cyClient);
+
+    pr->left = cxClient / 2 - iScale;
+    pr->top = cyClient / 2 - iScale;
+    pr->right = pr->left + 2 * iScale;
+    pr->bottom = pr->top + 2 * iScale;
+}
+
+FACEENTRY* FaceCacheFind(FACECACHE* pCache, int cxClient, int cyClient, uint32_t dwStyle)
+{
+    FACEENTRY* pEntry;
+    int i;
+
+    for (i = 0; i < pCache->nEntries; i++)
+    {
+        pEntry = &pCache->entries[i];
+        if (pEntry->cx == cxClient && pEntry->cy == cyClient && pEntry->dwStyle == dwStyle)
+        {
+            pEntry->qwLastUse = ++pCache->qwUse;
+            pCache->dwHits++;
+            return pEntry;
+        }
+    }
+    return NULL;
+}
+
+FACEENTRY* FaceCacheNearest(FACECACHE* pCache, int iBucket, uint32_t dwStyle, int iMaxSteps)
+{
+    FACEENTRY* pBest = NULL;
+    FACEENTRY* pEntry;
+    int i, iSteps, iBestSteps = iMaxSteps + 1;
+
+    for (i = 0; i < pCache->nEntries; i++)
+    {
+        pEntry = &pCache->entries[i];
+        if (pEntry->dwStyle != dwStyle)
+            continue;
+        iSteps = pEntry->iBucket > iBucket ? pEntry->iBucket - iBucket : iBucket - pEntry->iBucket;
+        if (iSteps < iBestSteps || (iSteps == iBestSteps && pBest && pEntry->iBucket > pBest->iBucket))
+        {
+            pBest = pEntry;
+            iBestSteps = iSteps;
+        }
+    }
+    if (pBest)
+    {
+        pBest->qwLastUse = ++pCache->qwUse;
+        pCache->dwScaled++;
+    }
+    return pBest;
+}
+
+static int OldestEntry(const FACECACHE* pCache)
+{
+    int i, iOldest = 0;
+
+    for (i = 1; i < pCache->nEntries; i++)
+        if (pCache->entries[i].qwLastUse < pCache->entries[iOldest].qwLastUse)
+            iOldest = i;
+    return iOldest;
+}
+
+FACEENTRY* FaceCacheInsert(FACECACHE* pCache, int cxClient, int cyClient, uint32_t dwStyle, void* pFace)
+{
+    FACEENTRY* pEntry;
+    size_t cb = (size_t)cxClient * cyClient * 4;
+    int i;
+
+    // Make room first, so the new face is never the one to go
+    for (i = 0; i < pCache->nEntries; i++)
+        if (pCache->entries[i].cx == cxClient && pCache->entries[i].cy == cyClient &&
+            pCache->entries[i].dwStyle == dwStyle)
+            RemoveEntry(pCache, i--);
+    while (pCache->nEntries && (pCache->nEntries == FACE_CACHE_MAX || pCache->cbUsed + cb > pCache->cbBudget))
+    {
+        RemoveEntry(pCache, OldestEntry(pCache));
+        pCache->dwEvictions++;
+    }
+
+    pEntry = &pCache->entries[pCache->nEntries++];
+    pEntry->cx = cxClient;
+    pEntry->cy = cyClient;
+    pEntry->dwStyle = dwStyle;
+    pEntry->iBucket = FaceBucketIndex(2 * IsoScale(cxClient, cyClient));
+    pEntry->cb = cb;
+    pEntry->qwLastUse = ++pCache->qwUse;
+    pEntry->pFace = pFace;
+
+    pCache->cbUsed += cb;
+    if (pCache->cbUsed > pCache->cbPeak)
+        pCache->cbPeak = pCache->cbUsed;
+    pCache->dwMisses++;
+    return pEntry;
+}
+
+void FaceCacheFormat(const FACECACHE* pCache, char* buf, size_t cb)
+{
+    uint32_t dwTotal = pCache->dwHits + pCache->dwScaled + pCache->dwMisses;
+
+    snprintf(buf, cb, "Face cache: %lu exact, %lu scaled, %lu drawn (%lu%% without drawing), %lu evicted; "
+        "%d faces in %lu KB, peak %lu KB of %lu KB; render %.0f us, blit %.0f us, scale %.0f us each",
+        (unsigned long)pCache->dwHits, (unsigned long)pCache->dwScaled, (unsigned long)pCache->dwMisses,
+        (unsigned long)(dwTotal ? (pCache->dwHits + pCache->dwScaled) * 100 / dwTotal : 0),
+        (unsigned long)pCache->dwEvictions, pCache->nEntries, (unsigned long)(pCache->cbUsed >> 10),
+        (unsigned long)(pCache->cbPeak >> 10), (unsigned long)(pCache->cbBudget >> 10),
+        pCache->dwMisses ? pCache->qwRenderNs / 1e3 / pCache->dwMisses : 0.0,
+        pCache->dwHits ? pCache->qwBlitNs / 1e3 / pCache->dwHits : 0.0,
+        pCache->dwScaled ? pCache->qwScaleNs / 1e3 / pCache->dwScaled : 0.0);
+}
@@ -0,0 +1,91 @@
+/*--------------------------
+    FACECACHE.H -- Clock faces kept at several sizes under a memory budget
+---------------------------*/
+
+#ifndef FACECACHE_H
+#define FACECACHE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "damage.h"
+
+#define FACE_CACHE_MAX 16
+
+// Faces drawn for a live resize come in square sizes FACE_BUCKET_STEPS to
+// a doubling, from FACE_BUCKET_MIN pixels up, so a drag across the screen
+// draws only a handful of them
+#define FACE_BUCKET_MIN 64
+#define FACE_BUCKET_STEPS 4
+
+// Furthest, in buckets, a face is scaled before one is drawn for the size
+#define FACE_SCALE_STEPS 2
+
+// Memory the faces may take together, at 4 bytes a pixel
+#define FACE_CACHE_BUDGET (48u << 20)
+
+// Face toggles, part of every key
+#define FACE_DARK    0x1
+#define FACE_ROMAN   0x2
+#define FACE_LIGHT   0x4
+#define FACE_DOTS    0x8
+
+typedef struct
+{
+    int cx, cy;                 // client size the face was drawn for
+    uint32_t dwStyle;           // FACE_* bits
+    int iBucket;                // FaceBucketIndex of its face square
+    size_t cb;
+    uint64_t qwLastUse;
+    void* pFace;                // the caller's bitmap
+} FACEENTRY;
+
+typedef struct
+{
+    FACEENTRY entries[FACE_CACHE_MAX];
+    int nEntries;
+    size_t cbBudget;
+    size_t cbUsed;
+    uint64_t qwUse;             // bumped on every lookup, for the LRU order
+    void (*pfnFree)(void* pCtx, void* pFace);
+    void* pCtx;
+
+    // Statistics
+    uint32_t dwHits;            // faces found at the exact size
+    uint32_t dwScaled;          // faces found near enough to scale
+    uint32_t dwMisses;          // faces drawn and added
+    uint32_t dwEvictions;
+    size_t cbPeak;
+    uint64_t qwRenderNs;        // counted by the caller
+    uint64_t qwBlitNs;
+    uint64_t qwScaleNs;
+} FACECACHE;
+
+// pfnFree is called for every face the cache lets go of
+void FaceCacheInit(FACECACHE* pCache, size_t cbBudget, void (*pfnFree)(void* pCtx, void* pFace), void* pCtx);
+void FaceCacheFree(FACECACHE* pCache);
+
+// Bucket nearest a face square of iSide pixels, and the side of bucket
+// iBucket (always even, so the face fills the square exactly)
+int FaceBucketIndex(int iSide);
+int FaceBucketSide(int iBucket);
+
+// The square the face fills in a client of cxClient by cyClient
+void FaceSquare(int cxClient, int cyClient, DAMAGERECT* pr);
+
+// The face drawn for exactly this client size, or NULL
+FACEENTRY* FaceCacheFind(FACECACHE* pCache, int cxClient, int cyClient, uint32_t dwStyle);
+
+// The face whose bucket is nearest iBucket and no more than iMaxSteps
+// from it, the larger on a tie so it is shrunk rather than blown up, or
+// NULL
+FACEENTRY* FaceCacheNearest(FACECACHE* pCache, int iBucket, uint32_t dwStyle, int iMaxSteps);
+
+// Takes pFace, drawn for cxClient by cyClient, letting go of the least
+// recently used faces until the rest fit the budget. A face bigger than
+// the budget is still kept, alone. Earlier FACEENTRY pointers are no
+// longer valid afterwards.
+FACEENTRY* FaceCacheInsert(FACECACHE* pCache, int cxClient, int cyClient, uint32_t dwStyle, void* pFace);
+
+void FaceCacheFormat(const FACECACHE* pCache, char* buf, size_t cb);
+
+#endif
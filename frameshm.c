@@ -0,0 +1,334 @@
+/*--------------------------
+    FRAMESHM.C -- Finished clock frames in a shared-memory ring for other processes
+---------------------------*/
+
+#ifndef _WIN32
+#define _POSIX_C_SOURCE 200809L
+#endif
+
+#include <stdio.h>
+#include <string.h>
+#include "frameshm.h"
+#include "phasetime.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// One publisher and any number of readers, with no locks: the publisher
+// only ever stores to the shared words and readers only ever load them
+#ifdef _MSC_VER
+// Full fences keep this correct on ARM64 as well; they cost nothing at
+// the rate frames are published
+static uint32_t LoadAcquire32(const volatile uint32_t* p)
+{
+    uint32_t v = *p;
+
+    MemoryBarrier();
+    return v;
+}
+
+static void StoreRelease32(volatile uint32_t* p, uint32_t v)
+{
+    MemoryBarrier();
+    *p = v;
+}
+
+#define LoadRelaxed32(p) (*(p))
+#define StoreRelaxed32(p, v) (*(p) = (v))
+#define FenceAcquire() MemoryBarrier()
+#define FenceRelease() MemoryBarrier()
+#else
+#define LoadAcquire32(p) __atomic_load_n((p), __ATOMIC_ACQUIRE)
+#define StoreRelease32(p, v) __atomic_store_n((p), (v), __ATOMIC_RELEASE)
+#define LoadRelaxed32(p) __atomic_load_n((p), __ATOMIC_RELAXED)
+#define StoreRelaxed32(p, v) __atomic_store_n((p), (v), __ATOMIC_RELAXED)
+#define FenceAcquire() __atomic_thread_fence(__ATOMIC_ACQUIRE)
+#define FenceRelease() __atomic_thread_fence(__ATOMIC_RELEASE)
+#endif
+
+// A reader that keeps landing on a slot being rewritten gives up
+#define FRAMESHM_READ_TRIES 8
+
+static size_t AlignUp(size_t cb)
+{
+    return (cb + FRAMESHM_ALIGN - 1) & ~(size_t)(FRAMESHM_ALIGN - 1);
+}
+
+static FRAMESHMSLOT* SlotOf(const FRAMESHM* pShm, uint32_t dwFrame)
+{
+    const FRAMESHMHEADER* pHeader = pShm->pHeader;
+
+    return (FRAMESHMSLOT*)((uint8_t*)pShm->pHeader + pHeader->cbHeader +
+        (size_t)(dwFrame & (pHeader->nSlots - 1)) * pHeader->cbSlot);
+}
+
+static uint8_t* PixelsOf(const FRAMESHMSLOT* pSlot)
+{
+    return (uint8_t*)pSlot + AlignUp(sizeof(FRAMESHMSLOT));
+}
+
+// A header that matches the shape asked for, or any valid one if cx is 0
+static int HeaderValid(const FRAMESHMHEADER* pHeader, size_t cbMap, int cx, int cy, int nSlots)
+{
+    if (cbMap < sizeof(FRAMESHMHEADER) || LoadAcquire32(&pHeader->dwMagic) != FRAMESHM_MAGIC ||
+        pHeader->dwVersion != FRAMESHM_VERSION)
+        return 0;
+    if (cx && (pHeader->cx != (uint32_t)cx || pHeader->cy != (uint32_t)cy || pHeader->nSlots != (uint32_t)nSlots))
+        return 0;
+    return pHeader->nSlots >= 2 && pHeader->nSlots <= FRAMESHM_MAX_SLOTS &&
+        (pHeader->nSlots & (pHeader->nSlots - 1)) == 0 && pHeader->cbHeader >= sizeof(FRAMESHMHEADER) &&
+        pHeader->cbSlot >= AlignUp(sizeof(FRAMESHMSLOT)) + (size_t)pHeader->cx * pHeader->cy * 4 &&
+        pHeader->cbHeader + (size_t)pHeader->nSlots * pHeader->cbSlot <= cbMap;
+}
+
+#ifdef _WIN32
+static int MapShared(FRAMESHM* pShm, const char* pszName, size_t cbMap)
+{
+    char szName[96];
+
+    snprintf(szName, sizeof(szName), "Local\\%s", pszName);
+    if (cbMap)
+    {
+        pShm->hMap = CreateFileMappingA(INVALID_HANDLE_VALUE, NULL, PAGE_READWRITE,
+            (DWORD)((uint64_t)cbMap >> 32), (DWORD)cbMap, szName);
+        if (pShm->hMap)
+            pShm->pHeader = (FRAMESHMHEADER*)MapViewOfFile(pShm->hMap, FILE_MAP_WRITE, 0, 0, cbMap);
+        pShm->cbMap = cbMap;
+    }
+    else
+    {
+        MEMORY_BASIC_INFORMATION mbi;
+
+        pShm->hMap = OpenFileMappingA(FILE_MAP_READ, FALSE, szName);
+        if (pShm->hMap)
+            pShm->pHeader = (FRAMESHMHEADER*)MapViewOfFile(pShm->hMap, FILE_MAP_READ, 0, 0, 0);
+        if (pShm->pHeader && VirtualQuery(pShm->pHeader, &mbi, sizeof(mbi)))
+            pShm->cbMap = mbi.RegionSize;
+    }
+
+    if (!pShm->pHeader)
+    {
+        FrameShmClose(pShm);
+        return 0;
+    }
+    return 1;
+}
+
+void FrameShmRemove(const char* pszName)
+{
+    (void)pszName;
+}
+#else
+// A ring of another shape is replaced; its readers keep the old one
+static int MapShared(FRAMESHM* pShm, const char* pszName, size_t cbMap)
+{
+    struct stat st;
+    void* pView;
+    int fd;
+
+    snprintf(pShm->szName, sizeof(pShm->szName), "/%s", pszName);
+    fd = shm_open(pShm->szName, cbMap ? O_RDWR | O_CREAT : O_RDONLY, 0644);
+    if (fd >= 0 && cbMap && fstat(fd, &st) == 0 && st.st_size != 0 && (size_t)st.st_size != cbMap)
+    {
+        close(fd);
+        shm_unlink(pShm->szName);
+        fd = shm_open(pShm->szName, O_RDWR | O_CREAT | O_EXCL, 0644);
+    }
+    if (fd < 0)
+        return 0;
+
+    if (fstat(fd, &st) != 0 || (cbMap && st.st_size == 0 && ftruncate(fd, (off_t)cbMap) != 0))
+    {
+        close(fd);
+        return 0;
+    }
+    if (!cbMap)
+        cbMap = (size_t)st.st_size;
+
+    pView = cbMap ? mmap(NULL, cbMap, pShm->bWriter ? PROT_READ | PROT_WRITE : PROT_READ, MAP_SHARED, fd, 0) :
+        MAP_FAILED;
+    close(fd);
+    if (pView == MAP_FAILED)
+        return 0;
+
+    pShm->pHeader = (FRAMESHMHEADER*)pView;
+    pShm->cbMap = cbMap;
+    return 1;
+}
+
+void FrameShmRemove(const char* pszName)
+{
+    char szName[64];
+
+    snprintf(szName, sizeof(szName), "/%s", pszName);
+    shm_unlink(szName);
+}
+#endif
+
+int FrameShmCreate(FRAMESHM* pShm, const char* pszName, int cx, int cy, int nSlots)
+{
+    FRAMESHMHEADER* pHeader;
+    size_t cbHeader = AlignUp(sizeof(FRAMESHMHEADER));
+    size_t cbSlot;
+
+    memset(pShm, 0, sizeof(*pShm));
+    if (cx <= 0 || cy <= 0 || nSlots < 2 || nSlots > FRAMESHM_MAX_SLOTS || (nSlots & (nSlots - 1)))
+        return 0;
+    cbSlot = AlignUp(AlignUp(sizeof(FRAMESHMSLOT)) + (size_t)cx * cy * 4);
+    if (cbSlot > 0xFFFFFFFFu)
+        return 0;
+
+    pShm->bWriter = 1;
+    if (!MapShared(pShm, pszName, cbHeader + cbSlot * nSlots))
+        return 0;
+
+    // A ring of this shape left by an earlier publisher keeps its numbers,
+    // so its readers never see a frame number go back
+    pHeader = pShm->pHeader;
+    if (HeaderValid(pHeader, pShm->cbMap, cx, cy, nSlots))
+        return 1;
+
+#ifdef _WIN32
+    // Another shape: the kernel object cannot be resized under its readers
+    if (LoadRelaxed32(&pHeader->dwMagic) == FRAMESHM_MAGIC)
+    {
+        FrameShmClose(pShm);
+        return 0;
+    }
+#endif
+    memset(pHeader, 0, pShm->cbMap);
+    pHeader->dwVersion = FRAMESHM_VERSION;
+    pHeader->cx = (uint32_t)cx;
+    pHeader->cy = (uint32_t)cy;
+    pHeader->nSlots = (uint32_t)nSlots;
+    pHeader->cbSlot = (uint32_t)cbSlot;
+    pHeader->cbHeader = (uint32_t)cbHeader;
+    StoreRelease32(&pHeader->dwMagic, FRAMESHM_MAGIC);
+    return 1;
+}
+
+int FrameShmOpen(FRAMESHM* pShm, const char* pszName)
+{
+    memset(pShm, 0, sizeof(*pShm));
+    if (!MapShared(pShm, pszName, 0))
+        return 0;
+    if (!HeaderValid(pShm->pHeader, pShm->cbMap, 0, 0, 0))
+    {
+        FrameShmClose(pShm);
+        return 0;
+    }
+    return 1;
+}
+
+void FrameShmClose(FRAMESHM* pShm)
+{
+#ifdef _WIN32
+    if (pShm->pHeader)
+        UnmapViewOfFile(pShm->pHeader);
+    if (pShm->hMap)
+        CloseHandle(pShm->hMap);
+    pShm->hMap = NULL;
+#else
+    if (pShm->pHeader)
+        munmap(pShm->pHeader, pShm->cbMap);
+#endif
+    pShm->pHeader = NULL;
+    pShm->cbMap = 0;
+}
+
+void FrameShmBeginWrite(FRAMESHM* pShm, FRAMEBUFFER* pFb)
+{
+    FRAMESHMHEADER* pHeader = pShm->pHeader;
+    FRAMESHMSLOT* pSlot;
+
+    // 0 means no frame yet, so the numbers skip it when they wrap
+    pShm->dwWriting = LoadRelaxed32(&pHeader->dwLatest) + 1;
+    if (!pShm->dwWriting)
+        pShm->dwWriting = 1;
+    pSlot = SlotOf(pShm, pShm->dwWriting);
+
+    // Odd before any pixel changes; a publisher that died mid-frame left
+    // it odd already, and it must still move on
+    StoreRelaxed32(&pSlot->dwSeq, (LoadRelaxed32(&pSlot->dwSeq) + 1) | 1);
+    FenceRelease();
+
+    pFb->cx = (int)pHeader->cx;
+    pFb->cy = (int)pHeader->cy;
+    pFb->pPixels = PixelsOf(pSlot);
+}
+
+void FrameShmPublish(FRAMESHM* pShm, const FRAMETIME* pTime, const DAMAGERECT* pDamage)
+{
+    FRAMESHMHEADER* pHeader = pShm->pHeader;
+    FRAMESHMSLOT* pSlot = SlotOf(pShm, pShm->dwWriting);
+
+    pSlot->dwFrame = pShm->dwWriting;
+    pSlot->qwPublishNs = PhaseNowNs();
+    pSlot->time = *pTime;
+    if (pDamage)
+        pSlot->damage = *pDamage;
+    else
+    {
+        pSlot->damage.left = 0;
+        pSlot->damage.top = 0;
+        pSlot->damage.right = (int32_t)pHeader->cx;
+        pSlot->damage.bottom = (int32_t)pHeader->cy;
+    }
+
+    StoreRelease32(&pSlot->dwSeq, LoadRelaxed32(&pSlot->dwSeq) + 1);
+    StoreRelease32(&pHeader->dwLatest, pShm->dwWriting);
+}
+
+uint32_t FrameShmLatest(const FRAMESHM* pShm)
+{
+    return LoadAcquire32(&pShm->pHeader->dwLatest);
+}
+
+int FrameShmBeginRead(const FRAMESHM* pShm, FRAMEVIEW* pView)
+{
+    const FRAMESHMSLOT* pSlot;
+    uint32_t dwFrame;
+    int i;
+
+    for (i = 0; i < FRAMESHM_READ_TRIES; i++)
+    {
+        dwFrame = FrameShmLatest(pShm);
+        if (!dwFrame)
+            return 0;
+
+        // Odd or a different frame: the publisher has lapped the ring
+        // since dwLatest was read, so look again for the newest
+        pSlot = SlotOf(pShm, dwFrame);
+        pView->dwSeq = LoadAcquire32(&pSlot->dwSeq);
+        if (pView->dwSeq & 1)
+            continue;
+
+        pView->dwFrame = pSlot->dwFrame;
+        pView->qwPublishNs = pSlot->qwPublishNs;
+        pView->time = pSlot->time;
+        pView->damage = pSlot->damage;
+        FenceAcquire();
+        if (LoadRelaxed32(&pSlot->dwSeq) != pView->dwSeq || pView->dwFrame != dwFrame)
+            continue;
+
+        pView->pSlot = pSlot;
+        pView->pPixels = PixelsOf(pSlot);
+        pView->cx = (int)pShm->pHeader->cx;
+        pView->cy = (int)pShm->pHeader->cy;
+        return 1;
+    }
+    return 0;
+}
+
+int FrameShmEndRead(const FRAMESHM* pShm, const FRAMEVIEW* pView)
+{
+    (void)pShm;
+    FenceAcquire();
+    return LoadRelaxed32(&pView->pSlot->dwSeq) == pView->dwSeq;
+}
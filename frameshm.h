@@ -0,0 +1,119 @@
+/*--------------------------
+    FRAMESHM.H -- Finished clock frames in a shared-memory ring for other processes
+---------------------------*/
+
+#ifndef FRAMESHM_H
+#define FRAMESHM_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "damage.h"
+#include "raster.h"
+
+// "Local\ClockFrames" on Windows, "/ClockFrames" under POSIX
+#define FRAMESHM_DEFAULT_NAME "ClockFrames"
+#define FRAMESHM_MAGIC 0x4B4C4346   // "FCLK"
+#define FRAMESHM_VERSION 1
+#define FRAMESHM_MAX_SLOTS 16
+#define FRAMESHM_ALIGN 64
+
+// Layout of the mapping: this header, then nSlots slots of cbSlot bytes,
+// each a FRAMESHMSLOT followed by the frame's RGBA pixels, rows top to
+// bottom and cx * 4 bytes apart. The publisher fills the header before it
+// sets dwMagic and never changes it afterwards.
+typedef struct
+{
+    volatile uint32_t dwMagic;
+    uint32_t dwVersion;
+    uint32_t cx, cy;
+    uint32_t nSlots;            // a power of two
+    uint32_t cbSlot;            // a FRAMESHM_ALIGN multiple
+    uint32_t cbHeader;          // offset of slot 0
+    volatile uint32_t dwLatest; // number of the newest complete frame, 0 before the first
+    uint32_t reserved[8];
+} FRAMESHMHEADER;
+
+// Same layout as the Win32 SYSTEMTIME
+typedef struct
+{
+    uint16_t wYear;
+    uint16_t wMonth;
+    uint16_t wDayOfWeek;
+    uint16_t wDay;
+    uint16_t wHour;
+    uint16_t wMinute;
+    uint16_t wSecond;
+    uint16_t wMilliseconds;
+} FRAMETIME;
+
+// A seqlock: dwSeq is odd while the publisher rewrites the slot, and a
+// reader's view is good only if dwSeq is the same even value afterwards
+typedef struct
+{
+    volatile uint32_t dwSeq;
+    uint32_t dwFrame;
+    uint64_t qwPublishNs;       // PhaseNowNs() when published, for latency
+    FRAMETIME time;             // the time the frame shows
+    DAMAGERECT damage;          // pixels changed since frame dwFrame - 1
+    uint32_t reserved[4];
+} FRAMESHMSLOT;
+
+typedef struct
+{
+    FRAMESHMHEADER* pHeader;    // NULL when not open
+    size_t cbMap;
+    int bWriter;
+    uint32_t dwWriting;         // frame being drawn by the publisher
+#ifdef _WIN32
+    void* hMap;
+#else
+    char szName[64];
+#endif
+} FRAMESHM;
+
+// A frame still in the mapping; nothing is copied but the small fields
+typedef struct
+{
+    const uint8_t* pPixels;
+    int cx, cy;
+    uint32_t dwFrame;
+    uint64_t qwPublishNs;
+    FRAMETIME time;
+    DAMAGERECT damage;
+    const FRAMESHMSLOT* pSlot;
+    uint32_t dwSeq;
+} FRAMEVIEW;
+
+// Publisher: creates the named ring of nSlots frames of cx by cy, or
+// takes over one of that shape and carries on its frame numbers. One
+// publisher per name. Returns 0 on failure.
+int FrameShmCreate(FRAMESHM* pShm, const char* pszName, int cx, int cy, int nSlots);
+
+// Reader: maps an existing ring read-only. Returns 0 if there is none yet.
+int FrameShmOpen(FRAMESHM* pShm, const char* pszName);
+
+void FrameShmClose(FRAMESHM* pShm);
+
+// Deletes the name under POSIX, where the ring outlives its publisher so
+// that readers keep working across a restart. On Windows the ring goes
+// away with its last handle.
+void FrameShmRemove(const char* pszName);
+
+// Publisher: the next slot as a framebuffer to draw the whole frame into,
+// then publishes it. pDamage NULL means the whole frame changed. Readers
+// still on that slot see their view fail FrameShmEndRead.
+void FrameShmBeginWrite(FRAMESHM* pShm, FRAMEBUFFER* pFb);
+void FrameShmPublish(FRAMESHM* pShm, const FRAMETIME* pTime, const DAMAGERECT* pDamage);
+
+// Reader: number of the newest frame, to poll for a new one
+uint32_t FrameShmLatest(const FRAMESHM* pShm);
+
+// Reader: the newest frame in place. Returns 0 if nothing is published
+// yet. The pixels may be overwritten once the publisher has gone nSlots - 1
+// frames further; FrameShmEndRead returns 1 if they were not, so whatever
+// was done with them stands. A reader that skipped frames (dwFrame is not
+// the last one plus one) should treat the whole frame as damaged.
+int FrameShmBeginRead(const FRAMESHM* pShm, FRAMEVIEW* pView);
+int FrameShmEndRead(const FRAMESHM* pShm, const FRAMEVIEW* pView);
+
+#endif
@@ -0,0 +1,133 @@
+/*--------------------------
+    GLYPHATLAS.C -- Pre-rendered label atlas for the hour numerals
+---------------------------*/
+
+#include <string.h>
+#include "glyphatlas.h"
+#include "damage.h"
+
+void GlyphAtlasInit(GLYPHATLAS* pAtlas, int iFont, int iHeight, uint32_t bgColor)
+{
+    memset(pAtlas, 0, sizeof(*pAtlas));
+    pAtlas->iFont = iFont;
+    pAtlas->iHeight = iHeight;
+    pAtlas->bgColor = bgColor;
+}
+
+int GlyphAtlasMatches(const GLYPHATLAS* pAtlas, int iFont, int iHeight, uint32_t bgColor)
+{
+    return pAtlas->nEntries > 0 && pAtlas->iFont == iFont && pAtlas->iHeight == iHeight &&
+        pAtlas->bgColor == bgColor;
+}
+
+int GlyphAtlasFind(const GLYPHATLAS* pAtlas, const char* psz, uint32_t color)
+{
+    int i;
+
+    for (i = 0; i < pAtlas->nEntries; i++)
+    {
+        if (pAtlas->entries[i].color == color && strcmp(pAtlas->entries[i].sz, psz) == 0)
+            return i;
+    }
+    return -1;
+}
+
+int GlyphAtlasAdd(GLYPHATLAS* pAtlas, const char* psz, uint32_t color)
+{
+    ATLASENTRY* pEntry;
+    int i = GlyphAtlasFind(pAtlas, psz, color);
+
+    if (i >= 0)
+        return i;
+    if (pAtlas->nEntries >= ATLAS_MAX_ENTRIES || strlen(psz) >= ATLAS_MAX_TEXT)
+        return -1;
+
+    pEntry = &pAtlas->entries[pAtlas->nEntries];
+    memset(pEntry, 0, sizeof(*pEntry));
+    strcpy(pEntry->sz, psz);
+    pEntry->color = color;
+    return pAtlas->nEntries++;
+}
+
+void GlyphAtlasAddNumerals(GLYPHATLAS* pAtlas, uint32_t color)
+{
+    int iHour;
+    char buf[8];
+
+    for (iHour = 1; iHour <= 12; iHour++)
+    {
+        GlyphAtlasAdd(pAtlas, ClockLabel(iHour, 0, buf), color);
+        GlyphAtlasAdd(pAtlas, ClockLabel(iHour, 1, buf), color);
+    }
+}
+
+// Entries are nearly the same height, so plain shelves in insertion order
+// waste little space
+void GlyphAtlasPack(GLYPHATLAS* pAtlas, const GLYPHSOURCE* pSource, int cxMax)
+{
+    int i, x = ATLAS_PAD, y = ATLAS_PAD, cyShelf = 0;
+    ATLASENTRY* pEntry;
+
+    pAtlas->cx = 0;
+    pAtlas->cy = 0;
+
+    for (i = 0; i < pAtlas->nEntries; i++)
+    {
+        pEntry = &pAtlas->entries[i];
+        pSource->pfnMeasure(pSource->pCtx, pEntry->sz, &pEntry->cx, &pEntry->cy);
+
+        if (x > ATLAS_PAD && x + pEntry->cx + ATLAS_PAD > cxMax)
+        {
+            x = ATLAS_PAD;
+            y += cyShelf + ATLAS_PAD;
+            cyShelf = 0;
+        }
+
+        pEntry->x = x;
+        pEntry->y = y;
+        x += pEntry->cx + ATLAS_PAD;
+        if (pEntry->cy > cyShelf)
+            cyShelf = pEntry->cy;
+        if (x > pAtlas->cx)
+            pAtlas->cx = x;
+    }
+
+    pAtlas->cy = y + cyShelf + ATLAS_PAD;
+}
+
+void GlyphAtlasRender(const GLYPHATLAS* pAtlas, const GLYPHSOURCE* pSource)
+{
+    int i;
+    const ATLASENTRY* pEntry;
+
+    for (i = 0; i < pAtlas->nEntries; i++)
+    {
+        pEntry = &pAtlas->entries[i];
+        pSource->pfnDraw(pSource->pCtx, pEntry->sz, pEntry->color, pEntry->x, pEntry->y);
+    }
+}
+
+int GlyphAtlasPlaceNumerals(const GLYPHATLAS* pAtlas, int bRoman, uint32_t color,
+    int cxClient, int cyClient, ATLASPLACE place[12])
+{
+    int iHour, x, y;
+    ROTPOINT pt;
+    char buf[8];
+    const ATLASENTRY* pEntry;
+
+    for (iHour = 1; iHour <= 12; iHour++)
+    {
+        place[iHour - 1].iEntry = GlyphAtlasFind(pAtlas, ClockLabel(iHour, bRoman, buf), color);
+        if (place[iHour - 1].iEntry < 0)
+            return 0;
+        pEntry = &pAtlas->entries[place[iHour - 1].iEntry];
+
+        // TextOut at (x - cx / 2, y - cy / 2) in y-up logical units puts
+        // the top of the text half its height below the anchor on screen
+        ClockLabelAnchor(iHour, &pt);
+        IsoToDevice(cxClient, cyClient, pt.x, pt.y, &x, &y);
+        place[iHour - 1].x = x - pEntry->cx / 2;
+        place[iHour - 1].y = y + pEntry->cy / 2;
+    }
+    return 1;
+}
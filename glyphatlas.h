@@ -0,0 +1,73 @@
+/*--------------------------
+    GLYPHATLAS.H -- Pre-rendered label atlas for the hour numerals
+---------------------------*/
+
+#ifndef GLYPHATLAS_H
+#define GLYPHATLAS_H
+
+#include "clockdraw.h"
+
+#define ATLAS_MAX_ENTRIES 32
+#define ATLAS_MAX_TEXT 8
+#define ATLAS_PAD 1             // blank pixels between entries
+
+// One string in one color, at (x, y) in the atlas surface
+typedef struct
+{
+    char sz[ATLAS_MAX_TEXT];
+    uint32_t color;
+    int x, y;
+    int cx, cy;                 // extent as the glyph source measured it
+} ATLASENTRY;
+
+// A font at one pixel size that can measure strings and draw them onto
+// the atlas surface, which the caller has filled with the background
+typedef struct
+{
+    void* pCtx;
+    void (*pfnMeasure)(void* pCtx, const char* psz, int* pcx, int* pcy);
+    void (*pfnDraw)(void* pCtx, const char* psz, uint32_t color, int x, int y);
+} GLYPHSOURCE;
+
+// Entries are keyed on text and color; the atlas as a whole on the font,
+// its pixel height and the background it was drawn over
+typedef struct
+{
+    int iFont;                  // caller's font id
+    int iHeight;                // pixels
+    uint32_t bgColor;
+    int cx, cy;                 // surface size, set by GlyphAtlasPack
+    int nEntries;
+    ATLASENTRY entries[ATLAS_MAX_ENTRIES];
+} GLYPHATLAS;
+
+// Where a numeral goes for one client size: device top-left and entry
+typedef struct
+{
+    int iEntry;
+    int x, y;
+} ATLASPLACE;
+
+void GlyphAtlasInit(GLYPHATLAS* pAtlas, int iFont, int iHeight, uint32_t bgColor);
+int GlyphAtlasMatches(const GLYPHATLAS* pAtlas, int iFont, int iHeight, uint32_t bgColor);
+
+// Returns the entry index, or -1 when the atlas is full
+int GlyphAtlasAdd(GLYPHATLAS* pAtlas, const char* psz, uint32_t color);
+int GlyphAtlasFind(const GLYPHATLAS* pAtlas, const char* psz, uint32_t color);
+
+// "1".."12" and "I".."XII" in the given color
+void GlyphAtlasAddNumerals(GLYPHATLAS* pAtlas, uint32_t color);
+
+// Measures every entry and packs them into shelves no wider than cxMax
+void GlyphAtlasPack(GLYPHATLAS* pAtlas, const GLYPHSOURCE* pSource, int cxMax);
+
+// Draws every entry at its packed position
+void GlyphAtlasRender(const GLYPHATLAS* pAtlas, const GLYPHSOURCE* pSource);
+
+// Device positions of the twelve numerals, placed exactly as pfnText
+// places them, for a client of cxClient by cyClient. Returns 0 if any
+// numeral is missing from the atlas.
+int GlyphAtlasPlaceNumerals(const GLYPHATLAS* pAtlas, int bRoman, uint32_t color,
+    int cxClient, int cyClient, ATLASPLACE place[12]);
+
+#endif
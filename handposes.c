@@ -0,0 +1,496 @@
+/*--------------------------
+    HANDPOSES.C -- Hand outlines at every angle a tick can show
+
+    Generated by mkposes from the outlines in clockdraw.c; do not edit.
+---------------------------*/
+
+#include "handposes.h"
+
+const ROTPOINT handPoseHour[POSE_HOUR_ANGLES][CLOCK_HAND_POINTS] = {
+    { {0, -110}, {70, 0}, {0, 300}, {-70, 0}, {0, -110} },  // 0
+    { {-2, -110}, {70, -1}, {5, 300}, {-70, 1}, {-2, -110} },  // 1
+    { {-4, -110}, {70, -2}, {10, 300}, {-70, 2}, {-4, -110} },  // 2
+    { {-6, -110}, {70, -4}, {16, 300}, {-70, 4}, {-6, -110} },  // 3
+    { {-8, -110}, {70, -5}, {21, 299}, {-70, 5}, {-8, -110} },  // 4
+    { {-10, -110}, {70, -6}, {26, 299}, {-70, 6}, {-10, -110} },  // 5
+    { {-11, -109}, {70, -7}, {31, 298}, {-70, 7}, {-11, -109} },  // 6
+    { {-13, -109}, {69, -9}, {37, 298}, {-69, 9}, {-13, -109} },  // 7
+    { {-15, -109}, {69, -10}, {42, 297}, {-69, 10}, {-15, -109} },  // 8
+    { {-17, -109}, {69, -11}, {47, 296}, {-69, 11}, {-17, -109} },  // 9
+    { {-19, -108}, {69, -12}, {52, 295}, {-69, 12}, {-19, -108} },  // 10
+    { {-21, -108}, {69, -13}, {57, 294}, {-69, 13}, {-21, -108} },  // 11
+    { {-23, -108}, {68, -15}, {62, 293}, {-68, 15}, {-23, -108} },  // 12
+    { {-25, -107}, {68, -16}, {67, 292}, {-68, 16}, {-25, -107} },  // 13
+    { {-27, -107}, {68, -17}, {73, 291}, {-68, 17}, {-27, -107} },  // 14
+    { {-28, -106}, {68, -18}, {78, 290}, {-68, 18}, {-28, -106} },  // 15
+    { {-30, -106}, {67, -19}, {83, 288}, {-67, 19}, {-30, -106} },  // 16
+    { {-32, -105}, {67, -20}, {88, 287}, {-67, 20}, {-32, -105} },  // 17
+    { {-34, -105}, {67, -22}, {93, 285}, {-67, 22}, {-34, -105} },  // 18
+    { {-36, -104}, {66, -23}, {98, 284}, {-66, 23}, {-36, -104} },  // 19
+    { {-38, -103}, {66, -24}, {103, 282}, {-66, 24}, {-38, -103} },  // 20
+    { {-39, -103}, {65, -25}, {108, 280}, {-65, 25}, {-39, -103} },  // 21
+    { {-41, -102}, {65, -26}, {112, 278}, {-65, 26}, {-41, -102} },  // 22
+    { {-43, -101}, {64, -27}, {117, 276}, {-64, 27}, {-43, -101} },  // 23
+    { {-45, -100}, {64, -28}, {122, 274}, {-64, 28}, {-45, -100} },  // 24
+    { {-46, -100}, {63, -30}, {127, 272}, {-63, 30}, {-46, -100} },  // 25
+    { {-48, -99}, {63, -31}, {132, 270}, {-63, 31}, {-48, -99} },  // 26
+    { {-50, -98}, {62, -32}, {136, 267}, {-62, 32}, {-50, -98} },  // 27
+    { {-52, -97}, {62, -33}, {141, 265}, {-62, 33}, {-52, -97} },  // 28
+    { {-53, -96}, {61, -34}, {145, 262}, {-61, 34}, {-53, -96} },  // 29
+    { {-55, -95}, {61, -35}, {150, 260}, {-61, 35}, {-55, -95} },  // 30
+    { {-57, -94}, {60, -36}, {155, 257}, {-60, 36}, {-57, -94} },  // 31
+    { {-58, -93}, {59, -37}, {159, 254}, {-59, 37}, {-58, -93} },  // 32
+    { {-60, -92}, {59, -38}, {163, 252}, {-59, 38}, {-60, -92} },  // 33
+    { {-62, -91}, {58, -39}, {168, 249}, {-58, 39}, {-62, -91} },  // 34
+    { {-63, -90}, {57, -40}, {172, 246}, {-57, 40}, {-63, -90} },  // 35
+    { {-65, -89}, {57, -41}, {176, 243}, {-57, 41}, {-65, -89} },  // 36
+    { {-66, -88}, {56, -42}, {181, 240}, {-56, 42}, {-66, -88} },  // 37
+    { {-68, -87}, {55, -43}, {185, 236}, {-55, 43}, {-68, -87} },  // 38
+    { {-69, -85}, {54, -44}, {189, 233}, {-54, 44}, {-69, -85} },  // 39
+    { {-71, -84}, {54, -45}, {193, 230}, {-54, 45}, {-71, -84} },  // 40
+    { {-72, -83}, {53, -46}, {197, 226}, {-53, 46}, {-72, -83} },  // 41
+    { {-74, -82}, {52, -47}, {201, 223}, {-52, 47}, {-74, -82} },  // 42
+    { {-75, -80}, {51, -48}, {205, 219}, {-51, 48}, {-75, -80} },  // 43
+    { {-76, -79}, {50, -49}, {208, 216}, {-50, 49}, {-76, -79} },  // 44
+    { {-78, -78}, {49, -49}, {212, 212}, {-49, 49}, {-78, -78} },  // 45
+    { {-79, -76}, {49, -50}, {216, 208}, {-49, 50}, {-79, -76} },  // 46
+    { {-80, -75}, {48, -51}, {219, 205}, {-48, 51}, {-80, -75} },  // 47
+    { {-82, -74}, {47, -52}, {223, 201}, {-47, 52}, {-82, -74} },  // 48
+    { {-83, -72}, {46, -53}, {226, 197}, {-46, 53}, {-83, -72} },  // 49
+    { {-84, -71}, {45, -54}, {230, 193}, {-45, 54}, {-84, -71} },  // 50
+    { {-85, -69}, {44, -54}, {233, 189}, {-44, 54}, {-85, -69} },  // 51
+    { {-87, -68}, {43, -55}, {236, 185}, {-43, 55}, {-87, -68} },  // 52
+    { {-88, -66}, {42, -56}, {240, 181}, {-42, 56}, {-88, -66} },  // 53
+    { {-89, -65}, {41, -57}, {243, 176}, {-41, 57}, {-89, -65} },  // 54
+    { {-90, -63}, {40, -57}, {246, 172}, {-40, 57}, {-90, -63} },  // 55
+    { {-91, -62}, {39, -58}, {249, 168}, {-39, 58}, {-91, -62} },  // 56
+    { {-92, -60}, {38, -59}, {252, 163}, {-38, 59}, {-92, -60} },  // 57
+    { {-93, -58}, {37, -59}, {254, 159}, {-37, 59}, {-93, -58} },  // 58
+    { {-94, -57}, {36, -60}, {257, 155}, {-36, 60}, {-94, -57} },  // 59
+    { {-95, -55}, {35, -61}, {260, 150}, {-35, 61}, {-95, -55} },  // 60
+    { {-96, -53}, {34, -61}, {262, 145}, {-34, 61}, {-96, -53} },  // 61
+    { {-97, -52}, {33, -62}, {265, 141}, {-33, 62}, {-97, -52} },  // 62
+    { {-98, -50}, {32, -62}, {267, 136}, {-32, 62}, {-98, -50} },  // 63
+    { {-99, -48}, {31, -63}, {270, 132}, {-31, 63}, {-99, -48} },  // 64
+    { {-100, -46}, {30, -63}, {272, 127}, {-30, 63}, {-100, -46} },  // 65
+    { {-100, -45}, {28, -64}, {274, 122}, {-28, 64}, {-100, -45} },  // 66
+    { {-101, -43}, {27, -64}, {276, 117}, {-27, 64}, {-101, -43} },  // 67
+    { {-102, -41}, {26, -65}, {278, 112}, {-26, 65}, {-102, -41} },  // 68
+    { {-103, -39}, {25, -65}, {280, 108}, {-25, 65}, {-103, -39} },  // 69
+    { {-103, -38}, {24, -66}, {282, 103}, {-24, 66}, {-103, -38} },  // 70
+    { {-104, -36}, {23, -66}, {284, 98}, {-23, 66}, {-104, -36} },  // 71
+    { {-105, -34}, {22, -67}, {285, 93}, {-22, 67}, {-105, -34} },  // 72
+    { {-105, -32}, {20, -67}, {287, 88}, {-20, 67}, {-105, -32} },  // 73
+    { {-106, -30}, {19, -67}, {288, 83}, {-19, 67}, {-106, -30} },  // 74
+    { {-106, -28}, {18, -68}, {290, 78}, {-18, 68}, {-106, -28} },  // 75
+    { {-107, -27}, {17, -68}, {291, 73}, {-17, 68}, {-107, -27} },  // 76
+    { {-107, -25}, {16, -68}, {292, 67}, {-16, 68}, {-107, -25} },  // 77
+    { {-108, -23}, {15, -68}, {293, 62}, {-15, 68}, {-108, -23} },  // 78
+    { {-108, -21}, {13, -69}, {294, 57}, {-13, 69}, {-108, -21} },  // 79
+    { {-108, -19}, {12, -69}, {295, 52}, {-12, 69}, {-108, -19} },  // 80
+    { {-109, -17}, {11, -69}, {296, 47}, {-11, 69}, {-109, -17} },  // 81
+    { {-109, -15}, {10, -69}, {297, 42}, {-10, 69}, {-109, -15} },  // 82
+    { {-109, -13}, {9, -69}, {298, 37}, {-9, 69}, {-109, -13} },  // 83
+    { {-109, -11}, {7, -70}, {298, 31}, {-7, 70}, {-109, -11} },  // 84
+    { {-110, -10}, {6, -70}, {299, 26}, {-6, 70}, {-110, -10} },  // 85
+    { {-110, -8}, {5, -70}, {299, 21}, {-5, 70}, {-110, -8} },  // 86
+    { {-110, -6}, {4, -70}, {300, 16}, {-4, 70}, {-110, -6} },  // 87
+    { {-110, -4}, {2, -70}, {300, 10}, {-2, 70}, {-110, -4} },  // 88
+    { {-110, -2}, {1, -70}, {300, 5}, {-1, 70}, {-110, -2} },  // 89
+    { {-110, 0}, {0, -70}, {300, 0}, {0, 70}, {-110, 0} },  // 90
+    { {-110, 2}, {-1, -70}, {300, -5}, {1, 70}, {-110, 2} },  // 91
+    { {-110, 4}, {-2, -70}, {300, -10}, {2, 70}, {-110, 4} },  // 92
+    { {-110, 6}, {-4, -70}, {300, -16}, {4, 70}, {-110, 6} },  // 93
+    { {-110, 8}, {-5, -70}, {299, -21}, {5, 70}, {-110, 8} },  // 94
+    { {-110, 10}, {-6, -70}, {299, -26}, {6, 70}, {-110, 10} },  // 95
+    { {-109, 11}, {-7, -70}, {298, -31}, {7, 70}, {-109, 11} },  // 96
+    { {-109, 13}, {-9, -69}, {298, -37}, {9, 69}, {-109, 13} },  // 97
+    { {-109, 15}, {-10, -69}, {297, -42}, {10, 69}, {-109, 15} },  // 98
+    { {-109, 17}, {-11, -69}, {296, -47}, {11, 69}, {-109, 17} },  // 99
+    { {-108, 19}, {-12, -69}, {295, -52}, {12, 69}, {-108, 19} },  // 100
+    { {-108, 21}, {-13, -69}, {294, -57}, {13, 69}, {-108, 21} },  // 101
+    { {-108, 23}, {-15, -68}, {293, -62}, {15, 68}, {-108, 23} },  // 102
+    { {-107, 25}, {-16, -68}, {292, -67}, {16, 68}, {-107, 25} },  // 103
+    { {-107, 27}, {-17, -68}, {291, -73}, {17, 68}, {-107, 27} },  // 104
+    { {-106, 28}, {-18, -68}, {290, -78}, {18, 68}, {-106, 28} },  // 105
+    { {-106, 30}, {-19, -67}, {288, -83}, {19, 67}, {-106, 30} },  // 106
+    { {-105, 32}, {-20, -67}, {287, -88}, {20, 67}, {-105, 32} },  // 107
+    { {-105, 34}, {-22, -67}, {285, -93}, {22, 67}, {-105, 34} },  // 108
+    { {-104, 36}, {-23, -66}, {284, -98}, {23, 66}, {-104, 36} },  // 109
+    { {-103, 38}, {-24, -66}, {282, -103}, {24, 66}, {-103, 38} },  // 110
+    { {-103, 39}, {-25, -65}, {280, -108}, {25, 65}, {-103, 39} },  // 111
+    { {-102, 41}, {-26, -65}, {278, -112}, {26, 65}, {-102, 41} },  // 112
+    { {-101, 43}, {-27, -64}, {276, -117}, {27, 64}, {-101, 43} },  // 113
+    { {-100, 45}, {-28, -64}, {274, -122}, {28, 64}, {-100, 45} },  // 114
+    { {-100, 46}, {-30, -63}, {272, -127}, {30, 63}, {-100, 46} },  // 115
+    { {-99, 48}, {-31, -63}, {270, -132}, {31, 63}, {-99, 48} },  // 116
+    { {-98, 50}, {-32, -62}, {267, -136}, {32, 62}, {-98, 50} },  // 117
+    { {-97, 52}, {-33, -62}, {265, -141}, {33, 62}, {-97, 52} },  // 118
+    { {-96, 53}, {-34, -61}, {262, -145}, {34, 61}, {-96, 53} },  // 119
+    { {-95, 55}, {-35, -61}, {260, -150}, {35, 61}, {-95, 55} },  // 120
+    { {-94, 57}, {-36, -60}, {257, -155}, {36, 60}, {-94, 57} },  // 121
+    { {-93, 58}, {-37, -59}, {254, -159}, {37, 59}, {-93, 58} },  // 122
+    { {-92, 60}, {-38, -59}, {252, -163}, {38, 59}, {-92, 60} },  // 123
+    { {-91, 62}, {-39, -58}, {249, -168}, {39, 58}, {-91, 62} },  // 124
+    { {-90, 63}, {-40, -57}, {246, -172}, {40, 57}, {-90, 63} },  // 125
+    { {-89, 65}, {-41, -57}, {243, -176}, {41, 57}, {-89, 65} },  // 126
+    { {-88, 66}, {-42, -56}, {240, -181}, {42, 56}, {-88, 66} },  // 127
+    { {-87, 68}, {-43, -55}, {236, -185}, {43, 55}, {-87, 68} },  // 128
+    { {-85, 69}, {-44, -54}, {233, -189}, {44, 54}, {-85, 69} },  // 129
+    { {-84, 71}, {-45, -54}, {230, -193}, {45, 54}, {-84, 71} },  // 130
+    { {-83, 72}, {-46, -53}, {226, -197}, {46, 53}, {-83, 72} },  // 131
+    { {-82, 74}, {-47, -52}, {223, -201}, {47, 52}, {-82, 74} },  // 132
+    { {-80, 75}, {-48, -51}, {219, -205}, {48, 51}, {-80, 75} },  // 133
+    { {-79, 76}, {-49, -50}, {216, -208}, {49, 50}, {-79, 76} },  // 134
+    { {-78, 78}, {-49, -49}, {212, -212}, {49, 49}, {-78, 78} },  // 135
+    { {-76, 79}, {-50, -49}, {208, -216}, {50, 49}, {-76, 79} },  // 136
+    { {-75, 80}, {-51, -48}, {205, -219}, {51, 48}, {-75, 80} },  // 137
+    { {-74, 82}, {-52, -47}, {201, -223}, {52, 47}, {-74, 82} },  // 138
+    { {-72, 83}, {-53, -46}, {197, -226}, {53, 46}, {-72, 83} },  // 139
+    { {-71, 84}, {-54, -45}, {193, -230}, {54, 45}, {-71, 84} },  // 140
+    { {-69, 85}, {-54, -44}, {189, -233}, {54, 44}, {-69, 85} },  // 141
+    { {-68, 87}, {-55, -43}, {185, -236}, {55, 43}, {-68, 87} },  // 142
+    { {-66, 88}, {-56, -42}, {181, -240}, {56, 42}, {-66, 88} },  // 143
+    { {-65, 89}, {-57, -41}, {176, -243}, {57, 41}, {-65, 89} },  // 144
+    { {-63, 90}, {-57, -40}, {172, -246}, {57, 40}, {-63, 90} },  // 145
+    { {-62, 91}, {-58, -39}, {168, -249}, {58, 39}, {-62, 91} },  // 146
+    { {-60, 92}, {-59, -38}, {163, -252}, {59, 38}, {-60, 92} },  // 147
+    { {-58, 93}, {-59, -37}, {159, -254}, {59, 37}, {-58, 93} },  // 148
+    { {-57, 94}, {-60, -36}, {155, -257}, {60, 36}, {-57, 94} },  // 149
+    { {-55, 95}, {-61, -35}, {150, -260}, {61, 35}, {-55, 95} },  // 150
+    { {-53, 96}, {-61, -34}, {145, -262}, {61, 34}, {-53, 96} },  // 151
+    { {-52, 97}, {-62, -33}, {141, -265}, {62, 33}, {-52, 97} },  // 152
+    { {-50, 98}, {-62, -32}, {136, -267}, {62, 32}, {-50, 98} },  // 153
+    { {-48, 99}, {-63, -31}, {132, -270}, {63, 31}, {-48, 99} },  // 154
+    { {-46, 100}, {-63, -30}, {127, -272}, {63, 30}, {-46, 100} },  // 155
+    { {-45, 100}, {-64, -28}, {122, -274}, {64, 28}, {-45, 100} },  // 156
+    { {-43, 101}, {-64, -27}, {117, -276}, {64, 27}, {-43, 101} },  // 157
+    { {-41, 102}, {-65, -26}, {112, -278}, {65, 26}, {-41, 102} },  // 158
+    { {-39, 103}, {-65, -25}, {108, -280}, {65, 25}, {-39, 103} },  // 159
+    { {-38, 103}, {-66, -24}, {103, -282}, {66, 24}, {-38, 103} },  // 160
+    { {-36, 104}, {-66, -23}, {98, -284}, {66, 23}, {-36, 104} },  // 161
+    { {-34, 105}, {-67, -22}, {93, -285}, {67, 22}, {-34, 105} },  // 162
+    { {-32, 105}, {-67, -20}, {88, -287}, {67, 20}, {-32, 105} },  // 163
+    { {-30, 106}, {-67, -19}, {83, -288}, {67, 19}, {-30, 106} },  // 164
+    { {-28, 106}, {-68, -18}, {78, -290}, {68, 18}, {-28, 106} },  // 165
+    { {-27, 107}, {-68, -17}, {73, -291}, {68, 17}, {-27, 107} },  // 166
+    { {-25, 107}, {-68, -16}, {67, -292}, {68, 16}, {-25, 107} },  // 167
+    { {-23, 108}, {-68, -15}, {62, -293}, {68, 15}, {-23, 108} },  // 168
+    { {-21, 108}, {-69, -13}, {57, -294}, {69, 13}, {-21, 108} },  // 169
+    { {-19, 108}, {-69, -12}, {52, -295}, {69, 12}, {-19, 108} },  // 170
+    { {-17, 109}, {-69, -11}, {47, -296}, {69, 11}, {-17, 109} },  // 171
+    { {-15, 109}, {-69, -10}, {42, -297}, {69, 10}, {-15, 109} },  // 172
+    { {-13, 109}, {-69, -9}, {37, -298}, {69, 9}, {-13, 109} },  // 173
+    { {-11, 109}, {-70, -7}, {31, -298}, {70, 7}, {-11, 109} },  // 174
+    { {-10, 110}, {-70, -6}, {26, -299}, {70, 6}, {-10, 110} },  // 175
+    { {-8, 110}, {-70, -5}, {21, -299}, {70, 5}, {-8, 110} },  // 176
+    { {-6, 110}, {-70, -4}, {16, -300}, {70, 4}, {-6, 110} },  // 177
+    { {-4, 110}, {-70, -2}, {10, -300}, {70, 2}, {-4, 110} },  // 178
+    { {-2, 110}, {-70, -1}, {5, -300}, {70, 1}, {-2, 110} },  // 179
+    { {0, 110}, {-70, 0}, {0, -300}, {70, 0}, {0, 110} },  // 180
+    { {2, 110}, {-70, 1}, {-5, -300}, {70, -1}, {2, 110} },  // 181
+    { {4, 110}, {-70, 2}, {-10, -300}, {70, -2}, {4, 110} },  // 182
+    { {6, 110}, {-70, 4}, {-16, -300}, {70, -4}, {6, 110} },  // 183
+    { {8, 110}, {-70, 5}, {-21, -299}, {70, -5}, {8, 110} },  // 184
+    { {10, 110}, {-70, 6}, {-26, -299}, {70, -6}, {10, 110} },  // 185
+    { {11, 109}, {-70, 7}, {-31, -298}, {70, -7}, {11, 109} },  // 186
+    { {13, 109}, {-69, 9}, {-37, -298}, {69, -9}, {13, 109} },  // 187
+    { {15, 109}, {-69, 10}, {-42, -297}, {69, -10}, {15, 109} },  // 188
+    { {17, 109}, {-69, 11}, {-47, -296}, {69, -11}, {17, 109} },  // 189
+    { {19, 108}, {-69, 12}, {-52, -295}, {69, -12}, {19, 108} },  // 190
+    { {21, 108}, {-69, 13}, {-57, -294}, {69, -13}, {21, 108} },  // 191
+    { {23, 108}, {-68, 15}, {-62, -293}, {68, -15}, {23, 108} },  // 192
+    { {25, 107}, {-68, 16}, {-67, -292}, {68, -16}, {25, 107} },  // 193
+    { {27, 107}, {-68, 17}, {-73, -291}, {68, -17}, {27, 107} },  // 194
+    { {28, 106}, {-68, 18}, {-78, -290}, {68, -18}, {28, 106} },  // 195
+    { {30, 106}, {-67, 19}, {-83, -288}, {67, -19}, {30, 106} },  // 196
+    { {32, 105}, {-67, 20}, {-88, -287}, {67, -20}, {32, 105} },  // 197
+    { {34, 105}, {-67, 22}, {-93, -285}, {67, -22}, {34, 105} },  // 198
+    { {36, 104}, {-66, 23}, {-98, -284}, {66, -23}, {36, 104} },  // 199
+    { {38, 103}, {-66, 24}, {-103, -282}, {66, -24}, {38, 103} },  // 200
+    { {39, 103}, {-65, 25}, {-108, -280}, {65, -25}, {39, 103} },  // 201
+    { {41, 102}, {-65, 26}, {-112, -278}, {65, -26}, {41, 102} },  // 202
+    { {43, 101}, {-64, 27}, {-117, -276}, {64, -27}, {43, 101} },  // 203
+    { {45, 100}, {-64, 28}, {-122, -274}, {64, -28}, {45, 100} },  // 204
+    { {46, 100}, {-63, 30}, {-127, -272}, {63, -30}, {46, 100} },  // 205
+    { {48, 99}, {-63, 31}, {-132, -270}, {63, -31}, {48, 99} },  // 206
+    { {50, 98}, {-62, 32}, {-136, -267}, {62, -32}, {50, 98} },  // 207
+    { {52, 97}, {-62, 33}, {-141, -265}, {62, -33}, {52, 97} },  // 208
+    { {53, 96}, {-61, 34}, {-145, -262}, {61, -34}, {53, 96} },  // 209
+    { {55, 95}, {-61, 35}, {-150, -260}, {61, -35}, {55, 95} },  // 210
+    { {57, 94}, {-60, 36}, {-155, -257}, {60, -36}, {57, 94} },  // 211
+    { {58, 93}, {-59, 37}, {-159, -254}, {59, -37}, {58, 93} },  // 212
+    { {60, 92}, {-59, 38}, {-163, -252}, {59, -38}, {60, 92} },  // 213
+    { {62, 91}, {-58, 39}, {-168, -249}, {58, -39}, {62, 91} },  // 214
+    { {63, 90}, {-57, 40}, {-172, -246}, {57, -40}, {63, 90} },  // 215
+    { {65, 89}, {-57, 41}, {-176, -243}, {57, -41}, {65, 89} },  // 216
+    { {66, 88}, {-56, 42}, {-181, -240}, {56, -42}, {66, 88} },  // 217
+    { {68, 87}, {-55, 43}, {-185, -236}, {55, -43}, {68, 87} },  // 218
+    { {69, 85}, {-54, 44}, {-189, -233}, {54, -44}, {69, 85} },  // 219
+    { {71, 84}, {-54, 45}, {-193, -230}, {54, -45}, {71, 84} },  // 220
+    { {72, 83}, {-53, 46}, {-197, -226}, {53, -46}, {72, 83} },  // 221
+    { {74, 82}, {-52, 47}, {-201, -223}, {52, -47}, {74, 82} },  // 222
+    { {75, 80}, {-51, 48}, {-205, -219}, {51, -48}, {75, 80} },  // 223
+    { {76, 79}, {-50, 49}, {-208, -216}, {50, -49}, {76, 79} },  // 224
+    { {78, 78}, {-49, 49}, {-212, -212}, {49, -49}, {78, 78} },  // 225
+    { {79, 76}, {-49, 50}, {-216, -208}, {49, -50}, {79, 76} },  // 226
+    { {80, 75}, {-48, 51}, {-219, -205}, {48, -51}, {80, 75} },  // 227
+    { {82, 74}, {-47, 52}, {-223, -201}, {47, -52}, {82, 74} },  // 228
+    { {83, 72}, {-46, 53}, {-226, -197}, {46, -53}, {83, 72} },  // 229
+    { {84, 71}, {-45, 54}, {-230, -193}, {45, -54}, {84, 71} },  // 230
+    { {85, 69}, {-44, 54}, {-233, -189}, {44, -54}, {85, 69} },  // 231
+    { {87, 68}, {-43, 55}, {-236, -185}, {43, -55}, {87, 68} },  // 232
+    { {88, 66}, {-42, 56}, {-240, -181}, {42, -56}, {88, 66} },  // 233
+    { {89, 65}, {-41, 57}, {-243, -176}, {41, -57}, {89, 65} },  // 234
+    { {90, 63}, {-40, 57}, {-246, -172}, {40, -57}, {90, 63} },  // 235
+    { {91, 62}, {-39, 58}, {-249, -168}, {39, -58}, {91, 62} },  // 236
+    { {92, 60}, {-38, 59}, {-252, -163}, {38, -59}, {92, 60} },  // 237
+    { {93, 58}, {-37, 59}, {-254, -159}, {37, -59}, {93, 58} },  // 238
+    { {94, 57}, {-36, 60}, {-257, -155}, {36, -60}, {94, 57} },  // 239
+    { {95, 55}, {-35, 61}, {-260, -150}, {35, -61}, {95, 55} },  // 240
+    { {96, 53}, {-34, 61}, {-262, -145}, {34, -61}, {96, 53} },  // 241
+    { {97, 52}, {-33, 62}, {-265, -141}, {33, -62}, {97, 52} },  // 242
+    { {98, 50}, {-32, 62}, {-267, -136}, {32, -62}, {98, 50} },  // 243
+    { {99, 48}, {-31, 63}, {-270, -132}, {31, -63}, {99, 48} },  // 244
+    { {100, 46}, {-30, 63}, {-272, -127}, {30, -63}, {100, 46} },  // 245
+    { {100, 45}, {-28, 64}, {-274, -122}, {28, -64}, {100, 45} },  // 246
+    { {101, 43}, {-27, 64}, {-276, -117}, {27, -64}, {101, 43} },  // 247
+    { {102, 41}, {-26, 65}, {-278, -112}, {26, -65}, {102, 41} },  // 248
+    { {103, 39}, {-25, 65}, {-280, -108}, {25, -65}, {103, 39} },  // 249
+    { {103, 38}, {-24, 66}, {-282, -103}, {24, -66}, {103, 38} },  // 250
+    { {104, 36}, {-23, 66}, {-284, -98}, {23, -66}, {104, 36} },  // 251
+    { {105, 34}, {-22, 67}, {-285, -93}, {22, -67}, {105, 34} },  // 252
+    { {105, 32}, {-20, 67}, {-287, -88}, {20, -67}, {105, 32} },  // 253
+    { {106, 30}, {-19, 67}, {-288, -83}, {19, -67}, {106, 30} },  // 254
+    { {106, 28}, {-18, 68}, {-290, -78}, {18, -68}, {106, 28} },  // 255
+    { {107, 27}, {-17, 68}, {-291, -73}, {17, -68}, {107, 27} },  // 256
+    { {107, 25}, {-16, 68}, {-292, -67}, {16, -68}, {107, 25} },  // 257
+    { {108, 23}, {-15, 68}, {-293, -62}, {15, -68}, {108, 23} },  // 258
+    { {108, 21}, {-13, 69}, {-294, -57}, {13, -69}, {108, 21} },  // 259
+    { {108, 19}, {-12, 69}, {-295, -52}, {12, -69}, {108, 19} },  // 260
+    { {109, 17}, {-11, 69}, {-296, -47}, {11, -69}, {109, 17} },  // 261
+    { {109, 15}, {-10, 69}, {-297, -42}, {10, -69}, {109, 15} },  // 262
+    { {109, 13}, {-9, 69}, {-298, -37}, {9, -69}, {109, 13} },  // 263
+    { {109, 11}, {-7, 70}, {-298, -31}, {7, -70}, {109, 11} },  // 264
+    { {110, 10}, {-6, 70}, {-299, -26}, {6, -70}, {110, 10} },  // 265
+    { {110, 8}, {-5, 70}, {-299, -21}, {5, -70}, {110, 8} },  // 266
+    { {110, 6}, {-4, 70}, {-300, -16}, {4, -70}, {110, 6} },  // 267
+    { {110, 4}, {-2, 70}, {-300, -10}, {2, -70}, {110, 4} },  // 268
+    { {110, 2}, {-1, 70}, {-300, -5}, {1, -70}, {110, 2} },  // 269
+    { {110, 0}, {0, 70}, {-300, 0}, {0, -70}, {110, 0} },  // 270
+    { {110, -2}, {1, 70}, {-300, 5}, {-1, -70}, {110, -2} },  // 271
+    { {110, -4}, {2, 70}, {-300, 10}, {-2, -70}, {110, -4} },  // 272
+    { {110, -6}, {4, 70}, {-300, 16}, {-4, -70}, {110, -6} },  // 273
+    { {110, -8}, {5, 70}, {-299, 21}, {-5, -70}, {110, -8} },  // 274
+    { {110, -10}, {6, 70}, {-299, 26}, {-6, -70}, {110, -10} },  // 275
+    { {109, -11}, {7, 70}, {-298, 31}, {-7, -70}, {109, -11} },  // 276
+    { {109, -13}, {9, 69}, {-298, 37}, {-9, -69}, {109, -13} },  // 277
+    { {109, -15}, {10, 69}, {-297, 42}, {-10, -69}, {109, -15} },  // 278
+    { {109, -17}, {11, 69}, {-296, 47}, {-11, -69}, {109, -17} },  // 279
+    { {108, -19}, {12, 69}, {-295, 52}, {-12, -69}, {108, -19} },  // 280
+    { {108, -21}, {13, 69}, {-294, 57}, {-13, -69}, {108, -21} },  // 281
+    { {108, -23}, {15, 68}, {-293, 62}, {-15, -68}, {108, -23} },  // 282
+    { {107, -25}, {16, 68}, {-292, 67}, {-16, -68}, {107, -25} },  // 283
+    { {107, -27}, {17, 68}, {-291, 73}, {-17, -68}, {107, -27} },  // 284
+    { {106, -28}, {18, 68}, {-290, 78}, {-18, -68}, {106, -28} },  // 285
+    { {106, -30}, {19, 67}, {-288, 83}, {-19, -67}, {106, -30} },  // 286
+    { {105, -32}, {20, 67}, {-287, 88}, {-20, -67}, {105, -32} },  // 287
+    { {105, -34}, {22, 67}, {-285, 93}, {-22, -67}, {105, -34} },  // 288
+    { {104, -36}, {23, 66}, {-284, 98}, {-23, -66}, {104, -36} },  // 289
+    { {103, -38}, {24, 66}, {-282, 103}, {-24, -66}, {103, -38} },  // 290
+    { {103, -39}, {25, 65}, {-280, 108}, {-25, -65}, {103, -39} },  // 291
+    { {102, -41}, {26, 65}, {-278, 112}, {-26, -65}, {102, -41} },  // 292
+    { {101, -43}, {27, 64}, {-276, 117}, {-27, -64}, {101, -43} },  // 293
+    { {100, -45}, {28, 64}, {-274, 122}, {-28, -64}, {100, -45} },  // 294
+    { {100, -46}, {30, 63}, {-272, 127}, {-30, -63}, {100, -46} },  // 295
+    { {99, -48}, {31, 63}, {-270, 132}, {-31, -63}, {99, -48} },  // 296
+    { {98, -50}, {32, 62}, {-267, 136}, {-32, -62}, {98, -50} },  // 297
+    { {97, -52}, {33, 62}, {-265, 141}, {-33, -62}, {97, -52} },  // 298
+    { {96, -53}, {34, 61}, {-262, 145}, {-34, -61}, {96, -53} },  // 299
+    { {95, -55}, {35, 61}, {-260, 150}, {-35, -61}, {95, -55} },  // 300
+    { {94, -57}, {36, 60}, {-257, 155}, {-36, -60}, {94, -57} },  // 301
+    { {93, -58}, {37, 59}, {-254, 159}, {-37, -59}, {93, -58} },  // 302
+    { {92, -60}, {38, 59}, {-252, 163}, {-38, -59}, {92, -60} },  // 303
+    { {91, -62}, {39, 58}, {-249, 168}, {-39, -58}, {91, -62} },  // 304
+    { {90, -63}, {40, 57}, {-246, 172}, {-40, -57}, {90, -63} },  // 305
+    { {89, -65}, {41, 57}, {-243, 176}, {-41, -57}, {89, -65} },  // 306
+    { {88, -66}, {42, 56}, {-240, 181}, {-42, -56}, {88, -66} },  // 307
+    { {87, -68}, {43, 55}, {-236, 185}, {-43, -55}, {87, -68} },  // 308
+    { {85, -69}, {44, 54}, {-233, 189}, {-44, -54}, {85, -69} },  // 309
+    { {84, -71}, {45, 54}, {-230, 193}, {-45, -54}, {84, -71} },  // 310
+    { {83, -72}, {46, 53}, {-226, 197}, {-46, -53}, {83, -72} },  // 311
+    { {82, -74}, {47, 52}, {-223, 201}, {-47, -52}, {82, -74} },  // 312
+    { {80, -75}, {48, 51}, {-219, 205}, {-48, -51}, {80, -75} },  // 313
+    { {79, -76}, {49, 50}, {-216, 208}, {-49, -50}, {79, -76} },  // 314
+    { {78, -78}, {49, 49}, {-212, 212}, {-49, -49}, {78, -78} },  // 315
+    { {76, -79}, {50, 49}, {-208, 216}, {-50, -49}, {76, -79} },  // 316
+    { {75, -80}, {51, 48}, {-205, 219}, {-51, -48}, {75, -80} },  // 317
+    { {74, -82}, {52, 47}, {-201, 223}, {-52, -47}, {74, -82} },  // 318
+    { {72, -83}, {53, 46}, {-197, 226}, {-53, -46}, {72, -83} },  // 319
+    { {71, -84}, {54, 45}, {-193, 230}, {-54, -45}, {71, -84} },  // 320
+    { {69, -85}, {54, 44}, {-189, 233}, {-54, -44}, {69, -85} },  // 321
+    { {68, -87}, {55, 43}, {-185, 236}, {-55, -43}, {68, -87} },  // 322
+    { {66, -88}, {56, 42}, {-181, 240}, {-56, -42}, {66, -88} },  // 323
+    { {65, -89}, {57, 41}, {-176, 243}, {-57, -41}, {65, -89} },  // 324
+    { {63, -90}, {57, 40}, {-172, 246}, {-57, -40}, {63, -90} },  // 325
+    { {62, -91}, {58, 39}, {-168, 249}, {-58, -39}, {62, -91} },  // 326
+    { {60, -92}, {59, 38}, {-163, 252}, {-59, -38}, {60, -92} },  // 327
+    { {58, -93}, {59, 37}, {-159, 254}, {-59, -37}, {58, -93} },  // 328
+    { {57, -94}, {60, 36}, {-155, 257}, {-60, -36}, {57, -94} },  // 329
+    { {55, -95}, {61, 35}, {-150, 260}, {-61, -35}, {55, -95} },  // 330
+    { {53, -96}, {61, 34}, {-145, 262}, {-61, -34}, {53, -96} },  // 331
+    { {52, -97}, {62, 33}, {-141, 265}, {-62, -33}, {52, -97} },  // 332
+    { {50, -98}, {62, 32}, {-136, 267}, {-62, -32}, {50, -98} },  // 333
+    { {48, -99}, {63, 31}, {-132, 270}, {-63, -31}, {48, -99} },  // 334
+    { {46, -100}, {63, 30}, {-127, 272}, {-63, -30}, {46, -100} },  // 335
+    { {45, -100}, {64, 28}, {-122, 274}, {-64, -28}, {45, -100} },  // 336
+    { {43, -101}, {64, 27}, {-117, 276}, {-64, -27}, {43, -101} },  // 337
+    { {41, -102}, {65, 26}, {-112, 278}, {-65, -26}, {41, -102} },  // 338
+    { {39, -103}, {65, 25}, {-108, 280}, {-65, -25}, {39, -103} },  // 339
+    { {38, -103}, {66, 24}, {-103, 282}, {-66, -24}, {38, -103} },  // 340
+    { {36, -104}, {66, 23}, {-98, 284}, {-66, -23}, {36, -104} },  // 341
+    { {34, -105}, {67, 22}, {-93, 285}, {-67, -22}, {34, -105} },  // 342
+    { {32, -105}, {67, 20}, {-88, 287}, {-67, -20}, {32, -105} },  // 343
+    { {30, -106}, {67, 19}, {-83, 288}, {-67, -19}, {30, -106} },  // 344
+    { {28, -106}, {68, 18}, {-78, 290}, {-68, -18}, {28, -106} },  // 345
+    { {27, -107}, {68, 17}, {-73, 291}, {-68, -17}, {27, -107} },  // 346
+    { {25, -107}, {68, 16}, {-67, 292}, {-68, -16}, {25, -107} },  // 347
+    { {23, -108}, {68, 15}, {-62, 293}, {-68, -15}, {23, -108} },  // 348
+    { {21, -108}, {69, 13}, {-57, 294}, {-69, -13}, {21, -108} },  // 349
+    { {19, -108}, {69, 12}, {-52, 295}, {-69, -12}, {19, -108} },  // 350
+    { {17, -109}, {69, 11}, {-47, 296}, {-69, -11}, {17, -109} },  // 351
+    { {15, -109}, {69, 10}, {-42, 297}, {-69, -10}, {15, -109} },  // 352
+    { {13, -109}, {69, 9}, {-37, 298}, {-69, -9}, {13, -109} },  // 353
+    { {11, -109}, {70, 7}, {-31, 298}, {-70, -7}, {11, -109} },  // 354
+    { {10, -110}, {70, 6}, {-26, 299}, {-70, -6}, {10, -110} },  // 355
+    { {8, -110}, {70, 5}, {-21, 299}, {-70, -5}, {8, -110} },  // 356
+    { {6, -110}, {70, 4}, {-16, 300}, {-70, -4}, {6, -110} },  // 357
+    { {4, -110}, {70, 2}, {-10, 300}, {-70, -2}, {4, -110} },  // 358
+    { {2, -110}, {70, 1}, {-5, 300}, {-70, -1}, {2, -110} },  // 359
+};
+
+const ROTPOINT handPoseMinute[POSE_STEPS][CLOCK_HAND_POINTS] = {
+    { {0, -150}, {40, 0}, {0, 420}, {-40, 0}, {0, -150} },  // 0
+    { {-16, -149}, {40, -4}, {44, 418}, {-40, 4}, {-16, -149} },  // 6
+    { {-31, -147}, {39, -8}, {87, 411}, {-39, 8}, {-31, -147} },  // 12
+    { {-46, -143}, {38, -12}, {130, 399}, {-38, 12}, {-46, -143} },  // 18
+    { {-61, -137}, {37, -16}, {171, 384}, {-37, 16}, {-61, -137} },  // 24
+    { {-75, -130}, {35, -20}, {210, 364}, {-35, 20}, {-75, -130} },  // 30
+    { {-88, -121}, {32, -24}, {247, 340}, {-32, 24}, {-88, -121} },  // 36
+    { {-100, -111}, {30, -27}, {281, 312}, {-30, 27}, {-100, -111} },  // 42
+    { {-111, -100}, {27, -30}, {312, 281}, {-27, 30}, {-111, -100} },  // 48
+    { {-121, -88}, {24, -32}, {340, 247}, {-24, 32}, {-121, -88} },  // 54
+    { {-130, -75}, {20, -35}, {364, 210}, {-20, 35}, {-130, -75} },  // 60
+    { {-137, -61}, {16, -37}, {384, 171}, {-16, 37}, {-137, -61} },  // 66
+    { {-143, -46}, {12, -38}, {399, 130}, {-12, 38}, {-143, -46} },  // 72
+    { {-147, -31}, {8, -39}, {411, 87}, {-8, 39}, {-147, -31} },  // 78
+    { {-149, -16}, {4, -40}, {418, 44}, {-4, 40}, {-149, -16} },  // 84
+    { {-150, 0}, {0, -40}, {420, 0}, {0, 40}, {-150, 0} },  // 90
+    { {-149, 16}, {-4, -40}, {418, -44}, {4, 40}, {-149, 16} },  // 96
+    { {-147, 31}, {-8, -39}, {411, -87}, {8, 39}, {-147, 31} },  // 102
+    { {-143, 46}, {-12, -38}, {399, -130}, {12, 38}, {-143, 46} },  // 108
+    { {-137, 61}, {-16, -37}, {384, -171}, {16, 37}, {-137, 61} },  // 114
+    { {-130, 75}, {-20, -35}, {364, -210}, {20, 35}, {-130, 75} },  // 120
+    { {-121, 88}, {-24, -32}, {340, -247}, {24, 32}, {-121, 88} },  // 126
+    { {-111, 100}, {-27, -30}, {312, -281}, {27, 30}, {-111, 100} },  // 132
+    { {-100, 111}, {-30, -27}, {281, -312}, {30, 27}, {-100, 111} },  // 138
+    { {-88, 121}, {-32, -24}, {247, -340}, {32, 24}, {-88, 121} },  // 144
+    { {-75, 130}, {-35, -20}, {210, -364}, {35, 20}, {-75, 130} },  // 150
+    { {-61, 137}, {-37, -16}, {171, -384}, {37, 16}, {-61, 137} },  // 156
+    { {-46, 143}, {-38, -12}, {130, -399}, {38, 12}, {-46, 143} },  // 162
+    { {-31, 147}, {-39, -8}, {87, -411}, {39, 8}, {-31, 147} },  // 168
+    { {-16, 149}, {-40, -4}, {44, -418}, {40, 4}, {-16, 149} },  // 174
+    { {0, 150}, {-40, 0}, {0, -420}, {40, 0}, {0, 150} },  // 180
+    { {16, 149}, {-40, 4}, {-44, -418}, {40, -4}, {16, 149} },  // 186
+    { {31, 147}, {-39, 8}, {-87, -411}, {39, -8}, {31, 147} },  // 192
+    { {46, 143}, {-38, 12}, {-130, -399}, {38, -12}, {46, 143} },  // 198
+    { {61, 137}, {-37, 16}, {-171, -384}, {37, -16}, {61, 137} },  // 204
+    { {75, 130}, {-35, 20}, {-210, -364}, {35, -20}, {75, 130} },  // 210
+    { {88, 121}, {-32, 24}, {-247, -340}, {32, -24}, {88, 121} },  // 216
+    { {100, 111}, {-30, 27}, {-281, -312}, {30, -27}, {100, 111} },  // 222
+    { {111, 100}, {-27, 30}, {-312, -281}, {27, -30}, {111, 100} },  // 228
+    { {121, 88}, {-24, 32}, {-340, -247}, {24, -32}, {121, 88} },  // 234
+    { {130, 75}, {-20, 35}, {-364, -210}, {20, -35}, {130, 75} },  // 240
+    { {137, 61}, {-16, 37}, {-384, -171}, {16, -37}, {137, 61} },  // 246
+    { {143, 46}, {-12, 38}, {-399, -130}, {12, -38}, {143, 46} },  // 252
+    { {147, 31}, {-8, 39}, {-411, -87}, {8, -39}, {147, 31} },  // 258
+    { {149, 16}, {-4, 40}, {-418, -44}, {4, -40}, {149, 16} },  // 264
+    { {150, 0}, {0, 40}, {-420, 0}, {0, -40}, {150, 0} },  // 270
+    { {149, -16}, {4, 40}, {-418, 44}, {-4, -40}, {149, -16} },  // 276
+    { {147, -31}, {8, 39}, {-411, 87}, {-8, -39}, {147, -31} },  // 282
+    { {143, -46}, {12, 38}, {-399, 130}, {-12, -38}, {143, -46} },  // 288
+    { {137, -61}, {16, 37}, {-384, 171}, {-16, -37}, {137, -61} },  // 294
+    { {130, -75}, {20, 35}, {-364, 210}, {-20, -35}, {130, -75} },  // 300
+    { {121, -88}, {24, 32}, {-340, 247}, {-24, -32}, {121, -88} },  // 306
+    { {111, -100}, {27, 30}, {-312, 281}, {-27, -30}, {111, -100} },  // 312
+    { {100, -111}, {30, 27}, {-281, 312}, {-30, -27}, {100, -111} },  // 318
+    { {88, -121}, {32, 24}, {-247, 340}, {-32, -24}, {88, -121} },  // 324
+    { {75, -130}, {35, 20}, {-210, 364}, {-35, -20}, {75, -130} },  // 330
+    { {61, -137}, {37, 16}, {-171, 384}, {-37, -16}, {61, -137} },  // 336
+    { {46, -143}, {38, 12}, {-130, 399}, {-38, -12}, {46, -143} },  // 342
+    { {31, -147}, {39, 8}, {-87, 411}, {-39, -8}, {31, -147} },  // 348
+    { {16, -149}, {40, 4}, {-44, 418}, {-40, -4}, {16, -149} },  // 354
+};
+
+const ROTPOINT handPoseSecond[POSE_STEPS][CLOCK_HAND_POINTS] = {
+    { {0, 0}, {0, 0}, {0, 0}, {0, 0}, {0, 420} },  // 0
+    { {0, 0}, {0, 0}, {0, 0}, {0, 0}, {44, 418} },  // 6
+    { {0, 0}, {0, 0}, {0, 0}, {0, 0}, {87, 411} },  // 12
+    { {0, 0}, {0, 0}, {0, 0}, {0, 0}, {130, 399} },  // 18
+    { {0, 0}, {0, 0}, {0, 0}, {0, 0}, {171, 384} },  // 24
+    { {0, 0}, {0, 0}, {0, 0}, {0, 0}, {210, 364} },  // 30
+    { {0, 0}, {0, 0}, {0, 0}, {0, 0}, {247, 340} },  // 36
+    { {0, 0}, {0, 0}, {0, 0}, {0, 0}, {281, 312} },  // 42
+    { {0, 0}, {0, 0}, {0, 0}, {0, 0}, {312, 281} },  // 48
+    { {0, 0}, {0, 0}, {0, 0}, {0, 0}, {340, 247} },  // 54
+    { {0, 0}, {0, 0}, {0, 0}, {0, 0}, {364, 210} },  // 60
+    { {0, 0}, {0, 0}, {0, 0}, {0, 0}, {384, 171} },  // 66
+    { {0, 0}, {0, 0}, {0, 0}, {0, 0}, {399, 130} },  // 72
+    { {0, 0}, {0, 0}, {0, 0}, {0, 0}, {411, 87} },  // 78
+    { {0, 0}, {0, 0}, {0, 0}, {0, 0}, {418, 44} },  // 84
+    { {0, 0}, {0, 0}, {0, 0}, {0, 0}, {420, 0} },  // 90
+    { {0, 0}, {0, 0}, {0, 0}, {0, 0}, {418, -44} },  // 96
+    { {0, 0}, {0, 0}, {0, 0}, {0, 0}, {411, -87} },  // 102
+    { {0, 0}, {0, 0}, {0, 0}, {0, 0}, {399, -130} },  // 108
+    { {0, 0}, {0, 0}, {0, 0}, {0, 0}, {384, -171} },  // 114
+    { {0, 0}, {0, 0}, {0, 0}, {0, 0}, {364, -210} },  // 120
+    { {0, 0}, {0, 0}, {0, 0}, {0, 0}, {340, -247} },  // 126
+    { {0, 0}, {0, 0}, {0, 0}, {0, 0}, {312, -281} },  // 132
+    { {0, 0}, {0, 0}, {0, 0}, {0, 0}, {281, -312} },  // 138
+    { {0, 0}, {0, 0}, {0, 0}, {0, 0}, {247, -340} },  // 144
+    { {0, 0}, {0, 0}, {0, 0}, {0, 0}, {210, -364} },  // 150
+    { {0, 0}, {0, 0}, {0, 0}, {0, 0}, {171, -384} },  // 156
+    { {0, 0}, {0, 0}, {0, 0}, {0, 0}, {130, -399} },  // 162
+    { {0, 0}, {0, 0}, {0, 0}, {0, 0}, {87, -411} },  // 168
+    { {0, 0}, {0, 0}, {0, 0}, {0, 0}, {44, -418} },  // 174
+    { {0, 0}, {0, 0}, {0, 0}, {0, 0}, {0, -420} },  // 180
+    { {0, 0}, {0, 0}, {0, 0}, {0, 0}, {-44, -418} },  // 186
+    { {0, 0}, {0, 0}, {0, 0}, {0, 0}, {-87, -411} },  // 192
+    { {0, 0}, {0, 0}, {0, 0}, {0, 0}, {-130, -399} },  // 198
+    { {0, 0}, {0, 0}, {0, 0}, {0, 0}, {-171, -384} },  // 204
+    { {0, 0}, {0, 0}, {0, 0}, {0, 0}, {-210, -364} },  // 210
+    { {0, 0}, {0, 0}, {0, 0}, {0, 0}, {-247, -340} },  // 216
+    { {0, 0}, {0, 0}, {0, 0}, {0, 0}, {-281, -312} },  // 222
+    { {0, 0}, {0, 0}, {0, 0}, {0, 0}, {-312, -281} },  // 228
+    { {0, 0}, {0, 0}, {0, 0}, {0, 0}, {-340, -247} },  // 234
+    { {0, 0}, {0, 0}, {0, 0}, {0, 0}, {-364, -210} },  // 240
+    { {0, 0}, {0, 0}, {0, 0}, {0, 0}, {-384, -171} },  // 246
+    { {0, 0}, {0, 0}, {0, 0}, {0, 0}, {-399, -130} },  // 252
+    { {0, 0}, {0, 0}, {0, 0}, {0, 0}, {-411, -87} },  // 258
+    { {0, 0}, {0, 0}, {0, 0}, {0, 0}, {-418, -44} },  // 264
+    { {0, 0}, {0, 0}, {0, 0}, {0, 0}, {-420, 0} },  // 270
+    { {0, 0}, {0, 0}, {0, 0}, {0, 0}, {-418, 44} },  // 276
+    { {0, 0}, {0, 0}, {0, 0}, {0, 0}, {-411, 87} },  // 282
+    { {0, 0}, {0, 0}, {0, 0}, {0, 0}, {-399, 130} },  // 288
+    { {0, 0}, {0, 0}, {0, 0}, {0, 0}, {-384, 171} },  // 294
+    { {0, 0}, {0, 0}, {0, 0}, {0, 0}, {-364, 210} },  // 300
+    { {0, 0}, {0, 0}, {0, 0}, {0, 0}, {-340, 247} },  // 306
+    { {0, 0}, {0, 0}, {0, 0}, {0, 0}, {-312, 281} },  // 312
+    { {0, 0}, {0, 0}, {0, 0}, {0, 0}, {-281, 312} },  // 318
+    { {0, 0}, {0, 0}, {0, 0}, {0, 0}, {-247, 340} },  // 324
+    { {0, 0}, {0, 0}, {0, 0}, {0, 0}, {-210, 364} },  // 330
+    { {0, 0}, {0, 0}, {0, 0}, {0, 0}, {-171, 384} },  // 336
+    { {0, 0}, {0, 0}, {0, 0}, {0, 0}, {-130, 399} },  // 342
+    { {0, 0}, {0, 0}, {0, 0}, {0, 0}, {-87, 411} },  // 348
+    { {0, 0}, {0, 0}, {0, 0}, {0, 0}, {-44, 418} },  // 354
+};
@@ -0,0 +1,22 @@
+/*--------------------------
+    HANDPOSES.H -- Hand outlines at every angle a tick can show
+---------------------------*/
+
+#ifndef HANDPOSES_H
+#define HANDPOSES_H
+
+#include "clockdraw.h"
+
+// The hour hand moves in whole degrees ((wHour * 30) % 360 + wMinute / 2);
+// the minute and second hands in 6 degree steps
+#define POSE_HOUR_ANGLES 360
+#define POSE_STEPS 60
+#define POSE_STEP_DEGREES 6
+
+// Generated by mkposes into handposes.c. Each pose is CLOCK_HAND_POINTS
+// consecutive points, so a lookup touches one or two cache lines.
+extern const ROTPOINT handPoseHour[POSE_HOUR_ANGLES][CLOCK_HAND_POINTS];
+extern const ROTPOINT handPoseMinute[POSE_STEPS][CLOCK_HAND_POINTS];
+extern const ROTPOINT handPoseSecond[POSE_STEPS][CLOCK_HAND_POINTS];
+
+#endif
@@ -0,0 +1,125 @@
+/*--------------------------
+    MIXER.C -- Sample-accurate mixer for resident sounds
+---------------------------*/
+
+#include <string.h>
+#include "mixer.h"
+
+// Samples summed per pass; a whole number of frames at any channel count
+#define MIX_CHUNK_SAMPLES (MIXER_MAX_CHANNELS * 256)
+
+void MixerInit(MIXER* pMixer, uint16_t wChannels, uint32_t dwSampleRate)
+{
+    memset(pMixer, 0, sizeof(*pMixer));
+    pMixer->wChannels = wChannels;
+    pMixer->dwSampleRate = dwSampleRate;
+}
+
+int MixerSchedule(MIXER* pMixer, const WAVSOUND* pSound, uint64_t qwStart)
+{
+    MIXVOICE* pVoice;
+
+    if (!pSound || !pSound->pSamples || pSound->dwSampleRate != pMixer->dwSampleRate ||
+        (pSound->wChannels != pMixer->wChannels && pSound->wChannels != 1) ||
+        pMixer->wChannels > MIXER_MAX_CHANNELS || pMixer->nVoices == MIXER_MAX_VOICES)
+        return 0;
+
+    pVoice = &pMixer->voices[pMixer->nVoices++];
+    memset(pVoice, 0, sizeof(*pVoice));
+    pVoice->pSound = pSound;
+    pVoice->qwStart = qwStart;
+    return 1;
+}
+
+void MixerClear(MIXER* pMixer)
+{
+    pMixer->nVoices = 0;
+}
+
+uint64_t MixerMsToFrames(const MIXER* pMixer, uint32_t dwMs)
+{
+    return (uint64_t)dwMs * pMixer->dwSampleRate / 1000;
+}
+
+static int16_t Clamp16(int32_t v)
+{
+    return (int16_t)(v > 32767 ? 32767 : v < -32768 ? -32768 : v);
+}
+
+// Mixes up to MIX_CHUNK_SAMPLES / wChannels frames: every voice is summed
+// into 32 bits first and the total clamped once on the way out
+static void MixChunk(MIXER* pMixer, int16_t* pOut, uint32_t dwFrames)
+{
+    int32_t acc[MIX_CHUNK_SAMPLES];
+    uint64_t qwEnd = pMixer->qwFrame + dwFrames;
+    uint32_t f, c, i;
+    int v;
+    uint16_t wCh = pMixer->wChannels;
+
+    memset(acc, 0, (size_t)dwFrames * wCh * sizeof(int32_t));
+
+    for (v = 0; v < pMixer->nVoices; )
+    {
+        MIXVOICE* pVoice = &pMixer->voices[v];
+        const WAVSOUND* pSound = pVoice->pSound;
+        uint64_t qwFrom;
+
+        if (pVoice->qwStart >= qwEnd)
+        {
+            v++;
+            continue;
+        }
+
+        // A start in the past plays from the top of this block
+        qwFrom = pVoice->qwStart > pMixer->qwFrame ? pVoice->qwStart : pMixer->qwFrame;
+        if (!pVoice->bStarted)
+        {
+            pVoice->bStarted = 1;
+            pVoice->qwStarted = qwFrom;
+            pMixer->qwLastStart = qwFrom;
+            pMixer->dwLastLateFrames = (uint32_t)(qwFrom - pVoice->qwStart);
+            pMixer->dwStarts++;
+        }
+
+        for (f = (uint32_t)(qwFrom - pMixer->qwFrame); f < dwFrames && pVoice->dwPos < pSound->dwFrames; f++)
+        {
+            const int16_t* pSrc = pSound->pSamples + (size_t)pVoice->dwPos * pSound->wChannels;
+
+            for (c = 0; c < wCh; c++)
+                acc[f * wCh + c] += pSrc[pSound->wChannels == 1 ? 0 : c];
+            pVoice->dwPos++;
+        }
+
+        // Finished voices are swapped out with the last one
+        if (pVoice->dwPos >= pSound->dwFrames)
+            *pVoice = pMixer->voices[--pMixer->nVoices];
+        else
+            v++;
+    }
+
+    for (i = 0; i < dwFrames * wCh; i++)
+        pOut[i] = Clamp16(acc[i]);
+    pMixer->qwFrame = qwEnd;
+}
+
+void MixerRender(MIXER* pMixer, int16_t* pOut, uint32_t dwFrames)
+{
+    uint16_t wCh = pMixer->wChannels;
+    uint32_t dwChunk, dwMax;
+
+    // Nothing can play in a mixer wider than the scratch buffer
+    if (wCh == 0 || wCh > MIXER_MAX_CHANNELS)
+    {
+        memset(pOut, 0, (size_t)dwFrames * wCh * sizeof(int16_t));
+        pMixer->qwFrame += dwFrames;
+        return;
+    }
+
+    dwMax = MIX_CHUNK_SAMPLES / wCh;
+    for (; dwFrames; dwFrames -= dwChunk)
+    {
+        dwChunk = dwFrames < dwMax ? dwFrames : dwMax;
+        MixChunk(pMixer, pOut, dwChunk);
+        pOut += (size_t)dwChunk * wCh;
+    }
+}
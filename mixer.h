@@ -0,0 +1,54 @@
+/*--------------------------
+    MIXER.H -- Sample-accurate mixer for resident sounds
+---------------------------*/
+
+#ifndef MIXER_H
+#define MIXER_H
+
+#include "wavfile.h"
+
+#define MIXER_MAX_VOICES 8
+#define MIXER_MAX_CHANNELS 8
+
+typedef struct
+{
+    const WAVSOUND* pSound;
+    uint64_t qwStart;           // output frame the sound is due to start on
+    uint64_t qwStarted;         // output frame it really started on
+    uint32_t dwPos;             // frames already played
+    int bStarted;
+} MIXVOICE;
+
+typedef struct
+{
+    uint16_t wChannels;
+    uint32_t dwSampleRate;
+    uint64_t qwFrame;           // frames rendered so far (the write head)
+    int nVoices;
+    MIXVOICE voices[MIXER_MAX_VOICES];
+
+    // Start frame of the most recently started voice, and how late it was
+    uint64_t qwLastStart;
+    uint32_t dwLastLateFrames;
+    uint32_t dwStarts;
+} MIXER;
+
+void MixerInit(MIXER* pMixer, uint16_t wChannels, uint32_t dwSampleRate);
+
+// Queues pSound to start on output frame qwStart. A frame that has already
+// been rendered starts it on the next render instead. The sound must have
+// the mixer's sample rate and either its channel count or one channel.
+// Returns 0 if the sound does not fit the mixer, the mixer has more than
+// MIXER_MAX_CHANNELS channels, or every voice is busy.
+int MixerSchedule(MIXER* pMixer, const WAVSOUND* pSound, uint64_t qwStart);
+
+// Drops every queued and playing voice
+void MixerClear(MIXER* pMixer);
+
+// Mixes the next dwFrames frames of interleaved 16-bit output. Voices are
+// summed at full precision and clamped once, so their order never matters.
+void MixerRender(MIXER* pMixer, int16_t* pOut, uint32_t dwFrames);
+
+uint64_t MixerMsToFrames(const MIXER* pMixer, uint32_t dwMs);
+
+#endif
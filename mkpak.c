@@ -0,0 +1,24 @@
+/*--------------------------
+    MKPAK.C -- Build step that packs the clock assets into one file
+
+    Usage: mkpak clock.pak Minecraft.ttf Dogica.ttf sound_on.ico ...
+---------------------------*/
+
+#include <stdio.h>
+#include "assetpak.h"
+
+int main(int argc, char* argv[])
+{
+    if (argc < 3)
+    {
+        fprintf(stderr, "usage: %s <output.pak> <file>...\n", argv[0]);
+        return 2;
+    }
+
+    if (!PakWriteFile(argv[1], (const char* const*)(argv + 2), argc - 2))
+    {
+        fprintf(stderr, "%s: could not write %s\n", argv[0], argv[1]);
+        return 1;
+    }
+    return 0;
+}
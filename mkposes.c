@@ -0,0 +1,103 @@
+/*--------------------------
+    MKPOSES.C -- Build step that writes the hand pose tables
+
+    Usage: mkposes handposes.c      write the tables
+           mkposes --check          compare the linked tables with the
+                                    run-time rotation
+---------------------------*/
+
+#include <stdio.h>
+#include <string.h>
+#include "handposes.h"
+
+static void WriteTable(FILE* fp, const char* pszName, const char* pszCount, int iHand,
+    int nAngles, int iStep)
+{
+    ROTPOINT pt[CLOCK_HAND_POINTS];
+    int i, j;
+
+    fprintf(fp, "\nconst ROTPOINT %s[%s][CLOCK_HAND_POINTS] = {\n", pszName, pszCount);
+    for (i = 0; i < nAngles; i++)
+    {
+        ClockComputeHand(iHand, i * iStep, pt);
+        fprintf(fp, "    {");
+        for (j = 0; j < CLOCK_HAND_POINTS; j++)
+            fprintf(fp, "%s{%d, %d}", j ? ", " : " ", (int)pt[j].x, (int)pt[j].y);
+        fprintf(fp, " },  // %d\n", i * iStep);
+    }
+    fprintf(fp, "};\n");
+}
+
+static int WritePoses(const char* pszPath)
+{
+    FILE* fp = fopen(pszPath, "w");
+    int bOk;
+
+    if (!fp)
+        return 0;
+
+    fprintf(fp, "/*--------------------------\n"
+        "    HANDPOSES.C -- Hand outlines at every angle a tick can show\n\n"
+        "    Generated by mkposes from the outlines in clockdraw.c; do not edit.\n"
+        "---------------------------*/\n\n"
+        "#include \"handposes.h\"\n");
+    WriteTable(fp, "handPoseHour", "POSE_HOUR_ANGLES", 0, POSE_HOUR_ANGLES, 1);
+    WriteTable(fp, "handPoseMinute", "POSE_STEPS", 1, POSE_STEPS, POSE_STEP_DEGREES);
+    WriteTable(fp, "handPoseSecond", "POSE_STEPS", 2, POSE_STEPS, POSE_STEP_DEGREES);
+
+    bOk = !ferror(fp);
+    return fclose(fp) == 0 && bOk;
+}
+
+// Every angle ClockHandAngles can return, looked up and rotated
+static int CheckPoses(void)
+{
+    ROTPOINT pt[CLOCK_HAND_POINTS];
+    const ROTPOINT* pPose;
+    int iHour, iMinute, iSecond, iHand, iAngle[3], nBad = 0;
+
+    for (iHour = 0; iHour < 24; iHour++)
+        for (iMinute = 0; iMinute < 60; iMinute++)
+            for (iSecond = 0; iSecond < 60; iSecond++)
+            {
+                ClockHandAngles(iHour, iMinute, iSecond, iAngle);
+                for (iHand = 0; iHand < 3; iHand++)
+                {
+                    ClockComputeHand(iHand, iAngle[iHand], pt);
+                    pPose = ClockHandPose(iHand, iAngle[iHand]);
+                    if (!pPose || memcmp(pPose, pt, sizeof(pt)) != 0)
+                    {
+                        if (nBad++ < 10)
+                            fprintf(stderr, "%02d:%02d:%02d hand %d at %d degrees differs\n",
+                                iHour, iMinute, iSecond, iHand, iAngle[iHand]);
+                    }
+                }
+            }
+
+    if (nBad)
+        fprintf(stderr, "%d mismatched poses; run mkposes handposes.c\n", nBad);
+    else
+        printf("pose tables match the run-time rotation\n");
+    return nBad == 0;
+}
+
+int main(int argc, char* argv[])
+{
+    if (argc != 2)
+    {
+        fprintf(stderr, "usage: %s <handposes.c> | --check\n", argv[0]);
+        return 2;
+    }
+
+    InitRotateTable();
+
+    if (strcmp(argv[1], "--check") == 0)
+        return CheckPoses() ? 0 : 1;
+
+    if (!WritePoses(argv[1]))
+    {
+        fprintf(stderr, "%s: could not write %s\n", argv[0], argv[1]);
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,195 @@
+/*--------------------------
+    PHASETIME.C -- Per-phase frame timing histograms
+---------------------------*/
+
+#ifndef _WIN32
+#define _POSIX_C_SOURCE 200809L
+#endif
+
+#include <string.h>
+#include <time.h>
+#include "phasetime.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#endif
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#define AtomicAdd32(p, v) _InterlockedExchangeAdd((volatile long*)(p), (long)(v))
+#define AtomicAdd64(p, v) _InterlockedExchangeAdd64((volatile __int64*)(p), (__int64)(v))
+#define AtomicCas64(p, cmp, v) \
+    (_InterlockedCompareExchange64((volatile __int64*)(p), (__int64)(v), (__int64)(cmp)) == (__int64)(cmp))
+#define AtomicLoad32(p) ((uint32_t)_InterlockedOr((volatile long*)(p), 0))
+#define AtomicLoad64(p) ((uint64_t)_InterlockedOr64((volatile __int64*)(p), 0))
+#else
+#define AtomicAdd32(p, v) __atomic_fetch_add((p), (v), __ATOMIC_RELAXED)
+#define AtomicAdd64(p, v) __atomic_fetch_add((p), (v), __ATOMIC_RELAXED)
+#define AtomicCas64(p, cmp, v) \
+    __atomic_compare_exchange_n((p), &(cmp), (v), 0, __ATOMIC_RELAXED, __ATOMIC_RELAXED)
+#define AtomicLoad32(p) __atomic_load_n((p), __ATOMIC_RELAXED)
+#define AtomicLoad64(p) __atomic_load_n((p), __ATOMIC_RELAXED)
+#endif
+
+static const char* phaseNames[PHASE_COUNT] = {
+    "clear", "face_blit", "isotropic", "dots", "labels", "hands", "audio", "buttons"
+};
+
+uint64_t PhaseNowNs(void)
+{
+#ifdef _WIN32
+    static LARGE_INTEGER liFreq = { 0 };
+    LARGE_INTEGER li;
+
+    if (!liFreq.QuadPart)
+        QueryPerformanceFrequency(&liFreq);
+    QueryPerformanceCounter(&li);
+
+    // Split to keep the multiply from overflowing after a long uptime
+    return (uint64_t)(li.QuadPart / liFreq.QuadPart) * 1000000000 +
+        (uint64_t)(li.QuadPart % liFreq.QuadPart) * 1000000000 / (uint64_t)liFreq.QuadPart;
+#else
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000 + (uint64_t)ts.tv_nsec;
+#endif
+}
+
+const char* PhaseName(int iPhase)
+{
+    return iPhase >= 0 && iPhase < PHASE_COUNT ? phaseNames[iPhase] : "?";
+}
+
+void PhaseReset(PHASESTATS* pStats)
+{
+    memset(pStats, 0, sizeof(*pStats));
+}
+
+static int BucketOf(uint64_t qwNs)
+{
+    int i = 0;
+
+    while (qwNs > 1 && i < PHASE_BUCKETS - 1)
+    {
+        qwNs >>= 1;
+        i++;
+    }
+    return i;
+}
+
+void PhaseRecord(PHASESTATS* pStats, int iPhase, uint64_t qwNs)
+{
+    PHASEHIST* pHist = &pStats->hist[iPhase];
+    uint64_t qwMax = AtomicLoad64(&pHist->qwMaxNs);
+
+    AtomicAdd32(&pHist->buckets[BucketOf(qwNs)], 1);
+    AtomicAdd64(&pHist->qwTotalNs, qwNs);
+    AtomicAdd32(&pHist->dwCount, 1);
+
+    while (qwNs > qwMax && !AtomicCas64(&pHist->qwMaxNs, qwMax, qwNs))
+        qwMax = AtomicLoad64(&pHist->qwMaxNs);
+}
+
+void PhaseLap(PHASESTATS* pStats, int iPhase, uint64_t* pqwStart)
+{
+    uint64_t qwNow = PhaseNowNs();
+
+    PhaseRecord(pStats, iPhase, qwNow - *pqwStart);
+    *pqwStart = qwNow;
+}
+
+uint64_t PhasePercentileNs(const PHASEHIST* pHist, int iPercent)
+{
+    uint32_t dwCount = 0, dwSeen = 0, dwTarget;
+    int i;
+
+    for (i = 0; i < PHASE_BUCKETS; i++)
+        dwCount += AtomicLoad32(&pHist->buckets[i]);
+    if (!dwCount)
+        return 0;
+
+    dwTarget = (uint32_t)(((uint64_t)dwCount * iPercent + 99) / 100);
+    for (i = 0; i < PHASE_BUCKETS - 1; i++)
+    {
+        dwSeen += AtomicLoad32(&pHist->buckets[i]);
+        if (dwSeen >= dwTarget)
+            break;
+    }
+    return i == PHASE_BUCKETS - 1 ? AtomicLoad64(&pHist->qwMaxNs) : (uint64_t)2 << i;
+}
+
+int PhaseWriteCsv(const PHASESTATS* pStats, FILE* fp)
+{
+    const PHASEHIST* pHist;
+    uint32_t dwCount;
+    int i, j;
+
+    fprintf(fp, "phase,count,total_ns,mean_ns,max_ns,p50_ns,p99_ns");
+    for (j = 0; j < PHASE_BUCKETS; j++)
+        fprintf(fp, ",lt_%llu", (unsigned long long)((uint64_t)2 << j));
+    fprintf(fp, "\n");
+
+    for (i = 0; i < PHASE_COUNT; i++)
+    {
+        pHist = &pStats->hist[i];
+        dwCount = AtomicLoad32(&pHist->dwCount);
+        fprintf(fp, "%s,%u,%llu,%llu,%llu,%llu,%llu", phaseNames[i], dwCount,
+            (unsigned long long)AtomicLoad64(&pHist->qwTotalNs),
+            (unsigned long long)(dwCount ? AtomicLoad64(&pHist->qwTotalNs) / dwCount : 0),
+            (unsigned long long)AtomicLoad64(&pHist->qwMaxNs),
+            (unsigned long long)PhasePercentileNs(pHist, 50),
+            (unsigned long long)PhasePercentileNs(pHist, 99));
+        for (j = 0; j < PHASE_BUCKETS; j++)
+            fprintf(fp, ",%u", AtomicLoad32(&pHist->buckets[j]));
+        fprintf(fp, "\n");
+    }
+    return !ferror(fp);
+}
+
+int PhaseWriteJson(const PHASESTATS* pStats, FILE* fp)
+{
+    const PHASEHIST* pHist;
+    uint32_t dwCount;
+    int i, j;
+
+    fprintf(fp, "{\n  \"bucket_upper_ns\": [");
+    for (j = 0; j < PHASE_BUCKETS; j++)
+        fprintf(fp, "%s%llu", j ? ", " : "", (unsigned long long)((uint64_t)2 << j));
+    fprintf(fp, "],\n  \"phases\": {\n");
+
+    for (i = 0; i < PHASE_COUNT; i++)
+    {
+        pHist = &pStats->hist[i];
+        dwCount = AtomicLoad32(&pHist->dwCount);
+        fprintf(fp, "    \"%s\": { \"count\": %u, \"total_ns\": %llu, \"mean_ns\": %llu, "
+            "\"max_ns\": %llu, \"p50_ns\": %llu, \"p99_ns\": %llu, \"buckets\": [",
+            phaseNames[i], dwCount,
+            (unsigned long long)AtomicLoad64(&pHist->qwTotalNs),
+            (unsigned long long)(dwCount ? AtomicLoad64(&pHist->qwTotalNs) / dwCount : 0),
+            (unsigned long long)AtomicLoad64(&pHist->qwMaxNs),
+            (unsigned long long)PhasePercentileNs(pHist, 50),
+            (unsigned long long)PhasePercentileNs(pHist, 99));
+        for (j = 0; j < PHASE_BUCKETS; j++)
+            fprintf(fp, "%s%u", j ? ", " : "", AtomicLoad32(&pHist->buckets[j]));
+        fprintf(fp, "] }%s\n", i + 1 < PHASE_COUNT ? "," : "");
+    }
+
+    fprintf(fp, "  }\n}\n");
+    return !ferror(fp);
+}
+
+int PhaseDumpFile(const PHASESTATS* pStats, const char* pszPath)
+{
+    size_t cch = strlen(pszPath);
+    FILE* fp = fopen(pszPath, "w");
+    int bOk;
+
+    if (!fp)
+        return 0;
+    if (cch > 5 && strcmp(pszPath + cch - 5, ".json") == 0)
+        bOk = PhaseWriteJson(pStats, fp);
+    else
+        bOk = PhaseWriteCsv(pStats, fp);
+    return fclose(fp) == 0 && bOk;
+}
@@ -0,0 +1,64 @@
+/*--------------------------
+    PHASETIME.H -- Per-phase frame timing histograms
+---------------------------*/
+
+#ifndef PHASETIME_H
+#define PHASETIME_H
+
+#include <stdint.h>
+#include <stdio.h>
+
+// Where paint and tick time goes
+enum
+{
+    PHASE_CLEAR,                // background fill
+    PHASE_FACE_BLIT,            // copying the cached face
+    PHASE_ISOTROPIC,            // SetIsotropic
+    PHASE_DOTS,
+    PHASE_LABELS,
+    PHASE_HANDS,
+    PHASE_AUDIO,                // scheduling the tick sound
+    PHASE_BUTTONS,              // drawing the buttons the paint reaches
+    PHASE_COUNT
+};
+
+// Bucket i counts samples of [2^i, 2^(i+1)) ns; bucket 0 also takes 0 ns
+// and the last one everything longer
+#define PHASE_BUCKETS 32
+
+typedef struct
+{
+    volatile uint32_t dwCount;
+    volatile uint64_t qwTotalNs;
+    volatile uint64_t qwMaxNs;
+    volatile uint32_t buckets[PHASE_BUCKETS];
+} PHASEHIST;
+
+// Updated with atomic adds only, so any thread may record or dump
+typedef struct
+{
+    PHASEHIST hist[PHASE_COUNT];
+} PHASESTATS;
+
+// Monotonic high-resolution clock in nanoseconds
+uint64_t PhaseNowNs(void);
+
+const char* PhaseName(int iPhase);
+
+void PhaseReset(PHASESTATS* pStats);
+void PhaseRecord(PHASESTATS* pStats, int iPhase, uint64_t qwNs);
+
+// Records the time since *pqwStart and moves *pqwStart to now, so
+// consecutive phases can be timed with one clock read each
+void PhaseLap(PHASESTATS* pStats, int iPhase, uint64_t* pqwStart);
+
+// Upper bound in ns of the bucket holding the given percentile, 0 if empty
+uint64_t PhasePercentileNs(const PHASEHIST* pHist, int iPercent);
+
+int PhaseWriteCsv(const PHASESTATS* pStats, FILE* fp);
+int PhaseWriteJson(const PHASESTATS* pStats, FILE* fp);
+
+// Writes JSON if pszPath ends in ".json", CSV otherwise
+int PhaseDumpFile(const PHASESTATS* pStats, const char* pszPath);
+
+#endif
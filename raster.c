@@ -0,0 +1,664 @@
+/*--------------------------
+    RASTER.C -- Headless software rasterizer for the clock renderer
+---------------------------*/
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "raster.h"
+#include "aaraster.h"
+#include "damage.h"
+
+static const struct
+{
+    char ch;
+    uint8_t rows[RASTER_GLYPH_ROWS];
+} glyphs[] = {
+    { '0', { 0x0E, 0x11, 0x13, 0x15, 0x19, 0x11, 0x0E } },
+    { '1', { 0x04, 0x0C, 0x04, 0x04, 0x04, 0x04, 0x0E } },
+    { '2', { 0x0E, 0x11, 0x01, 0x02, 0x04, 0x08, 0x1F } },
+    { '3', { 0x1F, 0x02, 0x04, 0x02, 0x01, 0x11, 0x0E } },
+    { '4', { 0x02, 0x06, 0x0A, 0x12, 0x1F, 0x02, 0x02 } },
+    { '5', { 0x1F, 0x10, 0x1E, 0x01, 0x01, 0x11, 0x0E } },
+    { '6', { 0x06, 0x08, 0x10, 0x1E, 0x11, 0x11, 0x0E } },
+    { '7', { 0x1F, 0x01, 0x02, 0x04, 0x08, 0x08, 0x08 } },
+    { '8', { 0x0E, 0x11, 0x11, 0x0E, 0x11, 0x11, 0x0E } },
+    { '9', { 0x0E, 0x11, 0x11, 0x0F, 0x01, 0x02, 0x0C } },
+    { 'I', { 0x0E, 0x04, 0x04, 0x04, 0x04, 0x04, 0x0E } },
+    { 'V', { 0x11, 0x11, 0x11, 0x11, 0x11, 0x0A, 0x04 } },
+    { 'X', { 0x11, 0x11, 0x0A, 0x04, 0x0A, 0x11, 0x11 } },
+    { '?', { 0x0E, 0x11, 0x01, 0x02, 0x04, 0x00, 0x04 } }
+};
+
+static const uint8_t glyphBox[RASTER_GLYPH_ROWS] = { 0x1F, 0x11, 0x11, 0x11, 0x11, 0x11, 0x1F };
+
+static uint32_t dwAllocs = 0;
+
+int RasterCreate(FRAMEBUFFER* pFb, int cx, int cy)
+{
+    pFb->cx = cx;
+    pFb->cy = cy;
+    pFb->pPixels = (cx > 0 && cy > 0) ? (uint8_t*)malloc((size_t)cx * cy * 4) : NULL;
+    if (pFb->pPixels)
+        dwAllocs++;
+    return pFb->pPixels != NULL;
+}
+
+uint32_t RasterAllocCount(void)
+{
+    return dwAllocs;
+}
+
+void RasterFree(FRAMEBUFFER* pFb)
+{
+    free(pFb->pPixels);
+    pFb->pPixels = NULL;
+    pFb->cx = pFb->cy = 0;
+}
+
+static void FillSpan(FRAMEBUFFER* pFb, const RASTERCLIP* pClip, int y, int x0, int x1, uint32_t color)
+{
+    uint8_t* p;
+    size_t cDone, cPixels;
+
+    if (y < 0 || y >= pFb->cy)
+        return;
+    if (x0 < 0) x0 = 0;
+    if (x1 > pFb->cx) x1 = pFb->cx;
+    if (pClip)
+    {
+        if (y < pClip->top || y >= pClip->bottom)
+            return;
+        if (x0 < pClip->left) x0 = pClip->left;
+        if (x1 > pClip->right) x1 = pClip->right;
+    }
+    if (x0 >= x1)
+        return;
+
+    p = pFb->pPixels + ((size_t)y * pFb->cx + x0) * 4;
+    p[0] = (uint8_t)(color >> 16);
+    p[1] = (uint8_t)(color >> 8);
+    p[2] = (uint8_t)color;
+    p[3] = 255;
+
+    // Double the filled prefix each step; long spans become a few memcpys
+    cPixels = (size_t)(x1 - x0);
+    for (cDone = 1; cDone < cPixels; cDone *= 2)
+        memcpy(p + cDone * 4, p, (cDone * 2 <= cPixels ? cDone : cPixels - cDone) * 4);
+}
+
+void RasterClear(FRAMEBUFFER* pFb, uint32_t color)
+{
+    RasterFillRect(pFb, 0, 0, pFb->cx, pFb->cy, color);
+}
+
+void RasterFillRect(FRAMEBUFFER* pFb, int left, int top, int right, int bottom, uint32_t color)
+{
+    RasterFillRectClip(pFb, NULL, left, top, right, bottom, color);
+}
+
+// Narrows rows [*pyTop, *pyBottom] to the clip rectangle, if any
+static void ClipRows(const RASTERCLIP* pClip, int* pyTop, int* pyBottom)
+{
+    if (!pClip)
+        return;
+    if (*pyTop < pClip->top) *pyTop = pClip->top;
+    if (*pyBottom > pClip->bottom - 1) *pyBottom = pClip->bottom - 1;
+}
+
+void RasterFillRectClip(FRAMEBUFFER* pFb, const RASTERCLIP* pClip, int left, int top, int right, int bottom,
+    uint32_t color)
+{
+    int y;
+    size_t cb;
+
+    if (top < 0) top = 0;
+    if (bottom > pFb->cy) bottom = pFb->cy;
+    if (left < 0) left = 0;
+    if (right > pFb->cx) right = pFb->cx;
+    if (pClip)
+    {
+        if (left < pClip->left) left = pClip->left;
+        if (right > pClip->right) right = pClip->right;
+    }
+    bottom--;
+    ClipRows(pClip, &top, &bottom);
+    if (left >= right || top > bottom)
+        return;
+
+    // Fill one row, then copy it; narrow rectangles (tiles, glyph cells)
+    // would otherwise pay FillSpan's setup on every row
+    FillSpan(pFb, pClip, top, left, right, color);
+    cb = (size_t)(right - left) * 4;
+    for (y = top + 1; y <= bottom; y++)
+        memcpy(pFb->pPixels + ((size_t)y * pFb->cx + left) * 4,
+            pFb->pPixels + ((size_t)top * pFb->cx + left) * 4, cb);
+}
+
+// Fills pixels whose centers lie in [xl, xr] on row y
+static void FillCenters(FRAMEBUFFER* pFb, const RASTERCLIP* pClip, int y, double xl, double xr, uint32_t color)
+{
+    if (xr >= xl)
+        FillSpan(pFb, pClip, y, (int)ceil(xl - 0.5), (int)floor(xr - 0.5) + 1, color);
+}
+
+void RasterFillDisc(FRAMEBUFFER* pFb, double xc, double yc, double r, uint32_t color)
+{
+    RasterFillDiscClip(pFb, NULL, xc, yc, r, color);
+}
+
+void RasterFillDiscClip(FRAMEBUFFER* pFb, const RASTERCLIP* pClip, double xc, double yc, double r, uint32_t color)
+{
+    int y, yTop, yBottom;
+
+    yTop = (int)ceil(yc - r - 0.5);
+    yBottom = (int)floor(yc + r - 0.5);
+    ClipRows(pClip, &yTop, &yBottom);
+    for (y = yTop; y <= yBottom; y++)
+    {
+        double dy = y + 0.5 - yc;
+        double dx = r * r - dy * dy;
+
+        if (dx >= 0)
+        {
+            dx = sqrt(dx);
+            FillCenters(pFb, pClip, y, xc - dx, xc + dx, color);
+        }
+    }
+}
+
+// Narrows [*pl, *pr] to the x where lo <= a * x + b <= hi
+static void ClipLinear(double a, double b, double lo, double hi, double* pl, double* pr)
+{
+    double t0, t1;
+
+    if (fabs(a) < 1e-12)
+    {
+        if (b < lo || b > hi)
+            *pl = 1, *pr = 0;
+        return;
+    }
+    t0 = (lo - b) / a;
+    t1 = (hi - b) / a;
+    if (t0 > t1)
+    {
+        double t = t0;
+        t0 = t1;
+        t1 = t;
+    }
+    if (t0 > *pl) *pl = t0;
+    if (t1 < *pr) *pr = t1;
+}
+
+// A thick segment is a capsule: a band around the segment plus a disc on
+// each end. Its intersection with a row is one interval.
+static int CapsuleRow(double x0, double y0, double x1, double y1, double len, double r, double yc,
+    double* pxl, double* pxr)
+{
+    double dx = x1 - x0, dy = y1 - y0;
+    double xl = 1e30, xr = -1e30;
+    double h, bl, br;
+
+    // End caps
+    h = r * r - (yc - y0) * (yc - y0);
+    if (h >= 0)
+    {
+        h = sqrt(h);
+        if (x0 - h < xl) xl = x0 - h;
+        if (x0 + h > xr) xr = x0 + h;
+    }
+    h = r * r - (yc - y1) * (yc - y1);
+    if (h >= 0)
+    {
+        h = sqrt(h);
+        if (x1 - h < xl) xl = x1 - h;
+        if (x1 + h > xr) xr = x1 + h;
+    }
+
+    // Band: projection onto the segment in [0, len] and distance to it <= r
+    if (len > 0)
+    {
+        bl = -1e30;
+        br = 1e30;
+        ClipLinear(dx / len, (yc - y0) * dy / len - x0 * dx / len, 0, len, &bl, &br);
+        ClipLinear(dy / len, -(yc - y0) * dx / len - x0 * dy / len, -r, r, &bl, &br);
+        if (br >= bl)
+        {
+            if (bl < xl) xl = bl;
+            if (br > xr) xr = br;
+        }
+    }
+
+    *pxl = xl;
+    *pxr = xr;
+    return xr >= xl;
+}
+
+int RasterCapsuleRow(double x0, double y0, double x1, double y1, double r, double yc, double* pxl, double* pxr)
+{
+    return CapsuleRow(x0, y0, x1, y1, sqrt((x1 - x0) * (x1 - x0) + (y1 - y0) * (y1 - y0)), r, yc, pxl, pxr);
+}
+
+void RasterThickLine(FRAMEBUFFER* pFb, double x0, double y0, double x1, double y1,
+    double width, uint32_t color)
+{
+    RasterThickLineClip(pFb, NULL, x0, y0, x1, y1, width, color);
+}
+
+// Each row is filled with a single span
+void RasterThickLineClip(FRAMEBUFFER* pFb, const RASTERCLIP* pClip, double x0, double y0, double x1, double y1,
+    double width, uint32_t color)
+{
+    double r = width / 2 < 0.5 ? 0.5 : width / 2;
+    double len = sqrt((x1 - x0) * (x1 - x0) + (y1 - y0) * (y1 - y0));
+    double xl, xr;
+    int y, yTop, yBottom;
+
+    yTop = (int)ceil((y0 < y1 ? y0 : y1) - r - 0.5);
+    yBottom = (int)floor((y0 > y1 ? y0 : y1) + r - 0.5);
+    ClipRows(pClip, &yTop, &yBottom);
+
+    for (y = yTop; y <= yBottom; y++)
+    {
+        if (CapsuleRow(x0, y0, x1, y1, len, r, y + 0.5, &xl, &xr))
+            FillCenters(pFb, pClip, y, xl, xr, color);
+    }
+}
+
+const uint8_t* RasterGlyph(char ch)
+{
+    size_t i;
+
+    for (i = 0; i < sizeof(glyphs) / sizeof(glyphs[0]); i++)
+        if (glyphs[i].ch == ch)
+            return glyphs[i].rows;
+    return glyphBox;
+}
+
+// A character cell is 6 x 8 font pixels: the 5 x 7 glyph plus one column
+// and one row of spacing, scaled so the cell is iHeight pixels high
+int RasterTextWidth(const char* psz, int iHeight)
+{
+    return (int)(strlen(psz) * 6 * iHeight / 8);
+}
+
+void RasterText(FRAMEBUFFER* pFb, int x, int y, const char* psz, int iHeight, uint32_t color)
+{
+    RasterTextClip(pFb, NULL, x, y, psz, iHeight, color);
+}
+
+void RasterTextClip(FRAMEBUFFER* pFb, const RASTERCLIP* pClip, int x, int y, const char* psz, int iHeight,
+    uint32_t color)
+{
+    int i, row, col;
+    double s = iHeight / 8.0;
+
+    for (i = 0; psz[i]; i++)
+    {
+        const uint8_t* pRows = RasterGlyph(psz[i]);
+        double xCell = x + i * 6 * s;
+
+        for (row = 0; row < RASTER_GLYPH_ROWS; row++)
+        {
+            int yt = y + (int)floor(row * s + 0.5);
+            int yb = y + (int)floor((row + 1) * s + 0.5);
+            if (yb == yt) yb++;
+
+            for (col = 0; col < RASTER_GLYPH_COLS; col++)
+            {
+                if (pRows[row] & (0x10 >> col))
+                {
+                    int xl = (int)floor(xCell + col * s + 0.5);
+                    int xr = (int)floor(xCell + (col + 1) * s + 0.5);
+                    if (xr == xl) xr++;
+                    RasterFillRectClip(pFb, pClip, xl, yt, xr, yb, color);
+                }
+            }
+        }
+    }
+}
+
+int RasterWritePPM(const FRAMEBUFFER* pFb, const char* pszPath)
+{
+    FILE* fp = fopen(pszPath, "wb");
+    size_t i, n = (size_t)pFb->cx * pFb->cy;
+    int bOk;
+
+    if (!fp)
+        return 0;
+
+    bOk = fprintf(fp, "P6\n%d %d\n255\n", pFb->cx, pFb->cy) > 0;
+    for (i = 0; bOk && i < n; i++)
+        bOk = fwrite(pFb->pPixels + i * 4, 1, 3, fp) == 3;
+    return fclose(fp) == 0 && bOk;
+}
+
+static uint32_t s_crcTable[256];
+
+static uint32_t Crc32(uint32_t crc, const uint8_t* p, size_t n)
+{
+    size_t i;
+
+    if (!s_crcTable[1])
+    {
+        uint32_t c, k, j;
+        for (k = 0; k < 256; k++)
+        {
+            for (c = k, j = 0; j < 8; j++)
+                c = c & 1 ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+            s_crcTable[k] = c;
+        }
+    }
+
+    crc = ~crc;
+    for (i = 0; i < n; i++)
+        crc = s_crcTable[(crc ^ p[i]) & 0xFF] ^ (crc >> 8);
+    return ~crc;
+}
+
+static void PutBE32(uint8_t* p, uint32_t v)
+{
+    p[0] = (uint8_t)(v >> 24);
+    p[1] = (uint8_t)(v >> 16);
+    p[2] = (uint8_t)(v >> 8);
+    p[3] = (uint8_t)v;
+}
+
+// Output state for the single IDAT chunk: its CRC, the zlib Adler-32 and
+// the room left in the current deflate "stored" block
+typedef struct
+{
+    FILE* fp;
+    uint32_t crc;
+    uint32_t adler;
+    uint32_t dwRemaining;       // raw bytes still to come, all blocks
+    uint32_t dwBlockLeft;
+    int bOk;
+} PNGSTREAM;
+
+static void PngRaw(PNGSTREAM* pStream, const uint8_t* p, size_t n)
+{
+    pStream->crc = Crc32(pStream->crc, p, n);
+    pStream->bOk = pStream->bOk && fwrite(p, 1, n, pStream->fp) == n;
+}
+
+// Appends image bytes, starting a new stored block every 65535 bytes
+static void PngData(PNGSTREAM* pStream, const uint8_t* p, size_t n)
+{
+    uint32_t a = pStream->adler & 0xFFFF, b = pStream->adler >> 16;
+    size_t i;
+
+    for (i = 0; i < n; i++)
+    {
+        a = (a + p[i]) % 65521;
+        b = (b + a) % 65521;
+    }
+    pStream->adler = (b << 16) | a;
+
+    while (n > 0 && pStream->bOk)
+    {
+        size_t nChunk;
+
+        if (pStream->dwBlockLeft == 0)
+        {
+            uint8_t hdr[5];
+            uint32_t dwLen = pStream->dwRemaining < 65535 ? pStream->dwRemaining : 65535;
+
+            hdr[0] = dwLen == pStream->dwRemaining ? 1 : 0;     // last block flag
+            hdr[1] = (uint8_t)dwLen;
+            hdr[2] = (uint8_t)(dwLen >> 8);
+            hdr[3] = (uint8_t)~dwLen;
+            hdr[4] = (uint8_t)(~dwLen >> 8);
+            PngRaw(pStream, hdr, 5);
+            pStream->dwBlockLeft = dwLen;
+        }
+
+        nChunk = n < pStream->dwBlockLeft ? n : pStream->dwBlockLeft;
+        PngRaw(pStream, p, nChunk);
+        p += nChunk;
+        n -= nChunk;
+        pStream->dwBlockLeft -= (uint32_t)nChunk;
+        pStream->dwRemaining -= (uint32_t)nChunk;
+    }
+}
+
+// PNG with the image stored uncompressed, which keeps the writer small,
+// fast and free of dependencies
+int RasterWritePNG(const FRAMEBUFFER* pFb, const char* pszPath)
+{
+    static const uint8_t sig[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+    static const uint8_t filterNone = 0;
+    uint8_t buf[32];
+    uint32_t dwRow = (uint32_t)pFb->cx * 4 + 1;
+    uint32_t dwRaw = dwRow * (uint32_t)pFb->cy;
+    uint32_t dwBlocks = (dwRaw + 65534) / 65535;
+    PNGSTREAM stream;
+    int y;
+
+    memset(&stream, 0, sizeof(stream));
+    stream.fp = fopen(pszPath, "wb");
+    if (!stream.fp)
+        return 0;
+    stream.bOk = fwrite(sig, 1, 8, stream.fp) == 8;
+
+    PutBE32(buf, 13);
+    memcpy(buf + 4, "IHDR", 4);
+    PutBE32(buf + 8, (uint32_t)pFb->cx);
+    PutBE32(buf + 12, (uint32_t)pFb->cy);
+    buf[16] = 8;        // bit depth
+    buf[17] = 6;        // RGBA
+    buf[18] = buf[19] = buf[20] = 0;
+    PutBE32(buf + 21, Crc32(0, buf + 4, 17));
+    stream.bOk = stream.bOk && fwrite(buf, 1, 25, stream.fp) == 25;
+
+    // IDAT length covers the zlib header, the blocks and the Adler-32
+    PutBE32(buf, 2 + dwRaw + 5 * dwBlocks + 4);
+    stream.bOk = stream.bOk && fwrite(buf, 1, 4, stream.fp) == 4;
+    memcpy(buf, "IDAT", 4);
+    buf[4] = 0x78;      // zlib header: deflate, 32K window
+    buf[5] = 0x01;
+    PngRaw(&stream, buf, 6);
+
+    stream.adler = 1;
+    stream.dwRemaining = dwRaw;
+    for (y = 0; y < pFb->cy && stream.bOk; y++)
+    {
+        PngData(&stream, &filterNone, 1);
+        PngData(&stream, pFb->pPixels + (size_t)y * pFb->cx * 4, dwRow - 1);
+    }
+
+    PutBE32(buf, stream.adler);
+    PngRaw(&stream, buf, 4);
+    PutBE32(buf, stream.crc);
+    stream.bOk = stream.bOk && fwrite(buf, 1, 4, stream.fp) == 4;
+
+    PutBE32(buf, 0);
+    memcpy(buf + 4, "IEND", 4);
+    PutBE32(buf + 8, Crc32(0, buf + 4, 4));
+    stream.bOk = stream.bOk && fwrite(buf, 1, 12, stream.fp) == 12;
+
+    return fclose(stream.fp) == 0 && stream.bOk;
+}
+
+static void FontMeasure(void* pCtx, const char* psz, int* pcx, int* pcy)
+{
+    RASTERFONT* pFont = (RASTERFONT*)pCtx;
+
+    *pcx = RasterTextWidth(psz, pFont->iHeight);
+    *pcy = pFont->iHeight;
+}
+
+static void FontDraw(void* pCtx, const char* psz, uint32_t color, int x, int y)
+{
+    RASTERFONT* pFont = (RASTERFONT*)pCtx;
+
+    RasterText(pFont->pFb, x, y, psz, pFont->iHeight, color);
+}
+
+void RasterGlyphSource(GLYPHSOURCE* pSource, RASTERFONT* pFont)
+{
+    pSource->pCtx = pFont;
+    pSource->pfnMeasure = FontMeasure;
+    pSource->pfnDraw = FontDraw;
+}
+
+void RasterViewInit(RASTERVIEW* pView, FRAMEBUFFER* pFb, int x, int y, int cx, int cy)
+{
+    pView->pFb = pFb;
+    pView->x = x;
+    pView->y = y;
+    pView->cx = cx;
+    pView->cy = cy;
+    pView->pSink = NULL;
+    pView->bAntiAlias = 0;
+}
+
+void RasterBlit(FRAMEBUFFER* pDst, int x, int y, const FRAMEBUFFER* pSrc)
+{
+    int row, xSrc = 0, cx = pSrc->cx;
+
+    if (x < 0)
+    {
+        xSrc = -x;
+        cx += x;
+        x = 0;
+    }
+    if (x + cx > pDst->cx)
+        cx = pDst->cx - x;
+    if (cx <= 0)
+        return;
+
+    for (row = 0; row < pSrc->cy; row++)
+    {
+        if (y + row < 0 || y + row >= pDst->cy)
+            continue;
+        memcpy(pDst->pPixels + ((size_t)(y + row) * pDst->cx + x) * 4,
+            pSrc->pPixels + ((size_t)row * pSrc->cx + xSrc) * 4, (size_t)cx * 4);
+    }
+}
+
+// Nearest pixel, as StretchBlt does in COLORONCOLOR mode, stepping the
+// source in 16.16 fixed point. A row that takes the same source row as
+// the one above, as most do when blowing up, is copied from it.
+void RasterStretch(FRAMEBUFFER* pDst, const RASTERCLIP* pDstRect, const FRAMEBUFFER* pSrc,
+    const RASTERCLIP* pSrcRect)
+{
+    const uint32_t* pSrcRow;
+    uint32_t* pDstRow;
+    int cxDst = pDstRect->right - pDstRect->left, cyDst = pDstRect->bottom - pDstRect->top;
+    int x, y, xStart, xEnd, yStart, ySrc, ySrcLast = -1;
+    uint32_t dxStep, dyStep, xSrc;
+
+    if (cxDst <= 0 || cyDst <= 0)
+        return;
+    dxStep = (uint32_t)(((uint64_t)(pSrcRect->right - pSrcRect->left) << 16) / cxDst);
+    dyStep = (uint32_t)(((uint64_t)(pSrcRect->bottom - pSrcRect->top) << 16) / cyDst);
+    xStart = pDstRect->left < 0 ? 0 : pDstRect->left;
+    xEnd = pDstRect->right > pDst->cx ? pDst->cx : pDstRect->right;
+    yStart = pDstRect->top < 0 ? 0 : pDstRect->top;
+    if (xStart >= xEnd)
+        return;
+
+    for (y = yStart; y < pDstRect->bottom && y < pDst->cy; y++)
+    {
+        ySrc = pSrcRect->top + (int)(((uint32_t)(y - pDstRect->top) * dyStep + dyStep / 2) >> 16);
+        pDstRow = (uint32_t*)pDst->pPixels + (size_t)y * pDst->cx;
+        if (ySrc == ySrcLast)
+        {
+            memcpy(pDstRow + xStart, pDstRow - pDst->cx + xStart, (size_t)(xEnd - xStart) * 4);
+            continue;
+        }
+        ySrcLast = ySrc;
+        pSrcRow = (const uint32_t*)pSrc->pPixels + (size_t)ySrc * pSrc->cx + pSrcRect->left;
+        xSrc = (uint32_t)(xStart - pDstRect->left) * dxStep + dxStep / 2;
+        for (x = xStart; x < xEnd; x++, xSrc += dxStep)
+            pDstRow[x] = pSrcRow[xSrc >> 16];
+    }
+}
+
+// Logical to device, with the same mapping SetIsotropic gives GDI
+static void MapPoint(const RASTERVIEW* pView, double x, double y, double* px, double* py)
+{
+    double scale = (double)IsoScale(pView->cx, pView->cy) / ISO_WINDOW_EXT;
+
+    *px = pView->x + pView->cx / 2 + x * scale;
+    *py = pView->y + pView->cy / 2 - y * scale;
+}
+
+static void BackendDisc(void* pCtx, int left, int top, int right, int bottom, uint32_t color)
+{
+    RASTERVIEW* pView = (RASTERVIEW*)pCtx;
+    double x0, y0, x1, y1;
+
+    MapPoint(pView, left, top, &x0, &y0);
+    MapPoint(pView, right, bottom, &x1, &y1);
+    if (pView->pSink)
+        pView->pSink->pfnDisc(pView->pSink->pCtx, (x0 + x1) / 2, (y0 + y1) / 2, fabs(x1 - x0) / 2, color);
+    else if (pView->bAntiAlias)
+        AAFillDisc(pView->pFb, NULL, (x0 + x1) / 2, (y0 + y1) / 2, fabs(x1 - x0) / 2, color);
+    else
+        RasterFillDisc(pView->pFb, (x0 + x1) / 2, (y0 + y1) / 2, fabs(x1 - x0) / 2, color);
+}
+
+static void BackendPolyline(void* pCtx, const ROTPOINT pt[], int iNum, int iWidth, uint32_t color)
+{
+    RASTERVIEW* pView = (RASTERVIEW*)pCtx;
+    double x0, y0, x1, y1;
+    double width = iWidth * (double)IsoScale(pView->cx, pView->cy) / ISO_WINDOW_EXT;
+    int i;
+
+    // GDI puts pen pixels on integer coordinates; pixel centers sit at +0.5.
+    // Anti-aliased lines keep their exact position instead.
+    for (i = 0; i + 1 < iNum; i++)
+    {
+        MapPoint(pView, pt[i].x, pt[i].y, &x0, &y0);
+        MapPoint(pView, pt[i + 1].x, pt[i + 1].y, &x1, &y1);
+        if (pView->pSink)
+            pView->pSink->pfnLine(pView->pSink->pCtx, floor(x0) + 0.5, floor(y0) + 0.5,
+                floor(x1) + 0.5, floor(y1) + 0.5, width, color);
+        else if (pView->bAntiAlias)
+            AAThickLine(pView->pFb, NULL, x0, y0, x1, y1, width, color);
+        else
+            RasterThickLine(pView->pFb, floor(x0) + 0.5, floor(y0) + 0.5, floor(x1) + 0.5, floor(y1) + 0.5,
+                width, color);
+    }
+}
+
+static void BackendText(void* pCtx, int x, int y, const char* psz, int iHeight, uint32_t color)
+{
+    RASTERVIEW* pView = (RASTERVIEW*)pCtx;
+    int iScale = IsoScale(pView->cx, pView->cy);
+    int cyText = iHeight * iScale / ISO_WINDOW_EXT;
+    int cxText = RasterTextWidth(psz, cyText);
+    double px, py;
+
+    // TextOut(x - cx / 2, y - cy / 2) in logical units: with y pointing up
+    // that puts the top of the text cy / 2 below the anchor on screen
+    MapPoint(pView, x, y, &px, &py);
+    if (pView->pSink)
+        pView->pSink->pfnText(pView->pSink->pCtx, (int)floor(px) - cxText / 2, (int)floor(py) + cyText / 2,
+            psz, cyText, color);
+    else
+        RasterText(pView->pFb, (int)floor(px) - cxText / 2, (int)floor(py) + cyText / 2, psz, cyText, color);
+}
+
+void RasterBackend(CLOCKBACKEND* pBackend, RASTERVIEW* pView)
+{
+    pBackend->pCtx = pView;
+    pBackend->pfnDisc = BackendDisc;
+    pBackend->pfnPolyline = BackendPolyline;
+    pBackend->pfnText = BackendText;
+}
+
+void RasterDrawClock(FRAMEBUFFER* pFb, const CLOCKSTYLE* pStyle, int iHour, int iMinute, int iSecond)
+{
+    CLOCKBACKEND backend;
+    RASTERVIEW view;
+
+    RasterViewInit(&view, pFb, 0, 0, pFb->cx, pFb->cy);
+    RasterBackend(&backend, &view);
+    RasterClear(pFb, ClockBackground(pStyle));
+    ClockDrawFace(&backend, pStyle);
+    ClockDrawHands(&backend, pStyle, iHour, iMinute, iSecond, 1);
+}
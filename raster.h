@@ -0,0 +1,112 @@
+/*--------------------------
+    RASTER.H -- Headless software rasterizer for the clock renderer
+---------------------------*/
+
+#ifndef RASTER_H
+#define RASTER_H
+
+#include "clockdraw.h"
+#include "glyphatlas.h"
+
+// RGBA pixels, 4 bytes each, rows top to bottom
+typedef struct
+{
+    int cx;
+    int cy;
+    uint8_t* pPixels;
+} FRAMEBUFFER;
+
+#define RASTER_GLYPH_COLS 5
+#define RASTER_GLYPH_ROWS 7
+
+int RasterCreate(FRAMEBUFFER* pFb, int cx, int cy);
+void RasterFree(FRAMEBUFFER* pFb);
+
+// Framebuffers allocated so far, for the benchmarks
+uint32_t RasterAllocCount(void);
+
+void RasterClear(FRAMEBUFFER* pFb, uint32_t color);
+void RasterFillRect(FRAMEBUFFER* pFb, int left, int top, int right, int bottom, uint32_t color);
+
+// Device-space primitives; pixel (x, y) covers [x, x + 1) x [y, y + 1) and a
+// pixel is drawn when its center is inside the shape
+void RasterFillDisc(FRAMEBUFFER* pFb, double xc, double yc, double r, uint32_t color);
+void RasterThickLine(FRAMEBUFFER* pFb, double x0, double y0, double x1, double y1,
+    double width, uint32_t color);
+
+// Pixels [left, right) x [top, bottom); the ...Clip variants draw exactly
+// the pixels the plain calls would, limited to this rectangle
+typedef struct
+{
+    int left, top, right, bottom;
+} RASTERCLIP;
+
+void RasterFillRectClip(FRAMEBUFFER* pFb, const RASTERCLIP* pClip, int left, int top, int right, int bottom,
+    uint32_t color);
+void RasterFillDiscClip(FRAMEBUFFER* pFb, const RASTERCLIP* pClip, double xc, double yc, double r, uint32_t color);
+void RasterThickLineClip(FRAMEBUFFER* pFb, const RASTERCLIP* pClip, double x0, double y0, double x1, double y1,
+    double width, uint32_t color);
+
+// Whether the row of pixel centers at yc crosses the capsule of radius r
+// around (x0, y0)-(x1, y1), and if so the x range [*pxl, *pxr] it covers
+int RasterCapsuleRow(double x0, double y0, double x1, double y1, double r, double yc, double* pxl, double* pxr);
+
+// Built-in 5x7 bitmap font (digits, I, V, X and '?'); rows are 5-bit masks,
+// most significant bit on the left. Other characters come out as a box.
+const uint8_t* RasterGlyph(char ch);
+int RasterTextWidth(const char* psz, int iHeight);
+void RasterText(FRAMEBUFFER* pFb, int x, int y, const char* psz, int iHeight, uint32_t color);
+void RasterTextClip(FRAMEBUFFER* pFb, const RASTERCLIP* pClip, int x, int y, const char* psz, int iHeight,
+    uint32_t color);
+
+int RasterWritePPM(const FRAMEBUFFER* pFb, const char* pszPath);
+int RasterWritePNG(const FRAMEBUFFER* pFb, const char* pszPath);
+
+// The built-in font at iHeight pixels as a glyph atlas source drawing into pFb
+typedef struct
+{
+    FRAMEBUFFER* pFb;
+    int iHeight;
+} RASTERFONT;
+
+void RasterGlyphSource(GLYPHSOURCE* pSource, RASTERFONT* pFont);
+
+// Device-space calls a view's backend makes, for recording them instead
+// of drawing (see rastertile.c)
+typedef struct
+{
+    void* pCtx;
+    void (*pfnDisc)(void* pCtx, double xc, double yc, double r, uint32_t color);
+    void (*pfnLine)(void* pCtx, double x0, double y0, double x1, double y1, double width, uint32_t color);
+    void (*pfnText)(void* pCtx, int x, int y, const char* psz, int iHeight, uint32_t color);
+} RASTERSINK;
+
+// A rectangle of a framebuffer that one clock is mapped into. With pSink
+// set, the backend passes device-space primitives to it instead of pFb;
+// otherwise bAntiAlias draws discs and lines with the aaraster.c kernels.
+typedef struct
+{
+    FRAMEBUFFER* pFb;
+    int x, y;
+    int cx, cy;
+    const RASTERSINK* pSink;
+    int bAntiAlias;
+} RASTERVIEW;
+
+void RasterViewInit(RASTERVIEW* pView, FRAMEBUFFER* pFb, int x, int y, int cx, int cy);
+
+// Copies all of pSrc to (x, y) in pDst, clipped to pDst
+void RasterBlit(FRAMEBUFFER* pDst, int x, int y, const FRAMEBUFFER* pSrc);
+
+// Scales pSrcRect of pSrc onto pDstRect of pDst, clipped to pDst, taking
+// the nearest source pixel
+void RasterStretch(FRAMEBUFFER* pDst, const RASTERCLIP* pDstRect, const FRAMEBUFFER* pSrc,
+    const RASTERCLIP* pSrcRect);
+
+// A CLOCKBACKEND drawing into the view with the SetIsotropic mapping
+void RasterBackend(CLOCKBACKEND* pBackend, RASTERVIEW* pView);
+
+// Background, face and hands, as one WM_PAINT would draw them
+void RasterDrawClock(FRAMEBUFFER* pFb, const CLOCKSTYLE* pStyle, int iHour, int iMinute, int iSecond);
+
+#endif
@@ -0,0 +1,295 @@
+/*--------------------------
+    RASTERTILE.C -- Tile-parallel rendering of one clock into a large framebuffer
+---------------------------*/
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include "rastertile.h"
+
+int TileRenderInit(TILERENDER* pRender, int nWorkers)
+{
+    memset(pRender, 0, sizeof(*pRender));
+    pRender->pPool = WorkPoolCreate(nWorkers > 0 ? nWorkers : WorkPoolCpuCount());
+    return pRender->pPool != NULL;
+}
+
+void TileRenderFree(TILERENDER* pRender)
+{
+    int i;
+
+    WorkPoolDestroy(pRender->pPool);
+    for (i = 0; i < 2; i++)
+    {
+        free(pRender->frames[i].pPrims);
+        free(pRender->frames[i].pBinStart);
+        free(pRender->frames[i].pBinItems);
+    }
+    free(pRender->pDirty);
+    memset(pRender, 0, sizeof(*pRender));
+}
+
+void TileRenderInvalidate(TILERENDER* pRender)
+{
+    pRender->bPrevValid = 0;
+}
+
+static TILEPRIM* AddPrim(TILERENDER* pRender, int iKind, uint32_t color)
+{
+    TILEFRAME* pFrame = &pRender->frames[pRender->iCur];
+    TILEPRIM* pPrim;
+    int nMax;
+
+    if (pFrame->nPrims == pFrame->nMaxPrims)
+    {
+        nMax = pFrame->nMaxPrims ? pFrame->nMaxPrims * 2 : 128;
+        pPrim = (TILEPRIM*)realloc(pFrame->pPrims, sizeof(TILEPRIM) * nMax);
+        if (!pPrim)
+        {
+            pRender->bNoMemory = 1;
+            return NULL;
+        }
+        pFrame->pPrims = pPrim;
+        pFrame->nMaxPrims = nMax;
+    }
+
+    // Zeroed so that records, padding included, compare with memcmp
+    pPrim = &pFrame->pPrims[pFrame->nPrims++];
+    memset(pPrim, 0, sizeof(*pPrim));
+    pPrim->iKind = iKind;
+    pPrim->color = color;
+    return pPrim;
+}
+
+// Bounds are generous by a pixel; the clipped draw decides exact coverage
+static void SetBounds(TILEPRIM* pPrim, double left, double top, double right, double bottom)
+{
+    pPrim->bounds.left = (int)floor(left) - 1;
+    pPrim->bounds.top = (int)floor(top) - 1;
+    pPrim->bounds.right = (int)ceil(right) + 2;
+    pPrim->bounds.bottom = (int)ceil(bottom) + 2;
+}
+
+static void RecordDisc(void* pCtx, double xc, double yc, double r, uint32_t color)
+{
+    TILEPRIM* pPrim = AddPrim((TILERENDER*)pCtx, TILEPRIM_DISC, color);
+
+    if (!pPrim)
+        return;
+    pPrim->x0 = xc;
+    pPrim->y0 = yc;
+    pPrim->r = r;
+    SetBounds(pPrim, xc - r, yc - r, xc + r, yc + r);
+}
+
+static void RecordLine(void* pCtx, double x0, double y0, double x1, double y1, double width, uint32_t color)
+{
+    TILEPRIM* pPrim = AddPrim((TILERENDER*)pCtx, TILEPRIM_LINE, color);
+    double r = width / 2 < 0.5 ? 0.5 : width / 2;
+
+    if (!pPrim)
+        return;
+    pPrim->x0 = x0;
+    pPrim->y0 = y0;
+    pPrim->x1 = x1;
+    pPrim->y1 = y1;
+    pPrim->r = width;
+    SetBounds(pPrim, (x0 < x1 ? x0 : x1) - r, (y0 < y1 ? y0 : y1) - r,
+        (x0 > x1 ? x0 : x1) + r, (y0 > y1 ? y0 : y1) + r);
+}
+
+static void RecordText(void* pCtx, int x, int y, const char* psz, int iHeight, uint32_t color)
+{
+    TILEPRIM* pPrim = AddPrim((TILERENDER*)pCtx, TILEPRIM_TEXT, color);
+
+    if (!pPrim)
+        return;
+    pPrim->x = x;
+    pPrim->y = y;
+    pPrim->iHeight = iHeight;
+    strncpy(pPrim->sz, psz, TILE_MAX_TEXT - 1);
+    SetBounds(pPrim, x, y, x + RasterTextWidth(pPrim->sz, iHeight), y + iHeight);
+}
+
+static int Grow(int** pp, int* pnMax, int n)
+{
+    int* p;
+
+    if (n <= *pnMax)
+        return 1;
+    p = (int*)realloc(*pp, sizeof(int) * n);
+    if (!p)
+        return 0;
+    *pp = p;
+    *pnMax = n;
+    return 1;
+}
+
+// Tile range [*pc0, *pc1) x [*pr0, *pr1) a primitive's bounds overlap
+static int TileSpan(const TILERENDER* pRender, const RASTERCLIP* pBounds, int* pc0, int* pr0, int* pc1, int* pr1)
+{
+    int left = pBounds->left > 0 ? pBounds->left : 0;
+    int top = pBounds->top > 0 ? pBounds->top : 0;
+    int right = pBounds->right < pRender->pFb->cx ? pBounds->right : pRender->pFb->cx;
+    int bottom = pBounds->bottom < pRender->pFb->cy ? pBounds->bottom : pRender->pFb->cy;
+
+    if (left >= right || top >= bottom)
+        return 0;
+    *pc0 = left / TILE_CX;
+    *pr0 = top / TILE_CY;
+    *pc1 = (right - 1) / TILE_CX + 1;
+    *pr1 = (bottom - 1) / TILE_CY + 1;
+    return 1;
+}
+
+// Counting sort of primitive indices by tile, keeping drawing order
+static int BinPrims(TILERENDER* pRender, TILEFRAME* pFrame)
+{
+    int nTiles = pRender->nCols * pRender->nRows;
+    int i, c, r, c0, r0, c1, r1, nItems;
+    int* pNext;
+
+    if (!Grow(&pFrame->pBinStart, &pFrame->nMaxStart, nTiles + 1))
+        return 0;
+    memset(pFrame->pBinStart, 0, sizeof(int) * (nTiles + 1));
+
+    for (i = 0; i < pFrame->nPrims; i++)
+    {
+        if (!TileSpan(pRender, &pFrame->pPrims[i].bounds, &c0, &r0, &c1, &r1))
+            continue;
+        for (r = r0; r < r1; r++)
+            for (c = c0; c < c1; c++)
+                pFrame->pBinStart[r * pRender->nCols + c + 1]++;
+    }
+    for (i = 1; i <= nTiles; i++)
+        pFrame->pBinStart[i] += pFrame->pBinStart[i - 1];
+    nItems = pFrame->pBinStart[nTiles];
+
+    if (!Grow(&pFrame->pBinItems, &pFrame->nMaxItems, nItems > 0 ? nItems : 1))
+        return 0;
+
+    pNext = (int*)malloc(sizeof(int) * nTiles);
+    if (!pNext)
+        return 0;
+    memcpy(pNext, pFrame->pBinStart, sizeof(int) * nTiles);
+    for (i = 0; i < pFrame->nPrims; i++)
+    {
+        if (!TileSpan(pRender, &pFrame->pPrims[i].bounds, &c0, &r0, &c1, &r1))
+            continue;
+        for (r = r0; r < r1; r++)
+            for (c = c0; c < c1; c++)
+                pFrame->pBinItems[pNext[r * pRender->nCols + c]++] = i;
+    }
+    free(pNext);
+    return 1;
+}
+
+static int SameTile(const TILERENDER* pRender, int iTile)
+{
+    const TILEFRAME* pCur = &pRender->frames[pRender->iCur];
+    const TILEFRAME* pPrev = &pRender->frames[pRender->iCur ^ 1];
+    int n = pCur->pBinStart[iTile + 1] - pCur->pBinStart[iTile];
+    int i;
+
+    if (n != pPrev->pBinStart[iTile + 1] - pPrev->pBinStart[iTile])
+        return 0;
+    for (i = 0; i < n; i++)
+    {
+        if (memcmp(&pCur->pPrims[pCur->pBinItems[pCur->pBinStart[iTile] + i]],
+            &pPrev->pPrims[pPrev->pBinItems[pPrev->pBinStart[iTile] + i]], sizeof(TILEPRIM)) != 0)
+            return 0;
+    }
+    return 1;
+}
+
+// Background and the tile's primitives in drawing order, clipped to the tile
+static void DrawTile(void* pCtx, int iItem, int iWorker)
+{
+    TILERENDER* pRender = (TILERENDER*)pCtx;
+    const TILEFRAME* pFrame = &pRender->frames[pRender->iCur];
+    int iTile = pRender->pDirty[iItem];
+    const TILEPRIM* pPrim;
+    RASTERCLIP clip;
+    int i;
+
+    (void)iWorker;
+    clip.left = iTile % pRender->nCols * TILE_CX;
+    clip.top = iTile / pRender->nCols * TILE_CY;
+    clip.right = clip.left + TILE_CX;
+    clip.bottom = clip.top + TILE_CY;
+
+    RasterFillRectClip(pRender->pFb, &clip, clip.left, clip.top, clip.right, clip.bottom, pFrame->bgColor);
+
+    for (i = pFrame->pBinStart[iTile]; i < pFrame->pBinStart[iTile + 1]; i++)
+    {
+        pPrim = &pFrame->pPrims[pFrame->pBinItems[i]];
+        switch (pPrim->iKind)
+        {
+            case TILEPRIM_DISC:
+                RasterFillDiscClip(pRender->pFb, &clip, pPrim->x0, pPrim->y0, pPrim->r, pPrim->color);
+                break;
+            case TILEPRIM_LINE:
+                RasterThickLineClip(pRender->pFb, &clip, pPrim->x0, pPrim->y0, pPrim->x1, pPrim->y1,
+                    pPrim->r, pPrim->color);
+                break;
+            case TILEPRIM_TEXT:
+                RasterTextClip(pRender->pFb, &clip, pPrim->x, pPrim->y, pPrim->sz, pPrim->iHeight,
+                    pPrim->color);
+                break;
+        }
+    }
+}
+
+int TileRenderClock(TILERENDER* pRender, FRAMEBUFFER* pFb, const CLOCKSTYLE* pStyle,
+    int iHour, int iMinute, int iSecond)
+{
+    RASTERSINK sink = { NULL, RecordDisc, RecordLine, RecordText };
+    CLOCKBACKEND backend;
+    RASTERVIEW view;
+    TILEFRAME* pFrame = &pRender->frames[pRender->iCur];
+    int nCols = (pFb->cx + TILE_CX - 1) / TILE_CX;
+    int nRows = (pFb->cy + TILE_CY - 1) / TILE_CY;
+    int i, nTiles = nCols * nRows;
+
+    if (pFb != pRender->pFb || nCols != pRender->nCols || nRows != pRender->nRows)
+        pRender->bPrevValid = 0;
+    pRender->pFb = pFb;
+    pRender->nCols = nCols;
+    pRender->nRows = nRows;
+
+    // Record what RasterDrawClock would draw, in the same order
+    sink.pCtx = pRender;
+    RasterViewInit(&view, pFb, 0, 0, pFb->cx, pFb->cy);
+    view.pSink = &sink;
+    RasterBackend(&backend, &view);
+
+    pFrame->nPrims = 0;
+    pFrame->bgColor = ClockBackground(pStyle);
+    pRender->bNoMemory = 0;
+    ClockDrawFace(&backend, pStyle);
+    ClockDrawHands(&backend, pStyle, iHour, iMinute, iSecond, 1);
+
+    if (pRender->bNoMemory || !BinPrims(pRender, pFrame) ||
+        !Grow(&pRender->pDirty, &pRender->nMaxDirty, nTiles))
+    {
+        pRender->bPrevValid = 0;
+        return 0;
+    }
+
+    pRender->nDirty = 0;
+    for (i = 0; i < nTiles; i++)
+    {
+        if (!pRender->bPrevValid || pFrame->bgColor != pRender->frames[pRender->iCur ^ 1].bgColor ||
+            !SameTile(pRender, i))
+            pRender->pDirty[pRender->nDirty++] = i;
+    }
+    pRender->dwTilesDrawn = pRender->nDirty;
+    pRender->dwTilesSkipped = nTiles - pRender->nDirty;
+
+    WorkPoolRun(pRender->pPool, DrawTile, pRender, 0, pRender->nDirty);
+    WorkPoolWait(pRender->pPool);
+
+    pRender->iCur ^= 1;
+    pRender->bPrevValid = 1;
+    return 1;
+}
@@ -0,0 +1,79 @@
+/*--------------------------
+    RASTERTILE.H -- Tile-parallel rendering of one clock into a large framebuffer
+---------------------------*/
+
+#ifndef RASTERTILE_H
+#define RASTERTILE_H
+
+#include "raster.h"
+#include "workpool.h"
+
+// Wide and short: on a row-major framebuffer, tall tiles step through
+// memory a whole row at a time. At 8K the row pitch is 30 KB, a multiple
+// of 2 KB, so those rows also compete for the same few cache sets.
+#define TILE_CX 512
+#define TILE_CY 32
+#define TILE_MAX_TEXT 16
+
+enum { TILEPRIM_DISC, TILEPRIM_LINE, TILEPRIM_TEXT };
+
+// One primitive in device space, as the backend would have drawn it, and
+// the pixels it can touch
+typedef struct
+{
+    int iKind;
+    uint32_t color;
+    double x0, y0, x1, y1, r;   // disc: (x0, y0) r; line: (x0, y0)-(x1, y1) width r
+    int x, y, iHeight;          // text
+    char sz[TILE_MAX_TEXT];
+    RASTERCLIP bounds;
+} TILEPRIM;
+
+// Primitives recorded for one frame and their per-tile bins
+typedef struct
+{
+    TILEPRIM* pPrims;
+    int nPrims, nMaxPrims;
+    int* pBinStart;             // nTiles + 1 offsets into pBinItems
+    int* pBinItems;             // primitive indices, in drawing order per tile
+    int nMaxStart, nMaxItems;
+    uint32_t bgColor;
+} TILEFRAME;
+
+typedef struct
+{
+    WORKPOOL* pPool;
+    FRAMEBUFFER* pFb;
+    int nCols, nRows;
+
+    // This frame and the one before; a tile whose background and primitive
+    // list match the last frame's still holds the right pixels
+    TILEFRAME frames[2];
+    int iCur;
+    int bPrevValid;
+
+    // Tiles to draw this frame
+    int* pDirty;
+    int nDirty, nMaxDirty;
+    int bNoMemory;              // a primitive could not be recorded
+
+    // Statistics for the last frame
+    uint32_t dwTilesDrawn;
+    uint32_t dwTilesSkipped;
+} TILERENDER;
+
+// nWorkers 0 uses every processor. Returns 0 if the pool cannot start.
+int TileRenderInit(TILERENDER* pRender, int nWorkers);
+void TileRenderFree(TILERENDER* pRender);
+
+// Forgets what the framebuffer holds, so the next frame draws every tile
+void TileRenderInvalidate(TILERENDER* pRender);
+
+// Background, face and hands into pFb, identical to RasterDrawClock. pFb
+// must not be touched by anything else between calls for skipped tiles
+// to stay correct; a different framebuffer or size redraws everything.
+// Returns 0 when out of memory.
+int TileRenderClock(TILERENDER* pRender, FRAMEBUFFER* pFb, const CLOCKSTYLE* pStyle,
+    int iHour, int iMinute, int iSecond);
+
+#endif
@@ -0,0 +1,139 @@
+/*--------------------------
+    RENDERPOLICY.C -- Suspends drawing while the clock cannot be seen
+---------------------------*/
+
+#include <stdio.h>
+#include <string.h>
+#include "renderpolicy.h"
+
+#define NS_PER_HOUR 3600000000000ULL
+
+void RenderPolicyInit(RENDERPOLICY* pPolicy, const POLICYCLOCK* pClock, int bKeepAudio)
+{
+    memset(pPolicy, 0, sizeof(*pPolicy));
+    pPolicy->clock = *pClock;
+    pPolicy->bKeepAudio = bKeepAudio;
+    pPolicy->qwSinceWallNs = pClock->pfnWallNs(pClock->pCtx);
+    pPolicy->qwSinceCpuNs = pClock->pfnCpuNs(pClock->pCtx);
+}
+
+// Closes the current stretch into the totals for the state it was in
+static void EndStretch(RENDERPOLICY* pPolicy)
+{
+    const POLICYCLOCK* pClock = &pPolicy->clock;
+    uint64_t qwWall = pClock->pfnWallNs(pClock->pCtx);
+    uint64_t qwCpu = pClock->pfnCpuNs(pClock->pCtx);
+    int iState = pPolicy->dwHidden != 0;
+
+    pPolicy->qwWallNs[iState] += qwWall - pPolicy->qwSinceWallNs;
+    pPolicy->qwCpuNs[iState] += qwCpu - pPolicy->qwSinceCpuNs;
+    pPolicy->qwSinceWallNs = qwWall;
+    pPolicy->qwSinceCpuNs = qwCpu;
+}
+
+int RenderPolicySet(RENDERPOLICY* pPolicy, uint32_t dwReason, int bOn)
+{
+    uint32_t dwHidden = bOn ? pPolicy->dwHidden | dwReason : pPolicy->dwHidden & ~dwReason;
+
+    if ((dwHidden != 0) == (pPolicy->dwHidden != 0))
+    {
+        pPolicy->dwHidden = dwHidden;
+        return 0;
+    }
+
+    EndStretch(pPolicy);
+    pPolicy->dwHidden = dwHidden;
+    if (dwHidden)
+        pPolicy->dwHides++;
+    else
+        pPolicy->bRepaintPending = 1;
+    return 1;
+}
+
+void RenderPolicyKeepAudio(RENDERPOLICY* pPolicy, int bKeepAudio)
+{
+    pPolicy->bKeepAudio = bKeepAudio;
+}
+
+int RenderPolicyMode(const RENDERPOLICY* pPolicy)
+{
+    if (!pPolicy->dwHidden)
+        return POLICY_RUN;
+
+    // Nobody hears a locked session
+    if (pPolicy->bKeepAudio && !(pPolicy->dwHidden & POLICY_LOCKED))
+        return POLICY_AUDIO_ONLY;
+    return POLICY_SUSPENDED;
+}
+
+int RenderPolicyVisible(const RENDERPOLICY* pPolicy)
+{
+    return pPolicy->dwHidden == 0;
+}
+
+int RenderPolicyTakeRepaint(RENDERPOLICY* pPolicy)
+{
+    int bRepaint = pPolicy->bRepaintPending;
+
+    pPolicy->bRepaintPending = 0;
+    return bRepaint;
+}
+
+void RenderPolicyWake(RENDERPOLICY* pPolicy)
+{
+    pPolicy->dwWakeups[pPolicy->dwHidden != 0]++;
+}
+
+static uint64_t StateWallNs(const RENDERPOLICY* pPolicy, int bHidden, uint64_t* pqwCpuNs)
+{
+    const POLICYCLOCK* pClock = &pPolicy->clock;
+    uint64_t qwWall = pPolicy->qwWallNs[bHidden];
+
+    *pqwCpuNs = pPolicy->qwCpuNs[bHidden];
+    if ((pPolicy->dwHidden != 0) == bHidden)
+    {
+        qwWall += pClock->pfnWallNs(pClock->pCtx) - pPolicy->qwSinceWallNs;
+        *pqwCpuNs += pClock->pfnCpuNs(pClock->pCtx) - pPolicy->qwSinceCpuNs;
+    }
+    return qwWall;
+}
+
+static double PerHour(uint64_t qwAmount, uint64_t qwWallNs)
+{
+    // Below one second of history the rate is noise
+    if (qwWallNs < 1000000000)
+        return 0;
+    return (double)qwAmount * NS_PER_HOUR / qwWallNs;
+}
+
+uint32_t RenderPolicyWakeupsPerHour(const RENDERPOLICY* pPolicy, int bHidden)
+{
+    uint64_t qwCpu;
+    uint64_t qwWall = StateWallNs(pPolicy, bHidden != 0, &qwCpu);
+
+    return (uint32_t)(PerHour(pPolicy->dwWakeups[bHidden != 0], qwWall) + 0.5);
+}
+
+uint32_t RenderPolicyCpuMsPerHour(const RENDERPOLICY* pPolicy, int bHidden)
+{
+    uint64_t qwCpu;
+    uint64_t qwWall = StateWallNs(pPolicy, bHidden != 0, &qwCpu);
+
+    return (uint32_t)(PerHour(qwCpu, qwWall) / 1000000 + 0.5);
+}
+
+void RenderPolicyFormat(const RENDERPOLICY* pPolicy, char* buf, size_t cb)
+{
+    uint64_t qwCpu[2], qwWall[2];
+    int i;
+
+    for (i = 0; i < 2; i++)
+        qwWall[i] = StateWallNs(pPolicy, i, &qwCpu[i]);
+
+    snprintf(buf, cb, "Render policy: visible %llus, %.0f wakeups/h, %.1f ms CPU/h; "
+        "hidden %llus (%u times), %.0f wakeups/h, %.1f ms CPU/h",
+        (unsigned long long)(qwWall[0] / 1000000000),
+        PerHour(pPolicy->dwWakeups[0], qwWall[0]), PerHour(qwCpu[0], qwWall[0]) / 1000000,
+        (unsigned long long)(qwWall[1] / 1000000000), pPolicy->dwHides,
+        PerHour(pPolicy->dwWakeups[1], qwWall[1]), PerHour(qwCpu[1], qwWall[1]) / 1000000);
+}
@@ -0,0 +1,75 @@
+/*--------------------------
+    RENDERPOLICY.H -- Suspends drawing while the clock cannot be seen
+---------------------------*/
+
+#ifndef RENDERPOLICY_H
+#define RENDERPOLICY_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Reasons the window cannot be seen; any one of them hides it
+#define POLICY_MINIMIZED 0x1
+#define POLICY_OCCLUDED 0x2
+#define POLICY_LOCKED 0x4
+
+// What the tick timer should do
+enum
+{
+    POLICY_RUN,                 // draw every second
+    POLICY_AUDIO_ONLY,          // keep the timer for the tick sound, draw nothing
+    POLICY_SUSPENDED            // stop the timer until the window is visible again
+};
+
+// Wall and process CPU time in nanoseconds; tests pass fake ones
+typedef struct
+{
+    uint64_t (*pfnWallNs)(void* pCtx);
+    uint64_t (*pfnCpuNs)(void* pCtx);
+    void* pCtx;
+} POLICYCLOCK;
+
+typedef struct
+{
+    POLICYCLOCK clock;
+    uint32_t dwHidden;          // POLICY_* reasons currently set
+    int bKeepAudio;             // tick audibly while hidden
+    int bRepaintPending;        // just became visible; show the current time now
+
+    // Start of the current visible or hidden stretch
+    uint64_t qwSinceWallNs;
+    uint64_t qwSinceCpuNs;
+
+    // Totals for finished stretches, by [0] visible and [1] hidden
+    uint64_t qwWallNs[2];
+    uint64_t qwCpuNs[2];
+    uint32_t dwWakeups[2];
+    uint32_t dwHides;
+} RENDERPOLICY;
+
+void RenderPolicyInit(RENDERPOLICY* pPolicy, const POLICYCLOCK* pClock, int bKeepAudio);
+
+// Sets or clears one POLICY_* reason. Returns 1 when that changes whether
+// the window can be seen.
+int RenderPolicySet(RENDERPOLICY* pPolicy, uint32_t dwReason, int bOn);
+
+void RenderPolicyKeepAudio(RENDERPOLICY* pPolicy, int bKeepAudio);
+
+int RenderPolicyMode(const RENDERPOLICY* pPolicy);
+int RenderPolicyVisible(const RENDERPOLICY* pPolicy);
+
+// Returns 1 once after the window becomes visible again
+int RenderPolicyTakeRepaint(RENDERPOLICY* pPolicy);
+
+// Counts a timer wake-up against the current state
+void RenderPolicyWake(RENDERPOLICY* pPolicy);
+
+// Wake-ups per hour and CPU milliseconds per hour, visible (0) or hidden (1),
+// including the stretch in progress
+uint32_t RenderPolicyWakeupsPerHour(const RENDERPOLICY* pPolicy, int bHidden);
+uint32_t RenderPolicyCpuMsPerHour(const RENDERPOLICY* pPolicy, int bHidden);
+
+// One-line summary of both states
+void RenderPolicyFormat(const RENDERPOLICY* pPolicy, char* buf, size_t cb);
+
+#endif
@@ -0,0 +1,162 @@
+/*--------------------------
+    ROTATE.C -- Table-driven point rotation
+                (portable C with SSE2/AVX2 paths)
+---------------------------*/
+
+#include <math.h>
+#include "rotate.h"
+
+#if defined(__AVX2__)
+#define ROT_USE_AVX2
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define ROT_USE_SSE2
+#include <emmintrin.h>
+#endif
+
+#define ROT_PI 3.14159265358979323846
+#define ROT_ROUND 0x8000
+
+// One full turn of sines plus a quarter turn, so cos(a) == sin(a + 90 degrees)
+// is a plain lookup with no wrap-around
+static int32_t s_sinQ16[ROT_TABLE_SIZE + ROT_TABLE_SIZE / 4];
+static int s_bTableReady = 0;
+
+void InitRotateTable(void)
+{
+    int i;
+
+    if (s_bTableReady)
+        return;
+
+    for (i = 0; i < ROT_TABLE_SIZE + ROT_TABLE_SIZE / 4; i++)
+    {
+        double rad = 2.0 * ROT_PI * i / ROT_TABLE_SIZE;
+        s_sinQ16[i] = (int32_t)floor(sin(rad) * ROT_Q16_ONE + 0.5);
+    }
+    s_bTableReady = 1;
+}
+
+static int NormalizeTenths(int iTenths)
+{
+    iTenths %= ROT_TABLE_SIZE;
+    return iTenths < 0 ? iTenths + ROT_TABLE_SIZE : iTenths;
+}
+
+int32_t RotSinQ16(int iTenths)
+{
+    InitRotateTable();
+    return s_sinQ16[NormalizeTenths(iTenths)];
+}
+
+int32_t RotCosQ16(int iTenths)
+{
+    InitRotateTable();
+    return s_sinQ16[NormalizeTenths(iTenths) + ROT_TABLE_SIZE / 4];
+}
+
+static void RotateRange(ROTPOINT pt[], int iFirst, int iNum, int32_t c, int32_t s)
+{
+    int i;
+    int32_t x, y;
+
+    // Round to nearest; >> on a negative value is an arithmetic shift on
+    // every compiler we build with, matching _mm_srai_epi32 below
+    for (i = iFirst; i < iNum; i++)
+    {
+        x = pt[i].x;
+        y = pt[i].y;
+        pt[i].x = (x * c + y * s + ROT_ROUND) >> 16;
+        pt[i].y = (y * c - x * s + ROT_ROUND) >> 16;
+    }
+}
+
+void RotatePointsScalar(ROTPOINT pt[], int iNum, int iTenths)
+{
+    RotateRange(pt, 0, iNum, RotCosQ16(iTenths), RotSinQ16(iTenths));
+}
+
+#if defined(ROT_USE_AVX2)
+
+// Each 256-bit register holds four interleaved points {x0,y0,x1,y1,...}.
+// x' = x*c + y*s and y' = y*c - x*s, so multiply the register by c, the
+// pair-swapped register by {s,-s,s,-s,...} and add.
+void RotatePoints(ROTPOINT pt[], int iNum, int iTenths)
+{
+    int i = 0;
+    int32_t c = RotCosQ16(iTenths);
+    int32_t s = RotSinQ16(iTenths);
+    __m256i vc = _mm256_set1_epi32(c);
+    __m256i vs = _mm256_setr_epi32(s, -s, s, -s, s, -s, s, -s);
+    __m256i vr = _mm256_set1_epi32(ROT_ROUND);
+
+    for (; i + 4 <= iNum; i += 4)
+    {
+        __m256i v = _mm256_loadu_si256((const __m256i*)&pt[i]);
+        __m256i sw = _mm256_shuffle_epi32(v, _MM_SHUFFLE(2, 3, 0, 1));
+        __m256i r = _mm256_add_epi32(_mm256_mullo_epi32(v, vc), _mm256_mullo_epi32(sw, vs));
+        r = _mm256_srai_epi32(_mm256_add_epi32(r, vr), 16);
+        _mm256_storeu_si256((__m256i*)&pt[i], r);
+    }
+    RotateRange(pt, i, iNum, c, s);
+}
+
+const char* RotateKernelName(void)
+{
+    return "avx2";
+}
+
+#elif defined(ROT_USE_SSE2)
+
+// SSE2 has no 32-bit low multiply (that arrived with SSE4.1), so build it
+// from two 32x32->64 multiplies on the even and odd lanes
+static __m128i MulLo32(__m128i a, __m128i b)
+{
+    __m128i even = _mm_mul_epu32(a, b);
+    __m128i odd = _mm_mul_epu32(_mm_srli_epi64(a, 32), _mm_srli_epi64(b, 32));
+    return _mm_unpacklo_epi32(_mm_shuffle_epi32(even, _MM_SHUFFLE(0, 0, 2, 0)),
+        _mm_shuffle_epi32(odd, _MM_SHUFFLE(0, 0, 2, 0)));
+}
+
+// Same scheme as the AVX2 path, two points per register, unrolled to four
+void RotatePoints(ROTPOINT pt[], int iNum, int iTenths)
+{
+    int i = 0;
+    int32_t c = RotCosQ16(iTenths);
+    int32_t s = RotSinQ16(iTenths);
+    __m128i vc = _mm_set1_epi32(c);
+    __m128i vs = _mm_setr_epi32(s, -s, s, -s);
+    __m128i vr = _mm_set1_epi32(ROT_ROUND);
+
+    for (; i + 4 <= iNum; i += 4)
+    {
+        __m128i v0 = _mm_loadu_si128((const __m128i*)&pt[i]);
+        __m128i v1 = _mm_loadu_si128((const __m128i*)&pt[i + 2]);
+        __m128i r0 = _mm_add_epi32(MulLo32(v0, vc),
+            MulLo32(_mm_shuffle_epi32(v0, _MM_SHUFFLE(2, 3, 0, 1)), vs));
+        __m128i r1 = _mm_add_epi32(MulLo32(v1, vc),
+            MulLo32(_mm_shuffle_epi32(v1, _MM_SHUFFLE(2, 3, 0, 1)), vs));
+        _mm_storeu_si128((__m128i*)&pt[i], _mm_srai_epi32(_mm_add_epi32(r0, vr), 16));
+        _mm_storeu_si128((__m128i*)&pt[i + 2], _mm_srai_epi32(_mm_add_epi32(r1, vr), 16));
+    }
+    RotateRange(pt, i, iNum, c, s);
+}
+
+const char* RotateKernelName(void)
+{
+    return "sse2";
+}
+
+#else
+
+void RotatePoints(ROTPOINT pt[], int iNum, int iTenths)
+{
+    RotatePointsScalar(pt, iNum, iTenths);
+}
+
+const char* RotateKernelName(void)
+{
+    return "scalar";
+}
+
+#endif
@@ -0,0 +1,40 @@
+/*--------------------------
+    ROTATE.H -- Table-driven point rotation
+---------------------------*/
+
+#ifndef ROTATE_H
+#define ROTATE_H
+
+#include <stdint.h>
+
+// Angles are given in tenths of a degree, clockwise, like the clock hands
+#define ROT_STEPS_PER_DEGREE 10
+#define ROT_TABLE_SIZE (360 * ROT_STEPS_PER_DEGREE)
+
+// Sine/cosine values are stored as Q16 fixed point (65536 == 1.0)
+#define ROT_Q16_ONE 65536
+
+// Coordinates must stay within +/-ROT_MAX_COORD so the Q16 products fit in 32 bits
+#define ROT_MAX_COORD 16383
+
+// Same layout as the Win32 POINT (two 32-bit LONGs)
+typedef struct
+{
+    int32_t x;
+    int32_t y;
+} ROTPOINT;
+
+void InitRotateTable(void);
+int32_t RotSinQ16(int iTenths);
+int32_t RotCosQ16(int iTenths);
+
+// Rotates iNum points in place, using the widest SIMD path compiled in
+void RotatePoints(ROTPOINT pt[], int iNum, int iTenths);
+
+// Plain C path; RotatePoints gives exactly the same results
+void RotatePointsScalar(ROTPOINT pt[], int iNum, int iTenths);
+
+// Name of the path RotatePoints uses ("avx2", "sse2" or "scalar")
+const char* RotateKernelName(void);
+
+#endif
@@ -0,0 +1,145 @@
+/*--------------------------
+    STARTPROF.C -- Startup timeline, phase by phase up to the first frame
+---------------------------*/
+
+#include <stdarg.h>
+#include <string.h>
+#include "startprof.h"
+#include "phasetime.h"
+
+void StartProfInit(STARTPROF* pProf, uint64_t qwOriginNs)
+{
+    memset(pProf, 0, sizeof(*pProf));
+    pProf->qwOriginNs = qwOriginNs;
+}
+
+static uint64_t SinceOrigin(const STARTPROF* pProf)
+{
+    uint64_t qwNow = PhaseNowNs();
+
+    return qwNow > pProf->qwOriginNs ? qwNow - pProf->qwOriginNs : 0;
+}
+
+void StartProfBegin(STARTPROF* pProf, const char* pszName)
+{
+    STARTPHASE* pPhase;
+
+    if (pProf->qwFirstFrameNs || !pProf->qwOriginNs)
+        return;
+
+    // A phase that does not fit is still matched by its StartProfEnd
+    if (pProf->nPhases == STARTPROF_MAX_PHASES || pProf->nOpen == STARTPROF_MAX_DEPTH)
+    {
+        pProf->nDropped++;
+        if (pProf->nOpen < STARTPROF_MAX_DEPTH)
+            pProf->iOpen[pProf->nOpen++] = -1;
+        return;
+    }
+
+    pPhase = &pProf->phases[pProf->nPhases];
+    pPhase->pszName = pszName;
+    pPhase->iDepth = pProf->nOpen;
+    pPhase->qwStartNs = SinceOrigin(pProf);
+    pPhase->qwEndNs = pPhase->qwStartNs;
+    pProf->iOpen[pProf->nOpen++] = pProf->nPhases++;
+}
+
+void StartProfEnd(STARTPROF* pProf)
+{
+    int iPhase;
+
+    if (pProf->qwFirstFrameNs || !pProf->nOpen)
+        return;
+
+    iPhase = pProf->iOpen[--pProf->nOpen];
+    if (iPhase >= 0)
+        pProf->phases[iPhase].qwEndNs = SinceOrigin(pProf);
+}
+
+void StartProfFirstFrame(STARTPROF* pProf)
+{
+    if (pProf->qwFirstFrameNs || !pProf->qwOriginNs)
+        return;
+
+    while (pProf->nOpen)
+        StartProfEnd(pProf);
+    pProf->qwFirstFrameNs = SinceOrigin(pProf);
+}
+
+uint64_t StartProfUnaccountedNs(const STARTPROF* pProf)
+{
+    uint64_t qwCovered = 0;
+    int i;
+
+    for (i = 0; i < pProf->nPhases; i++)
+    {
+        if (pProf->phases[i].iDepth == 0)
+            qwCovered += pProf->phases[i].qwEndNs - pProf->phases[i].qwStartNs;
+    }
+    return pProf->qwFirstFrameNs > qwCovered ? pProf->qwFirstFrameNs - qwCovered : 0;
+}
+
+// Appends to buf at *pcch; *pcch keeps counting past cb so overflow shows
+static void Append(char* buf, size_t cb, size_t* pcch, const char* pszFormat, ...)
+{
+    va_list args;
+    int n;
+
+    va_start(args, pszFormat);
+    n = vsnprintf(buf + (*pcch < cb ? *pcch : cb), *pcch < cb ? cb - *pcch : 0, pszFormat, args);
+    va_end(args);
+    if (n > 0)
+        *pcch += n;
+}
+
+int StartProfFormat(const STARTPROF* pProf, uint64_t qwBudgetNs, char* buf, size_t cb)
+{
+    const STARTPHASE* pPhase;
+    size_t cch = 0;
+    int i;
+
+    if (cb)
+        buf[0] = '\0';
+    Append(buf, cb, &cch, "Startup: first frame at %.1f ms", pProf->qwFirstFrameNs / 1e6);
+    if (qwBudgetNs)
+        Append(buf, cb, &cch, " (budget %.1f ms, %s)", qwBudgetNs / 1e6,
+            pProf->qwFirstFrameNs <= qwBudgetNs ? "met" : "MISSED");
+
+    for (i = 0; i < pProf->nPhases; i++)
+    {
+        pPhase = &pProf->phases[i];
+        Append(buf, cb, &cch, "\n  %7.2f ms %8.2f ms  %*s%s", pPhase->qwStartNs / 1e6,
+            (pPhase->qwEndNs - pPhase->qwStartNs) / 1e6, pPhase->iDepth * 2, "", pPhase->pszName);
+    }
+    Append(buf, cb, &cch, "\n             %8.2f ms  (between phases)", StartProfUnaccountedNs(pProf) / 1e6);
+    if (pProf->nDropped)
+        Append(buf, cb, &cch, "\n  %d phases not recorded", pProf->nDropped);
+    return cch < cb;
+}
+
+int StartProfWriteCsv(const STARTPROF* pProf, FILE* fp)
+{
+    const STARTPHASE* pPhase;
+    int i;
+
+    fprintf(fp, "phase,depth,start_ns,duration_ns\n");
+    for (i = 0; i < pProf->nPhases; i++)
+    {
+        pPhase = &pProf->phases[i];
+        fprintf(fp, "%s,%d,%llu,%llu\n", pPhase->pszName, pPhase->iDepth,
+            (unsigned long long)pPhase->qwStartNs, (unsigned long long)(pPhase->qwEndNs - pPhase->qwStartNs));
+    }
+    fprintf(fp, "first_frame,0,%llu,0\n", (unsigned long long)pProf->qwFirstFrameNs);
+    return !ferror(fp);
+}
+
+int StartProfDumpFile(const STARTPROF* pProf, const char* pszPath)
+{
+    FILE* fp = fopen(pszPath, "w");
+    int bOk;
+
+    if (!fp)
+        return 0;
+    bOk = StartProfWriteCsv(pProf, fp);
+    return fclose(fp) == 0 && bOk;
+}
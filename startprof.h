@@ -0,0 +1,56 @@
+/*--------------------------
+    STARTPROF.H -- Startup timeline, phase by phase up to the first frame
+---------------------------*/
+
+#ifndef STARTPROF_H
+#define STARTPROF_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#define STARTPROF_MAX_PHASES 32
+#define STARTPROF_MAX_DEPTH 4
+
+// Start and end are nanoseconds after the origin
+typedef struct
+{
+    const char* pszName;        // not copied; use string literals
+    int iDepth;                 // 0 for top-level phases
+    uint64_t qwStartNs;
+    uint64_t qwEndNs;
+} STARTPHASE;
+
+// Phases may nest, so a resource created on first use shows up inside
+// the phase that needed it. Everything after the first frame is ignored.
+typedef struct
+{
+    uint64_t qwOriginNs;        // PhaseNowNs() at process start
+    STARTPHASE phases[STARTPROF_MAX_PHASES];
+    int nPhases;
+    int iOpen[STARTPROF_MAX_DEPTH];
+    int nOpen;
+    int nDropped;               // phases that did not fit
+    uint64_t qwFirstFrameNs;    // 0 until StartProfFirstFrame
+} STARTPROF;
+
+// qwOriginNs may lie before now when the process started earlier
+void StartProfInit(STARTPROF* pProf, uint64_t qwOriginNs);
+
+void StartProfBegin(STARTPROF* pProf, const char* pszName);
+void StartProfEnd(STARTPROF* pProf);
+
+// Closes any open phases and stops recording
+void StartProfFirstFrame(STARTPROF* pProf);
+
+// Time not covered by any top-level phase, up to the first frame
+uint64_t StartProfUnaccountedNs(const STARTPROF* pProf);
+
+// Indented timeline, one phase per line, with the first frame checked
+// against qwBudgetNs (0 for no budget). Returns 0 if buf was too small.
+int StartProfFormat(const STARTPROF* pProf, uint64_t qwBudgetNs, char* buf, size_t cb);
+
+int StartProfWriteCsv(const STARTPROF* pProf, FILE* fp);
+int StartProfDumpFile(const STARTPROF* pProf, const char* pszPath);
+
+#endif
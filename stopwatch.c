@@ -0,0 +1,308 @@
+/*--------------------------
+    STOPWATCH.C -- Stopwatch on a steady counter, with laps in a lock-free ring
+---------------------------*/
+
+#include <stdlib.h>
+#include <string.h>
+#include "stopwatch.h"
+#include "sweep.h"
+
+#ifdef _MSC_VER
+#include <windows.h>
+#endif
+
+// Laps are stored by one thread and read by any, with no locks: the
+// writer only ever stores to a slot and readers only ever load from it
+#ifdef _MSC_VER
+static uint32_t LoadAcquire32(const volatile uint32_t* p)
+{
+    uint32_t v = *p;
+
+    MemoryBarrier();
+    return v;
+}
+
+static void StoreRelease32(volatile uint32_t* p, uint32_t v)
+{
+    MemoryBarrier();
+    *p = v;
+}
+
+#define LoadRelaxed32(p) (*(p))
+#define StoreRelaxed32(p, v) (*(p) = (v))
+#define FenceAcquire() MemoryBarrier()
+#define FenceRelease() MemoryBarrier()
+#else
+#define LoadAcquire32(p) __atomic_load_n((p), __ATOMIC_ACQUIRE)
+#define StoreRelease32(p, v) __atomic_store_n((p), (v), __ATOMIC_RELEASE)
+#define LoadRelaxed32(p) __atomic_load_n((p), __ATOMIC_RELAXED)
+#define StoreRelaxed32(p, v) __atomic_store_n((p), (v), __ATOMIC_RELAXED)
+#define FenceAcquire() __atomic_thread_fence(__ATOMIC_ACQUIRE)
+#define FenceRelease() __atomic_thread_fence(__ATOMIC_RELEASE)
+#endif
+
+// A reader that keeps landing on a slot being rewritten gives up on it
+#define LAP_READ_TRIES 8
+
+#define NS_PER_MS 1000000ULL
+
+void StopwatchInit(STOPWATCH* pWatch, const WATCHCLOCK* pClock)
+{
+    memset(pWatch, 0, sizeof(*pWatch));
+    pWatch->clock = *pClock;
+}
+
+// The press time, or now; never before the last start or stop
+static uint64_t PressTime(const STOPWATCH* pWatch, uint64_t qwPressNs)
+{
+    if (!qwPressNs)
+        qwPressNs = pWatch->clock.pfnNowNs(pWatch->clock.pCtx);
+    return qwPressNs < pWatch->qwStartNs ? pWatch->qwStartNs : qwPressNs;
+}
+
+void StopwatchStart(STOPWATCH* pWatch, uint64_t qwPressNs)
+{
+    if (pWatch->bRunning)
+        return;
+    pWatch->qwStartNs = PressTime(pWatch, qwPressNs);
+    pWatch->bRunning = 1;
+    pWatch->dwStarts++;
+}
+
+// qwStartNs keeps the stop time while stopped, so a late start press
+// cannot land before it
+void StopwatchStop(STOPWATCH* pWatch, uint64_t qwPressNs)
+{
+    uint64_t qwNowNs;
+
+    if (!pWatch->bRunning)
+        return;
+    qwNowNs = PressTime(pWatch, qwPressNs);
+    pWatch->qwBankedNs += qwNowNs - pWatch->qwStartNs;
+    pWatch->qwStartNs = qwNowNs;
+    pWatch->bRunning = 0;
+}
+
+void StopwatchReset(STOPWATCH* pWatch)
+{
+    StopwatchStop(pWatch, 0);
+    pWatch->qwBankedNs = 0;
+    pWatch->qwLastLapNs = 0;
+    StoreRelease32(&pWatch->ring.dwFirst, LoadRelaxed32(&pWatch->ring.dwCount));
+}
+
+uint64_t StopwatchElapsedNs(const STOPWATCH* pWatch, uint64_t qwNowNs)
+{
+    if (!pWatch->bRunning || qwNowNs < pWatch->qwStartNs)
+        return pWatch->qwBankedNs;
+    return pWatch->qwBankedNs + (qwNowNs - pWatch->qwStartNs);
+}
+
+uint32_t StopwatchLap(STOPWATCH* pWatch, uint64_t qwPressNs)
+{
+    LAPRING* pRing = &pWatch->ring;
+    LAP* pSlot;
+    uint32_t dwIndex, dwSeq;
+    uint64_t qwElapsedNs, qwCaptureNs;
+
+    if (!pWatch->bRunning)
+        return 0;
+    qwPressNs = PressTime(pWatch, qwPressNs);
+    qwElapsedNs = StopwatchElapsedNs(pWatch, qwPressNs);
+    if (qwElapsedNs < pWatch->qwLastLapNs)
+        qwElapsedNs = pWatch->qwLastLapNs;
+
+    dwIndex = LoadRelaxed32(&pRing->dwCount);
+    pSlot = &pRing->slots[dwIndex & (LAP_RING_SLOTS - 1)];
+
+    // Odd before any field changes
+    dwSeq = LoadRelaxed32(&pSlot->dwSeq);
+    StoreRelaxed32(&pSlot->dwSeq, dwSeq + 1);
+    FenceRelease();
+
+    pSlot->dwIndex = dwIndex;
+    pSlot->dwLap = dwIndex - LoadRelaxed32(&pRing->dwFirst) + 1;
+    pSlot->qwElapsedNs = qwElapsedNs;
+    pSlot->qwSplitNs = qwElapsedNs - pWatch->qwLastLapNs;
+    pSlot->qwPressNs = qwPressNs;
+    pSlot->qwStoredNs = pWatch->clock.pfnNowNs(pWatch->clock.pCtx);
+
+    StoreRelease32(&pSlot->dwSeq, dwSeq + 2);
+    StoreRelease32(&pRing->dwCount, dwIndex + 1);
+
+    pWatch->qwLastLapNs = qwElapsedNs;
+    qwCaptureNs = pSlot->qwStoredNs - qwPressNs;
+    pWatch->qwCaptureTotalNs += qwCaptureNs;
+    if (qwCaptureNs > pWatch->qwCaptureMaxNs)
+        pWatch->qwCaptureMaxNs = qwCaptureNs;
+    pWatch->dwLaps++;
+    return pSlot->dwLap;
+}
+
+// Copies the lap stored dwIndex-th; 0 if it has been overwritten
+static int ReadSlot(const LAPRING* pRing, uint32_t dwIndex, LAP* pOut)
+{
+    const LAP* pSlot = &pRing->slots[dwIndex & (LAP_RING_SLOTS - 1)];
+    uint32_t dwSeq;
+    int i;
+
+    for (i = 0; i < LAP_READ_TRIES; i++)
+    {
+        dwSeq = LoadAcquire32(&pSlot->dwSeq);
+        if (dwSeq & 1)
+            continue;
+        pOut->dwIndex = pSlot->dwIndex;
+        pOut->dwLap = pSlot->dwLap;
+        pOut->qwElapsedNs = pSlot->qwElapsedNs;
+        pOut->qwSplitNs = pSlot->qwSplitNs;
+        pOut->qwPressNs = pSlot->qwPressNs;
+        pOut->qwStoredNs = pSlot->qwStoredNs;
+        FenceAcquire();
+        if (LoadRelaxed32(&pSlot->dwSeq) != dwSeq)
+            continue;
+        pOut->dwSeq = dwSeq;
+        return pOut->dwIndex == dwIndex;
+    }
+    return 0;
+}
+
+int LapRingRead(const LAPRING* pRing, uint32_t dwFromLap, LAP* pOut, int nMax)
+{
+    uint32_t dwCount = LoadAcquire32(&pRing->dwCount);
+    uint32_t dwFirst = LoadAcquire32(&pRing->dwFirst);
+    uint32_t dwIndex = dwFirst + (dwFromLap ? dwFromLap - 1 : 0);
+    int n = 0;
+
+    if (dwIndex - dwFirst > dwCount - dwFirst)
+        return 0;
+    if (dwCount - dwIndex > LAP_RING_SLOTS)
+        dwIndex = dwCount - LAP_RING_SLOTS;
+
+    for (; dwIndex != dwCount && n < nMax; dwIndex++)
+        n += ReadSlot(pRing, dwIndex, &pOut[n]);
+    return n;
+}
+
+void StopwatchHandAngles(uint64_t qwElapsedNs, int iTenths[3])
+{
+    uint64_t qwMs = qwElapsedNs / NS_PER_MS;
+
+    SweepHandAngles(SWEEP_SMOOTH, (int)(qwMs / 3600000 % 12), (int)(qwMs / 60000 % 60), (int)(qwMs / 1000 % 60),
+        (int)(qwMs % 1000), iTenths);
+}
+
+void StopwatchFormatElapsed(uint64_t qwElapsedNs, char* buf, size_t cb)
+{
+    uint64_t qwMs = qwElapsedNs / NS_PER_MS;
+
+    if (qwMs >= 3600000)
+        snprintf(buf, cb, "%lu:%02u:%02u.%03u", (unsigned long)(qwMs / 3600000), (unsigned)(qwMs / 60000 % 60),
+            (unsigned)(qwMs / 1000 % 60), (unsigned)(qwMs % 1000));
+    else
+        snprintf(buf, cb, "%02u:%02u.%03u", (unsigned)(qwMs / 60000), (unsigned)(qwMs / 1000 % 60),
+            (unsigned)(qwMs % 1000));
+}
+
+void StopwatchDrawDial(const CLOCKBACKEND* pBackend, const CLOCKSTYLE* pStyle, uint64_t qwElapsedNs,
+    const LAP* pLastLap, int iTextHeight)
+{
+    uint32_t color = ClockForeground(pStyle);
+    ROTPOINT pt[2];
+    char buf[STOPWATCH_TEXT_CHARS], szSplit[24];
+    int i, iSize;
+
+    // A mark every 100 ms, the larger at 0
+    for (i = 0; i < 10; i++)
+    {
+        pt[0].x = 0;
+        pt[0].y = STOPWATCH_DIAL_RADIUS;
+        RotatePoints(pt, 1, i * 36 * ROT_STEPS_PER_DEGREE);
+        iSize = i ? 12 : 24;
+        pBackend->pfnDisc(pBackend->pCtx, pt[0].x - iSize / 2, STOPWATCH_DIAL_Y + pt[0].y - iSize / 2,
+            pt[0].x + iSize / 2, STOPWATCH_DIAL_Y + pt[0].y + iSize / 2, color);
+    }
+    pBackend->pfnDisc(pBackend->pCtx, -10, STOPWATCH_DIAL_Y - 10, 10, STOPWATCH_DIAL_Y + 10, color);
+
+    // One turn a second
+    pt[0].x = pt[0].y = 0;
+    pt[1].x = 0;
+    pt[1].y = STOPWATCH_DIAL_RADIUS - 20;
+    RotatePoints(&pt[1], 1, (int)(qwElapsedNs % (1000 * NS_PER_MS) * ROT_TABLE_SIZE / (1000 * NS_PER_MS)));
+    pt[0].y += STOPWATCH_DIAL_Y;
+    pt[1].y += STOPWATCH_DIAL_Y;
+    pBackend->pfnPolyline(pBackend->pCtx, pt, 2, 0, color);
+
+    StopwatchFormatElapsed(qwElapsedNs, buf, sizeof(buf));
+    pBackend->pfnText(pBackend->pCtx, 0, STOPWATCH_TEXT_Y, buf, iTextHeight, color);
+    if (pLastLap)
+    {
+        StopwatchFormatElapsed(pLastLap->qwSplitNs, szSplit, sizeof(szSplit));
+        snprintf(buf, sizeof(buf), "#%lu %s", (unsigned long)pLastLap->dwLap, szSplit);
+        pBackend->pfnText(pBackend->pCtx, 0, STOPWATCH_LAP_Y, buf, iTextHeight, color);
+    }
+}
+
+static void AddTextBox(int cxClient, int cyClient, int y, int cxText, int cyText, DAMAGERECT* pDamage)
+{
+    DAMAGERECT rc;
+    int x;
+
+    IsoToDevice(cxClient, cyClient, 0, y, &x, &y);
+    rc.left = x - cxText / 2 - 2;
+    rc.top = y - cyText / 2 - 2;
+    rc.right = x + (cxText + 1) / 2 + 2;
+    rc.bottom = y + (cyText + 1) / 2 + 2;
+    DamageUnion(pDamage, &rc);
+}
+
+void StopwatchDamage(int cxClient, int cyClient, int cxText, int cyText, DAMAGERECT* pDamage)
+{
+    const int r = STOPWATCH_DIAL_RADIUS + 15;
+    ROTPOINT pt[2] = { { -r, STOPWATCH_DIAL_Y - r }, { r, STOPWATCH_DIAL_Y + r } };
+    DAMAGERECT rc;
+
+    DamageFromPolygon(&rc, pt, 2, cxClient, cyClient, 2);
+    DamageUnion(pDamage, &rc);
+    AddTextBox(cxClient, cyClient, STOPWATCH_TEXT_Y, cxText, cyText, pDamage);
+    AddTextBox(cxClient, cyClient, STOPWATCH_LAP_Y, cxText, cyText, pDamage);
+}
+
+// Each call copies into a buffer of its own, so exports may overlap
+int StopwatchWriteCsv(const LAPRING* pRing, FILE* fp)
+{
+    LAP* laps = (LAP*)malloc(LAP_RING_SLOTS * sizeof(LAP));
+    int i, n;
+
+    if (!laps)
+        return 0;
+    n = LapRingRead(pRing, 1, laps, LAP_RING_SLOTS);
+    fprintf(fp, "lap,split_ms,elapsed_ms,capture_us\n");
+    for (i = 0; i < n; i++)
+        fprintf(fp, "%lu,%.6f,%.6f,%.3f\n", (unsigned long)laps[i].dwLap, laps[i].qwSplitNs / 1e6,
+            laps[i].qwElapsedNs / 1e6, (laps[i].qwStoredNs - laps[i].qwPressNs) / 1e3);
+    free(laps);
+    return !ferror(fp);
+}
+
+int StopwatchDumpFile(const LAPRING* pRing, const char* pszPath)
+{
+    FILE* fp = fopen(pszPath, "w");
+    int bOk;
+
+    if (!fp)
+        return 0;
+    bOk = StopwatchWriteCsv(pRing, fp);
+    return fclose(fp) == 0 && bOk;
+}
+
+void StopwatchFormat(const STOPWATCH* pWatch, char* buf, size_t cb)
+{
+    char szElapsed[32];
+
+    StopwatchFormatElapsed(StopwatchElapsedNs(pWatch, pWatch->clock.pfnNowNs(pWatch->clock.pCtx)),
+        szElapsed, sizeof(szElapsed));
+    snprintf(buf, cb, "Stopwatch: %s at %s, %lu starts, %lu laps, capture %.2f us avg, %.2f us max",
+        pWatch->bRunning ? "running" : "stopped", szElapsed, (unsigned long)pWatch->dwStarts,
+        (unsigned long)pWatch->dwLaps, pWatch->dwLaps ? pWatch->qwCaptureTotalNs / 1e3 / pWatch->dwLaps : 0.0,
+        pWatch->qwCaptureMaxNs / 1e3);
+}
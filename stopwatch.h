@@ -0,0 +1,118 @@
+/*--------------------------
+    STOPWATCH.H -- Stopwatch on a steady counter, with laps in a lock-free ring
+---------------------------*/
+
+#ifndef STOPWATCH_H
+#define STOPWATCH_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include "clockdraw.h"
+#include "damage.h"
+
+// Laps kept for reading and export; older ones are overwritten
+#define LAP_RING_SLOTS 256          // a power of two
+
+// Millisecond sub-dial below the centre of the face, and the readouts
+// above it, in logical units
+#define STOPWATCH_DIAL_Y (-250)
+#define STOPWATCH_DIAL_RADIUS 120
+#define STOPWATCH_TEXT_Y 250
+#define STOPWATCH_LAP_Y 170
+
+// Longest readout with its terminator: "#4294967295 " and 5124095:59:59.999,
+// the most a 64-bit nanosecond count can hold, with room to spare
+#define STOPWATCH_TEXT_CHARS 48
+
+// Where the time comes from; tests pass a fake counter
+typedef struct
+{
+    uint64_t (*pfnNowNs)(void* pCtx);   // never goes back, like PhaseNowNs
+    void* pCtx;
+} WATCHCLOCK;
+
+// A seqlock per slot, as in frameshm.h: dwSeq is odd while the slot is
+// rewritten, and a reader's copy is good only if dwSeq is the same even
+// value afterwards
+typedef struct
+{
+    volatile uint32_t dwSeq;
+    uint32_t dwIndex;           // laps stored before this one, ever
+    uint32_t dwLap;             // from 1 since the last reset
+    uint64_t qwElapsedNs;       // on the stopwatch when the lap was pressed
+    uint64_t qwSplitNs;         // since the lap before
+    uint64_t qwPressNs;         // counter reading when the lap was pressed
+    uint64_t qwStoredNs;        // counter reading once it was in the ring
+} LAP;
+
+// One writer, the thread that takes laps, and any number of readers
+typedef struct
+{
+    LAP slots[LAP_RING_SLOTS];
+    volatile uint32_t dwCount;  // laps stored, ever; published last
+    volatile uint32_t dwFirst;  // index of lap 1 since the last reset
+} LAPRING;
+
+// Everything but the ring belongs to the writer's thread
+typedef struct
+{
+    WATCHCLOCK clock;
+    int bRunning;
+    uint64_t qwStartNs;         // counter at the last start
+    uint64_t qwBankedNs;        // elapsed before the last start
+    uint64_t qwLastLapNs;       // elapsed at the last lap
+    LAPRING ring;
+
+    // Statistics
+    uint32_t dwStarts;
+    uint32_t dwLaps;
+    uint64_t qwCaptureTotalNs;  // press to stored, over dwLaps
+    uint64_t qwCaptureMaxNs;
+} STOPWATCH;
+
+void StopwatchInit(STOPWATCH* pWatch, const WATCHCLOCK* pClock);
+
+// Each takes the counter reading the key or button was pressed at, or 0
+// for now; a press before the last start or stop counts as at it
+void StopwatchStart(STOPWATCH* pWatch, uint64_t qwPressNs);
+void StopwatchStop(STOPWATCH* pWatch, uint64_t qwPressNs);
+
+// Stops, zeroes and starts the laps again from 1
+void StopwatchReset(STOPWATCH* pWatch);
+
+uint64_t StopwatchElapsedNs(const STOPWATCH* pWatch, uint64_t qwNowNs);
+
+// Stores a lap without a lock or an allocation, so it never waits on a
+// reader. Returns the lap number, or 0 while stopped.
+uint32_t StopwatchLap(STOPWATCH* pWatch, uint64_t qwPressNs);
+
+// Copies up to nMax laps since the last reset, oldest first, starting at
+// lap number dwFromLap. Laps overwritten before they were read are left
+// out. Any thread may call it while laps are being taken. Returns how
+// many were copied.
+int LapRingRead(const LAPRING* pRing, uint32_t dwFromLap, LAP* pOut, int nMax);
+
+// Hand angles in tenths of a degree for an elapsed time, sweeping: the
+// hour hand turns once in 12 hours, the others as on the clock
+void StopwatchHandAngles(uint64_t qwElapsedNs, int iTenths[3]);
+
+// H:MM:SS.mmm, or MM:SS.mmm under an hour
+void StopwatchFormatElapsed(uint64_t qwElapsedNs, char* buf, size_t cb);
+
+// The sub-dial with its millisecond hand, and the elapsed time and last
+// lap above the centre
+void StopwatchDrawDial(const CLOCKBACKEND* pBackend, const CLOCKSTYLE* pStyle, uint64_t qwElapsedNs,
+    const LAP* pLastLap, int iTextHeight);
+
+// Grows *pDamage by the device boxes of the sub-dial and both readouts,
+// each line of text at most cxText by cyText pixels
+void StopwatchDamage(int cxClient, int cyClient, int cxText, int cyText, DAMAGERECT* pDamage);
+
+// lap,split_ms,elapsed_ms,capture_us for every lap still in the ring
+int StopwatchWriteCsv(const LAPRING* pRing, FILE* fp);
+int StopwatchDumpFile(const LAPRING* pRing, const char* pszPath);
+
+void StopwatchFormat(const STOPWATCH* pWatch, char* buf, size_t cb);
+
+#endif
@@ -0,0 +1,142 @@
+/*--------------------------
+    SWEEP.C -- Sweeping hands from millisecond time, paced to the display
+---------------------------*/
+
+#include <math.h>
+#include <stdio.h>
+#include "sweep.h"
+
+// Damped spring for the mechanical tick: about 16% overshoot at 90 ms,
+// within 1% by SWEEP_EASE_MS, where the table snaps to exactly one
+#define SWEEP_SPRING_ZETA 0.5
+#define SWEEP_SPRING_OMEGA 40.0     // rad/s
+
+static int32_t easeQ16[SWEEP_EASE_MS + 1];
+
+void InitSweepTable(void)
+{
+    double wd = SWEEP_SPRING_OMEGA * sqrt(1 - SWEEP_SPRING_ZETA * SWEEP_SPRING_ZETA);
+    double decay = SWEEP_SPRING_ZETA * SWEEP_SPRING_OMEGA;
+    double t;
+    int i;
+
+    for (i = 0; i < SWEEP_EASE_MS; i++)
+    {
+        t = i / 1000.0;
+        easeQ16[i] = (int32_t)lround(ROT_Q16_ONE * (1 - exp(-decay * t) * (cos(wd * t) + decay / wd * sin(wd * t))));
+    }
+    easeQ16[SWEEP_EASE_MS] = ROT_Q16_ONE;
+}
+
+int32_t SweepEaseQ16(int iMs)
+{
+    if (iMs <= 0)
+        return 0;
+    return iMs < SWEEP_EASE_MS ? easeQ16[iMs] : ROT_Q16_ONE;
+}
+
+void SweepHandAngles(int iMode, int iHour, int iMinute, int iSecond, int iMilliseconds, int iTenths[3])
+{
+    int iPrev;
+
+    if (iMode == SWEEP_OFF)
+    {
+        ClockHandAngles(iHour, iMinute, iSecond, iTenths);
+        iTenths[0] *= ROT_STEPS_PER_DEGREE;
+        iTenths[1] *= ROT_STEPS_PER_DEGREE;
+        iTenths[2] *= ROT_STEPS_PER_DEGREE;
+        return;
+    }
+
+    // 3600 tenths in 12 hours, in an hour and in a minute
+    iTenths[0] = (int)(((iHour % 12) * 3600000L + iMinute * 60000L + iSecond * 1000L + iMilliseconds) / 12000);
+    iTenths[1] = iMinute * 60 + iSecond;
+    if (iMode == SWEEP_SMOOTH)
+    {
+        iTenths[2] = (iSecond * 1000 + iMilliseconds) * 3 / 50;
+        return;
+    }
+
+    // From the last second's mark to this one's, along the spring
+    iPrev = (iSecond + 59) % 60 * 60;
+    iTenths[2] = (iPrev + (int)((60 * SweepEaseQ16(iMilliseconds)) >> 16)) % 3600;
+}
+
+void SweepHandsInit(SWEEPHANDS* pHands)
+{
+    pHands->iTenths[0] = pHands->iTenths[1] = pHands->iTenths[2] = -1;
+}
+
+int SweepHandsMove(SWEEPHANDS* pHands, const int iTenths[3], int cxClient, int cyClient, DAMAGERECT* pDamage)
+{
+    DAMAGERECT rcHand;
+    int i, iMoved = 0;
+
+    for (i = 0; i < 3; i++)
+    {
+        if (iTenths[i] == pHands->iTenths[i])
+            continue;
+
+        if (pHands->iTenths[i] >= 0)
+        {
+            DamageFromPolygon(&rcHand, pHands->pt[i], CLOCK_HAND_POINTS, cxClient, cyClient, 2);
+            DamageUnion(pDamage, &rcHand);
+        }
+        ClockComputeHandTenths(i, iTenths[i], pHands->pt[i]);
+        pHands->iTenths[i] = iTenths[i];
+        DamageFromPolygon(&rcHand, pHands->pt[i], CLOCK_HAND_POINTS, cxClient, cyClient, 2);
+        DamageUnion(pDamage, &rcHand);
+        iMoved |= 1 << i;
+    }
+    return iMoved;
+}
+
+void FramePacerInit(FRAMEPACER* pPacer, int iHz, uint64_t qwNowNs)
+{
+    if (iHz < SWEEP_MIN_HZ)
+        iHz = SWEEP_MIN_HZ;
+    if (iHz > SWEEP_MAX_HZ)
+        iHz = SWEEP_MAX_HZ;
+
+    pPacer->qwPeriodNs = 1000000000 / (uint64_t)iHz;
+    pPacer->dwFrames = 0;
+    pPacer->dwEarly = 0;
+    pPacer->dwSkipped = 0;
+    pPacer->qwMaxLateNs = 0;
+    FramePacerResync(pPacer, qwNowNs);
+}
+
+void FramePacerResync(FRAMEPACER* pPacer, uint64_t qwNowNs)
+{
+    pPacer->qwNextNs = qwNowNs;
+}
+
+int FramePacerWake(FRAMEPACER* pPacer, uint64_t qwNowNs, uint64_t* pqwWaitNs)
+{
+    uint64_t qwLate, qwMissed;
+
+    if (qwNowNs < pPacer->qwNextNs)
+    {
+        pPacer->dwEarly++;
+        *pqwWaitNs = pPacer->qwNextNs - qwNowNs;
+        return 0;
+    }
+
+    qwLate = qwNowNs - pPacer->qwNextNs;
+    if (qwLate > pPacer->qwMaxLateNs)
+        pPacer->qwMaxLateNs = qwLate;
+    qwMissed = qwLate / pPacer->qwPeriodNs;
+    pPacer->dwSkipped += (uint32_t)qwMissed;
+    pPacer->qwNextNs += (qwMissed + 1) * pPacer->qwPeriodNs;
+
+    pPacer->dwFrames++;
+    *pqwWaitNs = pPacer->qwNextNs - qwNowNs;
+    return 1;
+}
+
+void FramePacerFormat(const FRAMEPACER* pPacer, char* buf, size_t cb)
+{
+    snprintf(buf, cb, "Frame pacer: %.1f Hz, %lu frames, %lu skipped, %lu early wake-ups, max late %.2f ms",
+        1e9 / pPacer->qwPeriodNs, (unsigned long)pPacer->dwFrames, (unsigned long)pPacer->dwSkipped,
+        (unsigned long)pPacer->dwEarly, pPacer->qwMaxLateNs / 1e6);
+}
@@ -0,0 +1,77 @@
+/*--------------------------
+    SWEEP.H -- Sweeping hands from millisecond time, paced to the display
+---------------------------*/
+
+#ifndef SWEEP_H
+#define SWEEP_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "clockdraw.h"
+#include "damage.h"
+
+// Frame rates the pacer accepts; 0 or 1 from the driver means 60
+#define SWEEP_MIN_HZ 60
+#define SWEEP_MAX_HZ 144
+
+// A mechanical tick moves the second hand in this long, overshooting and
+// settling like a damped spring
+#define SWEEP_EASE_MS 240
+
+typedef enum
+{
+    SWEEP_OFF,                  // whole-second ticks, as without /sweep
+    SWEEP_SMOOTH,               // every hand moves continuously
+    SWEEP_MECHANICAL            // the second hand ticks with overshoot
+} SWEEPMODE;
+
+// Builds the easing table; call once, after InitRotateTable
+void InitSweepTable(void);
+
+// Share of a mechanical tick done iMs after it starts, Q16; a little above
+// ROT_Q16_ONE while overshooting
+int32_t SweepEaseQ16(int iMs);
+
+// Hand angles in tenths of a degree (0..3599, clockwise from 12)
+void SweepHandAngles(int iMode, int iHour, int iMinute, int iSecond, int iMilliseconds, int iTenths[3]);
+
+// The hand outlines at the angles last shown. A hand is rotated again only
+// when its angle changes, from the pose tables when it is a whole degree.
+typedef struct
+{
+    int iTenths[3];             // -1 before the first move
+    ROTPOINT pt[3][CLOCK_HAND_POINTS];
+} SWEEPHANDS;
+
+void SweepHandsInit(SWEEPHANDS* pHands);
+
+// Moves the hands to iTenths. *pDamage grows by the old and new device
+// boxes of every hand that moved (all three the first time). Returns a
+// mask of those hands, bit 0 for the hour hand.
+int SweepHandsMove(SWEEPHANDS* pHands, const int iTenths[3], int cxClient, int cyClient, DAMAGERECT* pDamage);
+
+// Frame deadlines one refresh period apart. A wake-up past a deadline draws
+// one frame and drops the periods it missed, so a stall never turns into
+// a burst of frames catching up.
+typedef struct
+{
+    uint64_t qwPeriodNs;
+    uint64_t qwNextNs;          // deadline of the next frame
+    uint32_t dwFrames;
+    uint32_t dwEarly;           // wake-ups before the deadline
+    uint32_t dwSkipped;         // periods dropped after running late
+    uint64_t qwMaxLateNs;
+} FRAMEPACER;
+
+void FramePacerInit(FRAMEPACER* pPacer, int iHz, uint64_t qwNowNs);
+
+// Call on every wake-up. Returns 1 when a frame is due now. Either way
+// *pqwWaitNs is the time to the next deadline.
+int FramePacerWake(FRAMEPACER* pPacer, uint64_t qwNowNs, uint64_t* pqwWaitNs);
+
+// Starts again from now, without counting the time stopped as skipped
+void FramePacerResync(FRAMEPACER* pPacer, uint64_t qwNowNs);
+
+void FramePacerFormat(const FRAMEPACER* pPacer, char* buf, size_t cb);
+
+#endif
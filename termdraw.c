@@ -0,0 +1,320 @@
+/*--------------------------
+    TERMDRAW.C -- The clock as braille or half-block terminal cells, sent as a diff
+---------------------------*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "termdraw.h"
+#include "phasetime.h"
+
+#define TERM_BRAILLE_BASE 0x2800
+#define TERM_UPPER_HALF 0x2580
+#define TERM_LOWER_HALF 0x2584
+#define TERM_FULL_BLOCK 0x2588
+
+// Bit of each dot in a braille cell, by row then column
+static const uint8_t brailleBits[4][2] =
+{
+    { 0x01, 0x08 },
+    { 0x02, 0x10 },
+    { 0x04, 0x20 },
+    { 0x40, 0x80 }
+};
+
+int TermScreenInit(TERMSCREEN* pScreen, int nCols, int nRows, int iMode)
+{
+    size_t nCells = (size_t)nCols * nRows;
+
+    memset(pScreen, 0, sizeof(*pScreen));
+    pScreen->nCols = nCols;
+    pScreen->nRows = nRows;
+    pScreen->iMode = iMode;
+    pScreen->cxDot = iMode == TERM_BRAILLE ? 2 : 1;
+    pScreen->cyDot = iMode == TERM_BRAILLE ? 4 : 2;
+
+    // Three UTF-8 bytes a cell, a cursor move a row and the colors and
+    // clear of a whole frame are the most one diff can take
+    pScreen->cbCap = nCells * 3 + (size_t)nRows * 16 + 64;
+    pScreen->pCells = (uint32_t*)malloc(nCells * sizeof(uint32_t));
+    pScreen->pShown = (uint32_t*)malloc(nCells * sizeof(uint32_t));
+    pScreen->pOut = (char*)malloc(pScreen->cbCap);
+    if (!pScreen->pCells || !pScreen->pShown || !pScreen->pOut ||
+        !RasterCreate(&pScreen->dots, nCols * pScreen->cxDot, nRows * pScreen->cyDot))
+    {
+        TermScreenFree(pScreen);
+        return 0;
+    }
+
+    TermScreenInvalidate(pScreen);
+    return 1;
+}
+
+void TermScreenFree(TERMSCREEN* pScreen)
+{
+    free(pScreen->pCells);
+    free(pScreen->pShown);
+    free(pScreen->pOut);
+    RasterFree(&pScreen->dots);
+    pScreen->pCells = pScreen->pShown = NULL;
+    pScreen->pOut = NULL;
+}
+
+void TermScreenInvalidate(TERMSCREEN* pScreen)
+{
+    pScreen->bFull = 1;
+}
+
+// The sink gets device-space primitives from the raster backend. Discs
+// and lines go into the dot framebuffer; text becomes characters, so a
+// numeral reads as a numeral at any terminal size.
+static void SinkDisc(void* pCtx, double xc, double yc, double r, uint32_t color)
+{
+    TERMSCREEN* pScreen = (TERMSCREEN*)pCtx;
+    int x = (int)xc, y = (int)yc;
+
+    RasterFillDisc(&pScreen->dots, xc, yc, r, color);
+
+    // Minute dots shrink below one dot on small terminals; keep their centers
+    if (r < 0.75)
+        RasterFillRect(&pScreen->dots, x, y, x + 1, y + 1, color);
+}
+
+static void SinkLine(void* pCtx, double x0, double y0, double x1, double y1, double width, uint32_t color)
+{
+    TERMSCREEN* pScreen = (TERMSCREEN*)pCtx;
+
+    RasterThickLine(&pScreen->dots, x0, y0, x1, y1, width, color);
+}
+
+static void SinkText(void* pCtx, int x, int y, const char* psz, int iHeight, uint32_t color)
+{
+    TERMSCREEN* pScreen = (TERMSCREEN*)pCtx;
+    int xc = x + RasterTextWidth(psz, iHeight) / 2, yc = y + iHeight / 2;
+    int iLen = (int)strlen(psz);
+
+    (void)color;
+    if (xc < 0 || yc < 0)
+        return;
+    TermScreenText(pScreen, yc / pScreen->cyDot, xc / pScreen->cxDot - iLen / 2, psz);
+}
+
+void TermScreenText(TERMSCREEN* pScreen, int iRow, int iCol, const char* psz)
+{
+    uint32_t* pRow;
+
+    if (iRow < 0 || iRow >= pScreen->nRows)
+        return;
+    pRow = pScreen->pCells + (size_t)iRow * pScreen->nCols;
+    for (; *psz; psz++, iCol++)
+    {
+        if (iCol >= pScreen->nCols)
+            break;
+        if (iCol >= 0)
+            pRow[iCol] = (uint8_t)*psz;
+    }
+}
+
+// One cell from its dots; a dot is set when it is not the background
+static uint32_t ComposeCell(const TERMSCREEN* pScreen, int iRow, int iCol, uint32_t bgPixel)
+{
+    const uint8_t* pDots = pScreen->dots.pPixels;
+    size_t cxFb = (size_t)pScreen->dots.cx;
+    int x0 = iCol * pScreen->cxDot, y0 = iRow * pScreen->cyDot;
+    int dx, dy;
+    uint32_t dwBits = 0, dwPixel;
+
+    for (dy = 0; dy < pScreen->cyDot; dy++)
+        for (dx = 0; dx < pScreen->cxDot; dx++)
+        {
+            memcpy(&dwPixel, pDots + ((y0 + dy) * cxFb + x0 + dx) * 4, 4);
+            if (dwPixel == bgPixel)
+                continue;
+            dwBits |= pScreen->iMode == TERM_BRAILLE ? brailleBits[dy][dx] : 1u << dy;
+        }
+
+    if (pScreen->iMode == TERM_BRAILLE)
+        return dwBits ? TERM_BRAILLE_BASE + dwBits : ' ';
+    switch (dwBits)
+    {
+    case 1: return TERM_UPPER_HALF;
+    case 2: return TERM_LOWER_HALF;
+    case 3: return TERM_FULL_BLOCK;
+    default: return ' ';
+    }
+}
+
+void TermDrawClock(TERMSCREEN* pScreen, const CLOCKSTYLE* pStyle, int iHour, int iMinute, int iSecond,
+    int nBottomRows)
+{
+    CLOCKBACKEND backend;
+    RASTERVIEW view;
+    RASTERSINK sink;
+    uint64_t qwStart = PhaseNowNs();
+    size_t nCells = (size_t)pScreen->nCols * pScreen->nRows;
+    int nClockRows = pScreen->nRows - nBottomRows, iRow, iCol;
+    uint32_t bgPixel;
+    uint32_t* pCell;
+
+    pScreen->fg = ClockForeground(pStyle);
+    pScreen->bg = ClockBackground(pStyle);
+    RasterClear(&pScreen->dots, pScreen->bg);
+    memcpy(&bgPixel, pScreen->dots.pPixels, 4);
+
+    // Zero marks a cell the dots decide; the numerals fill in the others
+    memset(pScreen->pCells, 0, nCells * sizeof(uint32_t));
+    if (nClockRows > 0)
+    {
+        sink.pCtx = pScreen;
+        sink.pfnDisc = SinkDisc;
+        sink.pfnLine = SinkLine;
+        sink.pfnText = SinkText;
+        RasterViewInit(&view, &pScreen->dots, 0, 0, pScreen->dots.cx, nClockRows * pScreen->cyDot);
+        view.pSink = &sink;
+        RasterBackend(&backend, &view);
+        ClockDrawFace(&backend, pStyle);
+        ClockDrawHands(&backend, pStyle, iHour, iMinute, iSecond, 1);
+    }
+
+    for (iRow = 0; iRow < pScreen->nRows; iRow++)
+    {
+        pCell = pScreen->pCells + (size_t)iRow * pScreen->nCols;
+        for (iCol = 0; iCol < pScreen->nCols; iCol++, pCell++)
+        {
+            if (iRow >= nClockRows)
+                *pCell = ' ';
+            else if (!*pCell)
+                *pCell = ComposeCell(pScreen, iRow, iCol, bgPixel);
+        }
+    }
+
+    pScreen->qwDrawNs += PhaseNowNs() - qwStart;
+}
+
+static size_t Utf8Length(uint32_t cp)
+{
+    return cp < 0x80 ? 1 : cp < 0x800 ? 2 : 3;
+}
+
+static char* PutUtf8(char* p, uint32_t cp)
+{
+    if (cp < 0x80)
+        *p++ = (char)cp;
+    else if (cp < 0x800)
+    {
+        *p++ = (char)(0xC0 | cp >> 6);
+        *p++ = (char)(0x80 | (cp & 0x3F));
+    }
+    else
+    {
+        *p++ = (char)(0xE0 | cp >> 12);
+        *p++ = (char)(0x80 | (cp >> 6 & 0x3F));
+        *p++ = (char)(0x80 | (cp & 0x3F));
+    }
+    return p;
+}
+
+// CUP is 1-based
+static int CursorMove(char* buf, int iRow, int iCol)
+{
+    return sprintf(buf, "\x1b[%d;%dH", iRow + 1, iCol + 1);
+}
+
+// The terminal has only its own palette: bright white and black, as the
+// window uses white and black
+static int ColorSequence(char* buf, uint32_t fg, uint32_t bg)
+{
+    int bFgLight = ((fg >> 16 & 0xFF) + (fg >> 8 & 0xFF) + (fg & 0xFF)) >= 384;
+    int bBgLight = ((bg >> 16 & 0xFF) + (bg >> 8 & 0xFF) + (bg & 0xFF)) >= 384;
+
+    return sprintf(buf, "\x1b[0;%d;%dm", bFgLight ? 97 : 30, bBgLight ? 107 : 40);
+}
+
+size_t TermScreenDiff(TERMSCREEN* pScreen)
+{
+    uint64_t qwStart = PhaseNowNs();
+    size_t nCells = (size_t)pScreen->nCols * pScreen->nRows;
+    const uint32_t* pNew;
+    const uint32_t* pOld;
+    char* p = pScreen->pOut;
+    char szMove[32];
+    size_t cbGap;
+    int iRow, iCol, iGap, cbMove;
+
+    if (pScreen->bFull || pScreen->fg != pScreen->fgShown || pScreen->bg != pScreen->bgShown)
+    {
+        // Cleared to spaces in the new colors; only what is not blank follows
+        p += sprintf(p, "\x1b[?25l");
+        p += ColorSequence(p, pScreen->fg, pScreen->bg);
+        p += sprintf(p, "\x1b[2J");
+        for (iCol = 0; (size_t)iCol < nCells; iCol++)
+            pScreen->pShown[iCol] = ' ';
+        pScreen->fgShown = pScreen->fg;
+        pScreen->bgShown = pScreen->bg;
+        pScreen->iCursorRow = pScreen->iCursorCol = -1;
+        pScreen->bFull = 0;
+        pScreen->dwFullFrames++;
+    }
+
+    for (iRow = 0; iRow < pScreen->nRows; iRow++)
+    {
+        pNew = pScreen->pCells + (size_t)iRow * pScreen->nCols;
+        pOld = pScreen->pShown + (size_t)iRow * pScreen->nCols;
+        for (iCol = 0; iCol < pScreen->nCols; iCol++)
+        {
+            if (pNew[iCol] == pOld[iCol])
+                continue;
+
+            // Reach the cell by rewriting the unchanged cells since the
+            // cursor when they take fewer bytes than a move
+            cbMove = CursorMove(szMove, iRow, iCol);
+            cbGap = (size_t)-1;
+            if (pScreen->iCursorRow == iRow && pScreen->iCursorCol >= 0 && pScreen->iCursorCol <= iCol)
+            {
+                cbGap = 0;
+                for (iGap = pScreen->iCursorCol; iGap < iCol; iGap++)
+                    cbGap += Utf8Length(pNew[iGap]);
+            }
+            if (cbGap <= (size_t)cbMove)
+            {
+                for (iGap = pScreen->iCursorCol; iGap < iCol; iGap++)
+                    p = PutUtf8(p, pNew[iGap]);
+            }
+            else
+            {
+                memcpy(p, szMove, (size_t)cbMove);
+                p += cbMove;
+            }
+
+            p = PutUtf8(p, pNew[iCol]);
+            pScreen->qwCellsChanged++;
+
+            // Past the last column the cursor waits to wrap; do not count on it
+            pScreen->iCursorRow = iRow;
+            pScreen->iCursorCol = iCol + 1 < pScreen->nCols ? iCol + 1 : -1;
+        }
+    }
+
+    memcpy(pScreen->pShown, pScreen->pCells, nCells * sizeof(uint32_t));
+    pScreen->cbOut = (size_t)(p - pScreen->pOut);
+    pScreen->dwFrames++;
+    pScreen->qwBytes += pScreen->cbOut;
+    pScreen->qwDiffNs += PhaseNowNs() - qwStart;
+    return pScreen->cbOut;
+}
+
+const char* TermRestoreSequence(void)
+{
+    return "\x1b[0m\x1b[?25h";
+}
+
+void TermScreenFormat(const TERMSCREEN* pScreen, char* buf, size_t cb)
+{
+    double nFrames = pScreen->dwFrames ? pScreen->dwFrames : 1;
+
+    snprintf(buf, cb, "Terminal: %dx%d %s, %lu frames (%lu whole), %.0f bytes and %.1f cells a frame, "
+        "draw %.1f us, diff %.1f us",
+        pScreen->nCols, pScreen->nRows, pScreen->iMode == TERM_BRAILLE ? "braille" : "half blocks",
+        (unsigned long)pScreen->dwFrames, (unsigned long)pScreen->dwFullFrames, pScreen->qwBytes / nFrames,
+        pScreen->qwCellsChanged / nFrames, pScreen->qwDrawNs / nFrames / 1000, pScreen->qwDiffNs / nFrames / 1000);
+}
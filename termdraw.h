@@ -0,0 +1,76 @@
+/*--------------------------
+    TERMDRAW.H -- The clock as braille or half-block terminal cells, sent as a diff
+---------------------------*/
+
+#ifndef TERMDRAW_H
+#define TERMDRAW_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "raster.h"
+
+// Braille cells hold 2x4 dots, half blocks 1x2. Terminal cells are about
+// twice as tall as wide, so the dots come out square in both and the
+// isotropic mapping needs no correction.
+typedef enum
+{
+    TERM_BRAILLE,
+    TERM_HALFBLOCK
+} TERMMODE;
+
+typedef struct
+{
+    int nCols, nRows;
+    int iMode;
+    int cxDot, cyDot;           // dots per cell
+    FRAMEBUFFER dots;           // the face and hands, one pixel per dot
+
+    // Unicode code points, row-major. pShown is what the terminal shows,
+    // valid unless bFull is set.
+    uint32_t* pCells;
+    uint32_t* pShown;
+    int bFull;
+    uint32_t fg, bg;            // colors of the frame in pCells
+    uint32_t fgShown, bgShown;
+    int iCursorRow, iCursorCol; // -1 when not known
+
+    // The escape sequences for the last frame
+    char* pOut;
+    size_t cbOut, cbCap;
+
+    // Statistics
+    uint32_t dwFrames;
+    uint32_t dwFullFrames;
+    uint64_t qwBytes;
+    uint64_t qwCellsChanged;
+    uint64_t qwDrawNs, qwDiffNs;
+} TERMSCREEN;
+
+// Returns 0 if out of memory
+int TermScreenInit(TERMSCREEN* pScreen, int nCols, int nRows, int iMode);
+void TermScreenFree(TERMSCREEN* pScreen);
+
+// The next frame is sent whole, for a new or cleared terminal
+void TermScreenInvalidate(TERMSCREEN* pScreen);
+
+// Draws the clock into pCells through the raster backend's mapping; the
+// numerals become ordinary characters centred where DrawClock puts them.
+// bottomRows rows at the bottom are left out of the clock and kept blank.
+void TermDrawClock(TERMSCREEN* pScreen, const CLOCKSTYLE* pStyle, int iHour, int iMinute, int iSecond,
+    int nBottomRows);
+
+// Writes psz into row iRow of pCells from column iCol, clipped to the row
+void TermScreenText(TERMSCREEN* pScreen, int iRow, int iCol, const char* psz);
+
+// Builds the escape sequences that take the terminal from pShown to pCells
+// into pScreen->pOut and returns their length, or 0 if nothing changed.
+// Changed cells are reached with a cursor move, or by rewriting unchanged
+// cells when that is shorter.
+size_t TermScreenDiff(TERMSCREEN* pScreen);
+
+// Shows the cursor and resets the colors, for leaving the terminal as it was
+const char* TermRestoreSequence(void);
+
+void TermScreenFormat(const TERMSCREEN* pScreen, char* buf, size_t cb);
+
+#endif
@@ -0,0 +1,101 @@
+/*--------------------------
+    TICKSCHED.C -- Tick scheduler phase-locked to wall-clock seconds
+---------------------------*/
+
+#include <stdio.h>
+#include <string.h>
+#include "ticksched.h"
+
+#define US_PER_SECOND 1000000
+
+void TickSchedInit(TICKSCHED* pSched, const TICKCLOCK* pClock, uint32_t dwGuardUs)
+{
+    memset(pSched, 0, sizeof(*pSched));
+    pSched->clock = *pClock;
+    pSched->dwGuardUs = dwGuardUs;
+    pSched->llLastSecond = -1;
+}
+
+static uint32_t DelayMs(const TICKSCHED* pSched, uint64_t qwNowUs)
+{
+    uint32_t dwUs = US_PER_SECOND - (uint32_t)(qwNowUs % US_PER_SECOND) + pSched->dwGuardUs;
+
+    // Round up: timers never fire early, so rounding down could land us
+    // just before the boundary
+    return (dwUs + 999) / 1000;
+}
+
+uint32_t TickSchedNextDelayMs(TICKSCHED* pSched)
+{
+    return DelayMs(pSched, pSched->clock.pfnNowUs(pSched->clock.pCtx));
+}
+
+int TickSchedOnTimer(TICKSCHED* pSched, uint32_t* pdwNextMs)
+{
+    uint64_t qwNow = pSched->clock.pfnNowUs(pSched->clock.pCtx);
+    int64_t llSecond = (int64_t)(qwNow / US_PER_SECOND);
+    uint32_t dwLateUs = (uint32_t)(qwNow % US_PER_SECOND);
+    uint32_t dwBucket;
+
+    *pdwNextMs = DelayMs(pSched, qwNow);
+
+    if (llSecond == pSched->llLastSecond)
+    {
+        pSched->dwEarly++;
+        return 0;
+    }
+
+    if (pSched->llLastSecond >= 0 && llSecond > pSched->llLastSecond + 1)
+        pSched->dwSkipped += (uint32_t)(llSecond - pSched->llLastSecond - 1);
+
+    // The first tick starts at an arbitrary phase, and so does the first
+    // one after the clock was set back, so neither is measured
+    if (pSched->llLastSecond >= 0 && llSecond > pSched->llLastSecond)
+    {
+        dwBucket = dwLateUs / 1000;
+        if (dwBucket >= TICK_HIST_BUCKETS)
+            dwBucket = TICK_HIST_BUCKETS - 1;
+        pSched->hist[dwBucket]++;
+        if (dwLateUs > pSched->dwMaxLateUs)
+            pSched->dwMaxLateUs = dwLateUs;
+        pSched->dwTicks++;
+    }
+
+    pSched->llLastSecond = llSecond;
+    return 1;
+}
+
+void TickSchedResync(TICKSCHED* pSched)
+{
+    pSched->llLastSecond = -1;
+}
+
+uint32_t TickSchedWithinPercent(const TICKSCHED* pSched, uint32_t dwUs)
+{
+    uint32_t i, dwWithin = 0;
+
+    if (!pSched->dwTicks)
+        return 0;
+
+    for (i = 0; i < TICK_HIST_BUCKETS - 1 && (i + 1) * 1000 <= dwUs; i++)
+        dwWithin += pSched->hist[i];
+    return (uint32_t)((uint64_t)dwWithin * 100 / pSched->dwTicks);
+}
+
+void TickSchedFormat(const TICKSCHED* pSched, char* buf, size_t cb)
+{
+    size_t n;
+    uint32_t i;
+
+    n = (size_t)snprintf(buf, cb, "Tick scheduler: %u ticks, %u%% within 5 ms, max %u us late, "
+        "%u early, %u skipped; late ms:",
+        pSched->dwTicks, TickSchedWithinPercent(pSched, 5000), pSched->dwMaxLateUs,
+        pSched->dwEarly, pSched->dwSkipped);
+
+    for (i = 0; i < TICK_HIST_BUCKETS && n < cb; i++)
+    {
+        if (pSched->hist[i])
+            n += (size_t)snprintf(buf + n, cb - n, " %u%s=%u", i,
+                i == TICK_HIST_BUCKETS - 1 ? "+" : "", pSched->hist[i]);
+    }
+}
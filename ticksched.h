@@ -0,0 +1,53 @@
+/*--------------------------
+    TICKSCHED.H -- Tick scheduler phase-locked to wall-clock seconds
+---------------------------*/
+
+#ifndef TICKSCHED_H
+#define TICKSCHED_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Lateness histogram: one bucket per millisecond, the last one open-ended
+#define TICK_HIST_BUCKETS 32
+
+// Wall-clock source in microseconds; tests pass a fake one
+typedef struct
+{
+    uint64_t (*pfnNowUs)(void* pCtx);
+    void* pCtx;
+} TICKCLOCK;
+
+typedef struct
+{
+    TICKCLOCK clock;
+    uint32_t dwGuardUs;         // aim this far past the boundary
+    int64_t llLastSecond;       // -1 until the first tick
+    uint32_t dwTicks;
+    uint32_t dwEarly;           // fired before the boundary, re-armed
+    uint32_t dwSkipped;         // seconds that were never shown
+    uint32_t dwMaxLateUs;
+    uint32_t hist[TICK_HIST_BUCKETS];
+} TICKSCHED;
+
+void TickSchedInit(TICKSCHED* pSched, const TICKCLOCK* pClock, uint32_t dwGuardUs);
+
+// Milliseconds from now until the next second boundary plus the guard
+uint32_t TickSchedNextDelayMs(TICKSCHED* pSched);
+
+// Call when the timer fires. Returns 1 when a new second has started and
+// should be shown, 0 for an early wake-up. Either way *pdwNextMs is the
+// delay to arm the timer with for the next boundary.
+int TickSchedOnTimer(TICKSCHED* pSched, uint32_t* pdwNextMs);
+
+// Forgets the last tick, so a timer stopped on purpose (while the window
+// was hidden) is not counted as skipped seconds
+void TickSchedResync(TICKSCHED* pSched);
+
+// Share of ticks that landed within dwUs of their boundary, in percent
+uint32_t TickSchedWithinPercent(const TICKSCHED* pSched, uint32_t dwUs);
+
+// One-line summary with the non-empty histogram buckets
+void TickSchedFormat(const TICKSCHED* pSched, char* buf, size_t cb);
+
+#endif
@@ -0,0 +1,291 @@
+/*--------------------------
+    TIMESOURCE.C -- Local wall time from a steady counter and a cached zone offset
+---------------------------*/
+
+#ifndef _WIN32
+#define _POSIX_C_SOURCE 200809L
+#endif
+
+#include <stdio.h>
+#include <time.h>
+#include "timesource.h"
+#include "phasetime.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#endif
+
+#define US_PER_DAY 86400000000LL
+#define TIME_RESYNC_TRIES 3
+
+// Division and remainder rounding toward minus infinity
+static int64_t FloorDiv(int64_t a, int64_t b)
+{
+    return a / b - (a % b < 0);
+}
+
+// Days since 1970-01-01 of a proleptic Gregorian date, and back
+int64_t DaysFromCivil(int64_t y, int m, int d)
+{
+    int64_t era, yoe, doy, doe;
+
+    y -= m <= 2;
+    era = FloorDiv(y, 400);
+    yoe = y - era * 400;
+    doy = (153 * (m > 2 ? m - 3 : m + 9) + 2) / 5 + d - 1;
+    doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    return era * 146097 + doe - 719468;
+}
+
+static void CivilFromDays(int64_t llDays, int* piYear, int* piMonth, int* piDay)
+{
+    int64_t era, doe, yoe, doy, mp;
+
+    llDays += 719468;
+    era = FloorDiv(llDays, 146097);
+    doe = llDays - era * 146097;
+    yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+    doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+    mp = (5 * doy + 2) / 153;
+    *piDay = (int)(doy - (153 * mp + 2) / 5 + 1);
+    *piMonth = (int)(mp < 10 ? mp + 3 : mp - 9);
+    *piYear = (int)(yoe + era * 400 + (*piMonth <= 2));
+}
+
+// 1970-01-01 was a Thursday
+int DayOfWeek(int64_t llDays)
+{
+    return (int)(llDays - FloorDiv(llDays + 4, 7) * 7 + 4);
+}
+
+static uint64_t SystemSteadyNs(void* pCtx)
+{
+    (void)pCtx;
+    return PhaseNowNs();
+}
+
+#ifdef _WIN32
+// FILETIMEs count 100 ns units since 1601
+#define FILETIME_1970 116444736000000000LL
+
+typedef VOID (WINAPI* PFNGETSYSTEMTIME)(LPFILETIME);
+
+// GetSystemTimePreciseAsFileTime only exists from Windows 8, so it is
+// looked up rather than imported; older systems get the coarser
+// GetSystemTimeAsFileTime. Every thread that races the first call stores
+// the same pointer.
+int64_t TimeSourceUtcUs(void)
+{
+    static PFNGETSYSTEMTIME pfnGetTime;
+    FILETIME ft;
+
+    if (!pfnGetTime)
+    {
+        PFNGETSYSTEMTIME pfnPrecise = (PFNGETSYSTEMTIME)GetProcAddress(GetModuleHandle(TEXT("kernel32.dll")),
+            "GetSystemTimePreciseAsFileTime");
+
+        pfnGetTime = pfnPrecise ? pfnPrecise : GetSystemTimeAsFileTime;
+    }
+    pfnGetTime(&ft);
+    return ((int64_t)(((uint64_t)ft.dwHighDateTime << 32) | ft.dwLowDateTime) - FILETIME_1970) / 10;
+}
+
+static int32_t SystemOffsetAt(void* pCtx, int64_t llUtc)
+{
+    uint64_t qwFileTime = (uint64_t)(llUtc * 10000000 + FILETIME_1970);
+    FILETIME ft;
+    SYSTEMTIME stUtc, stLocal;
+
+    (void)pCtx;
+    ft.dwLowDateTime = (DWORD)qwFileTime;
+    ft.dwHighDateTime = (DWORD)(qwFileTime >> 32);
+    if (!FileTimeToSystemTime(&ft, &stUtc) || !SystemTimeToTzSpecificLocalTime(NULL, &stUtc, &stLocal))
+        return 0;
+    return (int32_t)((DaysFromCivil(stLocal.wYear, stLocal.wMonth, stLocal.wDay) * 86400 +
+        stLocal.wHour * 3600 + stLocal.wMinute * 60 + stLocal.wSecond) - llUtc);
+}
+#else
+int64_t TimeSourceUtcUs(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_REALTIME, &ts);
+    return (int64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+// localtime_r's fields read back as if they were UTC, less the UTC second
+static int32_t SystemOffsetAt(void* pCtx, int64_t llUtc)
+{
+    time_t t = (time_t)llUtc;
+    struct tm tm;
+
+    (void)pCtx;
+    if (!localtime_r(&t, &tm))
+        return 0;
+    return (int32_t)((DaysFromCivil(tm.tm_year + 1900LL, tm.tm_mon + 1, tm.tm_mday) * 86400 +
+        tm.tm_hour * 3600 + tm.tm_min * 60 + tm.tm_sec) - llUtc);
+}
+#endif
+
+static int64_t SystemUtcUs(void* pCtx)
+{
+    (void)pCtx;
+    return TimeSourceUtcUs();
+}
+
+void TimeSourceSystemClock(TIMECLOCK* pClock)
+{
+    pClock->pfnSteadyNs = SystemSteadyNs;
+    pClock->pfnUtcUs = SystemUtcUs;
+    pClock->pfnOffsetAt = SystemOffsetAt;
+    pClock->pCtx = NULL;
+}
+
+void TimeSourceInit(TIMESOURCE* pSrc, const TIMECLOCK* pClock, uint64_t qwResyncNs, uint64_t qwJumpUs)
+{
+    pSrc->clock = *pClock;
+    pSrc->qwResyncNs = qwResyncNs;
+    pSrc->qwJumpUs = qwJumpUs;
+    pSrc->dwCalls = 0;
+    pSrc->dwResyncs = 0;
+    pSrc->dwJumps = 0;
+    pSrc->dwZoneLookups = 0;
+    pSrc->dwTransitions = 0;
+    TimeSourceInvalidate(pSrc);
+}
+
+void TimeSourceInvalidate(TIMESOURCE* pSrc)
+{
+    pSrc->bAnchored = 0;
+    pSrc->bZoneValid = 0;
+    pSrc->llDay = INT64_MIN;
+}
+
+int64_t TimeSourceNextTransition(const TIMECLOCK* pClock, int64_t llUtc, int32_t lOffset)
+{
+    int64_t llEnd = llUtc + TIME_ZONE_HORIZON_SEC, llLo, llHi, llMid;
+
+    // Step until the offset differs, then bisect down to the second
+    for (llLo = llUtc; llLo < llEnd; llLo = llHi)
+    {
+        llHi = llLo + TIME_ZONE_STEP_SEC < llEnd ? llLo + TIME_ZONE_STEP_SEC : llEnd;
+        if (pClock->pfnOffsetAt(pClock->pCtx, llHi) == lOffset)
+            continue;
+
+        while (llHi - llLo > 1)
+        {
+            llMid = llLo + (llHi - llLo) / 2;
+            if (pClock->pfnOffsetAt(pClock->pCtx, llMid) == lOffset)
+                llLo = llMid;
+            else
+                llHi = llMid;
+        }
+        return llHi;
+    }
+    return llEnd;
+}
+
+// Re-reads the wall clock between two reads of the steady counter, again
+// if something ran in between. A steady clock and an adjusted wall clock
+// drift apart slowly, so anything beyond qwJumpUs means the time was set.
+static void Resync(TIMESOURCE* pSrc, uint64_t* pqwNow)
+{
+    int64_t llUtcUs = 0, llDiff;
+    uint64_t qwAfter;
+    int i;
+
+    for (i = 0; i < TIME_RESYNC_TRIES; i++)
+    {
+        llUtcUs = pSrc->clock.pfnUtcUs(pSrc->clock.pCtx);
+        qwAfter = pSrc->clock.pfnSteadyNs(pSrc->clock.pCtx);
+        if (qwAfter - *pqwNow <= pSrc->qwJumpUs * 500)
+            break;
+        *pqwNow = qwAfter;
+    }
+
+    if (pSrc->bAnchored)
+    {
+        pSrc->dwResyncs++;
+        llDiff = llUtcUs - pSrc->llAnchorUtcUs - (int64_t)((*pqwNow - pSrc->qwAnchorNs) / 1000);
+        if ((uint64_t)(llDiff < 0 ? -llDiff : llDiff) > pSrc->qwJumpUs)
+            pSrc->dwJumps++;
+    }
+    pSrc->bAnchored = 1;
+    pSrc->qwAnchorNs = *pqwNow;
+    pSrc->llAnchorUtcUs = llUtcUs;
+}
+
+static void LookupZone(TIMESOURCE* pSrc, int64_t llUtc)
+{
+    int32_t lOffset = pSrc->clock.pfnOffsetAt(pSrc->clock.pCtx, llUtc);
+
+    pSrc->dwZoneLookups++;
+    if (pSrc->bZoneValid && lOffset != pSrc->lOffset)
+        pSrc->dwTransitions++;
+    pSrc->bZoneValid = 1;
+    pSrc->lOffset = lOffset;
+    pSrc->llZoneFrom = llUtc;
+    pSrc->llZoneUntil = TimeSourceNextTransition(&pSrc->clock, llUtc, lOffset);
+}
+
+static void TimeOfDay(int64_t llUs, WALLTIME* pTime)
+{
+    int32_t lMs = (int32_t)(llUs / 1000), lSec = lMs / 1000;
+
+    pTime->iHour = lSec / 3600;
+    pTime->iMinute = lSec / 60 % 60;
+    pTime->iSecond = lSec % 60;
+    pTime->iMilliseconds = lMs % 1000;
+}
+
+void TimeSourceNow(TIMESOURCE* pSrc, WALLTIME* pTime)
+{
+    uint64_t qwNow = pSrc->clock.pfnSteadyNs(pSrc->clock.pCtx);
+    int64_t llUtcUs, llUtc, llLocalUs, llDay;
+
+    pSrc->dwCalls++;
+    if (!pSrc->bAnchored || qwNow - pSrc->qwAnchorNs >= pSrc->qwResyncNs)
+        Resync(pSrc, &qwNow);
+    llUtcUs = pSrc->llAnchorUtcUs + (int64_t)((qwNow - pSrc->qwAnchorNs) / 1000);
+
+    llUtc = FloorDiv(llUtcUs, 1000000);
+    if (!pSrc->bZoneValid || llUtc < pSrc->llZoneFrom || llUtc >= pSrc->llZoneUntil)
+        LookupZone(pSrc, llUtc);
+
+    llLocalUs = llUtcUs + (int64_t)pSrc->lOffset * 1000000;
+    llDay = FloorDiv(llLocalUs, US_PER_DAY);
+    if (llDay != pSrc->llDay)
+    {
+        pSrc->llDay = llDay;
+        CivilFromDays(llDay, &pSrc->iYear, &pSrc->iMonth, &pSrc->iDay);
+        pSrc->iDayOfWeek = DayOfWeek(llDay);
+    }
+
+    pTime->iYear = pSrc->iYear;
+    pTime->iMonth = pSrc->iMonth;
+    pTime->iDay = pSrc->iDay;
+    pTime->iDayOfWeek = pSrc->iDayOfWeek;
+    TimeOfDay(llLocalUs - llDay * US_PER_DAY, pTime);
+    pTime->lUtcOffset = pSrc->lOffset;
+}
+
+void WallTimeFromLocalUs(int64_t llLocalUs, WALLTIME* pTime)
+{
+    int64_t llDay = FloorDiv(llLocalUs, US_PER_DAY);
+
+    CivilFromDays(llDay, &pTime->iYear, &pTime->iMonth, &pTime->iDay);
+    pTime->iDayOfWeek = DayOfWeek(llDay);
+    TimeOfDay(llLocalUs - llDay * US_PER_DAY, pTime);
+    pTime->lUtcOffset = 0;
+}
+
+void TimeSourceFormat(const TIMESOURCE* pSrc, char* buf, size_t cb)
+{
+    int32_t lOffset = pSrc->lOffset < 0 ? -pSrc->lOffset : pSrc->lOffset;
+
+    snprintf(buf, cb, "Time source: %lu calls, %lu resyncs, %lu jumps, %lu zone lookups, "
+        "%lu transitions, UTC%c%02ld:%02ld",
+        (unsigned long)pSrc->dwCalls, (unsigned long)pSrc->dwResyncs, (unsigned long)pSrc->dwJumps,
+        (unsigned long)pSrc->dwZoneLookups, (unsigned long)pSrc->dwTransitions,
+        pSrc->lOffset < 0 ? '-' : '+', (long)(lOffset / 3600), (long)(lOffset / 60 % 60));
+}
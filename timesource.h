@@ -0,0 +1,93 @@
+/*--------------------------
+    TIMESOURCE.H -- Local wall time from a steady counter and a cached zone offset
+---------------------------*/
+
+#ifndef TIMESOURCE_H
+#define TIMESOURCE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// A zone offset is looked up this far ahead for its next change, in
+// steps no longer than the shortest time between two transitions
+#define TIME_ZONE_HORIZON_SEC (35 * 86400)
+#define TIME_ZONE_STEP_SEC (3 * 3600)
+
+// Where the time comes from; tests pass fake counters and keep the zone
+typedef struct
+{
+    uint64_t (*pfnSteadyNs)(void* pCtx);                // never goes back
+    int64_t (*pfnUtcUs)(void* pCtx);                    // since 1970-01-01 UTC
+    int32_t (*pfnOffsetAt)(void* pCtx, int64_t llUtc);  // seconds east of UTC at that second
+    void* pCtx;
+} TIMECLOCK;
+
+// Broken-down local time, fields as in SYSTEMTIME
+typedef struct
+{
+    int iYear, iMonth, iDay;    // month and day from 1
+    int iDayOfWeek;             // 0 for Sunday
+    int iHour, iMinute, iSecond, iMilliseconds;
+    int32_t lUtcOffset;         // seconds east of UTC
+} WALLTIME;
+
+typedef struct
+{
+    TIMECLOCK clock;
+    uint64_t qwResyncNs;        // how often the wall clock is read again
+    uint64_t qwJumpUs;          // larger disagreements count as a clock jump
+
+    // UTC is the anchor plus the steady time since; invalid until the first call
+    int bAnchored;
+    uint64_t qwAnchorNs;
+    int64_t llAnchorUtcUs;
+
+    // lOffset holds for UTC seconds llZoneFrom .. llZoneUntil - 1
+    int bZoneValid;
+    int32_t lOffset;
+    int64_t llZoneFrom, llZoneUntil;
+
+    // Date of the local day last shown, so most calls only divide the time of day
+    int64_t llDay;              // local days since 1970-01-01, or INT64_MIN
+    int iYear, iMonth, iDay, iDayOfWeek;
+
+    // Statistics
+    uint32_t dwCalls;
+    uint32_t dwResyncs;
+    uint32_t dwJumps;           // wall clock set, or off by more than qwJumpUs
+    uint32_t dwZoneLookups;
+    uint32_t dwTransitions;     // zone lookups that found a different offset
+} TIMESOURCE;
+
+// The system's own clocks and time zone
+void TimeSourceSystemClock(TIMECLOCK* pClock);
+
+// The system's UTC in microseconds since 1970, as precise as it offers
+int64_t TimeSourceUtcUs(void);
+
+void TimeSourceInit(TIMESOURCE* pSrc, const TIMECLOCK* pClock, uint64_t qwResyncNs, uint64_t qwJumpUs);
+
+// Local time now. Reads only the steady counter unless qwResyncNs has
+// passed or the zone offset is due to change.
+void TimeSourceNow(TIMESOURCE* pSrc, WALLTIME* pTime);
+
+// Forgets the anchor and the zone offset, for when the system reports a
+// new time or time zone
+void TimeSourceInvalidate(TIMESOURCE* pSrc);
+
+// First UTC second after llUtc with an offset other than the one at llUtc,
+// or llUtc + TIME_ZONE_HORIZON_SEC if there is none that soon
+int64_t TimeSourceNextTransition(const TIMECLOCK* pClock, int64_t llUtc, int32_t lOffset);
+
+// Local microseconds since 1970 into date and time of day
+void WallTimeFromLocalUs(int64_t llLocalUs, WALLTIME* pTime);
+
+// Days since 1970-01-01 of a proleptic Gregorian date (month and day from
+// 1), and the day of the week of such a day, 0 for Sunday
+int64_t DaysFromCivil(int64_t y, int m, int d);
+int DayOfWeek(int64_t llDays);
+
+// One-line summary of the counters
+void TimeSourceFormat(const TIMESOURCE* pSrc, char* buf, size_t cb);
+
+#endif
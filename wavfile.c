@@ -0,0 +1,171 @@
+/*--------------------------
+    WAVFILE.C -- RIFF/WAVE PCM loader and writer
+---------------------------*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "wavfile.h"
+
+#define WAVE_FORMAT_PCM_TAG 1
+#define WAVE_FORMAT_EXTENSIBLE_TAG 0xFFFE
+
+static uint16_t ReadLE16(const uint8_t* p)
+{
+    return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+static uint32_t ReadLE32(const uint8_t* p)
+{
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static void WriteLE16(uint8_t* p, uint16_t v)
+{
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+}
+
+static void WriteLE32(uint8_t* p, uint32_t v)
+{
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+    p[2] = (uint8_t)(v >> 16);
+    p[3] = (uint8_t)(v >> 24);
+}
+
+int WavParse(const void* pData, size_t cbData, WAVSOUND* pWav)
+{
+    const uint8_t* p = (const uint8_t*)pData;
+    const uint8_t* pFmt = NULL;
+    const uint8_t* pPcm = NULL;
+    size_t pos, cbPcm = 0;
+    uint16_t wTag, wChannels, wBits, wBlockAlign;
+    uint32_t dwRate, i, dwSamples;
+
+    memset(pWav, 0, sizeof(*pWav));
+
+    if (cbData < 12 || memcmp(p, "RIFF", 4) != 0 || memcmp(p + 8, "WAVE", 4) != 0)
+        return 0;
+
+    // Walk the chunk list; chunks are word aligned, so odd sizes have a pad byte
+    for (pos = 12; pos + 8 <= cbData; )
+    {
+        uint32_t cbChunk = ReadLE32(p + pos + 4);
+        const uint8_t* pBody = p + pos + 8;
+
+        if (cbChunk > cbData - pos - 8)
+            cbChunk = (uint32_t)(cbData - pos - 8);
+
+        if (memcmp(p + pos, "fmt ", 4) == 0 && cbChunk >= 16)
+            pFmt = pBody;
+        else if (memcmp(p + pos, "data", 4) == 0)
+        {
+            pPcm = pBody;
+            cbPcm = cbChunk;
+        }
+
+        pos += 8 + (size_t)cbChunk + (cbChunk & 1);
+    }
+
+    if (!pFmt || !pPcm)
+        return 0;
+
+    wTag = ReadLE16(pFmt);
+    wChannels = ReadLE16(pFmt + 2);
+    dwRate = ReadLE32(pFmt + 4);
+    wBlockAlign = ReadLE16(pFmt + 12);
+    wBits = ReadLE16(pFmt + 14);
+
+    if ((wTag != WAVE_FORMAT_PCM_TAG && wTag != WAVE_FORMAT_EXTENSIBLE_TAG) ||
+        (wBits != 8 && wBits != 16) || wChannels == 0 || dwRate == 0 ||
+        wBlockAlign != wChannels * (wBits / 8))
+        return 0;
+
+    pWav->wChannels = wChannels;
+    pWav->dwSampleRate = dwRate;
+    pWav->dwFrames = (uint32_t)(cbPcm / wBlockAlign);
+    dwSamples = pWav->dwFrames * wChannels;
+
+    pWav->pSamples = (int16_t*)malloc((dwSamples ? dwSamples : 1) * sizeof(int16_t));
+    if (!pWav->pSamples)
+        return 0;
+
+    // 8-bit PCM is unsigned with a 128 midpoint; widen it to 16-bit
+    for (i = 0; i < dwSamples; i++)
+    {
+        if (wBits == 16)
+            pWav->pSamples[i] = (int16_t)ReadLE16(pPcm + i * 2);
+        else
+            pWav->pSamples[i] = (int16_t)((pPcm[i] - 128) << 8);
+    }
+    return 1;
+}
+
+int WavLoadFile(const char* pszPath, WAVSOUND* pWav)
+{
+    FILE* fp;
+    long cb;
+    void* pData;
+    int bOk = 0;
+
+    memset(pWav, 0, sizeof(*pWav));
+
+    fp = fopen(pszPath, "rb");
+    if (!fp)
+        return 0;
+
+    if (fseek(fp, 0, SEEK_END) == 0 && (cb = ftell(fp)) > 0 && fseek(fp, 0, SEEK_SET) == 0)
+    {
+        pData = malloc((size_t)cb);
+        if (pData)
+        {
+            if (fread(pData, 1, (size_t)cb, fp) == (size_t)cb)
+                bOk = WavParse(pData, (size_t)cb, pWav);
+            free(pData);
+        }
+    }
+    fclose(fp);
+    return bOk;
+}
+
+int WavWriteFile(const char* pszPath, const int16_t* pSamples, uint32_t dwFrames,
+    uint16_t wChannels, uint32_t dwSampleRate)
+{
+    uint8_t hdr[44];
+    uint32_t i, cbPcm = dwFrames * wChannels * 2;
+    FILE* fp;
+    int bOk;
+
+    memcpy(hdr, "RIFF", 4);
+    WriteLE32(hdr + 4, 36 + cbPcm);
+    memcpy(hdr + 8, "WAVEfmt ", 8);
+    WriteLE32(hdr + 16, 16);
+    WriteLE16(hdr + 20, WAVE_FORMAT_PCM_TAG);
+    WriteLE16(hdr + 22, wChannels);
+    WriteLE32(hdr + 24, dwSampleRate);
+    WriteLE32(hdr + 28, dwSampleRate * wChannels * 2);
+    WriteLE16(hdr + 32, (uint16_t)(wChannels * 2));
+    WriteLE16(hdr + 34, 16);
+    memcpy(hdr + 36, "data", 4);
+    WriteLE32(hdr + 40, cbPcm);
+
+    fp = fopen(pszPath, "wb");
+    if (!fp)
+        return 0;
+
+    bOk = fwrite(hdr, 1, sizeof(hdr), fp) == sizeof(hdr);
+    for (i = 0; bOk && i < dwFrames * wChannels; i++)
+    {
+        uint8_t b[2];
+        WriteLE16(b, (uint16_t)pSamples[i]);
+        bOk = fwrite(b, 1, 2, fp) == 2;
+    }
+    return fclose(fp) == 0 && bOk;
+}
+
+void WavFree(WAVSOUND* pWav)
+{
+    free(pWav->pSamples);
+    memset(pWav, 0, sizeof(*pWav));
+}
@@ -0,0 +1,29 @@
+/*--------------------------
+    WAVFILE.H -- RIFF/WAVE PCM loader and writer
+---------------------------*/
+
+#ifndef WAVFILE_H
+#define WAVFILE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// A decoded sound, always held as interleaved signed 16-bit samples
+typedef struct
+{
+    uint16_t wChannels;
+    uint32_t dwSampleRate;
+    uint32_t dwFrames;
+    int16_t* pSamples;
+} WAVSOUND;
+
+// Parses an in-memory .wav image (8- or 16-bit PCM). Returns 1 on success;
+// the caller releases pWav->pSamples with WavFree.
+int WavParse(const void* pData, size_t cbData, WAVSOUND* pWav);
+
+int WavLoadFile(const char* pszPath, WAVSOUND* pWav);
+int WavWriteFile(const char* pszPath, const int16_t* pSamples, uint32_t dwFrames,
+    uint16_t wChannels, uint32_t dwSampleRate);
+void WavFree(WAVSOUND* pWav);
+
+#endif
@@ -0,0 +1,306 @@
+/*--------------------------
+    WORKPOOL.C -- Work-stealing thread pool for batch rendering
+---------------------------*/
+
+#ifndef _WIN32
+#define _POSIX_C_SOURCE 200809L
+#endif
+
+#include <stdlib.h>
+#include "workpool.h"
+
+#ifdef _WIN32
+#include <windows.h>
+
+typedef CRITICAL_SECTION POOLLOCK;
+typedef CONDITION_VARIABLE POOLCOND;
+typedef HANDLE POOLTHREAD;
+
+#define LockInit(p) InitializeCriticalSection(p)
+#define LockFree(p) DeleteCriticalSection(p)
+#define Lock(p) EnterCriticalSection(p)
+#define Unlock(p) LeaveCriticalSection(p)
+#define CondInit(p) InitializeConditionVariable(p)
+#define CondFree(p) ((void)(p))
+#define CondWait(p, pLock) SleepConditionVariableCS((p), (pLock), INFINITE)
+#define CondWakeAll(p) WakeAllConditionVariable(p)
+#else
+#include <pthread.h>
+#include <unistd.h>
+
+typedef pthread_mutex_t POOLLOCK;
+typedef pthread_cond_t POOLCOND;
+typedef pthread_t POOLTHREAD;
+
+#define LockInit(p) pthread_mutex_init((p), NULL)
+#define LockFree(p) pthread_mutex_destroy(p)
+#define Lock(p) pthread_mutex_lock(p)
+#define Unlock(p) pthread_mutex_unlock(p)
+#define CondInit(p) pthread_cond_init((p), NULL)
+#define CondFree(p) pthread_cond_destroy(p)
+#define CondWait(p, pLock) pthread_cond_wait((p), (pLock))
+#define CondWakeAll(p) pthread_cond_broadcast(p)
+#endif
+
+// Items iNext..iEnd-1 still owned by one worker. Padded so that workers
+// taking items from their own ranges do not share a cache line.
+typedef struct
+{
+    POOLLOCK lock;
+    int iNext;
+    int iEnd;
+    char pad[64];
+} WORKRANGE;
+
+typedef struct
+{
+    WORKPOOL* pPool;
+    int iWorker;
+    POOLTHREAD hThread;
+} WORKER;
+
+struct WORKPOOL
+{
+    int nWorkers;               // threads running
+    int nRanges;                // threads asked for
+    WORKER* pWorkers;
+    WORKRANGE* pRanges;
+
+    POOLLOCK lock;              // guards everything below
+    POOLCOND cvStart;
+    POOLCOND cvDone;
+    WORKFN pfn;
+    void* pCtx;
+    uint32_t dwBatch;           // bumped by every WorkPoolRun
+    int nBusy;                  // workers still in the current batch
+    int bQuit;
+    uint32_t dwSteals;
+};
+
+int WorkPoolCpuCount(void)
+{
+#ifdef _WIN32
+    SYSTEM_INFO si;
+
+    GetSystemInfo(&si);
+    return si.dwNumberOfProcessors > 0 ? (int)si.dwNumberOfProcessors : 1;
+#else
+    long n = sysconf(_SC_NPROCESSORS_ONLN);
+
+    return n > 0 ? (int)n : 1;
+#endif
+}
+
+static int TakeOwn(WORKRANGE* pRange)
+{
+    int iItem = -1;
+
+    Lock(&pRange->lock);
+    if (pRange->iNext < pRange->iEnd)
+        iItem = pRange->iNext++;
+    Unlock(&pRange->lock);
+    return iItem;
+}
+
+// Moves the upper half of another worker's range into ours and returns its
+// first item, or -1 when every range is empty
+static int Steal(WORKPOOL* pPool, int iWorker)
+{
+    WORKRANGE* pOwn = &pPool->pRanges[iWorker];
+    WORKRANGE* pVictim;
+    int i, nLeft, iStart, iEnd;
+
+    for (i = 1; i < pPool->nWorkers; i++)
+    {
+        pVictim = &pPool->pRanges[(iWorker + i) % pPool->nWorkers];
+
+        Lock(&pVictim->lock);
+        nLeft = pVictim->iEnd - pVictim->iNext;
+        iEnd = pVictim->iEnd;
+        iStart = iEnd - (nLeft + 1) / 2;
+        if (nLeft > 0)
+            pVictim->iEnd = iStart;
+        Unlock(&pVictim->lock);
+
+        if (nLeft <= 0)
+            continue;
+
+        Lock(&pOwn->lock);
+        pOwn->iNext = iStart + 1;
+        pOwn->iEnd = iEnd;
+        Unlock(&pOwn->lock);
+
+        Lock(&pPool->lock);
+        pPool->dwSteals++;
+        Unlock(&pPool->lock);
+        return iStart;
+    }
+    return -1;
+}
+
+#ifdef _WIN32
+static DWORD WINAPI WorkerProc(LPVOID pParam)
+#else
+static void* WorkerProc(void* pParam)
+#endif
+{
+    WORKER* pWorker = (WORKER*)pParam;
+    WORKPOOL* pPool = pWorker->pPool;
+    uint32_t dwSeen = 0;
+    WORKFN pfn;
+    void* pCtx;
+    int iItem;
+
+    for (;;)
+    {
+        Lock(&pPool->lock);
+        while (!pPool->bQuit && pPool->dwBatch == dwSeen)
+            CondWait(&pPool->cvStart, &pPool->lock);
+        if (pPool->bQuit)
+        {
+            Unlock(&pPool->lock);
+            break;
+        }
+        dwSeen = pPool->dwBatch;
+        pfn = pPool->pfn;
+        pCtx = pPool->pCtx;
+        Unlock(&pPool->lock);
+
+        while ((iItem = TakeOwn(&pPool->pRanges[pWorker->iWorker])) >= 0 ||
+            (iItem = Steal(pPool, pWorker->iWorker)) >= 0)
+            pfn(pCtx, iItem, pWorker->iWorker);
+
+        Lock(&pPool->lock);
+        if (--pPool->nBusy == 0)
+            CondWakeAll(&pPool->cvDone);
+        Unlock(&pPool->lock);
+    }
+    return 0;
+}
+
+WORKPOOL* WorkPoolCreate(int nWorkers)
+{
+    WORKPOOL* pPool;
+    WORKER* pWorker;
+    int i;
+
+    if (nWorkers < 1)
+        nWorkers = 1;
+
+    pPool = (WORKPOOL*)calloc(1, sizeof(WORKPOOL));
+    if (!pPool)
+        return NULL;
+    pPool->pWorkers = (WORKER*)calloc(nWorkers, sizeof(WORKER));
+    pPool->pRanges = (WORKRANGE*)calloc(nWorkers, sizeof(WORKRANGE));
+    if (!pPool->pWorkers || !pPool->pRanges)
+    {
+        free(pPool->pWorkers);
+        free(pPool->pRanges);
+        free(pPool);
+        return NULL;
+    }
+
+    LockInit(&pPool->lock);
+    CondInit(&pPool->cvStart);
+    CondInit(&pPool->cvDone);
+    for (i = 0; i < nWorkers; i++)
+        LockInit(&pPool->pRanges[i].lock);
+    pPool->nRanges = nWorkers;
+
+    // A worker that fails to start leaves the pool smaller, not broken
+    for (i = 0; i < nWorkers; i++)
+    {
+        pWorker = &pPool->pWorkers[pPool->nWorkers];
+        pWorker->pPool = pPool;
+        pWorker->iWorker = pPool->nWorkers;
+#ifdef _WIN32
+        pWorker->hThread = CreateThread(NULL, 0, WorkerProc, pWorker, 0, NULL);
+        if (!pWorker->hThread)
+            break;
+#else
+        if (pthread_create(&pWorker->hThread, NULL, WorkerProc, pWorker) != 0)
+            break;
+#endif
+        pPool->nWorkers++;
+    }
+
+    if (!pPool->nWorkers)
+    {
+        WorkPoolDestroy(pPool);
+        return NULL;
+    }
+    return pPool;
+}
+
+void WorkPoolDestroy(WORKPOOL* pPool)
+{
+    int i;
+
+    if (!pPool)
+        return;
+
+    Lock(&pPool->lock);
+    pPool->bQuit = 1;
+    CondWakeAll(&pPool->cvStart);
+    Unlock(&pPool->lock);
+
+    for (i = 0; i < pPool->nWorkers; i++)
+    {
+#ifdef _WIN32
+        WaitForSingleObject(pPool->pWorkers[i].hThread, INFINITE);
+        CloseHandle(pPool->pWorkers[i].hThread);
+#else
+        pthread_join(pPool->pWorkers[i].hThread, NULL);
+#endif
+    }
+
+    for (i = 0; i < pPool->nRanges; i++)
+        LockFree(&pPool->pRanges[i].lock);
+    CondFree(&pPool->cvDone);
+    CondFree(&pPool->cvStart);
+    LockFree(&pPool->lock);
+    free(pPool->pWorkers);
+    free(pPool->pRanges);
+    free(pPool);
+}
+
+int WorkPoolWorkers(const WORKPOOL* pPool)
+{
+    return pPool->nWorkers;
+}
+
+void WorkPoolRun(WORKPOOL* pPool, WORKFN pfn, void* pCtx, int iFirst, int nItems)
+{
+    WORKRANGE* pRange;
+    int i;
+
+    for (i = 0; i < pPool->nWorkers; i++)
+    {
+        pRange = &pPool->pRanges[i];
+        Lock(&pRange->lock);
+        pRange->iNext = iFirst + (int)((int64_t)nItems * i / pPool->nWorkers);
+        pRange->iEnd = iFirst + (int)((int64_t)nItems * (i + 1) / pPool->nWorkers);
+        Unlock(&pRange->lock);
+    }
+
+    Lock(&pPool->lock);
+    pPool->pfn = pfn;
+    pPool->pCtx = pCtx;
+    pPool->nBusy = pPool->nWorkers;
+    pPool->dwBatch++;
+    CondWakeAll(&pPool->cvStart);
+    Unlock(&pPool->lock);
+}
+
+void WorkPoolWait(WORKPOOL* pPool)
+{
+    Lock(&pPool->lock);
+    while (pPool->nBusy > 0)
+        CondWait(&pPool->cvDone, &pPool->lock);
+    Unlock(&pPool->lock);
+}
+
+uint32_t WorkPoolSteals(const WORKPOOL* pPool)
+{
+    return pPool->dwSteals;
+}
@@ -0,0 +1,33 @@
+/*--------------------------
+    WORKPOOL.H -- Work-stealing thread pool for batch rendering
+---------------------------*/
+
+#ifndef WORKPOOL_H
+#define WORKPOOL_H
+
+#include <stdint.h>
+
+// Called once per item, on whichever worker (0..nWorkers-1) took it
+typedef void (*WORKFN)(void* pCtx, int iItem, int iWorker);
+
+typedef struct WORKPOOL WORKPOOL;
+
+// Logical processors available to this process, at least 1
+int WorkPoolCpuCount(void);
+
+WORKPOOL* WorkPoolCreate(int nWorkers);
+void WorkPoolDestroy(WORKPOOL* pPool);
+
+int WorkPoolWorkers(const WORKPOOL* pPool);
+
+// Starts items iFirst..iFirst+nItems-1 and returns at once. Each worker
+// begins with an equal slice and, when its own runs out, steals half of
+// what is left in another's. One batch at a time: call WorkPoolWait
+// before the next WorkPoolRun.
+void WorkPoolRun(WORKPOOL* pPool, WORKFN pfn, void* pCtx, int iFirst, int nItems);
+void WorkPoolWait(WORKPOOL* pPool);
+
+// Successful steals since the pool was created
+uint32_t WorkPoolSteals(const WORKPOOL* pPool);
+
+#endif